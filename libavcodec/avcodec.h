@@ -32,7 +32,7 @@
 #include "libavutil/cpu.h"
 
 #define LIBAVCODEC_VERSION_MAJOR 52
-#define LIBAVCODEC_VERSION_MINOR 108
+#define LIBAVCODEC_VERSION_MINOR 110
 #define LIBAVCODEC_VERSION_MICRO  0
 
 #define LIBAVCODEC_VERSION_INT  AV_VERSION_INT(LIBAVCODEC_VERSION_MAJOR, \
@@ -731,6 +731,10 @@ typedef struct RcOverride{
  * Codec is able to deal with negative linesizes
  */
 #define CODEC_CAP_NEG_LINESIZES    0x0800
+/**
+ * Codec supports frame-level multithreading.
+ */
+#define CODEC_CAP_FRAME_THREADS    0x1000
 
 //The following defines may change, don't expect compatibility if you use them.
 #define MB_TYPE_INTRA4x4   0x0001
@@ -1030,6 +1034,20 @@ typedef struct AVPanScan{
      * - decoding: Read by user.\
      */\
     int64_t pkt_dts;\
+\
+    /**\
+     * the AVCodecContext which ff_thread_get_buffer() was last called on\
+     * - encoding: Set by libavcodec.\
+     * - decoding: Set by libavcodec.\
+     */\
+    struct AVCodecContext *owner;\
+\
+    /**\
+     * used by multithreading to store frame-specific info\
+     * - encoding: Set by libavcodec.\
+     * - decoding: Set by libavcodec.\
+     */\
+    void *thread_opaque;\
 
 
 #define FF_QSCALE_TYPE_MPEG1 0
@@ -1123,6 +1141,13 @@ typedef struct AVFrame {
     FF_COMMON_FRAME
 } AVFrame;
 
+/**
+ * Refcounted pool of picture buffers for avcodec_default_get_buffer(),
+ * which can be shared by several AVCodecContexts.
+ * @see avcodec_frame_pool_alloc()
+ */
+typedef struct AVFramePool AVFramePool;
+
 /**
  * main external API structure.
  * New fields can be added to the end with minor version bumps.
@@ -1807,6 +1832,7 @@ typedef struct AVCodecContext {
 #define FF_DEBUG_VIS_QP      0x00002000
 #define FF_DEBUG_VIS_MB_TYPE 0x00004000
 #define FF_DEBUG_BUFFERS     0x00008000
+#define FF_DEBUG_THREADS     0x00010000
 
     /**
      * debug
@@ -2822,6 +2848,65 @@ typedef struct AVCodecContext {
      * - encoding: unused
      */
     AVPacket *pkt;
+
+    /**
+     * Whether this is a copy of the context which had init() called on it.
+     * This is used by multithreading - shared tables and picture pointers
+     * should be freed from the original context only.
+     * - encoding: Set by libavcodec.
+     * - decoding: Set by libavcodec.
+     */
+    int is_copy;
+
+    /**
+     * Which multithreading methods to use.
+     * Use of FF_THREAD_FRAME will increase decoding delay by one frame per thread,
+     * so clients which cannot provide future frames should not use it.
+     *
+     * - encoding: Set by user, otherwise the default is used.
+     * - decoding: Set by user, otherwise the default is used.
+     */
+    int thread_type;
+#define FF_THREAD_FRAME   1 ///< Decode more than one frame at once
+#define FF_THREAD_SLICE   2 ///< Decode more than one part of a single frame at once
+
+    /**
+     * Which multithreading methods are in use by the codec.
+     * - encoding: Set by libavcodec.
+     * - decoding: Set by libavcodec.
+     */
+    int active_thread_type;
+
+    /**
+     * Set by the client if its custom get_buffer() callback can be called
+     * from another thread, which allows faster multithreaded decoding.
+     * draw_horiz_band() will be called from other threads regardless of this setting.
+     * Ignored if the default get_buffer() is used.
+     * - encoding: Set by user.
+     * - decoding: Set by user.
+     */
+    int thread_safe_callbacks;
+
+    /**
+     * Pool from which avcodec_default_get_buffer() takes its buffers and to
+     * which avcodec_default_release_buffer() returns them, instead of keeping
+     * them in this context. Decoders sharing a pool reuse each other's
+     * buffers when they have the same dimensions and pixel format.
+     * avcodec_open() takes a reference to it, avcodec_close() drops that
+     * reference and resets this field to NULL.
+     * - encoding: unused
+     * - decoding: Set by user before avcodec_open().
+     */
+    AVFramePool *frame_pool;
+
+    /**
+     * Playback entry points of the sequencer module to be rendered by a
+     * sequencer decoder, pointing to an AVSequencerPlayback owned by the
+     * demuxer. It is only passed in memory and never stored in files.
+     * - encoding: unused
+     * - decoding: Set by libavformat.
+     */
+    void *sequencer_playback;
 } AVCodecContext;
 
 /**
@@ -2874,6 +2959,26 @@ typedef struct AVCodec {
     uint8_t max_lowres;                     ///< maximum value for lowres supported by the decoder
     AVClass *priv_class;                    ///< AVClass for the private context
     const AVProfile *profiles;              ///< array of recognized profiles, or NULL if unknown, array is terminated by {FF_PROFILE_UNKNOWN}
+
+    /**
+     * @defgroup framethreading Frame-level threading support functions.
+     * @{
+     */
+    /**
+     * If defined, called on thread contexts when they are created.
+     * If the codec allocates writable tables in init(), re-allocate them here.
+     * priv_data will be set to a copy of the original.
+     */
+    int (*init_thread_copy)(AVCodecContext *);
+    /**
+     * Copy necessary context variables from a previous thread context to the current one.
+     * If not defined, the next thread will start automatically; otherwise, the codec
+     * must call ff_thread_finish_setup().
+     *
+     * dst and src will (rarely) point to the same context, in which case memcpy should be skipped.
+     */
+    int (*update_thread_context)(AVCodecContext *dst, const AVCodecContext *src);
+    /** @} */
 } AVCodec;
 
 /**
@@ -3507,6 +3612,34 @@ int avcodec_default_get_buffer(AVCodecContext *s, AVFrame *pic);
 void avcodec_default_release_buffer(AVCodecContext *s, AVFrame *pic);
 int avcodec_default_reget_buffer(AVCodecContext *s, AVFrame *pic);
 
+/**
+ * Allocate a pool of picture buffers to be set as AVCodecContext.frame_pool.
+ * Buffers are matched by their allocated width and height, pixel format and
+ * alignment, so they are only reused by contexts with the same geometry.
+ *
+ * A pool used from several threads at the same time needs a lock manager,
+ * which must be registered with av_lockmgr_register() before the pool is
+ * allocated.
+ *
+ * @param max_unused number of unused buffers kept by the pool, the least
+ *                   recently released ones are freed above it
+ * @return a pool with a reference count of 1, or NULL on failure
+ */
+AVFramePool *avcodec_frame_pool_alloc(int max_unused);
+
+/**
+ * Add a reference to a pool.
+ *
+ * @return pool
+ */
+AVFramePool *avcodec_frame_pool_ref(AVFramePool *pool);
+
+/**
+ * Drop a reference to a pool and set *pool to NULL. The pool and its unused
+ * buffers are freed along with the last reference.
+ */
+void avcodec_frame_pool_unref(AVFramePool **pool);
+
 /**
  * Return the amount of padding in pixels which the get_buffer callback must
  * provide around the edge of the image for codecs which do not have the
@@ -3547,6 +3680,14 @@ int avcodec_check_dimensions(void *av_log_ctx, unsigned int w, unsigned int h);
 
 enum PixelFormat avcodec_default_get_format(struct AVCodecContext *s, const enum PixelFormat * fmt);
 
+/**
+ * Set the number of threads used for decoding or encoding.
+ * If the codec has not been opened yet, the threads are started by
+ * avcodec_open(), which also selects the threading method from
+ * thread_type and the capabilities of the codec.
+ *
+ * @return 0 on success, a negative value otherwise
+ */
 int avcodec_thread_init(AVCodecContext *s, int thread_count);
 void avcodec_thread_free(AVCodecContext *s);
 int avcodec_default_execute(AVCodecContext *c, int (*func)(AVCodecContext *c2, void *arg2),void *arg, int *ret, int count, int size);
@@ -38,6 +38,7 @@
 #include "mathops.h"
 #include "rectangle.h"
 #include "vdpau_internal.h"
+#include "thread.h"
 #include "libavutil/avassert.h"
 
 #include "cabac.h"
@@ -246,6 +247,31 @@ int ff_h264_decode_rbsp_trailing(H264Context *h, const uint8_t *src){
     return 0;
 }
 
+/**
+ * Wait until the frame thread decoding a reference picture has finished the
+ * rows that the motion compensation of the current partition reads from.
+ * @param my     vertical luma motion vector of the partition, in quarter pels
+ * @param height height of the partition in luma rows
+ */
+static void await_reference_row(H264Context *h, Picture *ref, int my, int height){
+    MpegEncContext * const s = &h->s;
+    const int pic_height = 16*s->mb_height >> MB_FIELD;
+    int row = av_clip((my>>2) + height + 5, 0, pic_height - 1);
+
+    if(MB_FIELD){
+        int ref_field = (ref->reference & 3) == PICT_BOTTOM_FIELD;
+
+        if(ref->field_picture)
+            ff_thread_await_progress((AVFrame*)ref, row, ref_field);
+        else
+            ff_thread_await_progress((AVFrame*)ref, FFMIN(2*row + ref_field, 16*s->mb_height - 1), 0);
+    }else if(ref->field_picture){
+        ff_thread_await_progress((AVFrame*)ref,  row    >>1, 0);
+        ff_thread_await_progress((AVFrame*)ref, (row-1)>>1, 1);
+    }else
+        ff_thread_await_progress((AVFrame*)ref, row, 0);
+}
+
 static inline void mc_dir_part(H264Context *h, Picture *pic, int n, int square, int chroma_height, int delta, int list,
                            uint8_t *dest_y, uint8_t *dest_cb, uint8_t *dest_cr,
                            int src_x_offset, int src_y_offset,
@@ -267,6 +293,9 @@ static inline void mc_dir_part(H264Context *h, Picture *pic, int n, int square,
     if(mx&7) extra_width -= 3;
     if(my&7) extra_height -= 3;
 
+    if(s->avctx->active_thread_type & FF_THREAD_FRAME)
+        await_reference_row(h, pic, my, 2*chroma_height);
+
     if(   full_mx < 0-extra_width
        || full_my < 0-extra_height
        || full_mx + 16/*FIXME*/ > pic_width + extra_width
@@ -624,7 +653,7 @@ static void init_dequant_tables(H264Context *h){
 int ff_h264_alloc_tables(H264Context *h){
     MpegEncContext * const s = &h->s;
     const int big_mb_num= s->mb_stride * (s->mb_height+1);
-    const int row_mb_num= 2*s->mb_stride*s->avctx->thread_count;
+    const int row_mb_num= 2*s->mb_stride*ff_slice_context_count(s->avctx);
     int x,y;
 
     FF_ALLOCZ_OR_GOTO(h->s.avctx, h->intra4x4_pred_mode, row_mb_num * 8  * sizeof(uint8_t), fail)
@@ -833,6 +862,7 @@ int ff_h264_frame_start(H264Context *h){
      */
     s->current_picture_ptr->key_frame= 0;
     s->current_picture_ptr->mmco_reset= 0;
+    s->current_picture_ptr->field_picture= s->picture_structure != PICT_FRAME;
 
     assert(s->linesize && s->uvlinesize);
 
@@ -849,7 +879,7 @@ int ff_h264_frame_start(H264Context *h){
 
     /* can't be in alloc_tables because linesize isn't known there.
      * FIXME: redo bipred weight to not require extra buffer? */
-    for(i = 0; i < s->avctx->thread_count; i++)
+    for(i = 0; i < ff_slice_context_count(s->avctx); i++)
         if(h->thread_context[i] && !h->thread_context[i]->s.obmc_scratchpad)
             h->thread_context[i]->s.obmc_scratchpad = av_malloc(16*2*s->linesize + 8*2*s->uvlinesize);
 
@@ -1513,6 +1543,147 @@ static void init_scan_tables(H264Context *h){
     }
 }
 
+static int decode_init_thread_copy(AVCodecContext *avctx){
+    H264Context *h= avctx->priv_data;
+
+    if (!avctx->is_copy) return 0;
+    /* the parameter sets are copied from the other threads on every update */
+    memset(h->sps_buffers, 0, sizeof(h->sps_buffers));
+    memset(h->pps_buffers, 0, sizeof(h->pps_buffers));
+    h->rbsp_buffer[0] = h->rbsp_buffer[1] = NULL;
+    h->rbsp_buffer_size[0] = h->rbsp_buffer_size[1] = 0;
+    h->thread_context[0] = h;
+    h->s.avctx = avctx;
+
+    return 0;
+}
+
+static int copy_parameter_sets(void **to, void **from, int count, int size){
+    int i;
+
+    for(i=0; i<count; i++){
+        if(!from[i]){
+            av_freep(&to[i]);
+            continue;
+        }
+        if(!to[i] && !(to[i] = av_malloc(size)))
+            return AVERROR(ENOMEM);
+        memcpy(to[i], from[i], size);
+    }
+    return 0;
+}
+
+static int decode_update_thread_context(AVCodecContext *dst, const AVCodecContext *src){
+    H264Context *h= dst->priv_data, *h1= src->priv_data;
+    MpegEncContext * const s = &h->s, * const s1 = &h1->s;
+    int inited = s->context_initialized, err, i;
+
+    if(dst == src) return 0;
+
+    h->is_avc          = h1->is_avc;
+    h->nal_length_size = h1->nal_length_size;
+    h->x264_build      = h1->x264_build;
+
+    if((err = copy_parameter_sets((void**)h->sps_buffers, (void**)h1->sps_buffers, MAX_SPS_COUNT, sizeof(SPS))) < 0 ||
+       (err = copy_parameter_sets((void**)h->pps_buffers, (void**)h1->pps_buffers, MAX_PPS_COUNT, sizeof(PPS))) < 0)
+        return err;
+    h->sps = h1->sps;
+    h->pps = h1->pps;
+
+    if(!s1->context_initialized)
+        return 0;
+
+    if((err = ff_mpeg_update_thread_context(dst, src)) < 0)
+        return err;
+
+    if(!inited){
+        SPS *sps_buffers[MAX_SPS_COUNT];
+        PPS *pps_buffers[MAX_PPS_COUNT];
+
+        memcpy(sps_buffers, h->sps_buffers, sizeof(sps_buffers));
+        memcpy(pps_buffers, h->pps_buffers, sizeof(pps_buffers));
+        memcpy(&h->s + 1, &h1->s + 1, sizeof(H264Context) - sizeof(MpegEncContext));
+        memcpy(h->sps_buffers, sps_buffers, sizeof(sps_buffers));
+        memcpy(h->pps_buffers, pps_buffers, sizeof(pps_buffers));
+
+        memset(h->thread_context, 0, sizeof(h->thread_context));
+        h->thread_context[0] = h;
+        h->rbsp_buffer[0] = h->rbsp_buffer[1] = NULL;
+        h->rbsp_buffer_size[0] = h->rbsp_buffer_size[1] = 0;
+
+        if(ff_h264_alloc_tables(h) < 0 || context_init(h) < 0)
+            return AVERROR(ENOMEM);
+        init_scan_tables(h);
+        s->dsp.clear_blocks(h->mb);
+    }
+
+    /* the slice contexts allocate it in ff_h264_frame_start(), which the
+     * second field of a pair decoded by this thread does not call */
+    if(!s->obmc_scratchpad && s->linesize)
+        s->obmc_scratchpad = av_malloc(16*2*s->linesize + 8*2*s->uvlinesize);
+
+    memcpy(h->block_offset, h1->block_offset, sizeof(h->block_offset));
+
+    memcpy(h->dequant4_buffer, h1->dequant4_buffer, sizeof(h->dequant4_buffer));
+    memcpy(h->dequant8_buffer, h1->dequant8_buffer, sizeof(h->dequant8_buffer));
+    for(i=0; i<6; i++)
+        h->dequant4_coeff[i] = h1->dequant4_coeff[i] ? h->dequant4_buffer[0] + (h1->dequant4_coeff[i] - h1->dequant4_buffer[0]) : NULL;
+    for(i=0; i<2; i++)
+        h->dequant8_coeff[i] = h1->dequant8_coeff[i] ? h->dequant8_buffer[0] + (h1->dequant8_coeff[i] - h1->dequant8_buffer[0]) : NULL;
+    h->dequant_coeff_pps = h1->dequant_coeff_pps;
+
+    h->poc_lsb               = h1->poc_lsb;
+    h->poc_msb               = h1->poc_msb;
+    h->delta_poc_bottom      = h1->delta_poc_bottom;
+    h->delta_poc[0]          = h1->delta_poc[0];
+    h->delta_poc[1]          = h1->delta_poc[1];
+    h->prev_poc_msb          = h1->prev_poc_msb;
+    h->prev_poc_lsb          = h1->prev_poc_lsb;
+    h->frame_num             = h1->frame_num;
+    h->frame_num_offset      = h1->frame_num_offset;
+    h->prev_frame_num        = h1->prev_frame_num;
+    h->prev_frame_num_offset = h1->prev_frame_num_offset;
+    h->curr_pic_num          = h1->curr_pic_num;
+    h->max_pic_num           = h1->max_pic_num;
+
+    for(i=0; i<32; i++){
+        h->short_ref[i] = REBASE_PICTURE(h1->short_ref[i], s, s1);
+        h->long_ref[i]  = REBASE_PICTURE(h1->long_ref[i],  s, s1);
+    }
+    for(i=0; i<MAX_DELAYED_PIC_COUNT+2; i++)
+        h->delayed_pic[i] = REBASE_PICTURE(h1->delayed_pic[i], s, s1);
+    h->short_ref_count = h1->short_ref_count;
+    h->long_ref_count  = h1->long_ref_count;
+    /* I slices keep the lists of the previous picture, which the error
+     * concealment predicts from; stale lists of this thread could point to
+     * pictures that are decoded after this one */
+    memcpy(h->ref_list, h1->ref_list, sizeof(h->ref_list));
+
+    memcpy(h->mmco, h1->mmco, sizeof(h->mmco));
+    h->mmco_index = h1->mmco_index;
+
+    h->outputed_poc          = h1->outputed_poc;
+    h->prev_interlaced_frame = h1->prev_interlaced_frame;
+    h->last_slice_type       = h1->last_slice_type;
+
+    /* h1 left the reference picture marking of its picture to us */
+    if(h1->setup_finished){
+        if(!s->dropable){
+            ff_h264_execute_ref_pic_marking(h, h->mmco, h->mmco_index);
+            h->prev_poc_msb = h->poc_msb;
+            h->prev_poc_lsb = h->poc_lsb;
+        }
+        h->prev_frame_num_offset = h->frame_num_offset;
+        h->prev_frame_num        = h->frame_num;
+    }
+
+    /* the second field is decoded into the slice table of this thread */
+    if(s->first_field)
+        memset(h->slice_table, -1, (s->mb_height*s->mb_stride-1) * sizeof(*h->slice_table));
+
+    return 0;
+}
+
 static void field_end(H264Context *h){
     MpegEncContext * const s = &h->s;
     AVCodecContext * const avctx= s->avctx;
@@ -1524,13 +1695,17 @@ static void field_end(H264Context *h){
     if (CONFIG_H264_VDPAU_DECODER && s->avctx->codec->capabilities&CODEC_CAP_HWACCEL_VDPAU)
         ff_vdpau_h264_set_reference_frames(s);
 
-    if(!s->dropable) {
-        ff_h264_execute_ref_pic_marking(h, h->mmco, h->mmco_index);
-        h->prev_poc_msb= h->poc_msb;
-        h->prev_poc_lsb= h->poc_lsb;
+    /* once the setup is finished, the next frame thread does the marking
+     * itself in decode_update_thread_context() */
+    if(!h->setup_finished){
+        if(!s->dropable) {
+            ff_h264_execute_ref_pic_marking(h, h->mmco, h->mmco_index);
+            h->prev_poc_msb= h->poc_msb;
+            h->prev_poc_lsb= h->poc_lsb;
+        }
+        h->prev_frame_num_offset= h->frame_num_offset;
+        h->prev_frame_num= h->frame_num;
     }
-    h->prev_frame_num_offset= h->frame_num_offset;
-    h->prev_frame_num= h->frame_num;
 
     if (avctx->hwaccel) {
         if (avctx->hwaccel->end_frame(avctx) < 0)
@@ -1557,6 +1732,9 @@ static void field_end(H264Context *h){
 
     MPV_frame_end(s);
 
+    ff_thread_report_progress((AVFrame*)s->current_picture_ptr, INT_MAX,
+                              s->picture_structure == PICT_BOTTOM_FIELD);
+
     h->current_slice=0;
 }
 
@@ -1624,8 +1802,14 @@ static int decode_slice_header(H264Context *h, H264Context *h0){
         }
 
         h0->current_slice = 0;
-        if (!s0->first_field)
+        if (!s0->first_field){
+            /* a picture that was started but never finished must not
+             * block the frame threads predicting from it */
+            if(s0->current_picture_ptr)
+                ff_thread_report_progress((AVFrame*)s0->current_picture_ptr, INT_MAX,
+                                          s0->picture_structure == PICT_BOTTOM_FIELD);
             s->current_picture_ptr= NULL;
+        }
     }
 
     slice_type= get_ue_golomb_31(&s->gb);
@@ -1691,6 +1875,10 @@ static int decode_slice_header(H264Context *h, H264Context *h0){
             || av_cmp_q(h->sps.sar, s->avctx->sample_aspect_ratio))) {
         if(h != h0)
             return -1;   // width / height changed during parallelized decoding
+        if(s->avctx->active_thread_type & FF_THREAD_FRAME){
+            av_log(s->avctx, AV_LOG_ERROR, "Width/height changed during frame threaded decoding\n");
+            return -1;
+        }
         free_tables(h);
         flush_dpb(s->avctx);
         MPV_common_end(s);
@@ -1735,7 +1923,7 @@ static int decode_slice_header(H264Context *h, H264Context *h0){
         init_scan_tables(h);
         ff_h264_alloc_tables(h);
 
-        for(i = 1; i < s->avctx->thread_count; i++) {
+        for(i = 1; i < ff_slice_context_count(s->avctx); i++) {
             H264Context *c;
             c = h->thread_context[i] = av_malloc(sizeof(H264Context));
             memcpy(c, h->s.thread_context[i], sizeof(MpegEncContext));
@@ -1747,7 +1935,7 @@ static int decode_slice_header(H264Context *h, H264Context *h0){
             clone_tables(c, h, i);
         }
 
-        for(i = 0; i < s->avctx->thread_count; i++)
+        for(i = 0; i < ff_slice_context_count(s->avctx); i++)
             if(context_init(h->thread_context[i]) < 0)
                 return -1;
     }
@@ -1789,6 +1977,11 @@ static int decode_slice_header(H264Context *h, H264Context *h0){
              * be fixed. */
             if (h->short_ref_count) {
                 if (prev) {
+                    if (prev != s0->current_picture_ptr) {
+                        ff_thread_await_progress((AVFrame*)prev, INT_MAX, 0);
+                        if (prev->field_picture)
+                            ff_thread_await_progress((AVFrame*)prev, INT_MAX, 1);
+                    }
                     av_image_copy(h->short_ref[0]->data, h->short_ref[0]->linesize,
                                   (const uint8_t**)prev->data, prev->linesize,
                                   s->avctx->pix_fmt, s->mb_width*16, s->mb_height*16);
@@ -1796,6 +1989,8 @@ static int decode_slice_header(H264Context *h, H264Context *h0){
                 }
                 h->short_ref[0]->frame_num = h->prev_frame_num;
             }
+            ff_thread_report_progress((AVFrame*)s->current_picture_ptr, INT_MAX, 0);
+            ff_thread_report_progress((AVFrame*)s->current_picture_ptr, INT_MAX, 1);
         }
 
         /* See if we have a decoded first field looking for a pair... */
@@ -1810,6 +2005,8 @@ static int decode_slice_header(H264Context *h, H264Context *h0){
                  * Previous field is unmatched. Don't display it, but let it
                  * remain for reference if marked as such.
                  */
+                ff_thread_report_progress((AVFrame*)s0->current_picture_ptr, INT_MAX,
+                                          last_pic_structure == PICT_TOP_FIELD);
                 s0->current_picture_ptr = NULL;
                 s0->first_field = FIELD_PICTURE;
 
@@ -1823,6 +2020,8 @@ static int decode_slice_header(H264Context *h, H264Context *h0){
                      * pair. Throw away previous field except for reference
                      * purposes.
                      */
+                    ff_thread_report_progress((AVFrame*)s0->current_picture_ptr, INT_MAX,
+                                              last_pic_structure == PICT_TOP_FIELD);
                     s0->first_field = 1;
                     s0->current_picture_ptr = NULL;
 
@@ -2083,7 +2282,8 @@ static int decode_slice_header(H264Context *h, H264Context *h0){
                           +(h->ref_list[j][i].reference&3);
     }
 
-    h->emu_edge_width= (s->flags&CODEC_FLAG_EMU_EDGE) ? 0 : 16;
+    /* frame threads do not draw the picture edges, see MPV_frame_end() */
+    h->emu_edge_width= (s->flags&CODEC_FLAG_EMU_EDGE || s->avctx->active_thread_type&FF_THREAD_FRAME) ? 0 : 16;
     h->emu_edge_height= (FRAME_MBAFF || FIELD_PICTURE) ? 0 : h->emu_edge_width;
 
     if(s->avctx->debug&FF_DEBUG_PICT_INFO){
@@ -2334,7 +2534,7 @@ static int fill_filter_caches(H264Context *h, int mb_type){
     return 0;
 }
 
-static void loop_filter(H264Context *h){
+static void loop_filter(H264Context *h, int start_x, int end_x){
     MpegEncContext * const s = &h->s;
     uint8_t  *dest_y, *dest_cb, *dest_cr;
     int linesize, uvlinesize, mb_x, mb_y;
@@ -2342,7 +2542,7 @@ static void loop_filter(H264Context *h){
     const int old_slice_type= h->slice_type;
 
     if(h->deblocking_filter) {
-        for(mb_x= 0; mb_x<s->mb_width; mb_x++){
+        for(mb_x= start_x; mb_x<end_x; mb_x++){
             for(mb_y=end_mb_y - FRAME_MBAFF; mb_y<= end_mb_y; mb_y++){
                 int mb_xy, mb_type;
                 mb_xy = h->mb_xy = mb_x + mb_y*s->mb_stride;
@@ -2393,6 +2593,23 @@ static void loop_filter(H264Context *h){
     h->chroma_qp[1] = get_chroma_qp(h, 1, s->qscale);
 }
 
+/**
+ * Save the unfiltered bottom line of the just decoded macroblock row for
+ * the intra prediction of the next row, which loop_filter() does when
+ * it is called from decode_slice().
+ */
+static void backup_mb_row(H264Context *h){
+    MpegEncContext * const s = &h->s;
+
+    for(s->mb_x= 0; s->mb_x<s->mb_width; s->mb_x++){
+        backup_mb_border(h, s->current_picture.data[0] + (s->mb_x + s->mb_y * s->linesize  ) * 16,
+                            s->current_picture.data[1] + (s->mb_x + s->mb_y * s->uvlinesize) * 8,
+                            s->current_picture.data[2] + (s->mb_x + s->mb_y * s->uvlinesize) * 8,
+                            s->linesize, s->uvlinesize, 1);
+    }
+    s->mb_x= 0;
+}
+
 static void predict_field_decoding_flag(H264Context *h){
     MpegEncContext * const s = &h->s;
     const int mb_xy= s->mb_x + s->mb_y*s->mb_stride;
@@ -2404,6 +2621,25 @@ static void predict_field_decoding_flag(H264Context *h){
     h->mb_mbaff = h->mb_field_decoding_flag = IS_INTERLACED(mb_type) ? 1 : 0;
 }
 
+/**
+ * Report to the frame threads the lines of the current picture that can
+ * no longer change once the macroblock row at s->mb_y has been decoded
+ * and deblocked.
+ */
+static void report_decoded_row(H264Context *h){
+    MpegEncContext * const s = &h->s;
+    const int top = 16*(s->mb_y >> FIELD_PICTURE);
+    /* the deblocking of the next row still changes the bottom lines */
+    const int deblock_border = 3 << FRAME_MBAFF;
+
+    if(s->dropable)
+        return;
+
+    ff_thread_report_progress((AVFrame*)s->current_picture_ptr,
+                              top + (16 << FRAME_MBAFF) - 1 - deblock_border,
+                              s->picture_structure == PICT_BOTTOM_FIELD);
+}
+
 static int decode_slice(struct AVCodecContext *avctx, void *arg){
     H264Context *h = *(void**)arg;
     MpegEncContext * const s = &h->s;
@@ -2456,8 +2692,13 @@ static int decode_slice(struct AVCodecContext *avctx, void *arg){
 
             if( ++s->mb_x >= s->mb_width ) {
                 s->mb_x = 0;
-                loop_filter(h);
-                ff_draw_horiz_band(s, 16*s->mb_y, 16);
+                if(h->deblock_wavefront){
+                    backup_mb_row(h);
+                }else{
+                    loop_filter(h, 0, s->mb_width);
+                    ff_draw_horiz_band(s, 16*s->mb_y, 16);
+                    report_decoded_row(h);
+                }
                 ++s->mb_y;
                 if(FIELD_OR_MBAFF_PICTURE) {
                     ++s->mb_y;
@@ -2465,6 +2706,8 @@ static int decode_slice(struct AVCodecContext *avctx, void *arg){
                         predict_field_decoding_flag(h);
                 }
             }
+            if(h->deblock_wavefront)
+                ff_thread_report_progress2(s->avctx, 0, s->mb_y*s->mb_width + s->mb_x);
 
             if( eos || s->mb_y >= s->mb_height ) {
                 tprintf(s->avctx, "slice end %d %d\n", get_bits_count(&s->gb), s->gb.size_in_bits);
@@ -2496,8 +2739,13 @@ static int decode_slice(struct AVCodecContext *avctx, void *arg){
 
             if(++s->mb_x >= s->mb_width){
                 s->mb_x=0;
-                loop_filter(h);
-                ff_draw_horiz_band(s, 16*s->mb_y, 16);
+                if(h->deblock_wavefront){
+                    backup_mb_row(h);
+                }else{
+                    loop_filter(h, 0, s->mb_width);
+                    ff_draw_horiz_band(s, 16*s->mb_y, 16);
+                    report_decoded_row(h);
+                }
                 ++s->mb_y;
                 if(FIELD_OR_MBAFF_PICTURE) {
                     ++s->mb_y;
@@ -2519,6 +2767,9 @@ static int decode_slice(struct AVCodecContext *avctx, void *arg){
                 }
             }
 
+            if(h->deblock_wavefront)
+                ff_thread_report_progress2(s->avctx, 0, s->mb_y*s->mb_width + s->mb_x);
+
             if(get_bits_count(&s->gb) >= s->gb.size_in_bits && s->mb_skip_run<=0){
                 tprintf(s->avctx, "slice end %d %d\n", get_bits_count(&s->gb), s->gb.size_in_bits);
                 if(get_bits_count(&s->gb) == s->gb.size_in_bits ){
@@ -2582,6 +2833,80 @@ static int decode_slice(struct AVCodecContext *avctx, void *arg){
     return -1; //not reached
 }
 
+/**
+ * Copy the state used by loop_filter() to the context deblock_rows() runs on.
+ */
+static void clone_deblock_context(H264Context *dst, H264Context *src)
+{
+    dst->s.current_picture_ptr  = src->s.current_picture_ptr;
+    dst->s.current_picture      = src->s.current_picture;
+    dst->s.linesize             = src->s.linesize;
+    dst->s.uvlinesize           = src->s.uvlinesize;
+    dst->s.picture_structure    = src->s.picture_structure;
+    dst->s.qscale               = src->s.qscale;
+
+    dst->pps                    = src->pps;
+    dst->b_stride               = src->b_stride;
+    dst->mb_aff_frame           = src->mb_aff_frame;
+    dst->mb_mbaff               = src->mb_mbaff;
+    dst->mb_field_decoding_flag = src->mb_field_decoding_flag;
+    dst->slice_type             = src->slice_type;
+    dst->deblocking_filter      = src->deblocking_filter;
+    dst->slice_alpha_c0_offset  = src->slice_alpha_c0_offset;
+    dst->slice_beta_offset      = src->slice_beta_offset;
+    dst->qp_thresh              = src->qp_thresh;
+
+    memcpy(dst->ref2frm, src->ref2frm, sizeof(dst->ref2frm));
+}
+
+/**
+ * Deblock the macroblock rows reconstructed by decode_slice() in
+ * wavefront mode. Macroblock x of row y is filtered once macroblock
+ * x + 1 of row y + 1 has been reconstructed, since the intra
+ * prediction of the row below reads the unfiltered pixels around it.
+ */
+static void deblock_rows(H264Context *h, H264Context *hx, int start_mb_y){
+    MpegEncContext * const s = &h->s;
+    const int mb_width = s->mb_width;
+    const int mb_count = s->mb_height * mb_width;
+    int mb_x, mb_y;
+
+    for(mb_y= start_mb_y; mb_y<s->mb_height; mb_y++){
+        for(mb_x= 0; mb_x<mb_width; mb_x++){
+            int needed = (mb_y + 1) * mb_width + FFMIN(mb_x + 2, mb_width);
+
+            ff_thread_await_progress2(s->avctx, 0, FFMIN(needed, mb_count));
+            if(mb_y >= h->wavefront_end_mb_y)
+                return;
+
+            hx->s.mb_y = mb_y;
+            loop_filter(hx, mb_x, mb_x + 1);
+        }
+        ff_draw_horiz_band(s, 16*mb_y, 16);
+    }
+}
+
+/**
+ * Decode a slice and deblock it concurrently, see deblock_rows().
+ * Job 0 decodes the macroblocks in h->thread_context[0], job 1 filters
+ * them in h->thread_context[1].
+ */
+static int decode_slice_wavefront(struct AVCodecContext *avctx, void *arg, int jobnr, int threadnr){
+    H264Context *h = ((H264Context**)arg)[0];
+    H264Context *hx = ((H264Context**)arg)[1];
+    int ret;
+
+    if(jobnr){
+        deblock_rows(h, hx, h->s.resync_mb_y);
+        return 0;
+    }
+
+    ret = decode_slice(avctx, arg);
+    h->wavefront_end_mb_y = h->s.mb_y;
+    ff_thread_report_progress2(avctx, 0, INT_MAX);
+    return ret;
+}
+
 /**
  * Call decode_slice() for each context.
  *
@@ -2599,7 +2924,19 @@ static void execute_decode_slices(H264Context *h, int context_count){
     if(s->avctx->codec->capabilities&CODEC_CAP_HWACCEL_VDPAU)
         return;
     if(context_count == 1) {
-        decode_slice(avctx, &h);
+        /* Frame pictures decoded on a single context can still have their
+         * deblocking done by another thread, behind the reconstruction. */
+        if(ff_slice_context_count(avctx) > 1 && h->deblocking_filter && !FRAME_MBAFF &&
+           s->picture_structure == PICT_FRAME && s->codec_id == CODEC_ID_H264 &&
+           ff_thread_alloc_progress2(avctx, 1) >= 0) {
+            hx = h->thread_context[1];
+            clone_deblock_context(hx, h);
+            h->wavefront_end_mb_y = s->mb_height;
+            h->deblock_wavefront = 1;
+            avctx->execute2(avctx, decode_slice_wavefront, h->thread_context, NULL, 2);
+            h->deblock_wavefront = 0;
+        } else
+            decode_slice(avctx, &h);
     } else {
         for(i = 1; i < context_count; i++) {
             hx = h->thread_context[i];
@@ -2622,6 +2959,215 @@ static void execute_decode_slices(H264Context *h, int context_count){
 }
 
 
+/**
+ * Choose the picture to return for the current packet, once the current
+ * picture is known to be complete (a frame or the second field of a pair).
+ * Only the slice headers of the current picture have to be decoded, so
+ * frame threads may call this before decoding the slice data.
+ */
+static void decode_postinit(H264Context *h){
+    MpegEncContext * const s = &h->s;
+    Picture *out = s->current_picture_ptr;
+    Picture *cur = s->current_picture_ptr;
+    int i, pics, out_of_order, out_idx;
+
+    s->current_picture_ptr->qscale_type= FF_QSCALE_TYPE_H264;
+    s->current_picture_ptr->pict_type= s->pict_type;
+
+    if (cur->field_poc[0]==INT_MAX || cur->field_poc[1]==INT_MAX) {
+        /* Wait for second field. */
+        return;
+    }
+
+    cur->interlaced_frame = 0;
+    cur->repeat_pict = 0;
+
+    /* Signal interlacing information externally. */
+    /* Prioritize picture timing SEI information over used decoding process if it exists. */
+
+    if(h->sps.pic_struct_present_flag){
+        switch (h->sei_pic_struct)
+        {
+        case SEI_PIC_STRUCT_FRAME:
+            break;
+        case SEI_PIC_STRUCT_TOP_FIELD:
+        case SEI_PIC_STRUCT_BOTTOM_FIELD:
+            cur->interlaced_frame = 1;
+            break;
+        case SEI_PIC_STRUCT_TOP_BOTTOM:
+        case SEI_PIC_STRUCT_BOTTOM_TOP:
+            if (FIELD_OR_MBAFF_PICTURE)
+                cur->interlaced_frame = 1;
+            else
+                // try to flag soft telecine progressive
+                cur->interlaced_frame = h->prev_interlaced_frame;
+            break;
+        case SEI_PIC_STRUCT_TOP_BOTTOM_TOP:
+        case SEI_PIC_STRUCT_BOTTOM_TOP_BOTTOM:
+            // Signal the possibility of telecined film externally (pic_struct 5,6)
+            // From these hints, let the applications decide if they apply deinterlacing.
+            cur->repeat_pict = 1;
+            break;
+        case SEI_PIC_STRUCT_FRAME_DOUBLING:
+            // Force progressive here, as doubling interlaced frame is a bad idea.
+            cur->repeat_pict = 2;
+            break;
+        case SEI_PIC_STRUCT_FRAME_TRIPLING:
+            cur->repeat_pict = 4;
+            break;
+        }
+
+        if ((h->sei_ct_type & 3) && h->sei_pic_struct <= SEI_PIC_STRUCT_BOTTOM_TOP)
+            cur->interlaced_frame = (h->sei_ct_type & (1<<1)) != 0;
+    }else{
+        /* Derive interlacing flag from used decoding process. */
+        cur->interlaced_frame = FIELD_OR_MBAFF_PICTURE;
+    }
+    h->prev_interlaced_frame = cur->interlaced_frame;
+
+    if (cur->field_poc[0] != cur->field_poc[1]){
+        /* Derive top_field_first from field pocs. */
+        cur->top_field_first = cur->field_poc[0] < cur->field_poc[1];
+    }else{
+        if(cur->interlaced_frame || h->sps.pic_struct_present_flag){
+            /* Use picture timing SEI information. Even if it is a information of a past frame, better than nothing. */
+            if(h->sei_pic_struct == SEI_PIC_STRUCT_TOP_BOTTOM
+              || h->sei_pic_struct == SEI_PIC_STRUCT_TOP_BOTTOM_TOP)
+                cur->top_field_first = 1;
+            else
+                cur->top_field_first = 0;
+        }else{
+            /* Most likely progressive */
+            cur->top_field_first = 0;
+        }
+    }
+
+//FIXME do something with unavailable reference frames
+
+    /* Sort B-frames into display order */
+
+    if(h->sps.bitstream_restriction_flag
+       && s->avctx->has_b_frames < h->sps.num_reorder_frames){
+        s->avctx->has_b_frames = h->sps.num_reorder_frames;
+        s->low_delay = 0;
+    }
+
+    if(   s->avctx->strict_std_compliance >= FF_COMPLIANCE_STRICT
+       && !h->sps.bitstream_restriction_flag){
+        s->avctx->has_b_frames= MAX_DELAYED_PIC_COUNT;
+        s->low_delay= 0;
+    }
+
+    pics = 0;
+    while(h->delayed_pic[pics]) pics++;
+
+    assert(pics <= MAX_DELAYED_PIC_COUNT);
+
+    h->delayed_pic[pics++] = cur;
+    if(cur->reference == 0)
+        cur->reference = DELAYED_PIC_REF;
+
+    out = h->delayed_pic[0];
+    out_idx = 0;
+    for(i=1; h->delayed_pic[i] && !h->delayed_pic[i]->key_frame && !h->delayed_pic[i]->mmco_reset; i++)
+        if(h->delayed_pic[i]->poc < out->poc){
+            out = h->delayed_pic[i];
+            out_idx = i;
+        }
+    if(s->avctx->has_b_frames == 0 && (h->delayed_pic[0]->key_frame || h->delayed_pic[0]->mmco_reset))
+        h->outputed_poc= INT_MIN;
+    out_of_order = out->poc < h->outputed_poc;
+
+    if(h->sps.bitstream_restriction_flag && s->avctx->has_b_frames >= h->sps.num_reorder_frames)
+        { }
+    else if((out_of_order && pics-1 == s->avctx->has_b_frames && s->avctx->has_b_frames < MAX_DELAYED_PIC_COUNT)
+       || (s->low_delay &&
+        ((h->outputed_poc != INT_MIN && out->poc > h->outputed_poc + 2)
+         || cur->pict_type == FF_B_TYPE)))
+    {
+        s->low_delay = 0;
+        s->avctx->has_b_frames++;
+    }
+
+    if(out_of_order || pics > s->avctx->has_b_frames){
+        out->reference &= ~DELAYED_PIC_REF;
+        for(i=out_idx; h->delayed_pic[i]; i++)
+            h->delayed_pic[i] = h->delayed_pic[i+1];
+    }
+    if(!out_of_order && pics > s->avctx->has_b_frames){
+        h->next_output_pic = out;
+        if(out_idx==0 && h->delayed_pic[0] && (h->delayed_pic[0]->key_frame || h->delayed_pic[0]->mmco_reset)) {
+            h->outputed_poc = INT_MIN;
+        } else
+            h->outputed_poc = out->poc;
+    }else{
+        av_log(s->avctx, AV_LOG_DEBUG, "no picture\n");
+    }
+}
+
+/**
+ * @return 1 if the reference picture marking of the current picture
+ *         contains a memory_management_control_operation 5, 0 otherwise
+ */
+static int has_mmco_reset(H264Context *h){
+    int i;
+    for(i=0; i<h->mmco_index; i++)
+        if(h->mmco[i].opcode == MMCO_RESET)
+            return 1;
+    return 0;
+}
+
+/**
+ * Find the last NAL unit of a packet that the next frame thread depends on:
+ * the last parameter set or the first slice of the last picture.
+ * Only the NAL unit headers are looked at.
+ *
+ * @return offset of the NAL unit header in buf
+ */
+static int find_last_needed_nal(H264Context *h, const uint8_t *buf, int buf_size){
+    int buf_index=0, last_needed=0;
+    int next_avc= h->is_avc ? 0 : buf_size;
+
+    for(;;){
+        int i, nalsize = 0;
+
+        if(buf_index >= next_avc) {
+            if(buf_index >= buf_size) break;
+            for(i = 0; i < h->nal_length_size; i++)
+                nalsize = (nalsize << 8) | buf[buf_index++];
+            if(nalsize <= 0 || nalsize > buf_size - buf_index)
+                break;
+            next_avc= buf_index + nalsize;
+        } else {
+            for(; buf_index + 3 < next_avc; buf_index++){
+                if(buf[buf_index] == 0 && buf[buf_index+1] == 0 && buf[buf_index+2] == 1)
+                    break;
+            }
+
+            if(buf_index+3 >= buf_size) break;
+
+            buf_index+=3;
+            if(buf_index >= next_avc) continue;
+        }
+
+        switch(buf[buf_index] & 0x1F){
+        case NAL_SPS:
+        case NAL_PPS:
+            last_needed = buf_index;
+            break;
+        case NAL_IDR_SLICE:
+        case NAL_SLICE:
+            /* first_mb_in_slice == 0 is coded as a single set bit */
+            if(buf_index+1 < next_avc && (buf[buf_index+1] & 0x80))
+                last_needed = buf_index;
+            break;
+        }
+
+        buf_index = h->is_avc ? next_avc : buf_index+1;
+    }
+    return last_needed;
+}
+
 static int decode_nal_units(H264Context *h, const uint8_t *buf, int buf_size){
     MpegEncContext * const s = &h->s;
     AVCodecContext * const avctx= s->avctx;
@@ -2629,8 +3175,11 @@ static int decode_nal_units(H264Context *h, const uint8_t *buf, int buf_size){
     H264Context *hx; ///< thread context
     int context_count = 0;
     int next_avc= h->is_avc ? 0 : buf_size;
+    int last_needed_nal= buf_size;
 
-    h->max_contexts = avctx->thread_count;
+    h->max_contexts = ff_slice_context_count(avctx);
+    if(avctx->active_thread_type & FF_THREAD_FRAME)
+        last_needed_nal= find_last_needed_nal(h, buf, buf_size);
 #if 0
     int i;
     for(i=0; i<50; i++){
@@ -2735,6 +3284,16 @@ static int decode_nal_units(H264Context *h, const uint8_t *buf, int buf_size){
             s->current_picture_ptr->key_frame |=
                     (hx->nal_unit_type == NAL_IDR_SLICE) ||
                     (h->sei_recovery_frame_cnt >= 0);
+
+            /* Everything the next frame thread needs is known once the
+             * header of the last picture in the packet has been parsed,
+             * unless the picture is a first field or resets the POCs. */
+            if(h->current_slice == 1 && buf_index - consumed >= last_needed_nal &&
+               !(FIELD_PICTURE && s->first_field) && !has_mmco_reset(h)){
+                decode_postinit(h);
+                h->setup_finished = 1;
+                ff_thread_finish_setup(avctx);
+            }
             if(hx->redundant_pic_count==0 && hx->s.hurry_up < 5
                && (avctx->skip_frame < AVDISCARD_NONREF || hx->nal_ref_idc)
                && (avctx->skip_frame < AVDISCARD_BIDIR  || hx->slice_type_nos!=FF_B_TYPE)
@@ -2857,6 +3416,8 @@ static int decode_frame(AVCodecContext *avctx,
 
     s->flags= avctx->flags;
     s->flags2= avctx->flags2;
+    h->next_output_pic = NULL;
+    h->setup_finished = 0;
 
    /* end of stream, output what is still in the buffers */
  out:
@@ -2885,8 +3446,14 @@ static int decode_frame(AVCodecContext *avctx,
     }
 
     buf_index=decode_nal_units(h, buf, buf_size);
-    if(buf_index < 0)
+    if(buf_index < 0){
+        /* do not leave frame threads waiting for an unfinished picture */
+        if(s->current_picture_ptr){
+            ff_thread_report_progress((AVFrame*)s->current_picture_ptr, INT_MAX, 0);
+            ff_thread_report_progress((AVFrame*)s->current_picture_ptr, INT_MAX, 1);
+        }
         return -1;
+    }
 
     if (!s->current_picture_ptr && h->nal_unit_type == NAL_END_SEQUENCE) {
         buf_size = 0;
@@ -2900,143 +3467,14 @@ static int decode_frame(AVCodecContext *avctx,
     }
 
     if(!(s->flags2 & CODEC_FLAG2_CHUNKS) || (s->mb_y >= s->mb_height && s->mb_height)){
-        Picture *out = s->current_picture_ptr;
-        Picture *cur = s->current_picture_ptr;
-        int i, pics, out_of_order, out_idx;
-
         field_end(h);
 
-        if (cur->field_poc[0]==INT_MAX || cur->field_poc[1]==INT_MAX) {
-            /* Wait for second field. */
-            *data_size = 0;
-
-        } else {
-            cur->interlaced_frame = 0;
-            cur->repeat_pict = 0;
-
-            /* Signal interlacing information externally. */
-            /* Prioritize picture timing SEI information over used decoding process if it exists. */
+        if(!h->setup_finished)
+            decode_postinit(h);
 
-            if(h->sps.pic_struct_present_flag){
-                switch (h->sei_pic_struct)
-                {
-                case SEI_PIC_STRUCT_FRAME:
-                    break;
-                case SEI_PIC_STRUCT_TOP_FIELD:
-                case SEI_PIC_STRUCT_BOTTOM_FIELD:
-                    cur->interlaced_frame = 1;
-                    break;
-                case SEI_PIC_STRUCT_TOP_BOTTOM:
-                case SEI_PIC_STRUCT_BOTTOM_TOP:
-                    if (FIELD_OR_MBAFF_PICTURE)
-                        cur->interlaced_frame = 1;
-                    else
-                        // try to flag soft telecine progressive
-                        cur->interlaced_frame = h->prev_interlaced_frame;
-                    break;
-                case SEI_PIC_STRUCT_TOP_BOTTOM_TOP:
-                case SEI_PIC_STRUCT_BOTTOM_TOP_BOTTOM:
-                    // Signal the possibility of telecined film externally (pic_struct 5,6)
-                    // From these hints, let the applications decide if they apply deinterlacing.
-                    cur->repeat_pict = 1;
-                    break;
-                case SEI_PIC_STRUCT_FRAME_DOUBLING:
-                    // Force progressive here, as doubling interlaced frame is a bad idea.
-                    cur->repeat_pict = 2;
-                    break;
-                case SEI_PIC_STRUCT_FRAME_TRIPLING:
-                    cur->repeat_pict = 4;
-                    break;
-                }
-
-                if ((h->sei_ct_type & 3) && h->sei_pic_struct <= SEI_PIC_STRUCT_BOTTOM_TOP)
-                    cur->interlaced_frame = (h->sei_ct_type & (1<<1)) != 0;
-            }else{
-                /* Derive interlacing flag from used decoding process. */
-                cur->interlaced_frame = FIELD_OR_MBAFF_PICTURE;
-            }
-            h->prev_interlaced_frame = cur->interlaced_frame;
-
-            if (cur->field_poc[0] != cur->field_poc[1]){
-                /* Derive top_field_first from field pocs. */
-                cur->top_field_first = cur->field_poc[0] < cur->field_poc[1];
-            }else{
-                if(cur->interlaced_frame || h->sps.pic_struct_present_flag){
-                    /* Use picture timing SEI information. Even if it is a information of a past frame, better than nothing. */
-                    if(h->sei_pic_struct == SEI_PIC_STRUCT_TOP_BOTTOM
-                      || h->sei_pic_struct == SEI_PIC_STRUCT_TOP_BOTTOM_TOP)
-                        cur->top_field_first = 1;
-                    else
-                        cur->top_field_first = 0;
-                }else{
-                    /* Most likely progressive */
-                    cur->top_field_first = 0;
-                }
-            }
-
-        //FIXME do something with unavailable reference frames
-
-            /* Sort B-frames into display order */
-
-            if(h->sps.bitstream_restriction_flag
-               && s->avctx->has_b_frames < h->sps.num_reorder_frames){
-                s->avctx->has_b_frames = h->sps.num_reorder_frames;
-                s->low_delay = 0;
-            }
-
-            if(   s->avctx->strict_std_compliance >= FF_COMPLIANCE_STRICT
-               && !h->sps.bitstream_restriction_flag){
-                s->avctx->has_b_frames= MAX_DELAYED_PIC_COUNT;
-                s->low_delay= 0;
-            }
-
-            pics = 0;
-            while(h->delayed_pic[pics]) pics++;
-
-            assert(pics <= MAX_DELAYED_PIC_COUNT);
-
-            h->delayed_pic[pics++] = cur;
-            if(cur->reference == 0)
-                cur->reference = DELAYED_PIC_REF;
-
-            out = h->delayed_pic[0];
-            out_idx = 0;
-            for(i=1; h->delayed_pic[i] && !h->delayed_pic[i]->key_frame && !h->delayed_pic[i]->mmco_reset; i++)
-                if(h->delayed_pic[i]->poc < out->poc){
-                    out = h->delayed_pic[i];
-                    out_idx = i;
-                }
-            if(s->avctx->has_b_frames == 0 && (h->delayed_pic[0]->key_frame || h->delayed_pic[0]->mmco_reset))
-                h->outputed_poc= INT_MIN;
-            out_of_order = out->poc < h->outputed_poc;
-
-            if(h->sps.bitstream_restriction_flag && s->avctx->has_b_frames >= h->sps.num_reorder_frames)
-                { }
-            else if((out_of_order && pics-1 == s->avctx->has_b_frames && s->avctx->has_b_frames < MAX_DELAYED_PIC_COUNT)
-               || (s->low_delay &&
-                ((h->outputed_poc != INT_MIN && out->poc > h->outputed_poc + 2)
-                 || cur->pict_type == FF_B_TYPE)))
-            {
-                s->low_delay = 0;
-                s->avctx->has_b_frames++;
-            }
-
-            if(out_of_order || pics > s->avctx->has_b_frames){
-                out->reference &= ~DELAYED_PIC_REF;
-                for(i=out_idx; h->delayed_pic[i]; i++)
-                    h->delayed_pic[i] = h->delayed_pic[i+1];
-            }
-            if(!out_of_order && pics > s->avctx->has_b_frames){
-                *data_size = sizeof(AVFrame);
-
-                if(out_idx==0 && h->delayed_pic[0] && (h->delayed_pic[0]->key_frame || h->delayed_pic[0]->mmco_reset)) {
-                    h->outputed_poc = INT_MIN;
-                } else
-                    h->outputed_poc = out->poc;
-                *pict= *(AVFrame*)out;
-            }else{
-                av_log(avctx, AV_LOG_DEBUG, "no picture\n");
-            }
+        if(h->next_output_pic){
+            *data_size = sizeof(AVFrame);
+            *pict= *(AVFrame*)h->next_output_pic;
         }
     }
 
@@ -3279,9 +3717,11 @@ AVCodec h264_decoder = {
     NULL,
     ff_h264_decode_end,
     decode_frame,
-    /*CODEC_CAP_DRAW_HORIZ_BAND |*/ CODEC_CAP_DR1 | CODEC_CAP_DELAY,
+    /*CODEC_CAP_DRAW_HORIZ_BAND |*/ CODEC_CAP_DR1 | CODEC_CAP_DELAY | CODEC_CAP_FRAME_THREADS,
     .flush= flush_dpb,
     .long_name = NULL_IF_CONFIG_SMALL("H.264 / AVC / MPEG-4 AVC / MPEG-4 part 10"),
+    .init_thread_copy      = ONLY_IF_THREADS_ENABLED(decode_init_thread_copy),
+    .update_thread_context = ONLY_IF_THREADS_ENABLED(decode_update_thread_context),
 };
 
 #if CONFIG_H264_VDPAU_DECODER
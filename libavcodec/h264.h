@@ -543,6 +543,32 @@ typedef struct H264Context{
     int single_decode_warning;
 
     int last_slice_type;
+
+    /**
+     * 1 if decode_slice() leaves the deblocking to deblock_rows(), which
+     * runs as a second execute2() job one macroblock row behind it.
+     */
+    int deblock_wavefront;
+
+    /**
+     * First macroblock row that decode_slice() did not complete.
+     * Set before the final progress report in wavefront mode.
+     */
+    int wavefront_end_mb_y;
+    /** @} */
+
+    /**
+     * @defgroup frame_threading Members for frame based multithreading
+     * @{
+     */
+    /**
+     * 1 if ff_thread_finish_setup() was called before the current picture
+     * was decoded. Its reference picture marking is then left to the
+     * next frame thread, see decode_update_thread_context().
+     */
+    int setup_finished;
+
+    Picture *next_output_pic; ///< picture decode_postinit() chose to return for the current packet
     /** @} */
 
     /**
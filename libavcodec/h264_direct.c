@@ -31,6 +31,7 @@
 #include "mpegvideo.h"
 #include "h264.h"
 #include "rectangle.h"
+#include "thread.h"
 
 //#undef NDEBUG
 #include <assert.h>
@@ -581,7 +582,32 @@ single_col:
     }
 }
 
+/**
+ * Wait until the frame thread decoding the colocated picture has decoded
+ * the macroblocks that the direct prediction of the current one reads.
+ */
+static void await_colocated_mb(H264Context * const h){
+    MpegEncContext * const s = &h->s;
+    Picture * const ref = &h->ref_list[1][0];
+
+    if(ref->field_picture){
+        ff_thread_await_progress((AVFrame*)ref, 16*(s->mb_y>>1), 0);
+        ff_thread_await_progress((AVFrame*)ref, 16*(s->mb_y>>1), 1);
+    }else if(FIELD_OR_MBAFF_PICTURE || ref->mbaff)
+        ff_thread_await_progress((AVFrame*)ref, 16*(s->mb_y|1), 0);
+    else
+        ff_thread_await_progress((AVFrame*)ref, 16*s->mb_y, 0);
+}
+
 void ff_h264_pred_direct_motion(H264Context * const h, int *mb_type){
+    MpegEncContext * const s = &h->s;
+
+    /* the colocated picture is the first field of the current frame when
+     * decoding the second one, and that field is complete already */
+    if((s->avctx->active_thread_type & FF_THREAD_FRAME) &&
+       h->ref_list[1][0].thread_opaque != s->current_picture_ptr->thread_opaque)
+        await_colocated_mb(h);
+
     if(h->direct_spatial_mv_pred){
         pred_spatial_direct_motion(h, mb_type);
     }else{
@@ -58,6 +58,14 @@ enum OutputFormat {
 
 #define MAX_PICTURE_COUNT 32
 
+/**
+ * Map a Picture pointer from the picture array of one frame thread
+ * context to the same entry in another one.
+ * Pointers outside the picture array (static copies) become NULL.
+ */
+#define REBASE_PICTURE(pic, new_ctx, old_ctx) (pic && pic >= old_ctx->picture && pic < old_ctx->picture+old_ctx->picture_count ?\
+                                                &new_ctx->picture[pic - old_ctx->picture] : NULL)
+
 #define ME_MAP_SIZE 64
 #define ME_MAP_SHIFT 3
 #define ME_MAP_MV_BITS 11
@@ -123,6 +131,7 @@ typedef struct Picture{
     int ref_poc[2][2][16];      ///< h264 POCs of the frames used as reference (FIXME need per slice)
     int ref_count[2][2];        ///< number of entries in ref_poc              (FIXME need per slice)
     int mbaff;                  ///< h264 1 -> MBAFF frame 0-> not MBAFF
+    int field_picture;          ///< whether or not the picture was encoded in separate fields
 
     int mb_var_sum;             ///< sum of MB variance for current frame
     int mc_mb_var_sum;          ///< motion compensated MB variance for current frame
@@ -131,6 +140,7 @@ typedef struct Picture{
     uint8_t *mb_mean;           ///< Table for MB luminance
     int32_t *mb_cmp_score;      ///< Table for MB cmp scores, for mb decision FIXME remove
     int b_frame_score;          /* */
+    struct MpegEncContext *owner2; ///< pointer to the MpegEncContext that allocated this picture
 } Picture;
 
 struct MpegEncContext;
@@ -244,8 +254,11 @@ typedef struct MpegEncContext {
     int linesize;              ///< line size, in bytes, may be different from width
     int uvlinesize;            ///< line size, for chroma in bytes, may be different from width
     Picture *picture;          ///< main picture buffer
+    int picture_count;         ///< number of allocated pictures (MAX_PICTURE_COUNT * avctx->thread_count)
+    int picture_range_start, picture_range_end; ///< the part of picture that this context can allocate in
     Picture **input_picture;   ///< next pictures on display order for encoding
     Picture **reordered_input_picture; ///< pointer to the next pictures in codedorder for encoding
+    struct AVCodecContext *b_count_ctx[FF_MAX_B_FRAMES+1]; ///< downscaled encoders used by b_frame_strategy 2, one per B-frame count
 
     int start_mb_y;            ///< start mb_y of this thread (so current thread should process start_mb_y <= row < end_mb_y)
     int end_mb_y;              ///< end   mb_y of this thread (so current thread should process start_mb_y <= row < end_mb_y)
@@ -696,6 +709,7 @@ void MPV_common_init_bfin(MpegEncContext *s);
 void ff_clean_intra_table_entries(MpegEncContext *s);
 void ff_draw_horiz_band(MpegEncContext *s, int y, int h);
 void ff_mpeg_flush(AVCodecContext *avctx);
+int ff_mpeg_update_thread_context(AVCodecContext *dst, const AVCodecContext *src);
 void ff_print_debug_info(MpegEncContext *s, AVFrame *pict);
 void ff_write_quant_matrix(PutBitContext *pb, uint16_t *matrix);
 int ff_find_unused_picture(MpegEncContext *s, int shared);
@@ -724,6 +738,14 @@ int ff_alloc_picture(MpegEncContext *s, Picture *pic, int shared);
 extern const enum PixelFormat ff_pixfmt_list_420[];
 extern const enum PixelFormat ff_hwaccel_pixfmt_list_420[];
 
+/**
+ * Return the number of slice thread contexts.
+ * Frame threads decode each picture with a single context.
+ */
+static inline int ff_slice_context_count(AVCodecContext *avctx){
+    return avctx->active_thread_type & FF_THREAD_FRAME ? 1 : avctx->thread_count;
+}
+
 static inline void ff_update_block_index(MpegEncContext *s){
     const int block_size= 8>>s->avctx->lowres;
 
@@ -759,11 +759,32 @@ av_cold int MPV_encode_init(AVCodecContext *avctx)
     return 0;
 }
 
+/**
+ * Free the encoders opened by get_b_count_context().
+ * This runs inside avcodec_close() of the main encoder, which does not
+ * nest, so the codec is closed directly like the frame thread copies are.
+ */
+static void free_b_count_contexts(MpegEncContext *s){
+    int i;
+
+    for(i=0; i<FF_ARRAY_ELEMS(s->b_count_ctx); i++){
+        AVCodecContext *c= s->b_count_ctx[i];
+
+        if(!c)
+            continue;
+        c->codec->close(c);
+        avcodec_default_free_buffers(c);
+        av_freep(&c->priv_data);
+        av_freep(&s->b_count_ctx[i]);
+    }
+}
+
 av_cold int MPV_encode_end(AVCodecContext *avctx)
 {
     MpegEncContext *s = avctx->priv_data;
 
     ff_rate_control_uninit(s);
+    free_b_count_contexts(s);
 
     MPV_common_end(s);
     if ((CONFIG_MJPEG_ENCODER || CONFIG_LJPEG_ENCODER) && s->out_format == FMT_MJPEG)
@@ -951,27 +972,95 @@ static int skip_check(MpegEncContext *s, Picture *p, Picture *ref){
     return 0;
 }
 
-static int estimate_best_b_count(MpegEncContext *s){
-    AVCodec *codec= avcodec_find_encoder(s->avctx->codec_id);
-    AVCodecContext *c= avcodec_alloc_context();
+/**
+ * One candidate B-frame count tried by estimate_best_b_count().
+ */
+typedef struct BFrameCandidate {
+    AVCodecContext *c;          ///< downscaled encoder private to this candidate
+    AVFrame *input;             ///< downscaled input pictures, shared read only
+    int b_frames;               ///< number of consecutive B-frames to try
+    int max_b_frames;
+    int p_lambda, b_lambda, lambda2;
+    int64_t rd;                 ///< rate distortion cost, set by encode_b_candidate_thread()
+} BFrameCandidate;
+
+/**
+ * Clear what the previous decision left in a candidate encoder.
+ * The stale motion vectors would otherwise be used as predictors, so
+ * the result would depend on earlier decisions.
+ */
+static void reset_b_count_context(AVCodecContext *c){
+    MpegEncContext *s= c->priv_data;
+    const int mv_table_size= ((s->mb_height+2) * s->mb_stride + 1) * 2 * sizeof(int16_t);
+
+    memset(s->p_mv_table_base           , 0, mv_table_size);
+    memset(s->b_forw_mv_table_base      , 0, mv_table_size);
+    memset(s->b_back_mv_table_base      , 0, mv_table_size);
+    memset(s->b_bidir_forw_mv_table_base, 0, mv_table_size);
+    memset(s->b_bidir_back_mv_table_base, 0, mv_table_size);
+    memset(s->b_direct_mv_table_base    , 0, mv_table_size);
+    c->error[0]= c->error[1]= c->error[2]= 0;
+}
+
+static int encode_b_candidate_thread(AVCodecContext *avctx, void *arg){
+    BFrameCandidate *cand= arg;
+    AVCodecContext *c= cand->c;
     AVFrame input[FF_MAX_B_FRAMES+2];
-    const int scale= s->avctx->brd_scale;
-    int i, j, out_size, p_lambda, b_lambda, lambda2;
-    int outbuf_size= s->width * s->height; //FIXME
+    int outbuf_size= c->width * c->height << 2; //FIXME
     uint8_t *outbuf= av_malloc(outbuf_size);
-    int64_t best_rd= INT64_MAX;
-    int best_b_count= -1;
+    int64_t rd=0;
+    int i, out_size;
 
-    assert(scale>=0 && scale <=3);
+    cand->rd= INT64_MAX;
+    if(!outbuf)
+        return -1;
 
-//    emms_c();
-    p_lambda= s->last_lambda_for[FF_P_TYPE]; //s->next_picture_ptr->quality;
-    b_lambda= s->last_lambda_for[FF_B_TYPE]; //p_lambda *FFABS(s->avctx->b_quant_factor) + s->avctx->b_quant_offset;
-    if(!b_lambda) b_lambda= p_lambda; //FIXME we should do this somewhere else
-    lambda2= (b_lambda*b_lambda + (1<<FF_LAMBDA_SHIFT)/2 ) >> FF_LAMBDA_SHIFT;
+    /* the encoder writes to the AVFrame fields, so each candidate needs its own copy */
+    memcpy(input, cand->input, (cand->max_b_frames+2)*sizeof(AVFrame));
+    reset_b_count_context(c);
+
+    input[0].pict_type= FF_I_TYPE;
+    input[0].quality= 1 * FF_QP2LAMBDA;
+    out_size = avcodec_encode_video(c, outbuf, outbuf_size, &input[0]);
+//    rd += (out_size * lambda2) >> FF_LAMBDA_SHIFT;
 
-    c->width = s->width >> scale;
-    c->height= s->height>> scale;
+    for(i=0; i<cand->max_b_frames+1; i++){
+        int is_p= i % (cand->b_frames+1) == cand->b_frames || i==cand->max_b_frames;
+
+        input[i+1].pict_type= is_p ? FF_P_TYPE : FF_B_TYPE;
+        input[i+1].quality= is_p ? cand->p_lambda : cand->b_lambda;
+        out_size = avcodec_encode_video(c, outbuf, outbuf_size, &input[i+1]);
+        rd += (out_size * cand->lambda2) >> (FF_LAMBDA_SHIFT - 3);
+    }
+
+    /* get the delayed frames */
+    while(out_size){
+        out_size = avcodec_encode_video(c, outbuf, outbuf_size, NULL);
+        rd += (out_size * cand->lambda2) >> (FF_LAMBDA_SHIFT - 3);
+    }
+
+    rd += c->error[0] + c->error[1] + c->error[2];
+
+    av_free(outbuf);
+    cand->rd= rd;
+    return 0;
+}
+
+/**
+ * Open the downscaled encoder that estimate_best_b_count() uses to try
+ * b_count consecutive B-frames. It is kept open until MPV_encode_end().
+ */
+static AVCodecContext *get_b_count_context(MpegEncContext *s, int b_count){
+    AVCodecContext *c= s->b_count_ctx[b_count];
+
+    if(c)
+        return c;
+
+    c= avcodec_alloc_context();
+    if(!c)
+        return NULL;
+    c->width = s->width >> s->avctx->brd_scale;
+    c->height= s->height>> s->avctx->brd_scale;
     c->flags= CODEC_FLAG_QSCALE | CODEC_FLAG_PSNR | CODEC_FLAG_INPUT_PRESERVED /*| CODEC_FLAG_EMU_EDGE*/;
     c->flags|= s->avctx->flags & CODEC_FLAG_QPEL;
     c->mb_decision= s->avctx->mb_decision;
@@ -982,21 +1071,70 @@ static int estimate_best_b_count(MpegEncContext *s){
     c->time_base= s->avctx->time_base;
     c->max_b_frames= s->max_b_frames;
 
-    if (avcodec_open(c, codec) < 0)
-        return -1;
+    if (avcodec_open(c, avcodec_find_encoder(s->avctx->codec_id)) < 0){
+        av_free(c);
+        return NULL;
+    }
+    s->b_count_ctx[b_count]= c;
+    return c;
+}
+
+/**
+ * Choose the number of B-frames before the next P-frame by encoding a
+ * downscaled copy of the upcoming pictures once per candidate count.
+ * Each candidate count has its own encoder, so they are run in parallel
+ * on the slice threads of the main encoder.
+ */
+static int estimate_best_b_count(MpegEncContext *s){
+    BFrameCandidate cand[FF_MAX_B_FRAMES+1];
+    AVFrame input[FF_MAX_B_FRAMES+2];
+    const int scale= s->avctx->brd_scale;
+    int i, j, p_lambda, b_lambda, lambda2, nb_cand;
+    int64_t best_rd= INT64_MAX;
+    int best_b_count= -1;
+
+    assert(scale>=0 && scale <=3);
+
+//    emms_c();
+    p_lambda= s->last_lambda_for[FF_P_TYPE]; //s->next_picture_ptr->quality;
+    b_lambda= s->last_lambda_for[FF_B_TYPE]; //p_lambda *FFABS(s->avctx->b_quant_factor) + s->avctx->b_quant_offset;
+    if(!b_lambda) b_lambda= p_lambda; //FIXME we should do this somewhere else
+    lambda2= (b_lambda*b_lambda + (1<<FF_LAMBDA_SHIFT)/2 ) >> FF_LAMBDA_SHIFT;
+
+    for(nb_cand=0; nb_cand<s->max_b_frames+1; nb_cand++)
+        if(!s->input_picture[nb_cand])
+            break;
+
+    memset(input, 0, sizeof(input));
+    for(j=0; j<nb_cand; j++){
+        /* avcodec_open() must not run concurrently, so open them all here */
+        cand[j].c= get_b_count_context(s, j);
+        if(!cand[j].c)
+            return -1;
+        cand[j].input       = input;
+        cand[j].b_frames    = j;
+        cand[j].max_b_frames= s->max_b_frames;
+        cand[j].p_lambda    = p_lambda;
+        cand[j].b_lambda    = b_lambda;
+        cand[j].lambda2     = lambda2;
+    }
 
     for(i=0; i<s->max_b_frames+2; i++){
-        int ysize= c->width*c->height;
-        int csize= (c->width/2)*(c->height/2);
+        int w= s->width >> scale;
+        int h= s->height>> scale;
+        int ysize= w*h;
+        int csize= (w/2)*(h/2);
         Picture pre_input, *pre_input_ptr= i ? s->input_picture[i-1] : s->next_picture_ptr;
 
         avcodec_get_frame_defaults(&input[i]);
         input[i].data[0]= av_malloc(ysize + 2*csize);
+        if(!input[i].data[0])
+            goto fail;
         input[i].data[1]= input[i].data[0] + ysize;
         input[i].data[2]= input[i].data[1] + csize;
-        input[i].linesize[0]= c->width;
+        input[i].linesize[0]= w;
         input[i].linesize[1]=
-        input[i].linesize[2]= c->width/2;
+        input[i].linesize[2]= w/2;
 
         if(pre_input_ptr && (!i || s->input_picture[i-1])) {
             pre_input= *pre_input_ptr;
@@ -1007,52 +1145,22 @@ static int estimate_best_b_count(MpegEncContext *s){
                 pre_input.data[2]+=INPLACE_OFFSET;
             }
 
-            s->dsp.shrink[scale](input[i].data[0], input[i].linesize[0], pre_input.data[0], pre_input.linesize[0], c->width, c->height);
-            s->dsp.shrink[scale](input[i].data[1], input[i].linesize[1], pre_input.data[1], pre_input.linesize[1], c->width>>1, c->height>>1);
-            s->dsp.shrink[scale](input[i].data[2], input[i].linesize[2], pre_input.data[2], pre_input.linesize[2], c->width>>1, c->height>>1);
+            s->dsp.shrink[scale](input[i].data[0], input[i].linesize[0], pre_input.data[0], pre_input.linesize[0], w, h);
+            s->dsp.shrink[scale](input[i].data[1], input[i].linesize[1], pre_input.data[1], pre_input.linesize[1], w>>1, h>>1);
+            s->dsp.shrink[scale](input[i].data[2], input[i].linesize[2], pre_input.data[2], pre_input.linesize[2], w>>1, h>>1);
         }
     }
 
-    for(j=0; j<s->max_b_frames+1; j++){
-        int64_t rd=0;
-
-        if(!s->input_picture[j])
-            break;
-
-        c->error[0]= c->error[1]= c->error[2]= 0;
-
-        input[0].pict_type= FF_I_TYPE;
-        input[0].quality= 1 * FF_QP2LAMBDA;
-        out_size = avcodec_encode_video(c, outbuf, outbuf_size, &input[0]);
-//        rd += (out_size * lambda2) >> FF_LAMBDA_SHIFT;
-
-        for(i=0; i<s->max_b_frames+1; i++){
-            int is_p= i % (j+1) == j || i==s->max_b_frames;
-
-            input[i+1].pict_type= is_p ? FF_P_TYPE : FF_B_TYPE;
-            input[i+1].quality= is_p ? p_lambda : b_lambda;
-            out_size = avcodec_encode_video(c, outbuf, outbuf_size, &input[i+1]);
-            rd += (out_size * lambda2) >> (FF_LAMBDA_SHIFT - 3);
-        }
+    s->avctx->execute(s->avctx, encode_b_candidate_thread, cand, NULL, nb_cand, sizeof(BFrameCandidate));
 
-        /* get the delayed frames */
-        while(out_size){
-            out_size = avcodec_encode_video(c, outbuf, outbuf_size, NULL);
-            rd += (out_size * lambda2) >> (FF_LAMBDA_SHIFT - 3);
-        }
-
-        rd += c->error[0] + c->error[1] + c->error[2];
-
-        if(rd < best_rd){
-            best_rd= rd;
+    for(j=0; j<nb_cand; j++){
+        if(cand[j].rd < best_rd){
+            best_rd= cand[j].rd;
             best_b_count= j;
         }
     }
 
-    av_freep(&outbuf);
-    avcodec_close(c);
-    av_freep(&c);
-
+fail:
     for(i=0; i<s->max_b_frames+2; i++){
         av_freep(&input[i].data[0]);
     }
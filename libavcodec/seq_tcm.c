@@ -22,69 +22,219 @@
 /**
  * @file
  * IFF-TCM1 audio sequencer decoder.
+ *
+ * The demuxer parses the module into an AVSequencerContext and passes
+ * it through the sequencer_playback field of the codec context, together
+ * with the libavsequencer functions which start and stop playback, so
+ * that libavcodec itself does not link against libavsequencer. Nothing
+ * is taken from the extradata, which may come from an untrusted file. Each packet carries the number of sample
+ * frames requested as 32-bit little-endian value, which are rendered by
+ * the playback handler through the selected mixer. The first packet after
+ * a seek additionally carries the target playing time in AV_TIME_BASE
+ * units as 64-bit little-endian value. The seek is done here rather than
+ * by the demuxer, since the player state must only be touched by the
+ * thread rendering it.
  */
 
+#include "libavutil/intreadwrite.h"
 #include "libavutil/log.h"
+#include "libavutil/opt.h"
 #include "libavsequencer/avsequencer.h"
+#include "libavsequencer/player.h"
 #include "avcodec.h"
 
+#define MIXER_NULL 0
+#define MIXER_LQ   1
+#define MIXER_HQ   2
+#define MIXER_FLT  3
+
 /** decoder context */
 typedef struct IFFTCM1Context {
+    AVClass *av_class;
     AVSequencerContext *avctx;
+    AVSequencerPlayback playback;
+    int32_t *mix_buf;
+    unsigned mix_buf_size;
+    int mixer;
+    int interpolation;
+    int frame_size;
+    int bits;
 } IFFTCM1Context;
 
-#include "libavutil/avstring.h"
-#include "libavsequencer/avsequencer.h"
+static const char *const mixer_name[] = {
+    "Null mixer",
+    "Low quality mixer",
+    "High quality mixer",
+    "Floating point mixer",
+};
+
+#define OFFSET(x) offsetof(IFFTCM1Context, x)
+#define A AV_OPT_FLAG_AUDIO_PARAM|AV_OPT_FLAG_DECODING_PARAM
+static const AVOption options[] = {
+{"mixer", "mixer used for rendering", OFFSET(mixer), FF_OPT_TYPE_INT, MIXER_HQ, MIXER_NULL, MIXER_FLT, A, "mixer"},
+{"null", "null mixer, only advances playback (fast preview)", 0, FF_OPT_TYPE_CONST, MIXER_NULL, INT_MIN, INT_MAX, A, "mixer"},
+{"lq", "low quality mixer", 0, FF_OPT_TYPE_CONST, MIXER_LQ, INT_MIN, INT_MAX, A, "mixer"},
+{"hq", "high quality mixer", 0, FF_OPT_TYPE_CONST, MIXER_HQ, INT_MIN, INT_MAX, A, "mixer"},
+{"float", "floating point mixer, outputs float samples", 0, FF_OPT_TYPE_CONST, MIXER_FLT, INT_MIN, INT_MAX, A, "mixer"},
+{"interpolation", "mixer interpolation, 3 selects the sinc resampler of the high quality mixer", OFFSET(interpolation), FF_OPT_TYPE_INT, 0, 0, 3, A, "interpolation"},
+{"sinc", "band limited polyphase sinc resampling", 0, FF_OPT_TYPE_CONST, 3, INT_MIN, INT_MAX, A, "interpolation"},
+{"frame_size", "sample frames per output frame, 0 uses the demuxer request", OFFSET(frame_size), FF_OPT_TYPE_INT, 0, 0, AVCODEC_MAX_AUDIO_FRAME_SIZE >> 1, A},
+{"bits", "output sample size (16 or 32), ignored by the floating point mixer", OFFSET(bits), FF_OPT_TYPE_INT, 32, 16, 32, A},
+{NULL}
+};
+#undef A
+#undef OFFSET
+
+static AVClass iff_tcm1_class = { "iff_tcm1", av_default_item_name, options, LIBAVUTIL_VERSION_INT };
+
+/** render the requested number of sample frames into buf */
+static uint32_t render(AVSequencerContext *seq, int32_t *buf,
+                       const uint32_t frames, const unsigned channels)
+{
+    AVMixerData *mixer_data = seq->player_mixer_data;
+    AVMixerContext *mixctx  = mixer_data->mixctx;
+    uint32_t done           = 0;
+
+    while (done < frames) {
+        const uint32_t len = mixctx->mix_tick(mixer_data, buf + done * channels, frames - done);
+
+        if (!len)
+            break;
+
+        done += len;
+    }
+
+    return done;
+}
 
 /** decode a frame */
 static int iff_tcm1_decode_frame(AVCodecContext *avctx, void *data, int *data_size,
                                  AVPacket *avpkt)
 {
-    const uint8_t *buf = avpkt->data;
-    int buf_size = avpkt->size;
     IFFTCM1Context *iff_tcm1 = avctx->priv_data;
-    int16_t *out_data = data;
-    int consumed = buf_size;
-    const uint8_t *buf_end = buf + buf_size;
+    AVSequencerContext *seq  = iff_tcm1->avctx;
+    const unsigned channels  = avctx->channels;
+    const int sample_size    = channels * av_get_bits_per_sample_fmt(avctx->sample_fmt) >> 3;
+    uint32_t frames          = iff_tcm1->frame_size;
 
-    if((*data_size >> 2) < buf_size)
-        return -1;
+    if (!(seq && seq->player_mixer_data))
+        return AVERROR_INVALIDDATA;
 
-    if(avctx->frame_number == 0) {
-//        iff_tcm1->fib_acc = buf[1] << 8;
-        buf_size -= 2;
-        buf += 2;
+    if ((avpkt->size >= 12) && iff_tcm1->playback.seek) {
+        int res;
+
+        if ((res = iff_tcm1->playback.seek(seq, AV_RL64(avpkt->data + 4))) < 0) {
+            av_log(avctx, AV_LOG_ERROR, "Cannot seek to the requested playing time.\n");
+            return res;
+        }
     }
 
-    *data_size = buf_size << 2;
+    if (!frames) {
+        if (avpkt->size < 4)
+            return AVERROR_INVALIDDATA;
 
-    while(buf < buf_end) {
-        uint8_t d = *buf++;
-//        iff_tcm1->fib_acc += iff_tcm1->table[d & 0x0f];
-//        *out_data++ = iff_tcm1->fib_acc;
-//        iff_tcm1->fib_acc += iff_tcm1->table[d >> 4];
-//        *out_data++ = iff_tcm1->fib_acc;
+        frames = AV_RL32(avpkt->data);
     }
 
-    return consumed;
+    frames = FFMIN(frames, *data_size / sample_size);
+
+    if (avctx->sample_fmt == SAMPLE_FMT_S16) {
+        const int32_t *src;
+        int16_t *dst = data;
+        const unsigned size = frames * channels;
+        unsigned i;
+
+        if (iff_tcm1->mix_buf_size < size) {
+            av_free(iff_tcm1->mix_buf);
+
+            if (!(iff_tcm1->mix_buf = av_malloc((size << 2) + FF_INPUT_BUFFER_PADDING_SIZE))) {
+                iff_tcm1->mix_buf_size = 0;
+                av_log(avctx, AV_LOG_ERROR, "Cannot allocate mixing buffer.\n");
+                return AVERROR(ENOMEM);
+            }
+
+            iff_tcm1->mix_buf_size = size;
+        }
+
+        frames = render(seq, iff_tcm1->mix_buf, frames, channels);
+        src    = iff_tcm1->mix_buf;
+
+        for (i = frames * channels; i; i--)
+            *dst++ = *src++ >> 16;
+    } else {
+        frames = render(seq, data, frames, channels);
+    }
+
+    *data_size = frames * sample_size;
+
+    return avpkt->size;
 }
 
 /** initialize IFF-TCM1 decoder */
 static av_cold int iff_tcm1_decode_init(AVCodecContext *avctx)
 {
     IFFTCM1Context *iff_tcm1 = avctx->priv_data;
+    AVSequencerPlayback *playback = &iff_tcm1->playback;
+    AVMixerContext *mixctx;
+    char args[32];
+    uint32_t rate, channels;
+    int res;
 
     switch(avctx->codec->id) {
         case CODEC_ID_IFF_TCM1:
-          // TODO: Sequencer to audio conversation
-          break;
         case CODEC_ID_SEQ_TCM1:
-          // TODO: Sequencer to sequencer conversation
           break;
         default:
           return -1;
     }
-    avctx->sample_fmt = SAMPLE_FMT_S32;
+
+    if (!avctx->sequencer_playback) {
+        av_log(avctx, AV_LOG_ERROR, "Missing sequencer context.\n");
+        return AVERROR_INVALIDDATA;
+    }
+
+    memcpy(playback, avctx->sequencer_playback, sizeof(AVSequencerPlayback));
+
+    if (!(playback->avctx && playback->start && playback->stop)) {
+        av_log(avctx, AV_LOG_ERROR, "Missing sequencer playback functions.\n");
+        return AVERROR_INVALIDDATA;
+    }
+
+    if (iff_tcm1->bits != 16 && iff_tcm1->bits != 32) {
+        av_log(avctx, AV_LOG_ERROR, "Unsupported output sample size: %d bits\n", iff_tcm1->bits);
+        return AVERROR_INVALIDDATA;
+    }
+
+    snprintf(args, sizeof(args), "interpolation=%d;", iff_tcm1->interpolation);
+
+    rate     = avctx->sample_rate;
+    channels = avctx->channels;
+
+    if ((res = playback->start(playback->avctx, mixer_name[iff_tcm1->mixer], args, &rate, &channels)) < 0)
+        return res;
+
+    avctx->sample_rate = rate;
+    avctx->channels    = channels;
+    mixctx             = playback->avctx->player_mixer_data->mixctx;
+
+    iff_tcm1->avctx = playback->avctx;
+    if (mixctx->flags & AVSEQ_MIXER_CONTEXT_FLAG_FLOAT)
+        avctx->sample_fmt = SAMPLE_FMT_FLT;
+    else
+        avctx->sample_fmt = (iff_tcm1->bits == 16) ? SAMPLE_FMT_S16 : SAMPLE_FMT_S32;
+    return 0;
+}
+
+/** close IFF-TCM1 decoder */
+static av_cold int iff_tcm1_decode_end(AVCodecContext *avctx)
+{
+    IFFTCM1Context *iff_tcm1 = avctx->priv_data;
+
+    if (iff_tcm1->avctx)
+        iff_tcm1->playback.stop(iff_tcm1->avctx, 1);
+
+    av_freep(&iff_tcm1->mix_buf);
+    iff_tcm1->avctx = NULL;
     return 0;
 }
 
@@ -94,8 +244,10 @@ AVCodec iff_tcm1_decoder = {
   .id             = CODEC_ID_IFF_TCM1,
   .priv_data_size = sizeof (IFFTCM1Context),
   .init           = iff_tcm1_decode_init,
+  .close          = iff_tcm1_decode_end,
   .decode         = iff_tcm1_decode_frame,
   .long_name      = NULL_IF_CONFIG_SMALL("IFF-TCM1 audio"),
+  .priv_class     = &iff_tcm1_class,
 };
 
 AVCodec seq_tcm1_decoder = {
@@ -105,6 +257,8 @@ AVCodec seq_tcm1_decoder = {
   .id             = CODEC_ID_SEQ_TCM1,
   .priv_data_size = sizeof (IFFTCM1Context),
   .init           = iff_tcm1_decode_init,
+  .close          = iff_tcm1_decode_end,
   .decode         = iff_tcm1_decode_frame,
   .long_name      = NULL_IF_CONFIG_SMALL("IFF-TCM1 sequencer"),
+  .priv_class     = &iff_tcm1_class,
 };
@@ -0,0 +1,166 @@
+/*
+ * Multithreading support functions
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Multithreading support functions
+ * @see doc/multithreading.txt
+ */
+
+#ifndef AVCODEC_THREAD_H
+#define AVCODEC_THREAD_H
+
+#include "config.h"
+#include "avcodec.h"
+
+/**
+ * Use for the threading-only AVCodec callbacks, so that they are not
+ * referenced in builds without thread support.
+ */
+#if HAVE_THREADS
+#define ONLY_IF_THREADS_ENABLED(x) x
+#else
+#define ONLY_IF_THREADS_ENABLED(x) NULL
+#endif
+
+/**
+ * Start the threads selected by thread_type and thread_count.
+ * Called by avcodec_open(); does nothing before the codec is set.
+ *
+ * @return 0 on success, a negative value otherwise
+ */
+int ff_thread_init(AVCodecContext *avctx);
+
+/**
+ * Stop the threads started by ff_thread_init() and free their contexts.
+ */
+void ff_thread_free(AVCodecContext *avctx);
+
+/**
+ * Wait for decoding threads to finish and reset internal state.
+ * Called by avcodec_flush_buffers().
+ *
+ * @param avctx The context.
+ */
+void ff_thread_flush(AVCodecContext *avctx);
+
+/**
+ * Submit a new frame to a decoding thread.
+ * Returns the next available frame in picture. *got_picture_ptr
+ * will be 0 if none is available.
+ *
+ * Parameters are the same as avcodec_decode_video2().
+ */
+int ff_thread_decode_frame(AVCodecContext *avctx, AVFrame *picture,
+                           int *got_picture_ptr, AVPacket *avpkt);
+
+/**
+ * If the codec defines update_thread_context(), call this
+ * when they are ready for the next thread to start decoding
+ * the next frame. After calling it, do not change any variables
+ * read by the update_thread_context() method, or call ff_thread_get_buffer().
+ *
+ * @param avctx The context.
+ */
+void ff_thread_finish_setup(AVCodecContext *avctx);
+
+/**
+ * Notify later decoding threads when part of their reference picture is ready.
+ * Call this when some part of the picture is finished decoding.
+ * Later calls with lower values of progress have no effect.
+ *
+ * @param f The picture being decoded.
+ * @param progress Value, in arbitrary units, of how much of the picture has decoded.
+ * @param field The field being decoded, for field-picture codecs.
+ * 0 for top field or frame pictures, 1 for bottom field.
+ */
+void ff_thread_report_progress(AVFrame *f, int progress, int field);
+
+/**
+ * Wait for earlier decoding threads to finish reference pictures.
+ * Call this before accessing some part of a picture, with a given
+ * value for progress, and it will return after the responsible decoding
+ * thread calls ff_thread_report_progress() with the same or
+ * higher value for progress.
+ *
+ * @param f The picture being referenced.
+ * @param progress Value, in arbitrary units, to wait for.
+ * @param field The field being referenced, for field-picture codecs.
+ * 0 for top field or frame pictures, 1 for bottom field.
+ */
+void ff_thread_await_progress(AVFrame *f, int progress, int field);
+
+/**
+ * Wrapper around get_buffer() for frame-multithreaded codecs.
+ * Call this function instead of avctx->get_buffer(f).
+ * Cannot be called after the codec has called ff_thread_finish_setup().
+ *
+ * @param avctx The current context.
+ * @param f The frame to write into.
+ */
+int ff_thread_get_buffer(AVCodecContext *avctx, AVFrame *f);
+
+/**
+ * Wrapper around release_buffer() for frame-multithreaded codecs.
+ * Call this function instead of avctx->release_buffer(f).
+ * The AVFrame will be copied and the actual release_buffer() call
+ * will be performed later. The contents of data pointed to by the
+ * AVFrame should not be changed until ff_thread_get_buffer() is called
+ * on it.
+ *
+ * @param avctx The current context.
+ * @param f The picture being released.
+ */
+void ff_thread_release_buffer(AVCodecContext *avctx, AVFrame *f);
+
+/**
+ * Allocate progress counters for jobs run by execute2() that depend on
+ * each other, such as macroblock rows decoded as a wavefront.
+ * All counters are reset to 0. Must be called outside of execute2().
+ *
+ * @param avctx The context.
+ * @param count Number of counters needed.
+ * @return 0 on success, AVERROR(ENOSYS) if no slice thread pool is
+ *         active, in which case the jobs may not run concurrently and
+ *         the caller must not make them wait on each other.
+ */
+int ff_thread_alloc_progress2(AVCodecContext *avctx, int count);
+
+/**
+ * Set counter field to n and wake up the jobs waiting for it.
+ * Later calls with lower values of n have no effect.
+ *
+ * @param avctx The context.
+ * @param field Index of the counter, less than the count passed to
+ *              ff_thread_alloc_progress2().
+ * @param n New value of the counter.
+ */
+void ff_thread_report_progress2(AVCodecContext *avctx, int field, int n);
+
+/**
+ * Wait until counter field has reached at least n.
+ *
+ * @param avctx The context.
+ * @param field Index of the counter.
+ * @param n Value to wait for.
+ */
+void ff_thread_await_progress2(AVCodecContext *avctx, int field, int n);
+
+#endif /* AVCODEC_THREAD_H */
@@ -39,6 +39,7 @@
 #include "imgconvert.h"
 #include "audioconvert.h"
 #include "internal.h"
+#include "thread.h"
 #include <stdlib.h>
 #include <stdarg.h>
 #include <limits.h>
@@ -113,6 +114,33 @@ void avcodec_set_dimensions(AVCodecContext *s, int width, int height){
     s->height= -((-height)>>s->lowres);
 }
 
+/**
+ * Everything the layout of a buffer allocated by avcodec_default_get_buffer()
+ * depends on, buffers with equal keys are interchangeable.
+ */
+typedef struct FramePoolKey {
+    int width, height;          ///< allocated dimensions, including alignment and edges
+    enum PixelFormat pix_fmt;
+    int stride_align[4];
+    int edge;                   ///< whether the data starts after an EDGE_WIDTH border
+} FramePoolKey;
+
+typedef struct FramePoolBuffer {
+    struct FramePoolBuffer *next;
+    FramePoolKey key;
+    uint8_t *base[4];
+    uint8_t *data[4];
+    int linesize[4];
+} FramePoolBuffer;
+
+struct AVFramePool {
+    void *mutex;                ///< lock manager mutex, NULL if none was registered
+    int refcount;
+    int max_unused;
+    int nb_unused;
+    FramePoolBuffer *unused;    ///< unused buffers, most recently released first
+};
+
 typedef struct InternalBuffer{
     int last_pic_num;
     uint8_t *base[4];
@@ -120,6 +148,7 @@ typedef struct InternalBuffer{
     int linesize[4];
     int width, height;
     enum PixelFormat pix_fmt;
+    FramePoolBuffer *pool_buf;  ///< buffer taken from avctx->frame_pool, if any
 }InternalBuffer;
 
 #define INTERNAL_BUFFER_SIZE 32
@@ -226,6 +255,232 @@ int avcodec_check_dimensions(void *av_log_ctx, unsigned int w, unsigned int h){
 }
 #endif
 
+static void get_buffer_key(AVCodecContext *s, FramePoolKey *key)
+{
+    int w= s->width;
+    int h= s->height;
+
+    memset(key, 0, sizeof(*key));
+    avcodec_align_dimensions2(s, &w, &h, key->stride_align);
+
+    key->edge= !(s->flags&CODEC_FLAG_EMU_EDGE);
+    if(key->edge){
+        w+= EDGE_WIDTH*2;
+        h+= EDGE_WIDTH*2;
+    }
+    key->width  = w;
+    key->height = h;
+    key->pix_fmt= s->pix_fmt;
+}
+
+static int alloc_buffer_planes(const FramePoolKey *key, uint8_t *base[4],
+                               uint8_t *data[4], int linesize[4])
+{
+    int h_chroma_shift, v_chroma_shift;
+    int size[4] = {0};
+    int tmpsize;
+    int unaligned;
+    int i;
+    int w= key->width;
+    AVPicture picture;
+
+    avcodec_get_chroma_sub_sample(key->pix_fmt, &h_chroma_shift, &v_chroma_shift);
+
+    do {
+        // NOTE: do not align linesizes individually, this breaks e.g. assumptions
+        // that linesize[0] == 2*linesize[1] in the MPEG-encoder for 4:2:2
+        av_image_fill_linesizes(picture.linesize, key->pix_fmt, w);
+        // increase alignment of w for next try (rhs gives the lowest bit set in w)
+        w += w & ~(w-1);
+
+        unaligned = 0;
+        for (i=0; i<4; i++){
+            unaligned |= picture.linesize[i] % key->stride_align[i];
+        }
+    } while (unaligned);
+
+    tmpsize = av_image_fill_pointers(picture.data, key->pix_fmt, key->height, NULL, picture.linesize);
+    if (tmpsize < 0)
+        return -1;
+
+    for (i=0; i<3 && picture.data[i+1]; i++)
+        size[i] = picture.data[i+1] - picture.data[i];
+    size[i] = tmpsize - (picture.data[i] - picture.data[0]);
+
+    memset(base, 0, 4*sizeof(*base));
+    memset(data, 0, 4*sizeof(*data));
+
+    for(i=0; i<4 && size[i]; i++){
+        const int h_shift= i==0 ? 0 : h_chroma_shift;
+        const int v_shift= i==0 ? 0 : v_chroma_shift;
+
+        linesize[i]= picture.linesize[i];
+
+        base[i]= av_malloc(size[i]+16); //FIXME 16
+        if(base[i]==NULL){
+            for(i=0; i<4; i++){
+                av_freep(&base[i]);
+                data[i]= NULL;
+            }
+            return -1;
+        }
+        memset(base[i], 128, size[i]);
+
+        // no edge if EDGE EMU or not planar YUV
+        if(!key->edge || !size[2])
+            data[i] = base[i];
+        else
+            data[i] = base[i] + FFALIGN((linesize[i]*EDGE_WIDTH>>v_shift) + (EDGE_WIDTH>>h_shift), key->stride_align[i]);
+    }
+    if(size[1] && !size[2])
+        ff_set_systematic_pal2((uint32_t*)data[1], key->pix_fmt);
+
+    return 0;
+}
+
+static void frame_pool_lock(AVFramePool *pool)
+{
+    if (pool->mutex && ff_lockmgr_cb)
+        ff_lockmgr_cb(&pool->mutex, AV_LOCK_OBTAIN);
+}
+
+static void frame_pool_unlock(AVFramePool *pool)
+{
+    if (pool->mutex && ff_lockmgr_cb)
+        ff_lockmgr_cb(&pool->mutex, AV_LOCK_RELEASE);
+}
+
+static void frame_pool_free_buffer(FramePoolBuffer *pb)
+{
+    int i;
+
+    for (i = 0; i < 4; i++)
+        av_free(pb->base[i]);
+    av_free(pb);
+}
+
+AVFramePool *avcodec_frame_pool_alloc(int max_unused)
+{
+    AVFramePool *pool = av_mallocz(sizeof(*pool));
+
+    if (!pool)
+        return NULL;
+
+    if (ff_lockmgr_cb && ff_lockmgr_cb(&pool->mutex, AV_LOCK_CREATE)) {
+        av_free(pool);
+        return NULL;
+    }
+    pool->refcount   = 1;
+    pool->max_unused = max_unused;
+
+    return pool;
+}
+
+AVFramePool *avcodec_frame_pool_ref(AVFramePool *pool)
+{
+    frame_pool_lock(pool);
+    pool->refcount++;
+    frame_pool_unlock(pool);
+
+    return pool;
+}
+
+void avcodec_frame_pool_unref(AVFramePool **ppool)
+{
+    AVFramePool *pool = *ppool;
+    int refcount;
+
+    if (!pool)
+        return;
+    *ppool = NULL;
+
+    frame_pool_lock(pool);
+    refcount = --pool->refcount;
+    frame_pool_unlock(pool);
+
+    if (refcount)
+        return;
+
+    while (pool->unused) {
+        FramePoolBuffer *pb = pool->unused;
+        pool->unused = pb->next;
+        frame_pool_free_buffer(pb);
+    }
+    if (pool->mutex && ff_lockmgr_cb)
+        ff_lockmgr_cb(&pool->mutex, AV_LOCK_DESTROY);
+    av_free(pool);
+}
+
+/**
+ * Take a buffer matching the current dimensions and format of s from its
+ * frame_pool, allocating a new one if there is none.
+ */
+static int frame_pool_get_buffer(AVCodecContext *s, InternalBuffer *buf)
+{
+    AVFramePool *pool = s->frame_pool;
+    FramePoolBuffer **p, *pb = NULL;
+    FramePoolKey key;
+
+    get_buffer_key(s, &key);
+
+    frame_pool_lock(pool);
+    for (p = &pool->unused; *p; p = &(*p)->next) {
+        if (!memcmp(&(*p)->key, &key, sizeof(key))) {
+            pb = *p;
+            *p = pb->next;
+            pool->nb_unused--;
+            break;
+        }
+    }
+    frame_pool_unlock(pool);
+
+    if (!pb) {
+        pb = av_mallocz(sizeof(*pb));
+        if (!pb)
+            return AVERROR(ENOMEM);
+        pb->key = key;
+        if (alloc_buffer_planes(&key, pb->base, pb->data, pb->linesize) < 0) {
+            av_free(pb);
+            return -1;
+        }
+    }
+
+    buf->pool_buf = pb;
+    memcpy(buf->base,     pb->base,     sizeof(buf->base));
+    memcpy(buf->data,     pb->data,     sizeof(buf->data));
+    memcpy(buf->linesize, pb->linesize, sizeof(buf->linesize));
+    buf->width  = s->width;
+    buf->height = s->height;
+    buf->pix_fmt= s->pix_fmt;
+
+    return 0;
+}
+
+/**
+ * Return a buffer to the pool. Above max_unused unused buffers, the least
+ * recently released one is freed, so that a pool shared by decoders whose
+ * dimensions change does not keep the buffers of the old ones.
+ */
+static void frame_pool_release_buffer(AVFramePool *pool, FramePoolBuffer *pb)
+{
+    FramePoolBuffer **p, *trimmed = NULL;
+
+    frame_pool_lock(pool);
+    pb->next = pool->unused;
+    pool->unused = pb;
+    if (++pool->nb_unused > pool->max_unused) {
+        for (p = &pool->unused; (*p)->next; p = &(*p)->next)
+            ;
+        trimmed = *p;
+        *p = NULL;
+        pool->nb_unused--;
+    }
+    frame_pool_unlock(pool);
+
+    if (trimmed)
+        frame_pool_free_buffer(trimmed);
+}
+
 int avcodec_default_get_buffer(AVCodecContext *s, AVFrame *pic){
     int i;
     int w= s->width;
@@ -267,69 +522,22 @@ int avcodec_default_get_buffer(AVCodecContext *s, AVFrame *pic){
         }
     }
 
-    if(buf->base[0]){
+    if(s->frame_pool){
+        // the contents left by another context are unknown
+        if(frame_pool_get_buffer(s, buf) < 0)
+            return -1;
+        pic->age= 256*256*256*64;
+    }else if(buf->base[0]){
         pic->age= *picture_number - buf->last_pic_num;
         buf->last_pic_num= *picture_number;
     }else{
-        int h_chroma_shift, v_chroma_shift;
-        int size[4] = {0};
-        int tmpsize;
-        int unaligned;
-        AVPicture picture;
-        int stride_align[4];
-
-        avcodec_get_chroma_sub_sample(s->pix_fmt, &h_chroma_shift, &v_chroma_shift);
-
-        avcodec_align_dimensions2(s, &w, &h, stride_align);
-
-        if(!(s->flags&CODEC_FLAG_EMU_EDGE)){
-            w+= EDGE_WIDTH*2;
-            h+= EDGE_WIDTH*2;
-        }
-
-        do {
-            // NOTE: do not align linesizes individually, this breaks e.g. assumptions
-            // that linesize[0] == 2*linesize[1] in the MPEG-encoder for 4:2:2
-            av_image_fill_linesizes(picture.linesize, s->pix_fmt, w);
-            // increase alignment of w for next try (rhs gives the lowest bit set in w)
-            w += w & ~(w-1);
+        FramePoolKey key;
 
-            unaligned = 0;
-            for (i=0; i<4; i++){
-                unaligned |= picture.linesize[i] % stride_align[i];
-            }
-        } while (unaligned);
-
-        tmpsize = av_image_fill_pointers(picture.data, s->pix_fmt, h, NULL, picture.linesize);
-        if (tmpsize < 0)
+        get_buffer_key(s, &key);
+        if(alloc_buffer_planes(&key, buf->base, buf->data, buf->linesize) < 0)
             return -1;
 
-        for (i=0; i<3 && picture.data[i+1]; i++)
-            size[i] = picture.data[i+1] - picture.data[i];
-        size[i] = tmpsize - (picture.data[i] - picture.data[0]);
-
         buf->last_pic_num= -256*256*256*64;
-        memset(buf->base, 0, sizeof(buf->base));
-        memset(buf->data, 0, sizeof(buf->data));
-
-        for(i=0; i<4 && size[i]; i++){
-            const int h_shift= i==0 ? 0 : h_chroma_shift;
-            const int v_shift= i==0 ? 0 : v_chroma_shift;
-
-            buf->linesize[i]= picture.linesize[i];
-
-            buf->base[i]= av_malloc(size[i]+16); //FIXME 16
-            if(buf->base[i]==NULL) return -1;
-            memset(buf->base[i], 128, size[i]);
-
-            // no edge if EDGE EMU or not planar YUV
-            if((s->flags&CODEC_FLAG_EMU_EDGE) || !size[2])
-                buf->data[i] = buf->base[i];
-            else
-                buf->data[i] = buf->base[i] + FFALIGN((buf->linesize[i]*EDGE_WIDTH>>v_shift) + (EDGE_WIDTH>>h_shift), stride_align[i]);
-        }
-        if(size[1] && !size[2])
-            ff_set_systematic_pal2((uint32_t*)buf->data[1], s->pix_fmt);
         buf->width  = s->width;
         buf->height = s->height;
         buf->pix_fmt= s->pix_fmt;
@@ -373,6 +581,13 @@ void avcodec_default_release_buffer(AVCodecContext *s, AVFrame *pic){
 
     FFSWAP(InternalBuffer, *buf, *last);
 
+    if(last->pool_buf){
+        frame_pool_release_buffer(s->frame_pool, last->pool_buf);
+        last->pool_buf= NULL;
+        memset(last->base, 0, sizeof(last->base));
+        memset(last->data, 0, sizeof(last->data));
+    }
+
     for(i=0; i<4; i++){
         pic->data[i]=NULL;
 //        pic->base[i]=NULL;
@@ -536,12 +751,21 @@ int attribute_align_arg avcodec_open(AVCodecContext *avctx, AVCodec *codec)
         goto free_and_end;
     }
 
-    if(avctx->codec->init){
+    if (HAVE_THREADS && !avctx->thread_opaque) {
+        ret = ff_thread_init(avctx);
+        if (ret < 0) {
+            goto free_and_end;
+        }
+    }
+
+    if(avctx->codec->init && !(avctx->active_thread_type&FF_THREAD_FRAME)){
         ret = avctx->codec->init(avctx);
         if (ret < 0) {
             goto free_and_end;
         }
     }
+    if (avctx->frame_pool)
+        avcodec_frame_pool_ref(avctx->frame_pool);
     ret=0;
 end:
     entangled_thread_counter--;
@@ -634,14 +858,18 @@ int attribute_align_arg avcodec_decode_video2(AVCodecContext *avctx, AVFrame *pi
 
     avctx->pkt = avpkt;
 
-    if((avctx->codec->capabilities & CODEC_CAP_DELAY) || avpkt->size){
-        ret = avctx->codec->decode(avctx, picture, got_picture_ptr,
-                                avpkt);
+    if((avctx->codec->capabilities & CODEC_CAP_DELAY) || avpkt->size || (avctx->active_thread_type&FF_THREAD_FRAME)){
+        if (HAVE_PTHREADS && avctx->active_thread_type&FF_THREAD_FRAME)
+            ret = ff_thread_decode_frame(avctx, picture, got_picture_ptr,
+                                         avpkt);
+        else {
+            ret = avctx->codec->decode(avctx, picture, got_picture_ptr,
+                                       avpkt);
+            picture->pkt_dts= avpkt->dts;
+        }
 
         emms_c(); //needed to avoid an emms_c() call before every return;
 
-        picture->pkt_dts= avpkt->dts;
-
         if (*got_picture_ptr)
             avctx->frame_number++;
     }else
@@ -743,6 +971,9 @@ void avsubtitle_free(AVSubtitle *sub)
 
 av_cold int avcodec_close(AVCodecContext *avctx)
 {
+    /* frame threading clears avctx->codec when it stops its threads */
+    int opened = avctx->codec != NULL;
+
     /* If there is a user-supplied mutex locking routine, call it. */
     if (ff_lockmgr_cb) {
         if ((*ff_lockmgr_cb)(&codec_mutex, AV_LOCK_OBTAIN))
@@ -757,10 +988,12 @@ av_cold int avcodec_close(AVCodecContext *avctx)
     }
 
     if (HAVE_THREADS && avctx->thread_opaque)
-        avcodec_thread_free(avctx);
+        ff_thread_free(avctx);
     if (avctx->codec && avctx->codec->close)
         avctx->codec->close(avctx);
     avcodec_default_free_buffers(avctx);
+    if (opened)
+        avcodec_frame_pool_unref(&avctx->frame_pool);
     avctx->coded_frame = NULL;
     av_freep(&avctx->priv_data);
     if(avctx->codec && avctx->codec->encode)
@@ -1027,7 +1260,9 @@ void avcodec_init(void)
 
 void avcodec_flush_buffers(AVCodecContext *avctx)
 {
-    if(avctx->codec->flush)
+    if(HAVE_PTHREADS && avctx->active_thread_type&FF_THREAD_FRAME)
+        ff_thread_flush(avctx);
+    else if(avctx->codec->flush)
         avctx->codec->flush(avctx);
 }
 
@@ -1040,6 +1275,7 @@ void avcodec_default_free_buffers(AVCodecContext *s){
         av_log(s, AV_LOG_WARNING, "Found %i unreleased buffers!\n", s->internal_buffer_count);
     for(i=0; i<INTERNAL_BUFFER_SIZE; i++){
         InternalBuffer *buf= &((InternalBuffer*)s->internal_buffer)[i];
+        av_freep(&buf->pool_buf);
         for(j=0; j<4; j++){
             av_freep(&buf->base[j]);
             buf->data[j]= NULL;
@@ -1119,6 +1355,50 @@ int avcodec_thread_init(AVCodecContext *s, int thread_count){
     s->thread_count = thread_count;
     return -1;
 }
+
+int ff_thread_init(AVCodecContext *s){
+    return -1;
+}
+#endif
+
+#if !HAVE_PTHREADS
+
+int ff_thread_get_buffer(AVCodecContext *avctx, AVFrame *f)
+{
+    f->owner = avctx;
+    return avctx->get_buffer(avctx, f);
+}
+
+void ff_thread_release_buffer(AVCodecContext *avctx, AVFrame *f)
+{
+    f->owner->release_buffer(f->owner, f);
+}
+
+void ff_thread_finish_setup(AVCodecContext *avctx)
+{
+}
+
+void ff_thread_report_progress(AVFrame *f, int progress, int field)
+{
+}
+
+void ff_thread_await_progress(AVFrame *f, int progress, int field)
+{
+}
+
+int ff_thread_alloc_progress2(AVCodecContext *avctx, int count)
+{
+    return AVERROR(ENOSYS);
+}
+
+void ff_thread_report_progress2(AVCodecContext *avctx, int field, int n)
+{
+}
+
+void ff_thread_await_progress2(AVCodecContext *avctx, int field, int n)
+{
+}
+
 #endif
 
 unsigned int av_xiphlacing(unsigned char *s, unsigned int v)
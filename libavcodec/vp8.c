@@ -29,6 +29,7 @@
 #include "vp8dsp.h"
 #include "h264pred.h"
 #include "rectangle.h"
+#include "thread.h"
 
 typedef struct {
     uint8_t filter_level;
@@ -45,17 +46,40 @@ typedef struct {
     uint8_t partitioning;
     VP56mv mv;
     VP56mv bmv[16];
+    uint8_t intra4x4_pred_mode_mb[16];
+    uint8_t chroma_pred_mode;   ///< 8x8c pred mode
+    uint8_t segment;
 } VP8Macroblock;
 
+/**
+ * State used while decoding the coefficients and reconstructing one row of
+ * macroblocks, one per job when rows are decoded in parallel.
+ */
+typedef struct {
+    /**
+     * This is the index plus one of the last non-zero coeff
+     * for each of the blocks in the current macroblock.
+     * So, 0 -> no coeffs
+     *     1 -> dc-only (special transform)
+     *     2+-> full transform
+     */
+    DECLARE_ALIGNED(16, uint8_t, non_zero_count_cache)[6][4];
+    DECLARE_ALIGNED(16, DCTELEM, block)[6][4][16];
+    DECLARE_ALIGNED(16, DCTELEM, block_dc)[16];
+    DECLARE_ALIGNED(8, uint8_t, left_nnz)[9];
+    uint8_t *edge_emu_buffer;
+    VP8FilterStrength *filter_strength;
+} VP8ThreadData;
+
 typedef struct {
     AVCodecContext *avctx;
     DSPContext dsp;
     VP8DSPContext vp8dsp;
     H264PredContext hpc;
     vp8_mc_func put_pixels_tab[3][3][3];
-    AVFrame frames[4];
+    AVFrame frames[5];
     AVFrame *framep[4];
-    uint8_t *edge_emu_buffer;
+    AVFrame *next_framep[4];
     VP56RangeCoder c;   ///< header context, includes mb modes and motion vectors
     int profile;
 
@@ -84,13 +108,36 @@ typedef struct {
     int num_coeff_partitions;
     VP56RangeCoder coeff_partition[8];
 
+    /**
+     * With mb_layout 0, macroblocks are stored along a diagonal so that only
+     * the row being decoded and the one above it are kept, and the modes are
+     * decoded interleaved with the coefficients.
+     * With mb_layout 1 (slice threading), the modes of the whole frame are
+     * decoded first into a mb_width+1 strided array, and the macroblock rows
+     * are then reconstructed in parallel, one job per group of coefficient
+     * partitions.
+     */
     VP8Macroblock *macroblocks;
     VP8Macroblock *macroblocks_base;
-    VP8FilterStrength *filter_strength;
+    int mb_layout;
+
+    VP8ThreadData *thread_data;
+    int num_thread_data;
+    int num_jobs;           ///< number of rows decoded in parallel in this frame
 
     uint8_t *intra4x4_pred_mode_top;
     uint8_t intra4x4_pred_mode_left[4];
-    uint8_t *segmentation_map;
+
+    /**
+     * Segmentation map of each entry in frames, which is read by the
+     * decoding of the following frame. With frame threading, a frame
+     * can be released while the next frame is still being decoded by
+     * another thread, so the maps of released frames are queued and
+     * freed at the start of the next frame decoded by this context.
+     */
+    uint8_t *segmentation_maps[5];
+    uint8_t *queued_segmentation_maps[10];
+    int num_queued_segmentation_maps;
 
     /**
      * Cache of the top row needed for intra prediction
@@ -102,25 +149,10 @@ typedef struct {
      * For coeff decode, we need to know whether the above block had non-zero
      * coefficients. This means for each macroblock, we need data for 4 luma
      * blocks, 2 u blocks, 2 v blocks, and the luma dc block, for a total of 9
-     * per macroblock. We keep the last row in top_nnz.
+     * per macroblock. We keep the last row in top_nnz, the left one is in
+     * VP8ThreadData.
      */
     uint8_t (*top_nnz)[9];
-    DECLARE_ALIGNED(8, uint8_t, left_nnz)[9];
-
-    /**
-     * This is the index plus one of the last non-zero coeff
-     * for each of the blocks in the current macroblock.
-     * So, 0 -> no coeffs
-     *     1 -> dc-only (special transform)
-     *     2+-> full transform
-     */
-    DECLARE_ALIGNED(16, uint8_t, non_zero_count_cache)[6][4];
-    DECLARE_ALIGNED(16, DCTELEM, block)[6][4][16];
-    DECLARE_ALIGNED(16, DCTELEM, block_dc)[16];
-    uint8_t intra4x4_pred_mode_mb[16];
-
-    int chroma_pred_mode;    ///< 8x8c pred mode of the current macroblock
-    int segment;             ///< segment of the current macroblock
 
     int mbskip_enabled;
     int sign_bias[4]; ///< one state [0, 1] per ref frame type
@@ -200,51 +232,116 @@ typedef struct {
     } prob[2];
 } VP8Context;
 
-static void vp8_decode_flush(AVCodecContext *avctx)
+static void free_queued_segmentation_maps(VP8Context *s)
 {
-    VP8Context *s = avctx->priv_data;
-    int i;
+    while (s->num_queued_segmentation_maps > 0)
+        av_freep(&s->queued_segmentation_maps[--s->num_queued_segmentation_maps]);
+}
 
-    for (i = 0; i < 4; i++)
-        if (s->frames[i].data[0])
-            avctx->release_buffer(avctx, &s->frames[i]);
-    memset(s->framep, 0, sizeof(s->framep));
+static void vp8_release_frame(VP8Context *s, int i, int is_close)
+{
+    if (s->segmentation_maps[i]) {
+        if (is_close || s->num_queued_segmentation_maps >= FF_ARRAY_ELEMS(s->queued_segmentation_maps))
+            av_free(s->segmentation_maps[i]);
+        else
+            s->queued_segmentation_maps[s->num_queued_segmentation_maps++] = s->segmentation_maps[i];
+        s->segmentation_maps[i] = NULL;
+    }
+    ff_thread_release_buffer(s->avctx, &s->frames[i]);
+}
 
+static void free_buffers(VP8Context *s)
+{
+    int i;
+
+    if (s->thread_data)
+        for (i = 0; i < s->num_thread_data; i++) {
+            av_freep(&s->thread_data[i].filter_strength);
+            av_freep(&s->thread_data[i].edge_emu_buffer);
+        }
+    av_freep(&s->thread_data);
+    s->num_thread_data = 0;
     av_freep(&s->macroblocks_base);
-    av_freep(&s->filter_strength);
     av_freep(&s->intra4x4_pred_mode_top);
     av_freep(&s->top_nnz);
-    av_freep(&s->edge_emu_buffer);
     av_freep(&s->top_border);
-    av_freep(&s->segmentation_map);
 
-    s->macroblocks        = NULL;
+    s->macroblocks = NULL;
+}
+
+static void vp8_decode_flush_impl(AVCodecContext *avctx, int is_close)
+{
+    VP8Context *s = avctx->priv_data;
+    int i;
+
+    // thread copies only hold stale references at close time
+    if (!is_close || !avctx->is_copy) {
+        for (i = 0; i < 5; i++)
+            if (s->frames[i].data[0])
+                vp8_release_frame(s, i, is_close);
+    }
+    memset(s->framep, 0, sizeof(s->framep));
+    memset(s->next_framep, 0, sizeof(s->next_framep));
+
+    free_buffers(s);
+
+    if (is_close)
+        free_queued_segmentation_maps(s);
+}
+
+static void vp8_decode_flush(AVCodecContext *avctx)
+{
+    vp8_decode_flush_impl(avctx, 0);
 }
 
 static int update_dimensions(VP8Context *s, int width, int height)
 {
-    if (av_image_check_size(width, height, 0, s->avctx))
-        return AVERROR_INVALIDDATA;
+    int i;
 
-    vp8_decode_flush(s->avctx);
+    if (width  != s->avctx->width ||
+        height != s->avctx->height) {
+        if (av_image_check_size(width, height, 0, s->avctx))
+            return AVERROR_INVALIDDATA;
 
-    avcodec_set_dimensions(s->avctx, width, height);
+        vp8_decode_flush(s->avctx);
+
+        avcodec_set_dimensions(s->avctx, width, height);
+    }
+
+    free_buffers(s);
 
     s->mb_width  = (s->avctx->coded_width +15) / 16;
     s->mb_height = (s->avctx->coded_height+15) / 16;
 
-    s->macroblocks_base        = av_mallocz((s->mb_width+s->mb_height*2+1)*sizeof(*s->macroblocks));
-    s->filter_strength         = av_mallocz(s->mb_width*sizeof(*s->filter_strength));
+    // each coefficient partition is decoded by at most one job
+    s->mb_layout       = s->avctx->active_thread_type == FF_THREAD_SLICE;
+    s->num_thread_data = s->mb_layout ? FFMIN(s->avctx->thread_count, 8) : 1;
+
+    if (s->mb_layout)
+        s->macroblocks_base    = av_mallocz((s->mb_width+1)*(s->mb_height+1)*sizeof(*s->macroblocks));
+    else
+        s->macroblocks_base    = av_mallocz((s->mb_width+s->mb_height*2+1)*sizeof(*s->macroblocks));
     s->intra4x4_pred_mode_top  = av_mallocz(s->mb_width*4);
     s->top_nnz                 = av_mallocz(s->mb_width*sizeof(*s->top_nnz));
     s->top_border              = av_mallocz((s->mb_width+1)*sizeof(*s->top_border));
-    s->segmentation_map        = av_mallocz(s->mb_width*s->mb_height);
+    s->thread_data             = av_mallocz(s->num_thread_data*sizeof(*s->thread_data));
 
-    if (!s->macroblocks_base || !s->filter_strength || !s->intra4x4_pred_mode_top ||
-        !s->top_nnz || !s->top_border || !s->segmentation_map)
+    if (!s->macroblocks_base || !s->intra4x4_pred_mode_top ||
+        !s->top_nnz || !s->top_border || !s->thread_data)
         return AVERROR(ENOMEM);
 
-    s->macroblocks        = s->macroblocks_base + 1;
+    for (i = 0; i < s->num_thread_data; i++) {
+        s->thread_data[i].filter_strength = av_mallocz(s->mb_width*sizeof(*s->thread_data[i].filter_strength));
+        if (!s->thread_data[i].filter_strength)
+            return AVERROR(ENOMEM);
+    }
+
+    // with mb_layout 1, the top row and left column are left zeroed for
+    // prediction from outside the frame
+    if (s->mb_layout)
+        s->macroblocks    = s->macroblocks_base + s->mb_width + 2;
+    else
+        s->macroblocks    = s->macroblocks_base + 1;
 
     return 0;
 }
@@ -529,11 +626,11 @@ void clamp_mv(VP8Context *s, VP56mv *dst, const VP56mv *src, int mb_x, int mb_y)
 
 static av_always_inline
 void find_near_mvs(VP8Context *s, VP8Macroblock *mb,
-                   VP56mv near[2], VP56mv *best, uint8_t cnt[4])
+                   VP56mv near[2], VP56mv *best, uint8_t cnt[4], int layout)
 {
-    VP8Macroblock *mb_edge[3] = { mb + 2 /* top */,
+    VP8Macroblock *mb_edge[3] = { layout ? mb - s->mb_width - 1 : mb + 2 /* top */,
                                   mb - 1 /* left */,
-                                  mb + 1 /* top-left */ };
+                                  layout ? mb - s->mb_width - 2 : mb + 1 /* top-left */ };
     enum { EDGE_TOP, EDGE_LEFT, EDGE_TOPLEFT };
     VP56mv near_mv[4]  = {{ 0 }};
     enum { CNT_ZERO, CNT_NEAREST, CNT_NEAR, CNT_SPLITMV };
@@ -635,11 +732,11 @@ const uint8_t *get_submv_prob(uint32_t left, uint32_t top)
  * @returns the number of motion vectors parsed (2, 4 or 16)
  */
 static av_always_inline
-int decode_splitmvs(VP8Context *s, VP56RangeCoder *c, VP8Macroblock *mb)
+int decode_splitmvs(VP8Context *s, VP56RangeCoder *c, VP8Macroblock *mb, int layout)
 {
     int part_idx;
     int n, num;
-    VP8Macroblock *top_mb  = &mb[2];
+    VP8Macroblock *top_mb  = layout ? mb - s->mb_width - 1 : &mb[2];
     VP8Macroblock *left_mb = &mb[-1];
     const uint8_t *mbsplits_left = vp8_mbsplits[left_mb->partitioning],
                   *mbsplits_top = vp8_mbsplits[top_mb->partitioning],
@@ -699,10 +796,10 @@ int decode_splitmvs(VP8Context *s, VP56RangeCoder *c, VP8Macroblock *mb)
 }
 
 static av_always_inline
-void decode_intra4x4_modes(VP8Context *s, VP56RangeCoder *c,
+void decode_intra4x4_modes(VP8Context *s, VP56RangeCoder *c, VP8Macroblock *mb,
                            int mb_x, int keyframe)
 {
-    uint8_t *intra4x4 = s->intra4x4_pred_mode_mb;
+    uint8_t *intra4x4 = mb->intra4x4_pred_mode_mb;
     if (keyframe) {
         int x, y;
         uint8_t* const top = s->intra4x4_pred_mode_top + 4 * mb_x;
@@ -724,13 +821,16 @@ void decode_intra4x4_modes(VP8Context *s, VP56RangeCoder *c,
 }
 
 static av_always_inline
-void decode_mb_mode(VP8Context *s, VP8Macroblock *mb, int mb_x, int mb_y, uint8_t *segment)
+void decode_mb_mode(VP8Context *s, VP8Macroblock *mb, int mb_x, int mb_y,
+                    uint8_t *segment, const uint8_t *ref_segment, int layout)
 {
     VP56RangeCoder *c = &s->c;
 
     if (s->segmentation.update_map)
         *segment = vp8_rac_get_tree(c, vp8_segmentid_tree, s->prob->segmentid);
-    s->segment = *segment;
+    else
+        *segment = ref_segment ? *ref_segment : 0;
+    mb->segment = *segment;
 
     mb->skip = s->mbskip_enabled ? vp56_rac_get_prob(c, s->prob->mbskip) : 0;
 
@@ -738,14 +838,14 @@ void decode_mb_mode(VP8Context *s, VP8Macroblock *mb, int mb_x, int mb_y, uint8_
         mb->mode = vp8_rac_get_tree(c, vp8_pred16x16_tree_intra, vp8_pred16x16_prob_intra);
 
         if (mb->mode == MODE_I4x4) {
-            decode_intra4x4_modes(s, c, mb_x, 1);
+            decode_intra4x4_modes(s, c, mb, mb_x, 1);
         } else {
             const uint32_t modes = vp8_pred4x4_mode[mb->mode] * 0x01010101u;
             AV_WN32A(s->intra4x4_pred_mode_top + 4 * mb_x, modes);
             AV_WN32A(s->intra4x4_pred_mode_left, modes);
         }
 
-        s->chroma_pred_mode = vp8_rac_get_tree(c, vp8_pred8x8c_tree, vp8_pred8x8c_prob_intra);
+        mb->chroma_pred_mode = vp8_rac_get_tree(c, vp8_pred8x8c_tree, vp8_pred8x8c_prob_intra);
         mb->ref_frame = VP56_FRAME_CURRENT;
     } else if (vp56_rac_get_prob_branchy(c, s->prob->intra)) {
         VP56mv near[2], best;
@@ -760,14 +860,14 @@ void decode_mb_mode(VP8Context *s, VP8Macroblock *mb, int mb_x, int mb_y, uint8_
         s->ref_count[mb->ref_frame-1]++;
 
         // motion vectors, 16.3
-        find_near_mvs(s, mb, near, &best, cnt);
+        find_near_mvs(s, mb, near, &best, cnt, layout);
         if (vp56_rac_get_prob_branchy(c, vp8_mode_contexts[cnt[0]][0])) {
             if (vp56_rac_get_prob_branchy(c, vp8_mode_contexts[cnt[1]][1])) {
                 if (vp56_rac_get_prob_branchy(c, vp8_mode_contexts[cnt[2]][2])) {
                     if (vp56_rac_get_prob_branchy(c, vp8_mode_contexts[cnt[3]][3])) {
                         mb->mode = VP8_MVMODE_SPLIT;
                         clamp_mv(s, &mb->mv, &mb->mv, mb_x, mb_y);
-                        mb->mv = mb->bmv[decode_splitmvs(s, c, mb) - 1];
+                        mb->mv = mb->bmv[decode_splitmvs(s, c, mb, layout) - 1];
                     } else {
                         mb->mode = VP8_MVMODE_NEW;
                         clamp_mv(s, &mb->mv, &mb->mv, mb_x, mb_y);
@@ -795,9 +895,9 @@ void decode_mb_mode(VP8Context *s, VP8Macroblock *mb, int mb_x, int mb_y, uint8_
         mb->mode = vp8_rac_get_tree(c, vp8_pred16x16_tree_inter, s->prob->pred16x16);
 
         if (mb->mode == MODE_I4x4)
-            decode_intra4x4_modes(s, c, mb_x, 0);
+            decode_intra4x4_modes(s, c, mb, mb_x, 0);
 
-        s->chroma_pred_mode = vp8_rac_get_tree(c, vp8_pred8x8c_tree, s->prob->pred8x8c);
+        mb->chroma_pred_mode = vp8_rac_get_tree(c, vp8_pred8x8c_tree, s->prob->pred8x8c);
         mb->ref_frame = VP56_FRAME_CURRENT;
         mb->partitioning = VP8_SPLITMVMODE_NONE;
         AV_ZERO32(&mb->bmv[0]);
@@ -880,28 +980,28 @@ int decode_block_coeffs(VP56RangeCoder *c, DCTELEM block[16],
 }
 
 static av_always_inline
-void decode_mb_coeffs(VP8Context *s, VP56RangeCoder *c, VP8Macroblock *mb,
-                      uint8_t t_nnz[9], uint8_t l_nnz[9])
+void decode_mb_coeffs(VP8Context *s, VP8ThreadData *td, VP56RangeCoder *c,
+                      VP8Macroblock *mb, uint8_t t_nnz[9], uint8_t l_nnz[9])
 {
     int i, x, y, luma_start = 0, luma_ctx = 3;
     int nnz_pred, nnz, nnz_total = 0;
-    int segment = s->segment;
+    int segment = mb->segment;
     int block_dc = 0;
 
     if (mb->mode != MODE_I4x4 && mb->mode != VP8_MVMODE_SPLIT) {
         nnz_pred = t_nnz[8] + l_nnz[8];
 
         // decode DC values and do hadamard
-        nnz = decode_block_coeffs(c, s->block_dc, s->prob->token[1], 0, nnz_pred,
+        nnz = decode_block_coeffs(c, td->block_dc, s->prob->token[1], 0, nnz_pred,
                                   s->qmat[segment].luma_dc_qmul);
         l_nnz[8] = t_nnz[8] = !!nnz;
         if (nnz) {
             nnz_total += nnz;
             block_dc = 1;
             if (nnz == 1)
-                s->vp8dsp.vp8_luma_dc_wht_dc(s->block, s->block_dc);
+                s->vp8dsp.vp8_luma_dc_wht_dc(td->block, td->block_dc);
             else
-                s->vp8dsp.vp8_luma_dc_wht(s->block, s->block_dc);
+                s->vp8dsp.vp8_luma_dc_wht(td->block, td->block_dc);
         }
         luma_start = 1;
         luma_ctx = 0;
@@ -911,10 +1011,10 @@ void decode_mb_coeffs(VP8Context *s, VP56RangeCoder *c, VP8Macroblock *mb,
     for (y = 0; y < 4; y++)
         for (x = 0; x < 4; x++) {
             nnz_pred = l_nnz[y] + t_nnz[x];
-            nnz = decode_block_coeffs(c, s->block[y][x], s->prob->token[luma_ctx], luma_start,
+            nnz = decode_block_coeffs(c, td->block[y][x], s->prob->token[luma_ctx], luma_start,
                                       nnz_pred, s->qmat[segment].luma_qmul);
             // nnz+block_dc may be one more than the actual last index, but we don't care
-            s->non_zero_count_cache[y][x] = nnz + block_dc;
+            td->non_zero_count_cache[y][x] = nnz + block_dc;
             t_nnz[x] = l_nnz[y] = !!nnz;
             nnz_total += nnz;
         }
@@ -926,9 +1026,9 @@ void decode_mb_coeffs(VP8Context *s, VP56RangeCoder *c, VP8Macroblock *mb,
         for (y = 0; y < 2; y++)
             for (x = 0; x < 2; x++) {
                 nnz_pred = l_nnz[i+2*y] + t_nnz[i+2*x];
-                nnz = decode_block_coeffs(c, s->block[i][(y<<1)+x], s->prob->token[2], 0,
+                nnz = decode_block_coeffs(c, td->block[i][(y<<1)+x], s->prob->token[2], 0,
                                           nnz_pred, s->qmat[segment].chroma_qmul);
-                s->non_zero_count_cache[i][(y<<1)+x] = nnz;
+                td->non_zero_count_cache[i][(y<<1)+x] = nnz;
                 t_nnz[i+2*x] = l_nnz[i+2*y] = !!nnz;
                 nnz_total += nnz;
             }
@@ -1073,8 +1173,8 @@ int check_intra_pred4x4_mode_emuedge(int mode, int mb_x, int mb_y, int *copy_buf
 }
 
 static av_always_inline
-void intra_predict(VP8Context *s, uint8_t *dst[3], VP8Macroblock *mb,
-                   int mb_x, int mb_y)
+void intra_predict(VP8Context *s, VP8ThreadData *td, uint8_t *dst[3],
+                   VP8Macroblock *mb, int mb_x, int mb_y)
 {
     AVCodecContext *avctx = s->avctx;
     int x, y, mode, nnz, tr;
@@ -1095,7 +1195,7 @@ void intra_predict(VP8Context *s, uint8_t *dst[3], VP8Macroblock *mb,
         s->hpc.pred16x16[mode](dst[0], s->linesize);
     } else {
         uint8_t *ptr = dst[0];
-        uint8_t *intra4x4 = s->intra4x4_pred_mode_mb;
+        uint8_t *intra4x4 = mb->intra4x4_pred_mode_mb;
         uint8_t tr_top[4] = { 127, 127, 127, 127 };
 
         // all blocks on the right edge of the macroblock use bottom edge
@@ -1111,7 +1211,7 @@ void intra_predict(VP8Context *s, uint8_t *dst[3], VP8Macroblock *mb,
         }
 
         if (mb->skip)
-            AV_ZERO128(s->non_zero_count_cache);
+            AV_ZERO128(td->non_zero_count_cache);
 
         for (y = 0; y < 4; y++) {
             uint8_t *topright = ptr + 4 - s->linesize;
@@ -1164,12 +1264,12 @@ void intra_predict(VP8Context *s, uint8_t *dst[3], VP8Macroblock *mb,
                     * (uint32_t *) (ptr+4*x+s->linesize*3) = * (uint32_t *) (copy_dst + 36);
                 }
 
-                nnz = s->non_zero_count_cache[y][x];
+                nnz = td->non_zero_count_cache[y][x];
                 if (nnz) {
                     if (nnz == 1)
-                        s->vp8dsp.vp8_idct_dc_add(ptr+4*x, s->block[y][x], s->linesize);
+                        s->vp8dsp.vp8_idct_dc_add(ptr+4*x, td->block[y][x], s->linesize);
                     else
-                        s->vp8dsp.vp8_idct_add(ptr+4*x, s->block[y][x], s->linesize);
+                        s->vp8dsp.vp8_idct_add(ptr+4*x, td->block[y][x], s->linesize);
                 }
                 topright += 4;
             }
@@ -1180,9 +1280,9 @@ void intra_predict(VP8Context *s, uint8_t *dst[3], VP8Macroblock *mb,
     }
 
     if (avctx->flags & CODEC_FLAG_EMU_EDGE) {
-        mode = check_intra_pred8x8_mode_emuedge(s->chroma_pred_mode, mb_x, mb_y);
+        mode = check_intra_pred8x8_mode_emuedge(mb->chroma_pred_mode, mb_x, mb_y);
     } else {
-        mode = check_intra_pred8x8_mode(s->chroma_pred_mode, mb_x, mb_y);
+        mode = check_intra_pred8x8_mode(mb->chroma_pred_mode, mb_x, mb_y);
     }
     s->hpc.pred8x8[mode](dst[1], s->uvlinesize);
     s->hpc.pred8x8[mode](dst[2], s->uvlinesize);
@@ -1197,8 +1297,11 @@ void intra_predict(VP8Context *s, uint8_t *dst[3], VP8Macroblock *mb,
  * Generic MC function.
  *
  * @param s VP8 decoding context
+ * @param td thread data holding the edge emulation buffer
  * @param luma 1 for luma (Y) planes, 0 for chroma (Cb/Cr) planes
  * @param dst target buffer for block data at block position
+ * @param ref reference picture, used to wait for the rows being read
+ *            when it is still being decoded by another thread
  * @param src reference picture buffer at origin (0, 0)
  * @param mv motion vector (relative to block position) to get pixel data from
  * @param x_off horizontal position of block from origin (0, 0)
@@ -1211,8 +1314,8 @@ void intra_predict(VP8Context *s, uint8_t *dst[3], VP8Macroblock *mb,
  * @param mc_func motion compensation function pointers (bilinear or sixtap MC)
  */
 static av_always_inline
-void vp8_mc(VP8Context *s, int luma,
-            uint8_t *dst, uint8_t *src, const VP56mv *mv,
+void vp8_mc(VP8Context *s, VP8ThreadData *td, int luma,
+            uint8_t *dst, AVFrame *ref, uint8_t *src, const VP56mv *mv,
             int x_off, int y_off, int block_w, int block_h,
             int width, int height, int linesize,
             vp8_mc_func mc_func[3][3])
@@ -1225,22 +1328,28 @@ void vp8_mc(VP8Context *s, int luma,
         x_off += mv->x >> (3 - luma);
         y_off += mv->y >> (3 - luma);
 
+        // the last row read by the subpel filter plus the rows still
+        // modified by the loop filter of the next macroblock row
+        ff_thread_await_progress(ref, (y_off + block_h + 5) >> (3 + luma), 0);
+
         // edge emulation
         src += y_off * linesize + x_off;
         if (x_off < 2 || x_off >= width  - block_w - 3 ||
             y_off < 2 || y_off >= height - block_h - 3) {
-            ff_emulated_edge_mc(s->edge_emu_buffer, src - 2 * linesize - 2, linesize,
+            ff_emulated_edge_mc(td->edge_emu_buffer, src - 2 * linesize - 2, linesize,
                                 block_w + 5, block_h + 5,
                                 x_off - 2, y_off - 2, width, height);
-            src = s->edge_emu_buffer + 2 + linesize * 2;
+            src = td->edge_emu_buffer + 2 + linesize * 2;
         }
         mc_func[my_idx][mx_idx](dst, linesize, src, linesize, block_h, mx, my);
-    } else
+    } else {
+        ff_thread_await_progress(ref, (y_off + block_h + 2) >> (3 + luma), 0);
         mc_func[0][0](dst, linesize, src + y_off * linesize + x_off, linesize, block_h, 0, 0);
+    }
 }
 
 static av_always_inline
-void vp8_mc_part(VP8Context *s, uint8_t *dst[3],
+void vp8_mc_part(VP8Context *s, VP8ThreadData *td, uint8_t *dst[3],
                  AVFrame *ref_frame, int x_off, int y_off,
                  int bx_off, int by_off,
                  int block_w, int block_h,
@@ -1249,8 +1358,8 @@ void vp8_mc_part(VP8Context *s, uint8_t *dst[3],
     VP56mv uvmv = *mv;
 
     /* Y */
-    vp8_mc(s, 1, dst[0] + by_off * s->linesize + bx_off,
-           ref_frame->data[0], mv, x_off + bx_off, y_off + by_off,
+    vp8_mc(s, td, 1, dst[0] + by_off * s->linesize + bx_off,
+           ref_frame, ref_frame->data[0], mv, x_off + bx_off, y_off + by_off,
            block_w, block_h, width, height, s->linesize,
            s->put_pixels_tab[block_w == 8]);
 
@@ -1263,12 +1372,12 @@ void vp8_mc_part(VP8Context *s, uint8_t *dst[3],
     bx_off  >>= 1; by_off  >>= 1;
     width   >>= 1; height  >>= 1;
     block_w >>= 1; block_h >>= 1;
-    vp8_mc(s, 0, dst[1] + by_off * s->uvlinesize + bx_off,
-           ref_frame->data[1], &uvmv, x_off + bx_off, y_off + by_off,
+    vp8_mc(s, td, 0, dst[1] + by_off * s->uvlinesize + bx_off,
+           ref_frame, ref_frame->data[1], &uvmv, x_off + bx_off, y_off + by_off,
            block_w, block_h, width, height, s->uvlinesize,
            s->put_pixels_tab[1 + (block_w == 4)]);
-    vp8_mc(s, 0, dst[2] + by_off * s->uvlinesize + bx_off,
-           ref_frame->data[2], &uvmv, x_off + bx_off, y_off + by_off,
+    vp8_mc(s, td, 0, dst[2] + by_off * s->uvlinesize + bx_off,
+           ref_frame, ref_frame->data[2], &uvmv, x_off + bx_off, y_off + by_off,
            block_w, block_h, width, height, s->uvlinesize,
            s->put_pixels_tab[1 + (block_w == 4)]);
 }
@@ -1294,8 +1403,8 @@ static av_always_inline void prefetch_motion(VP8Context *s, VP8Macroblock *mb, i
  * Apply motion vectors to prediction buffer, chapter 18.
  */
 static av_always_inline
-void inter_predict(VP8Context *s, uint8_t *dst[3], VP8Macroblock *mb,
-                   int mb_x, int mb_y)
+void inter_predict(VP8Context *s, VP8ThreadData *td, uint8_t *dst[3],
+                   VP8Macroblock *mb, int mb_x, int mb_y)
 {
     int x_off = mb_x << 4, y_off = mb_y << 4;
     int width = 16*s->mb_width, height = 16*s->mb_height;
@@ -1303,7 +1412,7 @@ void inter_predict(VP8Context *s, uint8_t *dst[3], VP8Macroblock *mb,
     VP56mv *bmv = mb->bmv;
 
     if (mb->mode < VP8_MVMODE_SPLIT) {
-        vp8_mc_part(s, dst, ref, x_off, y_off,
+        vp8_mc_part(s, td, dst, ref, x_off, y_off,
                     0, 0, 16, 16, width, height, &mb->mv);
     } else switch (mb->partitioning) {
     case VP8_SPLITMVMODE_4x4: {
@@ -1313,8 +1422,8 @@ void inter_predict(VP8Context *s, uint8_t *dst[3], VP8Macroblock *mb,
         /* Y */
         for (y = 0; y < 4; y++) {
             for (x = 0; x < 4; x++) {
-                vp8_mc(s, 1, dst[0] + 4*y*s->linesize + x*4,
-                       ref->data[0], &bmv[4*y + x],
+                vp8_mc(s, td, 1, dst[0] + 4*y*s->linesize + x*4,
+                       ref, ref->data[0], &bmv[4*y + x],
                        4*x + x_off, 4*y + y_off, 4, 4,
                        width, height, s->linesize,
                        s->put_pixels_tab[2]);
@@ -1339,13 +1448,13 @@ void inter_predict(VP8Context *s, uint8_t *dst[3], VP8Macroblock *mb,
                     uvmv.x &= ~7;
                     uvmv.y &= ~7;
                 }
-                vp8_mc(s, 0, dst[1] + 4*y*s->uvlinesize + x*4,
-                       ref->data[1], &uvmv,
+                vp8_mc(s, td, 0, dst[1] + 4*y*s->uvlinesize + x*4,
+                       ref, ref->data[1], &uvmv,
                        4*x + x_off, 4*y + y_off, 4, 4,
                        width, height, s->uvlinesize,
                        s->put_pixels_tab[2]);
-                vp8_mc(s, 0, dst[2] + 4*y*s->uvlinesize + x*4,
-                       ref->data[2], &uvmv,
+                vp8_mc(s, td, 0, dst[2] + 4*y*s->uvlinesize + x*4,
+                       ref, ref->data[2], &uvmv,
                        4*x + x_off, 4*y + y_off, 4, 4,
                        width, height, s->uvlinesize,
                        s->put_pixels_tab[2]);
@@ -1354,51 +1463,51 @@ void inter_predict(VP8Context *s, uint8_t *dst[3], VP8Macroblock *mb,
         break;
     }
     case VP8_SPLITMVMODE_16x8:
-        vp8_mc_part(s, dst, ref, x_off, y_off,
+        vp8_mc_part(s, td, dst, ref, x_off, y_off,
                     0, 0, 16, 8, width, height, &bmv[0]);
-        vp8_mc_part(s, dst, ref, x_off, y_off,
+        vp8_mc_part(s, td, dst, ref, x_off, y_off,
                     0, 8, 16, 8, width, height, &bmv[1]);
         break;
     case VP8_SPLITMVMODE_8x16:
-        vp8_mc_part(s, dst, ref, x_off, y_off,
+        vp8_mc_part(s, td, dst, ref, x_off, y_off,
                     0, 0, 8, 16, width, height, &bmv[0]);
-        vp8_mc_part(s, dst, ref, x_off, y_off,
+        vp8_mc_part(s, td, dst, ref, x_off, y_off,
                     8, 0, 8, 16, width, height, &bmv[1]);
         break;
     case VP8_SPLITMVMODE_8x8:
-        vp8_mc_part(s, dst, ref, x_off, y_off,
+        vp8_mc_part(s, td, dst, ref, x_off, y_off,
                     0, 0, 8, 8, width, height, &bmv[0]);
-        vp8_mc_part(s, dst, ref, x_off, y_off,
+        vp8_mc_part(s, td, dst, ref, x_off, y_off,
                     8, 0, 8, 8, width, height, &bmv[1]);
-        vp8_mc_part(s, dst, ref, x_off, y_off,
+        vp8_mc_part(s, td, dst, ref, x_off, y_off,
                     0, 8, 8, 8, width, height, &bmv[2]);
-        vp8_mc_part(s, dst, ref, x_off, y_off,
+        vp8_mc_part(s, td, dst, ref, x_off, y_off,
                     8, 8, 8, 8, width, height, &bmv[3]);
         break;
     }
 }
 
-static av_always_inline void idct_mb(VP8Context *s, uint8_t *dst[3], VP8Macroblock *mb)
+static av_always_inline void idct_mb(VP8Context *s, VP8ThreadData *td, uint8_t *dst[3], VP8Macroblock *mb)
 {
     int x, y, ch;
 
     if (mb->mode != MODE_I4x4) {
         uint8_t *y_dst = dst[0];
         for (y = 0; y < 4; y++) {
-            uint32_t nnz4 = AV_RN32A(s->non_zero_count_cache[y]);
+            uint32_t nnz4 = AV_RN32A(td->non_zero_count_cache[y]);
             if (nnz4) {
                 if (nnz4&~0x01010101) {
                     for (x = 0; x < 4; x++) {
-                        int nnz = s->non_zero_count_cache[y][x];
+                        int nnz = td->non_zero_count_cache[y][x];
                         if (nnz) {
                             if (nnz == 1)
-                                s->vp8dsp.vp8_idct_dc_add(y_dst+4*x, s->block[y][x], s->linesize);
+                                s->vp8dsp.vp8_idct_dc_add(y_dst+4*x, td->block[y][x], s->linesize);
                             else
-                                s->vp8dsp.vp8_idct_add(y_dst+4*x, s->block[y][x], s->linesize);
+                                s->vp8dsp.vp8_idct_add(y_dst+4*x, td->block[y][x], s->linesize);
                         }
                     }
                 } else {
-                    s->vp8dsp.vp8_idct_dc_add4y(y_dst, s->block[y], s->linesize);
+                    s->vp8dsp.vp8_idct_dc_add4y(y_dst, td->block[y], s->linesize);
                 }
             }
             y_dst += 4*s->linesize;
@@ -1406,24 +1515,24 @@ static av_always_inline void idct_mb(VP8Context *s, uint8_t *dst[3], VP8Macroblo
     }
 
     for (ch = 0; ch < 2; ch++) {
-        uint32_t nnz4 = AV_RN32A(s->non_zero_count_cache[4+ch]);
+        uint32_t nnz4 = AV_RN32A(td->non_zero_count_cache[4+ch]);
         if (nnz4) {
             uint8_t *ch_dst = dst[1+ch];
             if (nnz4&~0x01010101) {
                 for (y = 0; y < 2; y++) {
                     for (x = 0; x < 2; x++) {
-                        int nnz = s->non_zero_count_cache[4+ch][(y<<1)+x];
+                        int nnz = td->non_zero_count_cache[4+ch][(y<<1)+x];
                         if (nnz) {
                             if (nnz == 1)
-                                s->vp8dsp.vp8_idct_dc_add(ch_dst+4*x, s->block[4+ch][(y<<1)+x], s->uvlinesize);
+                                s->vp8dsp.vp8_idct_dc_add(ch_dst+4*x, td->block[4+ch][(y<<1)+x], s->uvlinesize);
                             else
-                                s->vp8dsp.vp8_idct_add(ch_dst+4*x, s->block[4+ch][(y<<1)+x], s->uvlinesize);
+                                s->vp8dsp.vp8_idct_add(ch_dst+4*x, td->block[4+ch][(y<<1)+x], s->uvlinesize);
                         }
                     }
                     ch_dst += 4*s->uvlinesize;
                 }
             } else {
-                s->vp8dsp.vp8_idct_dc_add4uv(ch_dst, s->block[4+ch], s->uvlinesize);
+                s->vp8dsp.vp8_idct_dc_add4uv(ch_dst, td->block[4+ch], s->uvlinesize);
             }
         }
     }
@@ -1434,7 +1543,7 @@ static av_always_inline void filter_level_for_mb(VP8Context *s, VP8Macroblock *m
     int interior_limit, filter_level;
 
     if (s->segmentation.enabled) {
-        filter_level = s->segmentation.filter_level[s->segment];
+        filter_level = s->segmentation.filter_level[mb->segment];
         if (!s->segmentation.absolute_vals)
             filter_level += s->filter.level;
     } else
@@ -1569,17 +1678,21 @@ static av_always_inline void filter_mb_simple(VP8Context *s, uint8_t *dst, VP8Fi
     }
 }
 
-static void filter_mb_row(VP8Context *s, int mb_y)
+/**
+ * Filter the macroblocks start_x to end_x-1 of a row.
+ */
+static void filter_mb_row(VP8Context *s, VP8ThreadData *td, int mb_y,
+                          int start_x, int end_x)
 {
-    VP8FilterStrength *f = s->filter_strength;
+    VP8FilterStrength *f = td->filter_strength + start_x;
     uint8_t *dst[3] = {
-        s->framep[VP56_FRAME_CURRENT]->data[0] + 16*mb_y*s->linesize,
-        s->framep[VP56_FRAME_CURRENT]->data[1] +  8*mb_y*s->uvlinesize,
-        s->framep[VP56_FRAME_CURRENT]->data[2] +  8*mb_y*s->uvlinesize
+        s->framep[VP56_FRAME_CURRENT]->data[0] + 16*mb_y*s->linesize   + 16*start_x,
+        s->framep[VP56_FRAME_CURRENT]->data[1] +  8*mb_y*s->uvlinesize +  8*start_x,
+        s->framep[VP56_FRAME_CURRENT]->data[2] +  8*mb_y*s->uvlinesize +  8*start_x
     };
     int mb_x;
 
-    for (mb_x = 0; mb_x < s->mb_width; mb_x++) {
+    for (mb_x = start_x; mb_x < end_x; mb_x++) {
         backup_mb_border(s->top_border[mb_x+1], dst[0], dst[1], dst[2], s->linesize, s->uvlinesize, 0);
         filter_mb(s, dst, f++, mb_x, mb_y);
         dst[0] += 16;
@@ -1588,29 +1701,226 @@ static void filter_mb_row(VP8Context *s, int mb_y)
     }
 }
 
-static void filter_mb_row_simple(VP8Context *s, int mb_y)
+static void filter_mb_row_simple(VP8Context *s, VP8ThreadData *td, int mb_y,
+                                 int start_x, int end_x)
 {
-    VP8FilterStrength *f = s->filter_strength;
-    uint8_t *dst = s->framep[VP56_FRAME_CURRENT]->data[0] + 16*mb_y*s->linesize;
+    VP8FilterStrength *f = td->filter_strength + start_x;
+    uint8_t *dst = s->framep[VP56_FRAME_CURRENT]->data[0] + 16*mb_y*s->linesize + 16*start_x;
     int mb_x;
 
-    for (mb_x = 0; mb_x < s->mb_width; mb_x++) {
+    for (mb_x = start_x; mb_x < end_x; mb_x++) {
         backup_mb_border(s->top_border[mb_x+1], dst, NULL, NULL, s->linesize, 0, 1);
         filter_mb_simple(s, dst, f++, mb_x, mb_y);
         dst += 16;
     }
 }
 
+/**
+ * Decode the coefficients of a macroblock row, reconstruct it and apply
+ * the loop filter.
+ *
+ * @param curmap,prevmap segmentation maps, only used when the modes are
+ *                       decoded along with the row (mb_layout 0)
+ * @param sliced 1 if the row is decoded by one of several jobs (mb_layout 1),
+ *               in which case the row above may still be decoded by another
+ *               job, so each macroblock waits for it to be ready and the loop
+ *               filter runs one macroblock behind the reconstruction
+ */
+static av_always_inline
+void decode_mb_row(VP8Context *s, VP8ThreadData *td, int mb_y,
+                   uint8_t *curmap, uint8_t *prevmap, int sliced)
+{
+    AVCodecContext *avctx = s->avctx;
+    AVFrame *curframe = s->framep[VP56_FRAME_CURRENT];
+    VP56RangeCoder *c = &s->coeff_partition[mb_y & (s->num_coeff_partitions-1)];
+    VP8Macroblock *mb;
+    int mb_x, i, y, mb_xy = mb_y*s->mb_width;
+    uint8_t *dst[3] = {
+        curframe->data[0] + 16*mb_y*s->linesize,
+        curframe->data[1] +  8*mb_y*s->uvlinesize,
+        curframe->data[2] +  8*mb_y*s->uvlinesize
+    };
+
+    if (sliced) {
+        mb = s->macroblocks + mb_y*(s->mb_width+1);
+    } else {
+        mb = s->macroblocks + (s->mb_height - mb_y - 1)*2;
+        memset(mb - 1, 0, sizeof(*mb));   // zero left macroblock
+        AV_WN32A(s->intra4x4_pred_mode_left, DC_PRED*0x01010101);
+    }
+    memset(td->left_nnz, 0, sizeof(td->left_nnz));
+
+    // the top left edge below is still read by the first
+    // macroblock of the row above
+    if (sliced && mb_y)
+        ff_thread_await_progress2(avctx, mb_y-1, FFMIN(2, s->mb_width));
+
+    // left edge of 129 for intra prediction
+    if (!(avctx->flags & CODEC_FLAG_EMU_EDGE)) {
+        for (i = 0; i < 3; i++)
+            for (y = 0; y < 16>>!!i; y++)
+                dst[i][y*curframe->linesize[i]-1] = 129;
+        if (mb_y == 1) // top left edge is also 129
+            s->top_border[0][15] = s->top_border[0][23] = s->top_border[0][31] = 129;
+    }
+
+    for (mb_x = 0; mb_x < s->mb_width; mb_x++, mb_xy++, mb++) {
+        // intra prediction reads the row above up to the top-right
+        // macroblock, and top_nnz and top_border up to this one
+        if (sliced && mb_y)
+            ff_thread_await_progress2(avctx, mb_y-1, FFMIN(mb_x+2, s->mb_width));
+
+        /* Prefetch the current frame, 4 MBs ahead */
+        s->dsp.prefetch(dst[0] + (mb_x&3)*4*s->linesize + 64, s->linesize, 4);
+        s->dsp.prefetch(dst[1] + (mb_x&7)*s->uvlinesize + 64, dst[2] - dst[1], 2);
+
+        if (!sliced)
+            decode_mb_mode(s, mb, mb_x, mb_y, curmap + mb_xy,
+                           prevmap ? prevmap + mb_xy : NULL, 0);
+
+        prefetch_motion(s, mb, mb_x, mb_y, mb_xy, VP56_FRAME_PREVIOUS);
+
+        if (!mb->skip)
+            decode_mb_coeffs(s, td, c, mb, s->top_nnz[mb_x], td->left_nnz);
+
+        if (mb->mode <= MODE_I4x4)
+            intra_predict(s, td, dst, mb, mb_x, mb_y);
+        else
+            inter_predict(s, td, dst, mb, mb_x, mb_y);
+
+        prefetch_motion(s, mb, mb_x, mb_y, mb_xy, VP56_FRAME_GOLDEN);
+
+        if (!mb->skip) {
+            idct_mb(s, td, dst, mb);
+        } else {
+            AV_ZERO64(td->left_nnz);
+            AV_WN64(s->top_nnz[mb_x], 0);   // array of 9, so unaligned
+
+            // Reset DC block predictors if they would exist if the mb had coefficients
+            if (mb->mode != MODE_I4x4 && mb->mode != VP8_MVMODE_SPLIT) {
+                td->left_nnz[8]     = 0;
+                s->top_nnz[mb_x][8] = 0;
+            }
+        }
+
+        if (s->deblock_filter)
+            filter_level_for_mb(s, mb, &td->filter_strength[mb_x]);
+
+        prefetch_motion(s, mb, mb_x, mb_y, mb_xy, VP56_FRAME_GOLDEN2);
+
+        // the previous macroblock is filtered once this one no longer needs
+        // its top border saved in top_border
+        if (sliced) {
+            if (!s->deblock_filter) {
+                ff_thread_report_progress2(avctx, mb_y, mb_x+1);
+            } else if (mb_x) {
+                if (s->filter.simple)
+                    filter_mb_row_simple(s, td, mb_y, mb_x-1, mb_x);
+                else
+                    filter_mb_row(s, td, mb_y, mb_x-1, mb_x);
+                ff_thread_report_progress2(avctx, mb_y, mb_x);
+            }
+        }
+
+        dst[0] += 16;
+        dst[1] += 8;
+        dst[2] += 8;
+    }
+    if (s->deblock_filter) {
+        int start_x = sliced ? s->mb_width-1 : 0;
+        if (s->filter.simple)
+            filter_mb_row_simple(s, td, mb_y, start_x, s->mb_width);
+        else
+            filter_mb_row(s, td, mb_y, start_x, s->mb_width);
+        if (sliced)
+            ff_thread_report_progress2(avctx, mb_y, s->mb_width);
+    }
+    ff_thread_report_progress(curframe, mb_y, 0);
+}
+
+/**
+ * Decode the modes and motion vectors of the whole frame (mb_layout 1).
+ */
+static void decode_mb_modes(VP8Context *s, AVFrame *prev_frame,
+                            uint8_t *curmap, uint8_t *prevmap)
+{
+    int mb_x, mb_y, mb_xy = 0;
+
+    for (mb_y = 0; mb_y < s->mb_height; mb_y++) {
+        VP8Macroblock *mb = s->macroblocks + mb_y*(s->mb_width+1);
+
+        memset(mb - 1, 0, sizeof(*mb));   // zero left macroblock
+        AV_WN32A(s->intra4x4_pred_mode_left, DC_PRED*0x01010101);
+
+        // the segment ids are carried over from the previous frame
+        if (prev_frame && !s->segmentation.update_map)
+            ff_thread_await_progress(prev_frame, mb_y, 0);
+
+        for (mb_x = 0; mb_x < s->mb_width; mb_x++, mb_xy++, mb++)
+            decode_mb_mode(s, mb, mb_x, mb_y, curmap + mb_xy,
+                           prevmap ? prevmap + mb_xy : NULL, 1);
+    }
+}
+
+/**
+ * Decode every num_jobs-th macroblock row, starting at row jobnr.
+ * Since num_jobs divides the number of coefficient partitions, all rows
+ * sharing a partition are decoded in order by the same job.
+ */
+static int decode_mb_rows_sliced(AVCodecContext *avctx, void *tdata,
+                                 int jobnr, int threadnr)
+{
+    VP8Context *s = avctx->priv_data;
+    VP8ThreadData *td = (VP8ThreadData *)tdata + jobnr;
+    int mb_y;
+
+    for (mb_y = jobnr; mb_y < s->mb_height; mb_y += s->num_jobs)
+        decode_mb_row(s, td, mb_y, NULL, NULL, 1);
+
+    return 0;
+}
+
+/**
+ * Compute the references of the next frame into next_framep. They are
+ * updated in the same order as they used to be in place, so an altref
+ * update is seen by a golden update reading it.
+ */
+static void set_next_refs(VP8Context *s)
+{
+    memcpy(&s->next_framep[0], &s->framep[0], sizeof(s->framep[0]) * 4);
+
+    // check if golden and altref are swapped
+    if (s->update_altref == VP56_FRAME_GOLDEN &&
+        s->update_golden == VP56_FRAME_GOLDEN2)
+        FFSWAP(AVFrame *, s->next_framep[VP56_FRAME_GOLDEN], s->next_framep[VP56_FRAME_GOLDEN2]);
+    else {
+        if (s->update_altref != VP56_FRAME_NONE)
+            s->next_framep[VP56_FRAME_GOLDEN2] = s->next_framep[s->update_altref];
+
+        if (s->update_golden != VP56_FRAME_NONE)
+            s->next_framep[VP56_FRAME_GOLDEN] = s->next_framep[s->update_golden];
+    }
+
+    if (s->update_last) // move cur->prev
+        s->next_framep[VP56_FRAME_PREVIOUS] = s->next_framep[VP56_FRAME_CURRENT];
+}
+
 static int vp8_decode_frame(AVCodecContext *avctx, void *data, int *data_size,
                             AVPacket *avpkt)
 {
     VP8Context *s = avctx->priv_data;
-    int ret, mb_x, mb_y, i, y, referenced;
+    int ret, mb_y, i, j, referenced;
     enum AVDiscard skip_thresh;
-    AVFrame *av_uninit(curframe);
+    AVFrame *av_uninit(curframe), *prev_frame;
+    uint8_t *curmap = NULL, *prevmap = NULL;
+
+    free_queued_segmentation_maps(s);
 
     if ((ret = decode_frame_header(s, avpkt->data, avpkt->size)) < 0)
-        return ret;
+        goto err;
+
+    // read after the header, a size change drops all references
+    prev_frame = s->framep[VP56_FRAME_CURRENT];
 
     referenced = s->update_last || s->update_golden == VP56_FRAME_CURRENT
                                 || s->update_altref == VP56_FRAME_CURRENT;
@@ -1620,27 +1930,20 @@ static int vp8_decode_frame(AVCodecContext *avctx, void *data, int *data_size,
 
     if (avctx->skip_frame >= skip_thresh) {
         s->invisible = 1;
+        set_next_refs(s);
         goto skip_decode;
     }
     s->deblock_filter = s->filter.level && avctx->skip_loop_filter < skip_thresh;
 
-    for (i = 0; i < 4; i++)
-        if (&s->frames[i] != s->framep[VP56_FRAME_PREVIOUS] &&
+    // release no longer referenced frames; the previous frame is kept
+    // since its segmentation map may still be read by this frame
+    for (i = 0; i < 5; i++)
+        if (s->frames[i].data[0] &&
+            &s->frames[i] != prev_frame &&
+            &s->frames[i] != s->framep[VP56_FRAME_PREVIOUS] &&
             &s->frames[i] != s->framep[VP56_FRAME_GOLDEN] &&
-            &s->frames[i] != s->framep[VP56_FRAME_GOLDEN2]) {
-            curframe = s->framep[VP56_FRAME_CURRENT] = &s->frames[i];
-            break;
-        }
-    if (curframe->data[0])
-        avctx->release_buffer(avctx, curframe);
-
-    curframe->key_frame = s->keyframe;
-    curframe->pict_type = s->keyframe ? FF_I_TYPE : FF_P_TYPE;
-    curframe->reference = referenced ? 3 : 0;
-    if ((ret = avctx->get_buffer(avctx, curframe))) {
-        av_log(avctx, AV_LOG_ERROR, "get_buffer() failed!\n");
-        return ret;
-    }
+            &s->frames[i] != s->framep[VP56_FRAME_GOLDEN2])
+            vp8_release_frame(s, i, 0);
 
     // Given that arithmetic probabilities are updated every frame, it's quite likely
     // that the values we have on a random interframe are complete junk if we didn't
@@ -1649,19 +1952,66 @@ static int vp8_decode_frame(AVCodecContext *avctx, void *data, int *data_size,
                          !s->framep[VP56_FRAME_GOLDEN] ||
                          !s->framep[VP56_FRAME_GOLDEN2])) {
         av_log(avctx, AV_LOG_WARNING, "Discarding interframe without a prior keyframe!\n");
-        return AVERROR_INVALIDDATA;
+        ret = AVERROR_INVALIDDATA;
+        goto err;
+    }
+
+    if (s->mb_layout && (ret = ff_thread_alloc_progress2(avctx, s->mb_height)) < 0)
+        goto err;
+
+    // find a free buffer
+    for (i = 0; i < 5; i++)
+        if (&s->frames[i] != prev_frame &&
+            &s->frames[i] != s->framep[VP56_FRAME_PREVIOUS] &&
+            &s->frames[i] != s->framep[VP56_FRAME_GOLDEN] &&
+            &s->frames[i] != s->framep[VP56_FRAME_GOLDEN2])
+            break;
+    if (i == 5) {
+        av_log(avctx, AV_LOG_ERROR, "Ran out of free frames!\n");
+        ret = AVERROR_INVALIDDATA;
+        goto err;
     }
+    curframe = &s->frames[i];
+    if (curframe->data[0])
+        vp8_release_frame(s, i, 0);
+
+    curframe->key_frame = s->keyframe;
+    curframe->pict_type = s->keyframe ? FF_I_TYPE : FF_P_TYPE;
+    curframe->reference = referenced ? 3 : 0;
+    if ((ret = ff_thread_get_buffer(avctx, curframe))) {
+        av_log(avctx, AV_LOG_ERROR, "get_buffer() failed!\n");
+        goto err;
+    }
+    if (!(s->segmentation_maps[i] = av_mallocz(s->mb_width * s->mb_height))) {
+        vp8_release_frame(s, i, 0);
+        ret = AVERROR(ENOMEM);
+        goto err;
+    }
+    for (j = 0; j < s->num_thread_data; j++)
+        if (!s->thread_data[j].edge_emu_buffer &&
+            !(s->thread_data[j].edge_emu_buffer = av_malloc(21*curframe->linesize[0]))) {
+            vp8_release_frame(s, i, 0);
+            ret = AVERROR(ENOMEM);
+            goto err;
+        }
+    curmap = s->segmentation_maps[i];
+    if (prev_frame)
+        prevmap = s->segmentation_maps[prev_frame - s->frames];
+
+    s->framep[VP56_FRAME_CURRENT] = curframe;
+
+    set_next_refs(s);
+
+    ff_thread_finish_setup(avctx);
 
     s->linesize   = curframe->linesize[0];
     s->uvlinesize = curframe->linesize[1];
 
-    if (!s->edge_emu_buffer)
-        s->edge_emu_buffer = av_malloc(21*s->linesize);
-
     memset(s->top_nnz, 0, s->mb_width*sizeof(*s->top_nnz));
 
     /* Zero macroblock structures for top/top-left prediction from outside the frame. */
-    memset(s->macroblocks + s->mb_height*2 - 1, 0, (s->mb_width+1)*sizeof(*s->macroblocks));
+    if (!s->mb_layout)
+        memset(s->macroblocks + s->mb_height*2 - 1, 0, (s->mb_width+1)*sizeof(*s->macroblocks));
 
     // top edge of 127 for intra prediction
     if (!(avctx->flags & CODEC_FLAG_EMU_EDGE)) {
@@ -1672,114 +2022,40 @@ static int vp8_decode_frame(AVCodecContext *avctx, void *data, int *data_size,
     if (s->keyframe)
         memset(s->intra4x4_pred_mode_top, DC_PRED, s->mb_width*4);
 
-    for (mb_y = 0; mb_y < s->mb_height; mb_y++) {
-        VP56RangeCoder *c = &s->coeff_partition[mb_y & (s->num_coeff_partitions-1)];
-        VP8Macroblock *mb = s->macroblocks + (s->mb_height - mb_y - 1)*2;
-        int mb_xy = mb_y*s->mb_width;
-        uint8_t *dst[3] = {
-            curframe->data[0] + 16*mb_y*s->linesize,
-            curframe->data[1] +  8*mb_y*s->uvlinesize,
-            curframe->data[2] +  8*mb_y*s->uvlinesize
-        };
-
-        memset(mb - 1, 0, sizeof(*mb));   // zero left macroblock
-        memset(s->left_nnz, 0, sizeof(s->left_nnz));
-        AV_WN32A(s->intra4x4_pred_mode_left, DC_PRED*0x01010101);
-
-        // left edge of 129 for intra prediction
-        if (!(avctx->flags & CODEC_FLAG_EMU_EDGE)) {
-            for (i = 0; i < 3; i++)
-                for (y = 0; y < 16>>!!i; y++)
-                    dst[i][y*curframe->linesize[i]-1] = 129;
-            if (mb_y == 1) // top left edge is also 129
-                s->top_border[0][15] = s->top_border[0][23] = s->top_border[0][31] = 129;
-        }
-
-        for (mb_x = 0; mb_x < s->mb_width; mb_x++, mb_xy++, mb++) {
-            /* Prefetch the current frame, 4 MBs ahead */
-            s->dsp.prefetch(dst[0] + (mb_x&3)*4*s->linesize + 64, s->linesize, 4);
-            s->dsp.prefetch(dst[1] + (mb_x&7)*s->uvlinesize + 64, dst[2] - dst[1], 2);
-
-            decode_mb_mode(s, mb, mb_x, mb_y, s->segmentation_map + mb_xy);
-
-            prefetch_motion(s, mb, mb_x, mb_y, mb_xy, VP56_FRAME_PREVIOUS);
-
-            if (!mb->skip)
-                decode_mb_coeffs(s, c, mb, s->top_nnz[mb_x], s->left_nnz);
+    if (s->mb_layout) {
+        decode_mb_modes(s, prev_frame, curmap, prevmap);
 
-            if (mb->mode <= MODE_I4x4)
-                intra_predict(s, dst, mb, mb_x, mb_y);
-            else
-                inter_predict(s, dst, mb, mb_x, mb_y);
-
-            prefetch_motion(s, mb, mb_x, mb_y, mb_xy, VP56_FRAME_GOLDEN);
-
-            if (!mb->skip) {
-                idct_mb(s, dst, mb);
-            } else {
-                AV_ZERO64(s->left_nnz);
-                AV_WN64(s->top_nnz[mb_x], 0);   // array of 9, so unaligned
-
-                // Reset DC block predictors if they would exist if the mb had coefficients
-                if (mb->mode != MODE_I4x4 && mb->mode != VP8_MVMODE_SPLIT) {
-                    s->left_nnz[8]      = 0;
-                    s->top_nnz[mb_x][8] = 0;
-                }
-            }
-
-            if (s->deblock_filter)
-                filter_level_for_mb(s, mb, &s->filter_strength[mb_x]);
-
-            prefetch_motion(s, mb, mb_x, mb_y, mb_xy, VP56_FRAME_GOLDEN2);
+        s->num_jobs = 1 << av_log2(FFMIN(s->num_coeff_partitions, s->num_thread_data));
+        avctx->execute2(avctx, decode_mb_rows_sliced, s->thread_data, NULL, s->num_jobs);
+    } else {
+        for (mb_y = 0; mb_y < s->mb_height; mb_y++) {
+            // the segment ids are carried over from the previous frame
+            if (prev_frame && !s->segmentation.update_map)
+                ff_thread_await_progress(prev_frame, mb_y, 0);
 
-            dst[0] += 16;
-            dst[1] += 8;
-            dst[2] += 8;
-        }
-        if (s->deblock_filter) {
-            if (s->filter.simple)
-                filter_mb_row_simple(s, mb_y);
-            else
-                filter_mb_row(s, mb_y);
+            decode_mb_row(s, s->thread_data, mb_y, curmap, prevmap, 0);
         }
     }
 
+    ff_thread_report_progress(curframe, INT_MAX, 0);
+
 skip_decode:
     // if future frames don't use the updated probabilities,
     // reset them to the values we saved
     if (!s->update_probabilities)
         s->prob[0] = s->prob[1];
 
-    // check if golden and altref are swapped
-    if (s->update_altref == VP56_FRAME_GOLDEN &&
-        s->update_golden == VP56_FRAME_GOLDEN2)
-        FFSWAP(AVFrame *, s->framep[VP56_FRAME_GOLDEN], s->framep[VP56_FRAME_GOLDEN2]);
-    else {
-        if (s->update_altref != VP56_FRAME_NONE)
-            s->framep[VP56_FRAME_GOLDEN2] = s->framep[s->update_altref];
-
-        if (s->update_golden != VP56_FRAME_NONE)
-            s->framep[VP56_FRAME_GOLDEN] = s->framep[s->update_golden];
-    }
-
-    if (s->update_last) // move cur->prev
-        s->framep[VP56_FRAME_PREVIOUS] = s->framep[VP56_FRAME_CURRENT];
-
-    // release no longer referenced frames
-    for (i = 0; i < 4; i++)
-        if (s->frames[i].data[0] &&
-            &s->frames[i] != s->framep[VP56_FRAME_CURRENT] &&
-            &s->frames[i] != s->framep[VP56_FRAME_PREVIOUS] &&
-            &s->frames[i] != s->framep[VP56_FRAME_GOLDEN] &&
-            &s->frames[i] != s->framep[VP56_FRAME_GOLDEN2])
-            avctx->release_buffer(avctx, &s->frames[i]);
+    memcpy(&s->framep[0], &s->next_framep[0], sizeof(s->framep[0]) * 4);
 
     if (!s->invisible) {
-        *(AVFrame*)data = *s->framep[VP56_FRAME_CURRENT];
+        *(AVFrame*)data = *curframe;
         *data_size = sizeof(AVFrame);
     }
 
     return avpkt->size;
+err:
+    memcpy(&s->next_framep[0], &s->framep[0], sizeof(s->framep[0]) * 4);
+    return ret;
 }
 
 static av_cold int vp8_decode_init(AVCodecContext *avctx)
@@ -1798,7 +2074,41 @@ static av_cold int vp8_decode_init(AVCodecContext *avctx)
 
 static av_cold int vp8_decode_free(AVCodecContext *avctx)
 {
-    vp8_decode_flush(avctx);
+    vp8_decode_flush_impl(avctx, 1);
+    return 0;
+}
+
+static av_cold int vp8_decode_init_thread_copy(AVCodecContext *avctx)
+{
+    VP8Context *s = avctx->priv_data;
+
+    s->avctx = avctx;
+
+    return 0;
+}
+
+#define REBASE(pic) \
+    pic ? pic - &s_src->frames[0] + &s->frames[0] : NULL
+
+static int vp8_decode_update_thread_context(AVCodecContext *dst, const AVCodecContext *src)
+{
+    VP8Context *s = dst->priv_data, *s_src = src->priv_data;
+    int i;
+
+    if (s->macroblocks_base &&
+        (s_src->mb_width != s->mb_width || s_src->mb_height != s->mb_height))
+        free_buffers(s);
+
+    s->prob[0] = s_src->prob[!s_src->update_probabilities];
+    s->segmentation = s_src->segmentation;
+    s->lf_delta = s_src->lf_delta;
+    memcpy(s->sign_bias, s_src->sign_bias, sizeof(s->sign_bias));
+
+    memcpy(&s->frames, &s_src->frames, sizeof(s->frames));
+    memcpy(&s->segmentation_maps, &s_src->segmentation_maps, sizeof(s->segmentation_maps));
+    for (i = 0; i < 4; i++)
+        s->framep[i] = REBASE(s_src->next_framep[i]);
+
     return 0;
 }
 
@@ -1811,7 +2121,9 @@ AVCodec vp8_decoder = {
     NULL,
     vp8_decode_free,
     vp8_decode_frame,
-    CODEC_CAP_DR1,
+    CODEC_CAP_DR1 | CODEC_CAP_FRAME_THREADS,
     .flush = vp8_decode_flush,
     .long_name = NULL_IF_CONFIG_SMALL("On2 VP8"),
+    .init_thread_copy      = ONLY_IF_THREADS_ENABLED(vp8_decode_init_thread_copy),
+    .update_thread_context = ONLY_IF_THREADS_ENABLED(vp8_decode_update_thread_context),
 };
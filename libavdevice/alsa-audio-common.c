@@ -38,6 +38,8 @@ static av_cold snd_pcm_format_t codec_id_to_pcm_format(int codec_id)
     switch(codec_id) {
         case CODEC_ID_PCM_S16LE: return SND_PCM_FORMAT_S16_LE;
         case CODEC_ID_PCM_S16BE: return SND_PCM_FORMAT_S16_BE;
+        case CODEC_ID_PCM_S32LE: return SND_PCM_FORMAT_S32_LE;
+        case CODEC_ID_PCM_S32BE: return SND_PCM_FORMAT_S32_BE;
         case CODEC_ID_PCM_S8:    return SND_PCM_FORMAT_S8;
         default:                 return SND_PCM_FORMAT_UNKNOWN;
     }
@@ -121,6 +123,12 @@ av_cold int ff_alsa_open(AVFormatContext *ctx, snd_pcm_stream_t mode,
 
     snd_pcm_hw_params_get_buffer_size_max(hw_params, &buffer_size);
     /* TODO: maybe use ctx->max_picture_buffer somehow */
+    if (mode == SND_PCM_STREAM_PLAYBACK && ctx->max_delay > 0) {
+        /* the buffer depth requested in max_delay allows low latency
+           playback, it must still hold at least two periods */
+        snd_pcm_hw_params_get_period_size_min(hw_params, &period_size, NULL);
+        buffer_size = FFMIN(buffer_size, FFMAX(2 * period_size, av_rescale(ctx->max_delay, *sample_rate, AV_TIME_BASE)));
+    }
     res = snd_pcm_hw_params_set_buffer_size_near(h, hw_params, &buffer_size);
     if (res < 0) {
         av_log(ctx, AV_LOG_ERROR, "cannot set ALSA buffer size (%s)\n",
@@ -136,6 +144,7 @@ av_cold int ff_alsa_open(AVFormatContext *ctx, snd_pcm_stream_t mode,
         goto fail;
     }
     s->period_size = period_size;
+    s->buffer_size = buffer_size;
 
     res = snd_pcm_hw_params(h, hw_params);
     if (res < 0) {
@@ -171,6 +180,7 @@ int ff_alsa_xrun_recover(AVFormatContext *s1, int err)
 
     av_log(s1, AV_LOG_WARNING, "ALSA buffer xrun.\n");
     if (err == -EPIPE) {
+        s->underruns++;
         err = snd_pcm_prepare(handle);
         if (err < 0) {
             av_log(s1, AV_LOG_ERROR, "cannot recover from underrun (snd_pcm_prepare failed: %s)\n", snd_strerror(err));
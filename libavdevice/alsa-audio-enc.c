@@ -93,6 +93,66 @@ static int audio_write_packet(AVFormatContext *s1, AVPacket *pkt)
     return 0;
 }
 
+int ff_alsa_callback_run(AVFormatContext *s1, AVDeviceAudioCallback cb, void *opaque)
+{
+    AlsaData *s = s1->priv_data;
+    uint8_t *buf;
+    int res, ret = 0;
+
+    if (!s->h || s->period_size <= 0)
+        return AVERROR(EINVAL);
+
+    if (!(buf = av_malloc(s->period_size * s->frame_size)))
+        return AVERROR(ENOMEM);
+
+    while ((ret = cb(opaque, buf, s->period_size)) >= 0) {
+        uint8_t *ptr = buf;
+        int frames   = s->period_size;
+
+        s->periods++;
+
+        while (frames > 0) {
+            if ((res = snd_pcm_writei(s->h, ptr, frames)) < 0) {
+                if (res == -EAGAIN) {
+                    snd_pcm_wait(s->h, 1000);
+                    continue;
+                }
+
+                if (ff_alsa_xrun_recover(s1, res) < 0) {
+                    av_log(s1, AV_LOG_ERROR, "ALSA write error: %s\n",
+                           snd_strerror(res));
+                    av_free(buf);
+
+                    return AVERROR(EIO);
+                }
+
+                continue;
+            }
+
+            ptr      += res * s->frame_size;
+            frames   -= res;
+            s->frames += res;
+        }
+    }
+
+    av_free(buf);
+
+    return (ret == AVERROR_EOF) ? 0 : ret;
+}
+
+int ff_alsa_get_stats(AVFormatContext *s1, AVDeviceAudioStats *stats)
+{
+    AlsaData *s = s1->priv_data;
+
+    stats->period_size = s->period_size;
+    stats->buffer_size = s->buffer_size;
+    stats->frames      = s->frames;
+    stats->periods     = s->periods;
+    stats->underruns   = s->underruns;
+
+    return 0;
+}
+
 AVOutputFormat alsa_muxer = {
     "alsa",
     NULL_IF_CONFIG_SMALL("ALSA audio output"),
@@ -33,6 +33,7 @@
 #include <alsa/asoundlib.h>
 #include "config.h"
 #include "libavformat/avformat.h"
+#include "avdevice.h"
 
 /* XXX: we make the assumption that the soundcard accepts this format */
 /* XXX: find better solution with "preinit" method, needed also in
@@ -43,6 +44,10 @@ typedef struct {
     snd_pcm_t *h;
     int frame_size;  ///< preferred size for reads and writes
     int period_size; ///< bytes per sample * channels
+    int buffer_size; ///< device buffer size in frames
+    uint64_t frames; ///< number of frames written by the callback mode
+    unsigned periods;   ///< number of periods requested by the callback mode
+    unsigned underruns; ///< number of buffer xruns
 } AlsaData;
 
 /**
@@ -82,4 +87,26 @@ int ff_alsa_close(AVFormatContext *s1);
  */
 int ff_alsa_xrun_recover(AVFormatContext *s1, int err);
 
+/**
+ * Write the output of an audio callback to the ALSA PCM, one period
+ * at a time, until the callback stops.
+ *
+ * @param s1 media file handle
+ * @param cb callback to get the audio data of each period from
+ * @param opaque opaque pointer passed to the callback
+ *
+ * @return 0 if OK, AVERROR_xxx on error
+ */
+int ff_alsa_callback_run(AVFormatContext *s1, AVDeviceAudioCallback cb, void *opaque);
+
+/**
+ * Get the playback statistics of the ALSA PCM.
+ *
+ * @param s1 media file handle
+ * @param stats statistics to fill
+ *
+ * @return 0
+ */
+int ff_alsa_get_stats(AVFormatContext *s1, AVDeviceAudioStats *stats);
+
 #endif /* AVDEVICE_ALSA_AUDIO_H */
@@ -16,7 +16,16 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include "config.h"
+#include "libavformat/avformat.h"
 #include "avdevice.h"
+#if CONFIG_ALSA_OUTDEV
+#include "alsa-audio.h"
+#endif
+
+#if CONFIG_OSS_OUTDEV
+#include "oss_audio.h"
+#endif
 
 unsigned avdevice_version(void)
 {
@@ -33,3 +42,38 @@ const char * avdevice_license(void)
 #define LICENSE_PREFIX "libavdevice license: "
     return LICENSE_PREFIX FFMPEG_LICENSE + sizeof(LICENSE_PREFIX) - 1;
 }
+
+int avdevice_audio_callback_run(AVFormatContext *s,
+                                AVDeviceAudioCallback cb, void *opaque)
+{
+    if (!(s && s->oformat && s->priv_data && cb))
+        return AVERROR(EINVAL);
+
+#if CONFIG_ALSA_OUTDEV
+    if (!strcmp(s->oformat->name, "alsa"))
+        return ff_alsa_callback_run(s, cb, opaque);
+#endif
+#if CONFIG_OSS_OUTDEV
+    if (!strcmp(s->oformat->name, "oss"))
+        return ff_oss_callback_run(s, cb, opaque);
+#endif
+
+    return AVERROR(ENOSYS);
+}
+
+int avdevice_audio_get_stats(AVFormatContext *s, AVDeviceAudioStats *stats)
+{
+    if (!(s && s->oformat && s->priv_data && stats))
+        return AVERROR(EINVAL);
+
+#if CONFIG_ALSA_OUTDEV
+    if (!strcmp(s->oformat->name, "alsa"))
+        return ff_alsa_get_stats(s, stats);
+#endif
+#if CONFIG_OSS_OUTDEV
+    if (!strcmp(s->oformat->name, "oss"))
+        return ff_oss_get_stats(s, stats);
+#endif
+
+    return AVERROR(ENOSYS);
+}
@@ -22,8 +22,8 @@
 #include "libavutil/avutil.h"
 
 #define LIBAVDEVICE_VERSION_MAJOR 52
-#define LIBAVDEVICE_VERSION_MINOR  2
-#define LIBAVDEVICE_VERSION_MICRO  3
+#define LIBAVDEVICE_VERSION_MINOR  3
+#define LIBAVDEVICE_VERSION_MICRO  0
 
 #define LIBAVDEVICE_VERSION_INT AV_VERSION_INT(LIBAVDEVICE_VERSION_MAJOR, \
                                                LIBAVDEVICE_VERSION_MINOR, \
@@ -54,5 +54,62 @@ const char *avdevice_license(void);
  */
 void avdevice_register_all(void);
 
+struct AVFormatContext;
+
+/**
+ * Callback which produces audio for an output device, see
+ * avdevice_audio_callback_run().
+ *
+ * @param opaque   the opaque pointer passed to avdevice_audio_callback_run()
+ * @param buf      the buffer to fill with interleaved samples in the sample
+ *                 format and channel count of the output stream
+ * @param nb_frames the number of frames (samples per channel) to fill,
+ *                 which is the period size of the device
+ * @return >= 0 to continue playback, a negative error code to stop it,
+ *         AVERROR_EOF stops it without an error
+ */
+typedef int (*AVDeviceAudioCallback)(void *opaque, uint8_t *buf, int nb_frames);
+
+/**
+ * Statistics of an audio output device.
+ */
+typedef struct AVDeviceAudioStats {
+    int period_size;    ///< device period size in frames
+    int buffer_size;    ///< device buffer size in frames
+    uint64_t frames;    ///< number of frames written to the device
+    unsigned periods;   ///< number of periods requested from the callback
+    unsigned underruns; ///< number of buffer underruns of the device
+} AVDeviceAudioStats;
+
+/**
+ * Drive audio output directly from the write path of an audio output
+ * device. The callback is called for each device period, and its data
+ * is written to the device without any further buffering. The function
+ * returns when the callback stops playback.
+ *
+ * The device buffer depth is taken from s->max_delay (in AV_TIME_BASE
+ * units) if it is set before av_write_header(), which allows for
+ * latencies of a few periods.
+ *
+ * Supported devices are alsa and oss.
+ *
+ * @param s      an output device context, av_write_header() must have
+ *               been called already
+ * @param cb     the callback to produce the audio data
+ * @param opaque an opaque pointer passed to the callback
+ * @return >= 0 on success, a negative error code otherwise
+ */
+int avdevice_audio_callback_run(struct AVFormatContext *s,
+                                AVDeviceAudioCallback cb, void *opaque);
+
+/**
+ * Get the statistics of an audio output device.
+ *
+ * @param s     an output device context
+ * @param stats the structure to fill
+ * @return >= 0 on success, AVERROR(ENOSYS) if the device is not supported
+ */
+int avdevice_audio_get_stats(struct AVFormatContext *s, AVDeviceAudioStats *stats);
+
 #endif /* AVDEVICE_AVDEVICE_H */
 
@@ -39,6 +39,8 @@
 #include "libavutil/log.h"
 #include "libavcodec/avcodec.h"
 #include "libavformat/avformat.h"
+#include "avdevice.h"
+#include "oss_audio.h"
 
 #define AUDIO_BLOCK_SIZE 4096
 
@@ -51,6 +53,11 @@ typedef struct {
     unsigned int flip_left : 1;
     uint8_t buffer[AUDIO_BLOCK_SIZE];
     int buffer_ptr;
+    int period_size;    ///< fragment size in frames
+    int buffer_size;    ///< device buffer size in frames
+    uint64_t frames;    ///< number of frames written by the callback mode
+    unsigned periods;   ///< number of periods requested by the callback mode
+    unsigned underruns; ///< number of buffer underruns in callback mode
 } AudioData;
 
 static int audio_open(AVFormatContext *s1, int is_output, const char *audio_device)
@@ -78,13 +85,19 @@ static int audio_open(AVFormatContext *s1, int is_output, const char *audio_devi
         fcntl(audio_fd, F_SETFL, O_NONBLOCK);
 
     s->frame_size = AUDIO_BLOCK_SIZE;
-#if 0
-    tmp = (NB_FRAGMENTS << 16) | FRAGMENT_BITS;
-    err = ioctl(audio_fd, SNDCTL_DSP_SETFRAGMENT, &tmp);
-    if (err < 0) {
-        perror("SNDCTL_DSP_SETFRAGMENT");
+
+    /* the buffer depth requested in max_delay is split into fragments
+       of about a quarter of it, which allows low latency playback */
+    if (is_output && s1->max_delay > 0) {
+        int depth = av_rescale(s1->max_delay, s->sample_rate * s->channels * 2, AV_TIME_BASE);
+        int bits  = av_clip(av_log2(FFMAX(depth >> 2, 1)), 7, 16);
+
+        tmp = (FFMAX(depth >> bits, 2) << 16) | bits;
+        err = ioctl(audio_fd, SNDCTL_DSP_SETFRAGMENT, &tmp);
+        if (err < 0) {
+            av_log(s1, AV_LOG_WARNING, "SNDCTL_DSP_SETFRAGMENT: %s\n", strerror(errno));
+        }
     }
-#endif
 
     /* select format : favour native format */
     err = ioctl(audio_fd, SNDCTL_DSP_GETFMTS, &tmp);
@@ -141,6 +154,18 @@ static int audio_open(AVFormatContext *s1, int is_output, const char *audio_devi
     s->sample_rate = tmp; /* store real sample rate */
     s->fd = audio_fd;
 
+    if (is_output) {
+        audio_buf_info info;
+
+        if (ioctl(audio_fd, SNDCTL_DSP_GETOSPACE, &info) == 0 && info.fragsize > 0) {
+            s->period_size = info.fragsize / (2 * s->channels);
+            s->buffer_size = info.fragstotal * s->period_size;
+        } else {
+            s->period_size = AUDIO_BLOCK_SIZE / (2 * s->channels);
+            s->buffer_size = s->period_size;
+        }
+    }
+
     return 0;
  fail:
     close(audio_fd);
@@ -200,6 +225,64 @@ static int audio_write_packet(AVFormatContext *s1, AVPacket *pkt)
     return 0;
 }
 
+int ff_oss_callback_run(AVFormatContext *s1, AVDeviceAudioCallback cb, void *opaque)
+{
+    AudioData *s = s1->priv_data;
+    uint8_t *buf;
+    int size, ret;
+
+    if (s->period_size <= 0)
+        return AVERROR(EINVAL);
+
+    size = s->period_size * 2 * s->channels;
+
+    if (!(buf = av_malloc(size)))
+        return AVERROR(ENOMEM);
+
+    while ((ret = cb(opaque, buf, s->period_size)) >= 0) {
+        uint8_t *ptr = buf;
+        int len      = size, delay;
+
+        /* an empty device queue after the first period means that the
+           callback did not keep up with the device */
+        if (s->periods++ && ioctl(s->fd, SNDCTL_DSP_GETODELAY, &delay) == 0 && !delay)
+            s->underruns++;
+
+        while (len > 0) {
+            if ((ret = write(s->fd, ptr, len)) < 0) {
+                if (errno == EAGAIN || errno == EINTR)
+                    continue;
+
+                av_free(buf);
+
+                return AVERROR(EIO);
+            }
+
+            ptr += ret;
+            len -= ret;
+        }
+
+        s->frames += s->period_size;
+    }
+
+    av_free(buf);
+
+    return (ret == AVERROR_EOF) ? 0 : ret;
+}
+
+int ff_oss_get_stats(AVFormatContext *s1, AVDeviceAudioStats *stats)
+{
+    AudioData *s = s1->priv_data;
+
+    stats->period_size = s->period_size;
+    stats->buffer_size = s->buffer_size;
+    stats->frames      = s->frames;
+    stats->periods     = s->periods;
+    stats->underruns   = s->underruns;
+
+    return 0;
+}
+
 static int audio_write_trailer(AVFormatContext *s1)
 {
     AudioData *s = s1->priv_data;
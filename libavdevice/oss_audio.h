@@ -0,0 +1,54 @@
+/*
+ * Linux audio play and grab interface
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * OSS output: functions shared with avdevice.c
+ */
+
+#ifndef AVDEVICE_OSS_AUDIO_H
+#define AVDEVICE_OSS_AUDIO_H
+
+#include "libavformat/avformat.h"
+#include "avdevice.h"
+
+/**
+ * Write the output of an audio callback to the OSS device, one period
+ * at a time, until the callback stops.
+ *
+ * @param s1 media file handle
+ * @param cb callback to get the audio data of each period from
+ * @param opaque opaque pointer passed to the callback
+ *
+ * @return 0 if OK, AVERROR_xxx on error
+ */
+int ff_oss_callback_run(AVFormatContext *s1, AVDeviceAudioCallback cb, void *opaque);
+
+/**
+ * Get the playback statistics of the OSS device.
+ *
+ * @param s1 media file handle
+ * @param stats statistics to fill
+ *
+ * @return 0
+ */
+int ff_oss_get_stats(AVFormatContext *s1, AVDeviceAudioStats *stats);
+
+#endif /* AVDEVICE_OSS_AUDIO_H */
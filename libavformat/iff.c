@@ -148,6 +148,9 @@ static int open_arpg_arpe(AVFormatContext *s, AVSequencerArpeggio *arpeggio, uin
 #define STEREO  6
 
 #define PACKET_SIZE 1024
+#define TCM1_FRAME_SIZE 1024
+#define TCM1_SCAN_MAX_TIME (INT64_C(30 * 60) * AV_TIME_BASE)
+#define TCM1_SAMPLE_CACHE_SIZE (32 << 20)
 
 typedef enum {
     COMP_NONE,
@@ -160,6 +163,21 @@ typedef enum {
     BITMAP_BYTERUN1
 } bitmap_compression_type;
 
+#if CONFIG_AVSEQUENCER
+/** Sample whose data is left in the file until it is triggered. The
+   decoded data is owned by the demuxer and never attached to the
+   sample, so the module stays unmodified during playback.  */
+typedef struct {
+    const AVSequencerSample *sample;
+    int16_t *data;
+    int64_t  pos;
+    uint32_t len;
+    uint32_t size;
+    uint32_t last_used;
+    uint8_t  crunched;
+} IffLazySample;
+#endif
+
 typedef struct {
     uint64_t  body_pos;
     uint32_t  body_size;
@@ -167,11 +185,28 @@ typedef struct {
     uint32_t  audio_frame_count;
 #if CONFIG_AVSEQUENCER
     AVSequencerContext *avctx;
+    AVSequencerPlayback playback;
     const char *args;
     void *opaque;
+    uint64_t seek_time;
+    int seek_pending;
+    IffLazySample *lazy_samples;
+    unsigned lazy_sample_count;
+    uint64_t sample_cache_size;
+    uint64_t sample_cache_used;
+    uint32_t sample_cache_clock;
+    ByteIOContext *sample_pb;
+    int lazy;
+    AVSequencerTrackRowCache row_cache;
 #endif
 } IffDemuxContext;
 
+#if CONFIG_AVSEQUENCER
+static IffLazySample *find_lazy_sample(const IffDemuxContext *iff, const AVSequencerSample *sample);
+static int read_lazy_sample(AVFormatContext *s, ByteIOContext *pb, const IffLazySample *lazy, AVSequencerSample *sample);
+static const int16_t *iff_load_sample(const AVSequencerContext *avctx, const AVSequencerSample *sample);
+#endif
+
 
 static void interleave_stereo(const uint8_t *src, uint8_t *dest, int size)
 {
@@ -257,6 +292,16 @@ static int iff_read_header(AVFormatContext *s,
         iff->args   = args;
         iff->opaque = opaque;
 
+        /* Sample data is read on first trigger if the file is seekable
+           and can be opened again for reading the samples, keeping at
+           most TCM1_SAMPLE_CACHE_SIZE bytes of decoded samples.  */
+        if (!url_is_streamed(pb) && url_exist(s->filename)) {
+            iff->lazy                      = 1;
+            iff->sample_cache_size         = TCM1_SAMPLE_CACHE_SIZE;
+            iff->avctx->load_sample        = iff_load_sample;
+            iff->avctx->load_sample_opaque = s;
+        }
+
         if (!(module = avseq_module_create())) {
             avsequencer_destroy(iff->avctx);
             return AVERROR(ENOMEM);
@@ -653,8 +698,17 @@ read_unknown_chunk:
                         for (j = 0; j < module->instruments; ++j) {
                             AVSequencerInstrument *origin_instrument = module->instrument_list[i];
 
-                            if (origin < origin_instrument->samples)
-                                sample->data = origin_instrument->sample_list[origin]->data;
+                            if (origin < origin_instrument->samples) {
+                                AVSequencerSample *origin_sample = origin_instrument->sample_list[origin];
+                                IffLazySample *lazy;
+
+                                /* Redirections share the data pointer, so
+                                   their origin is loaded now into the module.  */
+                                if (!origin_sample->data && (lazy = find_lazy_sample(iff, origin_sample)))
+                                    read_lazy_sample(s, pb, lazy, origin_sample);
+
+                                sample->data = origin_sample->data;
+                            }
 
                             origin -= origin_instrument->samples;
                         }
@@ -704,27 +758,44 @@ read_unknown_chunk:
             if (!(st->codec->channels = ap->channels))
                 st->codec->channels = mixctx->channels_out;
 
-            iff->body_size = ((uint64_t) s->duration * st->codec->sample_rate * (st->codec->channels << 2)) / AV_TIME_BASE;
+            st->codec->channels = FFMIN(st->codec->channels, 2);
+            av_set_pts_info(st, 32, 1, st->codec->sample_rate);
 
-            if ((res = avseq_module_play(iff->avctx, mixctx, module, module->song_list[0], iff->args, iff->opaque, 1)) < 0) {
-                avsequencer_destroy(iff->avctx);
-                return res;
-            }
+            /* No duration stored in the module, pre-scan the sub-song
+               with the null mixer to find out where it ends.  */
+            if (s->duration <= 0) {
+                AVSequencerSong *song = module->song_list[0];
+                AVSequencerSongScan *scan;
 
-            avseq_mixer_set_rate(iff->avctx->player_mixer_data, st->codec->sample_rate, st->codec->channels);
+                scan = avseq_song_scan(iff->avctx, module, song, TCM1_SCAN_MAX_TIME);
 
-            if ((res = avseq_song_reset(iff->avctx, module->song_list[0])) < 0) {
-                avsequencer_destroy(iff->avctx);
-                return res;
+                if (scan) {
+                    s->duration = scan->duration;
+
+                    if (!song->duration)
+                        song->duration = scan->duration;
+
+                    avseq_song_scan_destroy(scan);
+                }
             }
 
+            iff->body_size      = ((uint64_t) s->duration * st->codec->sample_rate * (st->codec->channels << 2)) / AV_TIME_BASE;
+
+            /* Playback is started by the IFF-TCM1 decoder with the mixer
+               selected there, through the entry points passed here, so
+               that libavcodec does not link against libavsequencer. They
+               are only handed over in memory, never in the extradata.  */
+            iff->playback.avctx = iff->avctx;
+            iff->playback.start = avseq_module_start;
+            iff->playback.seek  = avseq_module_seek;
+            iff->playback.stop  = avseq_module_stop;
+
 //            iff->avctx->seed                 = 0xFA1E1E51; // FATE test init seed
+            st->codec->sequencer_playback    = &iff->playback;
             st->codec->bits_per_coded_sample = 32;
-#if AV_HAVE_BIGENDIAN
-            st->codec->codec_id              = CODEC_ID_PCM_S32BE;
-#else
-            st->codec->codec_id              = CODEC_ID_PCM_S32LE;
-#endif
+            st->codec->sample_fmt            = SAMPLE_FMT_S32;
+            st->codec->frame_size            = TCM1_FRAME_SIZE;
+            st->codec->codec_id              = CODEC_ID_IFF_TCM1;
         }
 #endif
         st->codec->bit_rate = st->codec->channels * st->codec->sample_rate * st->codec->bits_per_coded_sample;
@@ -1103,21 +1174,23 @@ static int open_patt_trak(AVFormatContext *s, AVSequencerSong *song, uint32_t da
         iff_size += 8;
     }
 
-    if ((res = avseq_track_data_open(track, last_row + 1)) < 0) {
+    /* Tracks are kept packed and decoded row by row on playback, only
+       empty tracks are opened unpacked.  */
+    if (buf && len) {
+        avseq_track_data_close(track);
+        av_freep(&track->data);
+
+        track->last_row = last_row;
+        res             = avseq_track_packed_open(track, buf, len);
+
         av_freep(&buf);
-        return res;
-    }
 
-    if (buf && len) {
-        if ((res = avseq_track_unpack(track, buf, len)) < 0) {
-            av_freep(&buf);
-            return res;
-        }
+        return res;
     }
 
     av_freep(&buf);
 
-    return 0;
+    return avseq_track_data_open(track, last_row + 1);
 }
 
 static int open_song_posi(AVFormatContext *s, AVSequencerSong *song, uint32_t data_size)
@@ -1563,11 +1636,251 @@ static int open_inst_samp(AVFormatContext *s, AVSequencerModule *module, AVSeque
     return 0;
 }
 
+/** Copy the big-endian data of a sample BODY chunk into the sample,
+   converting it to native byte order and delta decoding it.  */
+static int decode_sample_body(AVSequencerModule *module, AVSequencerSample *sample,
+                              const uint8_t *buf, uint32_t len, int crunched)
+{
+    int res;
+
+    if ((res = avseq_sample_data_open(sample, NULL, sample->samples)) < 0)
+        return res;
+
+    if (sample->bits_per_sample != 8) {
+#if AV_HAVE_BIGENDIAN
+        memcpy(sample->data, buf, len);
+#else
+        if (sample->bits_per_sample == 16) {
+            int16_t *data          = sample->data;
+            const uint8_t *tmp_buf = buf;
+            unsigned i             = FFALIGN(sample->samples, 4) >> 2;
+
+            do {
+                int16_t v = AV_RB16(tmp_buf);
+                *data++   = v;
+                v         = AV_RB16(tmp_buf + 2);
+                *data++   = v;
+                v         = AV_RB16(tmp_buf + 4);
+                *data++   = v;
+                v         = AV_RB16(tmp_buf + 6);
+                *data++   = v;
+                tmp_buf   += 8;
+            } while (--i);
+        } else {
+            int32_t *data          = (int32_t *) sample->data;
+            const uint8_t *tmp_buf = buf;
+            unsigned i             = FFALIGN(sample->samples, 2) >> 1;
+
+            do {
+                int32_t v = AV_RB32(tmp_buf);
+                *data++   = v;
+                v         = AV_RB32(tmp_buf + 4);
+                *data++   = v;
+                tmp_buf  += 8;
+            } while (--i);
+        }
+#endif
+    } else {
+        memcpy(sample->data, buf, len);
+    }
+
+    if (crunched) {
+        sample->flags &= ~AVSEQ_SAMPLE_FLAG_REDIRECT;
+
+        avseq_sample_decrunch(module, sample, 0);
+    }
+
+    return 0;
+}
+
+/** Register a sample whose BODY chunk is read when it is triggered.  */
+static int add_lazy_sample(IffDemuxContext *iff, AVSequencerSample *sample,
+                           int64_t pos, uint32_t len, int crunched)
+{
+    IffLazySample *lazy_samples = iff->lazy_samples;
+    IffLazySample *lazy;
+
+    if (!(lazy_samples = av_realloc(lazy_samples, ((iff->lazy_sample_count + 1) * sizeof(IffLazySample)) + FF_INPUT_BUFFER_PADDING_SIZE))) {
+        av_log(sample, AV_LOG_ERROR, "Cannot allocate lazy sample storage container.\n");
+        return AVERROR(ENOMEM);
+    }
+
+    lazy              = lazy_samples + iff->lazy_sample_count++;
+    lazy->sample      = sample;
+    lazy->data        = NULL;
+    lazy->pos         = pos;
+    lazy->len         = len;
+    lazy->size        = 0;
+    lazy->last_used   = 0;
+    lazy->crunched    = crunched;
+    iff->lazy_samples = lazy_samples;
+
+    return 0;
+}
+
+static IffLazySample *find_lazy_sample(const IffDemuxContext *iff,
+                                       const AVSequencerSample *sample)
+{
+    unsigned i;
+
+    for (i = 0; i < iff->lazy_sample_count; ++i) {
+        if (iff->lazy_samples[i].sample == sample)
+            return iff->lazy_samples + i;
+    }
+
+    return NULL;
+}
+
+/** Check if sample data is referenced by a virtual channel or by the
+   current or next channel state of the mixer.  */
+static int sample_in_use(const AVSequencerContext *avctx, const int16_t *data)
+{
+    const AVSequencerPlayerChannel *player_channel = avctx->player_channel;
+    uint16_t channel;
+
+    if (!(player_channel && avctx->player_globals))
+        return 0;
+
+    for (channel = 0; channel < avctx->player_globals->virtual_channels; ++channel) {
+        AVMixerChannel mixer_channel_current, mixer_channel_next;
+
+        if (player_channel[channel].mixer.data == data)
+            return 1;
+
+        memset(&mixer_channel_current, 0, sizeof(AVMixerChannel));
+        memset(&mixer_channel_next, 0, sizeof(AVMixerChannel));
+        avseq_mixer_get_both_channels(avctx->player_mixer_data, &mixer_channel_current, &mixer_channel_next, channel);
+
+        if ((mixer_channel_current.data == data) || (mixer_channel_next.data == data))
+            return 1;
+    }
+
+    return 0;
+}
+
+/** Free the least recently used samples not currently played until
+   size more bytes fit into the sample cache.  */
+static void evict_samples(IffDemuxContext *iff, const AVSequencerContext *avctx, uint64_t size)
+{
+    while (iff->sample_cache_used + size > iff->sample_cache_size) {
+        IffLazySample *victim = NULL;
+        unsigned i;
+
+        for (i = 0; i < iff->lazy_sample_count; ++i) {
+            IffLazySample *lazy = iff->lazy_samples + i;
+
+            if (!lazy->data)
+                continue;
+
+            if (sample_in_use(avctx, lazy->data)) {
+                lazy->last_used = iff->sample_cache_clock;
+
+                continue;
+            }
+
+            if (!victim || (lazy->last_used < victim->last_used))
+                victim = lazy;
+        }
+
+        if (!victim)
+            break;
+
+        iff->sample_cache_used -= victim->size;
+        victim->size            = 0;
+
+        av_freep(&victim->data);
+    }
+}
+
+/** Read and decode the BODY chunk of a sample left in the file into
+   the sample, restoring the file position afterwards.  */
+static int read_lazy_sample(AVFormatContext *s, ByteIOContext *pb, const IffLazySample *lazy, AVSequencerSample *sample)
+{
+    IffDemuxContext *iff = s->priv_data;
+    uint8_t *buf;
+    int64_t pos;
+    int res;
+
+    if (!(buf = av_mallocz(lazy->len + FF_INPUT_BUFFER_PADDING_SIZE))) {
+        av_log(s, AV_LOG_ERROR, "Cannot allocate sample data.\n");
+        return AVERROR(ENOMEM);
+    }
+
+    pos = url_ftell(pb);
+
+    if ((url_fseek(pb, lazy->pos, SEEK_SET) < 0) || (get_buffer(pb, buf, lazy->len) != (int) lazy->len)) {
+        url_fseek(pb, pos, SEEK_SET);
+        av_free(buf);
+        av_log(s, AV_LOG_ERROR, "Cannot read sample data.\n");
+        return AVERROR(EIO);
+    }
+
+    url_fseek(pb, pos, SEEK_SET);
+
+    res = decode_sample_body(iff->avctx->module_list[0], sample, buf, lazy->len, lazy->crunched);
+
+    av_free(buf);
+
+    return res;
+}
+
+/** Sequencer callback returning the data of a sample left in the file,
+   which is read and decoded into the sample cache of the demuxer when
+   it is triggered and not cached yet. It is called by the decoder,
+   possibly while the demuxer reads packets in another thread, so the
+   samples are read through a separate ByteIOContext.  */
+static const int16_t *iff_load_sample(const AVSequencerContext *avctx, const AVSequencerSample *sample)
+{
+    AVFormatContext *s   = avctx->load_sample_opaque;
+    IffDemuxContext *iff = s->priv_data;
+    AVSequencerSample decoded;
+    IffLazySample *lazy;
+
+    if (!(lazy = find_lazy_sample(iff, sample)))
+        return NULL;
+
+    if (lazy->data) {
+        lazy->last_used = ++iff->sample_cache_clock;
+
+        return lazy->data;
+    }
+
+    if (!iff->sample_pb && (url_fopen(&iff->sample_pb, s->filename, URL_RDONLY) < 0)) {
+        iff->sample_pb = NULL;
+        av_log(s, AV_LOG_ERROR, "Cannot open '%s' for reading sample data.\n", s->filename);
+        return NULL;
+    }
+
+    evict_samples(iff, avctx, FFALIGN((uint64_t) sample->samples * sample->bits_per_sample, 8) >> 3);
+
+    /* Decode into a copy of the sample header, so the data ends up
+       in the cache instead of the module.  */
+    memcpy(&decoded, sample, sizeof(AVSequencerSample));
+
+    decoded.data   = NULL;
+    decoded.size   = 0;
+    decoded.flags &= ~AVSEQ_SAMPLE_FLAG_REDIRECT;
+
+    if (read_lazy_sample(s, iff->sample_pb, lazy, &decoded) < 0) {
+        av_free(decoded.data);
+        return NULL;
+    }
+
+    lazy->data              = decoded.data;
+    lazy->size              = decoded.size;
+    lazy->last_used         = ++iff->sample_cache_clock;
+    iff->sample_cache_used += lazy->size;
+
+    return lazy->data;
+}
+
 static int open_samp_smpl(AVFormatContext *s, AVSequencerModule *module, AVSequencerInstrument *instrument, uint32_t data_size)
 {
     ByteIOContext *pb = s->pb;
+    IffDemuxContext *iff = s->priv_data;
     AVSequencerSample *sample;
     uint8_t *buf = NULL;
+    int64_t body_pos = -1;
     uint32_t len = 0, iff_size = 4;
     int res;
 
@@ -1637,8 +1950,14 @@ static int open_samp_smpl(AVFormatContext *s, AVSequencerModule *module, AVSeque
 
             break;
         case ID_BODY:
-            // TODO: Check if load samples parameter is true
             len = iff_size;
+
+            if (iff->lazy) {
+                body_pos = orig_pos;
+
+                break;
+            }
+
             buf = av_malloc(iff_size + FF_INPUT_BUFFER_PADDING_SIZE);
 
             if (!buf)
@@ -1712,62 +2031,19 @@ static int open_samp_smpl(AVFormatContext *s, AVSequencerModule *module, AVSeque
 
     if (!sample->data) {
         // TODO: Load sample from demuxer/decoder pair
-        if (!buf && sample->samples) {
-            av_freep(&buf);
+        if (!buf && (body_pos < 0) && sample->samples) {
             av_log(sample, AV_LOG_ERROR, "No sample data found, but non-zero number of samples!\n");
             return AVERROR_INVALIDDATA;
-        } else if (sample->bits_per_sample != 8) {
-            if ((res = avseq_sample_data_open(sample, NULL, sample->samples)) < 0) {
-                av_freep(&buf);
-                return res;
-            }
+        } else if (body_pos >= 0) {
+            const int crunched = sample->flags & 1;
 
-#if AV_HAVE_BIGENDIAN
-            memcpy(sample->data, buf, len);
-#else
-            if (sample->bits_per_sample == 16) {
-                int16_t *data    = sample->data;
-                uint8_t *tmp_buf = buf;
-                unsigned i       = FFALIGN(sample->samples, 4) >> 2;
-
-                do {
-                    int16_t v = AV_RB16(tmp_buf);
-                    *data++   = v;
-                    v         = AV_RB16(tmp_buf + 2);
-                    *data++   = v;
-                    v         = AV_RB16(tmp_buf + 4);
-                    *data++   = v;
-                    v         = AV_RB16(tmp_buf + 6);
-                    *data++   = v;
-                    tmp_buf   += 8;
-                } while (--i);
-            } else {
-                int32_t *data    = (int32_t *) sample->data;
-                uint8_t *tmp_buf = buf;
-                unsigned i       = FFALIGN(sample->samples, 2) >> 1;
-
-                do {
-                    int32_t v = AV_RB32(tmp_buf);
-                    *data++   = v;
-                    v         = AV_RB32(tmp_buf + 4);
-                    *data++   = v;
-                    tmp_buf  += 8;
-                } while (--i);
-            }
-#endif
-        } else {
-            if ((res = avseq_sample_data_open(sample, NULL, sample->samples)) < 0) {
-                av_freep(&buf);
-                return res;
-            }
-
-            memcpy(sample->data, buf, len);
-        }
-
-        if (sample->flags & 1) {
             sample->flags &= ~AVSEQ_SAMPLE_FLAG_REDIRECT;
 
-            avseq_sample_decrunch(module, sample, 0);
+            if ((res = add_lazy_sample(iff, sample, body_pos, len, crunched)) < 0)
+                return res;
+        } else if ((res = decode_sample_body(module, sample, buf, len, sample->flags & 1)) < 0) {
+            av_freep(&buf);
+            return res;
         }
     }
 
@@ -2736,15 +3012,33 @@ static int iff_read_packet(AVFormatContext *s,
         const AVSequencerPlayerHostChannel *player_host_channel = iff->avctx->player_host_channel;
         const AVSequencerPlayerChannel *player_channel;
         char *buf;
-        AVMixerData *mixer_data = iff->avctx->player_mixer_data;
-        const int size = st->codec->channels * mixer_data->mix_buf_size << 2;
 
-        avseq_mixer_do_mix(mixer_data, NULL);
+        if ((ret = av_new_packet(pkt, iff->seek_pending ? 12 : 4)) < 0) {
+            av_log(s, AV_LOG_ERROR, "Cannot allocate packet!\n");
+            return ret;
+        }
 
-        if (!(buf = av_malloc(16 * iff->avctx->player_song->channels))) {
-            avsequencer_destroy(iff->avctx);
+        AV_WL32(pkt->data, TCM1_FRAME_SIZE);
+
+        if (iff->seek_pending) {
+            AV_WL64(pkt->data + 4, iff->seek_time);
+
+            iff->seek_pending = 0;
+        }
+
+        iff->sent_bytes        += st->codec->channels * TCM1_FRAME_SIZE << 2;
+        pkt->duration           = TCM1_FRAME_SIZE;
+        pkt->flags             |= AV_PKT_FLAG_KEY;
+        pkt->stream_index       = 0;
+        pkt->pts                = iff->audio_frame_count;
+        iff->audio_frame_count += TCM1_FRAME_SIZE;
 
-            iff->avctx = NULL;
+        /* Pattern display needs the player state set up by the decoder. */
+        if (!player_globals)
+            return pkt->size;
+
+        if (!(buf = av_malloc(16 * iff->avctx->player_song->channels))) {
+            av_free_packet(pkt);
             av_log(s, AV_LOG_ERROR, "Cannot allocate pattern display buffer!\n");
             return AVERROR(ENOMEM);
         }
@@ -2766,8 +3060,12 @@ static int iff_read_packet(AVFormatContext *s,
             channel             = 0;
 
             do {
-                if (player_host_channel->track) {
-                    AVSequencerTrackRow *track_row = player_host_channel->track->data + row;
+                const AVSequencerTrackRow *track_row = NULL;
+
+                if (player_host_channel->track)
+                    track_row = avseq_track_get_row(player_host_channel->track, row, &iff->row_cache);
+
+                if (track_row) {
 
                     switch (track_row->note) {
                         case AVSEQ_TRACK_DATA_NOTE_NONE:
@@ -2872,26 +3170,7 @@ static int iff_read_packet(AVFormatContext *s,
 
         av_log(NULL, AV_LOG_INFO, "\033[%dA\n", FFMIN(iff->avctx->player_module->channels, 24) + 33);
 
-        if ((ret = av_new_packet(pkt, size)) < 0) {
-            avsequencer_destroy(iff->avctx);
-
-            iff->avctx = NULL;
-            av_log(s, AV_LOG_ERROR, "Cannot allocate packet!\n");
-
-            return ret;
-        }
-
-        memcpy(pkt->data, mixer_data->mix_buf, size);
-
-        iff->sent_bytes        += size;
-        pkt->duration           = mixer_data->mix_buf_size;
-        st->time_base           = (AVRational) {1, st->codec->sample_rate};
-        pkt->flags             |= AV_PKT_FLAG_KEY;
-        pkt->stream_index       = 0;
-        pkt->pts                = iff->audio_frame_count;
-        iff->audio_frame_count += mixer_data->mix_buf_size;
-
-        return size;
+        return pkt->size;
     }
 #endif
 
@@ -2932,8 +3211,6 @@ static int iff_read_seek(AVFormatContext *s,
     AVStream *st = s->streams[0];
 #if CONFIG_AVSEQUENCER
     IffDemuxContext *iff;
-    AVMixerContext *mixctx;
-    AVMixerData *mixer_data;
 #endif
 
     switch (st->codec->codec_tag) {
@@ -2944,96 +3221,21 @@ static int iff_read_seek(AVFormatContext *s,
         if (!iff->avctx)
             return -1;
 
-        if ((mixctx = avseq_mixer_get_by_name("Null mixer"))) {
-            AVSequencerPlayerGlobals *player_globals;
-            AVMixerData *mixer_data;
-            AVMixerData *old_mixer_data = iff->avctx->player_mixer_data;
-            uint32_t tempo;
-            uint16_t channel;
-            int res, size;
-
-            if (timestamp < 0)
-                timestamp = 0;
-
-            iff->avctx->player_mixer_data = NULL;
-
-            avseq_module_stop(iff->avctx, 0);
-
-            if (flags & AVSEEK_FLAG_BACKWARD) {
-                if ((res = avseq_song_reset(iff->avctx, iff->avctx->player_song)) < 0) {
-                    iff->avctx->player_mixer_data = old_mixer_data;
-                    avsequencer_destroy(iff->avctx);
-                    iff->avctx = NULL;
-                    return res;
-                }
-
-                iff->sent_bytes        = 0;
-                iff->audio_frame_count = 0;
-            }
+        if (timestamp < 0)
+            timestamp = 0;
 
-            player_globals = iff->avctx->player_globals;
+        /* The player state belongs to the decoder, which may be running
+           in another thread, so the target time is only passed with the
+           next packet and the decoder does the actual seek.  */
+        timestamp         = av_rescale(timestamp, st->time_base.num * (int64_t) AV_TIME_BASE, st->time_base.den);
+        iff->seek_time    = timestamp;
+        iff->seek_pending = 1;
 
-            if ((res = avseq_module_play(iff->avctx, mixctx, iff->avctx->player_module, iff->avctx->player_song, iff->args, iff->opaque, (player_globals->flags & AVSEQ_PLAYER_GLOBALS_FLAG_PLAY_ONCE) ? 0 : 1)) < 0) {
-                avseq_module_stop(iff->avctx, 0);
-                iff->avctx->player_mixer_data = old_mixer_data;
-                avsequencer_destroy(iff->avctx);
-                iff->avctx = NULL;
-                return res;
-            }
+        iff->audio_frame_count = av_rescale(timestamp, st->codec->sample_rate, AV_TIME_BASE);
+        iff->sent_bytes        = iff->audio_frame_count * (st->codec->channels << 2);
+        st->cur_dts            = iff->audio_frame_count;
 
-            mixer_data         = iff->avctx->player_mixer_data;
-            tempo              = avseq_song_calc_speed(iff->avctx, iff->avctx->player_song);
-            mixer_data->flags |= AVSEQ_MIXER_DATA_FLAG_MIXING;
-
-            avseq_mixer_set_rate(mixer_data, st->codec->sample_rate, st->codec->channels);
-            avseq_mixer_set_tempo(mixer_data, tempo);
-            avseq_mixer_set_volume(mixer_data, 0, 0, 0, iff->avctx->player_module->channels);
-
-            size      = st->codec->channels * mixer_data->mix_buf_size << 2;
-            timestamp = (timestamp * AV_TIME_BASE * st->time_base.num) / st->time_base.den;
-
-            if (flags & AVSEEK_FLAG_BACKWARD) {
-                timestamp += player_globals->play_time;
-            } else {
-                channel = iff->avctx->player_module->channels - 1;
-
-                do {
-                    AVMixerChannel mixer_channel_current;
-                    AVMixerChannel mixer_channel_next;
-
-                    avseq_mixer_get_both_channels(old_mixer_data, &mixer_channel_current, &mixer_channel_next, channel);
-                    avseq_mixer_set_both_channels(mixer_data, &mixer_channel_current, &mixer_channel_next, channel);
-                } while (channel--);
-            }
-
-            while (player_globals->play_time < timestamp) {
-                avseq_mixer_do_mix(mixer_data, NULL);
-
-                iff->sent_bytes        += size;
-                iff->audio_frame_count += mixer_data->mix_buf_size;
-            }
-
-            channel = iff->avctx->player_module->channels - 1;
-
-            do {
-                AVMixerChannel mixer_channel_current;
-                AVMixerChannel mixer_channel_next;
-
-                avseq_mixer_get_both_channels(mixer_data, &mixer_channel_current, &mixer_channel_next, channel);
-                avseq_mixer_reset_channel(old_mixer_data, channel);
-                avseq_mixer_set_both_channels(old_mixer_data, &mixer_channel_current, &mixer_channel_next, channel);
-            } while (channel--);
-
-            avseq_module_stop(iff->avctx, 0);
-            avseq_mixer_set_tempo(old_mixer_data, mixer_data->tempo);
-
-            iff->avctx->player_mixer_data = old_mixer_data;
-        } else {
-            mixer_data = iff->avctx->player_mixer_data;
-            mixctx     = mixer_data->mixctx;
-        }
-
-        break;
+        return 0;
 #endif
     default:
         break;
@@ -3044,6 +3246,33 @@ static int iff_read_seek(AVFormatContext *s,
     return -1;
 }
 
+#if CONFIG_AVSEQUENCER
+static int iff_read_close(AVFormatContext *s)
+{
+    IffDemuxContext *iff = s->priv_data;
+
+    if (iff->avctx && (iff->avctx->load_sample == iff_load_sample))
+        iff->avctx->load_sample = NULL;
+
+    while (iff->lazy_sample_count)
+        av_free(iff->lazy_samples[--iff->lazy_sample_count].data);
+
+    av_freep(&iff->lazy_samples);
+    iff->sample_cache_used = 0;
+
+    if (iff->sample_pb) {
+        url_fclose(iff->sample_pb);
+        iff->sample_pb = NULL;
+    }
+
+    avseq_track_row_cache_free(&iff->row_cache);
+
+    return 0;
+}
+#else
+#define iff_read_close NULL
+#endif
+
 AVInputFormat iff_demuxer = {
     "IFF",
     NULL_IF_CONFIG_SMALL("IFF format"),
@@ -3051,7 +3280,7 @@ AVInputFormat iff_demuxer = {
     iff_probe,
     iff_read_header,
     iff_read_packet,
-    NULL,
+    iff_read_close,
     iff_read_seek,
     .flags = AVSEEK_FLAG_ANY
 };
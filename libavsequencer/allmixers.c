@@ -42,4 +42,5 @@ void avsequencer_register_all(void)
     REGISTER_MIXER (NULL, null);
     REGISTER_MIXER (LOW_QUALITY, low_quality);
     REGISTER_MIXER (HIGH_QUALITY, high_quality);
+    REGISTER_MIXER (FLOAT, float);
 }
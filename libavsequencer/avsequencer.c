@@ -22,6 +22,16 @@
 #include "config.h"
 #include "avsequencer.h"
 #include "libavutil/random_seed.h"
+#include "libavutil/internal.h"
+#include "libavutil/mathematics.h"
+
+#if CONFIG_AVFILTER
+#include "libavfilter/avfilter.h"
+#endif
+
+#if HAVE_PTHREADS
+#include <pthread.h>
+#endif
 
 /**
  * @file
@@ -142,6 +152,7 @@ void avsequencer_destroy(AVSequencerContext *avctx)
             avseq_module_destroy(module);
         }
 
+        av_free(avctx->player_commands);
         av_free(avctx);
     }
 }
@@ -201,6 +212,8 @@ int avseq_mixer_uninit(AVSequencerContext *const avctx,
             avseq_module_stop(avctx, 0);
         }
 
+        avseq_mixer_thread_free(mixer_data);
+
         for (i = 0; i < mixers; ++i) {
             if (mixer_data_list[i] == mixer_data)
                 break;
@@ -255,6 +268,7 @@ uint32_t avseq_mixer_set_rate(AVMixerData *const mixer_data,
     if (mixctx && mixctx->set_rate) {
         uint32_t new_mix_rate = mix_rate;
         uint32_t new_channels = channels;
+        uint32_t old_mix_rate = mixer_data->rate;
 
         if (new_mix_rate < mixctx->frequency_min)
             new_mix_rate = mixctx->frequency_min;
@@ -264,7 +278,12 @@ uint32_t avseq_mixer_set_rate(AVMixerData *const mixer_data,
         if (new_channels > mixctx->channels_out)
             new_channels = mixctx->channels_out;
 
-        return mixctx->set_rate(mixer_data, new_mix_rate, new_channels);
+        new_mix_rate = mixctx->set_rate(mixer_data, new_mix_rate, new_channels);
+
+        if (new_mix_rate && old_mix_rate && (new_mix_rate != old_mix_rate))
+            mixer_data->filter_pts = av_rescale(mixer_data->filter_pts, new_mix_rate, old_mix_rate);
+
+        return new_mix_rate;
     }
 
     return mixer_data->rate;
@@ -305,6 +324,73 @@ uint32_t avseq_mixer_set_volume(AVMixerData *const mixer_data,
     return mixer_data->tempo;
 }
 
+uint32_t avseq_mixer_set_stems(AVMixerData *const mixer_data,
+                               const uint32_t stems)
+{
+    AVMixerContext *mixctx;
+
+    if (!mixer_data)
+        return 0;
+
+    mixctx = mixer_data->mixctx;
+
+    if (mixctx && mixctx->set_stems)
+        return mixctx->set_stems(mixer_data, stems);
+
+    return 0;
+}
+
+void avseq_mixer_get_tick_phase(const AVMixerData *const mixer_data,
+                                uint32_t *const left,
+                                uint32_t *const left_frac)
+{
+    AVMixerContext *mixctx;
+
+    *left      = 0;
+    *left_frac = 0;
+
+    if (mixer_data && (mixctx = mixer_data->mixctx) && mixctx->get_tick_phase)
+        mixctx->get_tick_phase(mixer_data, left, left_frac);
+}
+
+void avseq_mixer_set_tick_phase(AVMixerData *const mixer_data,
+                                const uint32_t left,
+                                const uint32_t left_frac)
+{
+    AVMixerContext *mixctx;
+
+    if (mixer_data && (mixctx = mixer_data->mixctx) && mixctx->set_tick_phase)
+        mixctx->set_tick_phase(mixer_data, left, left_frac);
+}
+
+int avseq_mixer_set_filter_link(AVMixerData *const mixer_data,
+                                struct AVFilterLink *link)
+{
+    AVMixerContext *mixctx;
+
+    if (!mixer_data)
+        return AVERROR_INVALIDDATA;
+
+    mixctx = mixer_data->mixctx;
+
+    if (link) {
+#if CONFIG_AVFILTER
+        if (!(mixctx && (mixctx->flags & AVSEQ_MIXER_CONTEXT_FLAG_AVFILTER)))
+            return AVERROR(ENOSYS);
+
+        if (link->type != AVMEDIA_TYPE_AUDIO)
+            return AVERROR(EINVAL);
+#else
+        return AVERROR(ENOSYS);
+#endif
+    }
+
+    mixer_data->filter_link = link;
+    mixer_data->filter_pts  = 0;
+
+    return 0;
+}
+
 void avseq_mixer_get_channel(const AVMixerData *const mixer_data,
                              AVMixerChannel *const mixer_channel,
                              const uint32_t channel)
@@ -381,6 +467,40 @@ void avseq_mixer_set_both_channels(AVMixerData *const mixer_data,
         mixctx->set_both_channels(mixer_data, mixer_channel_current, mixer_channel_next, channel);
 }
 
+#if CONFIG_AVFILTER
+static int mix_to_filter_link(AVMixerContext *const mixctx,
+                              AVMixerData *const mixer_data)
+{
+    AVFilterLink *const link = mixer_data->filter_link;
+    const uint32_t frames    = mixer_data->mix_buf_size;
+    const int stereo         = (mixer_data->channels_out >= 2);
+    AVFilterBufferRef *samplesref;
+
+    if (mixer_data->flags & AVSEQ_MIXER_DATA_FLAG_FROZEN)
+        return 0;
+
+    samplesref = avfilter_get_audio_buffer(link, AV_PERM_WRITE,
+                                           (mixctx->flags & AVSEQ_MIXER_CONTEXT_FLAG_FLOAT) ? AV_SAMPLE_FMT_FLT : AV_SAMPLE_FMT_S32,
+                                           frames << (stereo ? 3 : 2),
+                                           stereo ? AV_CH_LAYOUT_STEREO : AV_CH_LAYOUT_MONO, 0);
+
+    if (!samplesref)
+        return AVERROR(ENOMEM);
+
+    mixctx->mix(mixer_data, (int32_t *) samplesref->data[0]);
+
+    samplesref->pts                = av_rescale_q(mixer_data->filter_pts, (AVRational) { 1, mixer_data->rate }, link->time_base);
+    samplesref->pos                = -1;
+    samplesref->audio->nb_samples  = frames;
+    samplesref->audio->sample_rate = mixer_data->rate;
+    mixer_data->filter_pts        += frames;
+
+    avfilter_filter_samples(link, samplesref);
+
+    return 0;
+}
+#endif
+
 void avseq_mixer_do_mix(AVMixerData *const mixer_data, int32_t *buf)
 {
     AVMixerContext *mixctx;
@@ -391,9 +511,17 @@ void avseq_mixer_do_mix(AVMixerData *const mixer_data, int32_t *buf)
     mixctx = mixer_data->mixctx;
 
     if (mixctx && mixctx->mix) {
-        if (buf)
+        if (buf) {
             mixctx->mix(mixer_data, buf);
-        else if (mixer_data->mix_buf)
+            return;
+        }
+
+#if CONFIG_AVFILTER
+        if (mixer_data->filter_link && mixer_data->rate && (mix_to_filter_link(mixctx, mixer_data) >= 0))
+            return;
+#endif
+
+        if (mixer_data->mix_buf)
             mixctx->mix(mixer_data, mixer_data->mix_buf);
     }
 }
@@ -417,3 +545,163 @@ void avseq_mixer_do_mix_parallel(AVMixerData *const mixer_data,
             mixctx->mix_parallel(mixer_data, mixer_data->mix_buf, first_channel, last_channel);
     }
 }
+
+#if HAVE_PTHREADS
+typedef int (mixer_action_func)(AVMixerData *mixer_data, void *arg, int jobnr);
+
+typedef struct MixerThreadContext {
+    pthread_t *workers;
+    mixer_action_func *func;
+    void *arg;
+    int job_count;
+
+    pthread_cond_t last_job_cond;
+    pthread_cond_t current_job_cond;
+    pthread_mutex_t current_job_lock;
+    int current_job;
+    int done;
+} MixerThreadContext;
+
+static void *attribute_align_arg mixer_worker(void *v)
+{
+    AVMixerData *mixer_data = v;
+    MixerThreadContext *c   = mixer_data->thread_opaque;
+    const int thread_count  = mixer_data->thread_count;
+    int our_job             = c->job_count;
+    int self_id;
+
+    pthread_mutex_lock(&c->current_job_lock);
+    self_id = c->current_job++;
+
+    for (;;) {
+        while (our_job >= c->job_count) {
+            if (c->current_job == thread_count + c->job_count)
+                pthread_cond_signal(&c->last_job_cond);
+
+            pthread_cond_wait(&c->current_job_cond, &c->current_job_lock);
+            our_job = self_id;
+
+            if (c->done) {
+                pthread_mutex_unlock(&c->current_job_lock);
+                return NULL;
+            }
+        }
+
+        pthread_mutex_unlock(&c->current_job_lock);
+
+        c->func(mixer_data, c->arg, our_job);
+
+        pthread_mutex_lock(&c->current_job_lock);
+        our_job = c->current_job++;
+    }
+}
+
+static int mixer_thread_execute(AVMixerData *mixer_data,
+                                mixer_action_func *func,
+                                void *arg, int job_count)
+{
+    MixerThreadContext *c = mixer_data->thread_opaque;
+
+    if (job_count <= 0)
+        return 0;
+
+    pthread_mutex_lock(&c->current_job_lock);
+
+    c->current_job = mixer_data->thread_count;
+    c->job_count   = job_count;
+    c->arg         = arg;
+    c->func        = func;
+
+    pthread_cond_broadcast(&c->current_job_cond);
+    pthread_cond_wait(&c->last_job_cond, &c->current_job_lock);
+    pthread_mutex_unlock(&c->current_job_lock);
+
+    return 0;
+}
+#endif
+
+int avseq_mixer_thread_init(AVMixerData *const mixer_data,
+                            const int thread_count)
+{
+#if HAVE_PTHREADS
+    MixerThreadContext *c;
+    int i;
+#endif
+
+    if (!mixer_data)
+        return AVERROR_INVALIDDATA;
+
+    avseq_mixer_thread_free(mixer_data);
+
+    mixer_data->thread_count = 1;
+
+    if (thread_count <= 1)
+        return 0;
+
+#if HAVE_PTHREADS
+    if (!(c = av_mallocz(sizeof(MixerThreadContext))))
+        return AVERROR(ENOMEM);
+
+    if (!(c->workers = av_mallocz(thread_count * sizeof(pthread_t)))) {
+        av_free(c);
+
+        return AVERROR(ENOMEM);
+    }
+
+    mixer_data->thread_opaque = c;
+    mixer_data->thread_count  = thread_count;
+
+    pthread_cond_init(&c->current_job_cond, NULL);
+    pthread_cond_init(&c->last_job_cond, NULL);
+    pthread_mutex_init(&c->current_job_lock, NULL);
+    pthread_mutex_lock(&c->current_job_lock);
+
+    for (i = 0; i < thread_count; i++) {
+        if (pthread_create(&c->workers[i], NULL, mixer_worker, mixer_data)) {
+            mixer_data->thread_count = i;
+
+            pthread_mutex_unlock(&c->current_job_lock);
+            avseq_mixer_thread_free(mixer_data);
+
+            return AVERROR(ENOMEM);
+        }
+    }
+
+    pthread_cond_wait(&c->last_job_cond, &c->current_job_lock);
+    pthread_mutex_unlock(&c->current_job_lock);
+
+    mixer_data->execute = mixer_thread_execute;
+
+    return 0;
+#else
+    return AVERROR(ENOSYS);
+#endif
+}
+
+void avseq_mixer_thread_free(AVMixerData *const mixer_data)
+{
+#if HAVE_PTHREADS
+    MixerThreadContext *c;
+    int i;
+
+    if (!(mixer_data && (c = mixer_data->thread_opaque)))
+        return;
+
+    pthread_mutex_lock(&c->current_job_lock);
+    c->done = 1;
+    pthread_cond_broadcast(&c->current_job_cond);
+    pthread_mutex_unlock(&c->current_job_lock);
+
+    for (i = 0; i < mixer_data->thread_count; i++)
+        pthread_join(c->workers[i], NULL);
+
+    pthread_mutex_destroy(&c->current_job_lock);
+    pthread_cond_destroy(&c->current_job_cond);
+    pthread_cond_destroy(&c->last_job_cond);
+    av_free(c->workers);
+    av_freep(&mixer_data->thread_opaque);
+
+    mixer_data->thread_count = 1;
+    mixer_data->execute      = NULL;
+#endif
+}
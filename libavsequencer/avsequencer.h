@@ -58,6 +58,12 @@ const char *avsequencer_license(void);
 #include "libavsequencer/module.h"
 #include "libavsequencer/song.h"
 
+/** AVSequencerContext->stem_mode values.  */
+enum AVSequencerStemMode {
+    AVSEQ_STEM_MODE_HOST_CHANNEL = 0x00, ///< Route each host channel, including its NNA background channels, to its own stem
+    AVSEQ_STEM_MODE_INSTRUMENT   = 0x01, ///< Route each instrument to its own stem
+};
+
 /**
  * Sequencer context structure which is the very root of the
  * sequencer. It manages all modules currently in memory, controls
@@ -155,8 +161,83 @@ typedef struct AVSequencerContext {
 
     /** Executes one tick of the playback handler.  */
     int (*playback_handler)(AVMixerData *mixer_data);
+
+    /** Callback which returns the data of a sample having a non-zero
+       number of samples but no data or NULL. It is called by the
+       playback handler each time such a sample is triggered, which
+       allows the sample data to stay in the file until it is actually
+       used. The returned data is owned by the callback and must stay
+       valid while it is referenced by a channel of this context, the
+       sample itself is never modified, so a module shared by several
+       contexts stays untouched. If it returns NULL, the sample is
+       played as silence. Pre-scans and seeks, which run the player
+       with the null mixer, do not call it, except for the samples
+       still playing at the target time of a seek.  */
+    const int16_t *(*load_sample)(const struct AVSequencerContext *avctx,
+                                  const AVSequencerSample *sample);
+
+    /** User data for the load_sample callback.  */
+    void *load_sample_opaque;
+
+    /** Selects how the playback handler routes the virtual channels
+       to the stems of a mixer with stem output enabled, see enum
+       AVSequencerStemMode. The host channel or instrument number
+       (counting from 0) is wrapped around the number of stems. The
+       routing of a virtual channel is decided when a note is played
+       on it.  */
+    uint8_t stem_mode;
+
+    /** AVSequencerPlayerCommandQueue pointer to the queue of commands
+       sent by a control thread, which are executed by the playback
+       handler at the start of each tick, or NULL if no queue has been
+       initialized.  */
+    struct AVSequencerPlayerCommandQueue *player_commands;
+
+    /** Array (of size player_row_caches) of track row caches, one for
+       each host channel, which the playback handler uses for decoding
+       the rows of packed tracks.  */
+    AVSequencerTrackRowCache *player_row_cache;
+
+    /** Number of track row caches in player_row_cache.  */
+    uint16_t player_row_caches;
+
+    /** Array (of size player_synth_codes) of the synth sound codes
+       pre-decoded by the playback handler, one for each synth sound
+       played by this context. They are kept in the context rather
+       than in the synth sound, so the playback handler never writes
+       to a module shared with other contexts.  */
+    void **player_synth_code;
+
+    /** Number of pre-decoded synth sound codes in player_synth_code.  */
+    uint16_t player_synth_codes;
+
+    /** AVSequencerPlayerSnapshotIndex pointer to the seek index of
+       the sub-song currently played back, which is built by the
+       first call to avseq_module_seek, or NULL.  */
+    struct AVSequencerPlayerSnapshotIndex *player_snapshots;
 } AVSequencerContext;
 
+/**
+ * Offline rendering statistics which are filled by avseq_module_render.
+ * New fields can be added to the end with minor version bumps.
+ * Removal, reordering and changes to existing fields require a major
+ * version bump.
+ */
+typedef struct AVSequencerRenderStats {
+    /** Total number of frames passed to the sink.  */
+    uint64_t frames;
+
+    /** Number of times the sink has been called.  */
+    uint32_t chunks;
+
+    /** Wall clock time in AV_TIME_BASE fractional seconds spent for
+       rendering.  */
+    int64_t time;
+
+    /** Number of frames rendered per second of wall clock time.  */
+    uint64_t fps;
+} AVSequencerRenderStats;
+
 /** Registers all mixers to the AVSequencer.
  *
  * @note This is part of the new sequencer API which is still under construction.
@@ -322,6 +403,80 @@ uint32_t avseq_mixer_set_volume(AVMixerData *const mixer_data,
                                 const uint32_t right_volume,
                                 const uint32_t channels);
 
+/**
+ * Sets the number of output buses (stems) of the mixing engine. If
+ * non-zero, every buffer or tick based mixing call also outputs each
+ * stem separately into the stem_buf of the mixer data, with the
+ * channels being routed to the stems according to the stem_mode of
+ * the sequencer context. This allows rendering stems, e.g. one per
+ * track, in a single pass.
+ *
+ * @param mixer_data the AVMixerData to set the number of stems of
+ * @param stems the number of stems or 0 to disable stem output
+ * @return the number of stems which actually have been set, 0 if the
+ *         mixer does not support stem output
+ *
+ * @note This is part of the new sequencer API which is still under construction.
+ *       Thus do not use this yet. It may change at any time, do not expect
+ *       ABI compatibility yet!
+ */
+uint32_t avseq_mixer_set_stems(AVMixerData *const mixer_data,
+                               const uint32_t stems);
+
+/**
+ * Gets the position of the mixing engine within the current tick, i.e.
+ * the number of frames and the fraction of a frame left until the
+ * playback handler is called next.
+ *
+ * @param mixer_data the AVMixerData to get the tick position of
+ * @param left pointer to store the number of frames left in the tick
+ * @param left_frac pointer to store the fraction of a frame left in the tick,
+ *                  0 and 0 are stored if the mixer does not support this
+ *
+ * @note This is part of the new sequencer API which is still under construction.
+ *       Thus do not use this yet. It may change at any time, do not expect
+ *       ABI compatibility yet!
+ */
+void avseq_mixer_get_tick_phase(const AVMixerData *const mixer_data,
+                                uint32_t *const left,
+                                uint32_t *const left_frac);
+
+/**
+ * Sets the position of the mixing engine within the current tick, e.g.
+ * to continue at the position reached by another mixing engine which
+ * has been running at the same mixing rate and tempo.
+ *
+ * @param mixer_data the AVMixerData to set the tick position of
+ * @param left the number of frames left in the tick
+ * @param left_frac the fraction of a frame left in the tick
+ *
+ * @note This is part of the new sequencer API which is still under construction.
+ *       Thus do not use this yet. It may change at any time, do not expect
+ *       ABI compatibility yet!
+ */
+void avseq_mixer_set_tick_phase(AVMixerData *const mixer_data,
+                                const uint32_t left,
+                                const uint32_t left_frac);
+
+/**
+ * Attaches the output link of a libavfilter source filter to the
+ * mixing engine. Each call to avseq_mixer_do_mix without an explicit
+ * target buffer will then mix directly into an audio buffer obtained
+ * from this link and pass it to the filter graph, i.e. effects and
+ * sample format conversion run without an extra copy per block.
+ *
+ * @param mixer_data the AVMixerData to attach the filter link to
+ * @param link the AVFilterLink to pass the mixed PCM data to or NULL
+ *             to detach the current filter link
+ * @return >= 0 on success, a negative error code otherwise
+ *
+ * @note This is part of the new sequencer API which is still under construction.
+ *       Thus do not use this yet. It may change at any time, do not expect
+ *       ABI compatibility yet!
+ */
+int avseq_mixer_set_filter_link(AVMixerData *const mixer_data,
+                                struct AVFilterLink *link);
+
 /**
  * Gets and transfers a channel data block from the internal mixing
  * engine to the AVSequencer.
@@ -415,9 +570,12 @@ void avseq_mixer_set_both_channels(AVMixerData *const mixer_data,
 
 /**
  * Fills the output mixing buffer by calculating all the input channel samples.
+ * If buf is NULL and a filter link has been attached, the output data is
+ * mixed into an audio buffer of the filter link and passed to it.
  *
  * @param mixer_data the AVMixerData to do the actual mixing step
- * @param buf the target buffer to mix the output data to
+ * @param buf the target buffer to mix the output data to or NULL to use
+ *            the filter link or the internal mixing buffer
  *
  * @note This is part of the new sequencer API which is still under construction.
  *       Thus do not use this yet. It may change at any time, do not expect
@@ -446,6 +604,38 @@ void avseq_mixer_do_mix_parallel(AVMixerData *const mixer_data,
                                  const uint32_t first_channel,
                                  const uint32_t last_channel);
 
+/**
+ * Starts a thread pool which is used by the mixing engine to split
+ * the input channels into thread_count ranges. Each range is mixed into
+ * a separate buffer by one thread and all buffers are summed up after
+ * each mixing pass. The playback handler is only called between two
+ * mixing passes, i.e. at tick boundaries. A running pool is stopped
+ * before starting the new one.
+ *
+ * @param mixer_data the AVMixerData to start the thread pool for
+ * @param thread_count the number of threads to use, values below 2
+ *                     disable threaded mixing
+ * @return >= 0 on success, a negative error code otherwise
+ *
+ * @note This is part of the new sequencer API which is still under construction.
+ *       Thus do not use this yet. It may change at any time, do not expect
+ *       ABI compatibility yet!
+ */
+int avseq_mixer_thread_init(AVMixerData *const mixer_data,
+                            const int thread_count);
+
+/**
+ * Stops the thread pool of the mixing engine and returns to single
+ * threaded mixing. This is done automatically by avseq_mixer_uninit.
+ *
+ * @param mixer_data the AVMixerData to stop the thread pool of
+ *
+ * @note This is part of the new sequencer API which is still under construction.
+ *       Thus do not use this yet. It may change at any time, do not expect
+ *       ABI compatibility yet!
+ */
+void avseq_mixer_thread_free(AVMixerData *const mixer_data);
+
 /**
  * Creates a new uninitialized empty module.
  *
@@ -458,7 +648,9 @@ void avseq_mixer_do_mix_parallel(AVMixerData *const mixer_data,
 AVSequencerModule *avseq_module_create(void);
 
 /**
- * Destroys a module by freeing its occupied memory.
+ * Destroys a module by freeing its occupied memory. A module which is
+ * still opened to a sequencer context is kept. This may be called while
+ * other threads open or close the module to other contexts.
  *
  * @param module the AVSequencerModule to be destroyed
  *
@@ -469,7 +661,14 @@ AVSequencerModule *avseq_module_create(void);
 void avseq_module_destroy(AVSequencerModule *module);
 
 /**
- * Opens and registers a module to the AVSequencer.
+ * Opens and registers a module to the AVSequencer. The same module
+ * can be opened to several sequencer contexts, which then all share
+ * its data while each keeps its own playback state. The reference
+ * count of the module is protected by a lock if libavsequencer has been
+ * built with pthreads, so different threads can open and close a shared
+ * module to their own contexts concurrently. Without pthreads, opening
+ * and closing shared modules must not be done concurrently. Each
+ * sequencer context itself must only be used by one thread at a time.
  *
  * @param avctx the AVSequencerContext to store the opened module into
  * @param module the AVSequencerModule which has been opened to be registered
@@ -482,7 +681,9 @@ void avseq_module_destroy(AVSequencerModule *module);
 int avseq_module_open(AVSequencerContext *avctx, AVSequencerModule *module);
 
 /**
- * Closes and unregisters module from the AVSequencer.
+ * Closes and unregisters module from the AVSequencer. The module data
+ * is only freed when it is closed from the last context it was opened to.
+ * This is thread-safe in the same way as avseq_module_open.
  *
  * @param avctx the AVSequencerContext to remove the module reference
  * @param module the AVSequencerModule which has been opened to be unregistered
@@ -543,6 +744,239 @@ int avseq_module_play(AVSequencerContext *avctx, AVMixerContext *mixctx,
  */
 void avseq_module_stop(AVSequencerContext *avctx, uint32_t mode);
 
+/**
+ * Starts looping playback of the first sub-song of the first module
+ * attached to a sequencer context through the mixer with the given name,
+ * and sets the output rate of the mixer.
+ *
+ * @param avctx the AVSequencerContext to start playback for
+ * @param mixer_name the name of the mixer to use, see avseq_mixer_get_by_name
+ * @param args The string of parameters to use when initializing the mixer.
+ * @param rate pointer to the output rate, 0 is replaced by the default
+ *             rate of the mixer
+ * @param channels pointer to the number of output channels, 0 is replaced
+ *                 by the default of the mixer, clipped to 2
+ * @return >= 0 on success, a negative error code otherwise
+ *
+ * @note This is part of the new sequencer API which is still under construction.
+ *       Thus do not use this yet. It may change at any time, do not expect
+ *       ABI compatibility yet!
+ */
+int avseq_module_start(AVSequencerContext *avctx, const char *mixer_name,
+                       const char *args, uint32_t *rate, uint32_t *channels);
+
+/**
+ * Seeks the sub-song currently being played back to the given playing
+ * time. The snapshot index required for this is built by pre-scanning
+ * the sub-song up to the target time the first time it is needed, and
+ * is extended as later seeks go beyond it. This must be called from the
+ * thread rendering the playback, i.e. never concurrently with mixing.
+ *
+ * @param avctx the AVSequencerContext which has been initialized for
+ *              playback by avseq_module_play
+ * @param timestamp the target playing time in AV_TIME_BASE fractional seconds
+ * @return >= 0 on success, a negative error code otherwise
+ *
+ * @note This is part of the new sequencer API which is still under construction.
+ *       Thus do not use this yet. It may change at any time, do not expect
+ *       ABI compatibility yet!
+ */
+int avseq_module_seek(AVSequencerContext *avctx, uint64_t timestamp);
+
+/**
+ * Playback entry points passed by a demuxer to the decoder rendering a
+ * module, so that the decoder does not need to link against libavsequencer.
+ * The demuxer keeps the structure and points the sequencer_playback field
+ * of the codec context to it. It contains process addresses and must
+ * therefore never be written to or read from files.
+ *
+ * @note This is part of the new sequencer API which is still under construction.
+ *       Thus do not use this yet. It may change at any time, do not expect
+ *       ABI compatibility yet!
+ */
+typedef struct AVSequencerPlayback {
+    /** sequencer context with the module attached */
+    AVSequencerContext *avctx;
+
+    /** avseq_module_start */
+    int (*start)(AVSequencerContext *avctx, const char *mixer_name,
+                 const char *args, uint32_t *rate, uint32_t *channels);
+
+    /** avseq_module_stop */
+    void (*stop)(AVSequencerContext *avctx, uint32_t mode);
+
+    /** avseq_module_seek */
+    int (*seek)(AVSequencerContext *avctx, uint64_t timestamp);
+} AVSequencerPlayback;
+
+/**
+ * Renders the sub-song currently being played back as fast as possible
+ * until the song end is detected, ignoring the frozen state of the
+ * mixer. The mixed output is passed to the sink in chunks which never
+ * cross a tick boundary, i.e. each chunk contains at most one tick.
+ *
+ * @param avctx the AVSequencerContext which has been initialized for
+ *              playback by avseq_module_play
+ * @param sink the callback receiving the rendered SAMPLE_FMT_S32 frames,
+ *             interleaved if the mixer has more than one output channel,
+ *             a negative return value aborts rendering
+ * @param opaque the user data passed to the sink
+ * @param buf_size the maximum number of frames per chunk, 0 uses the
+ *                 maximum buffer size of the mixer; this is not limited
+ *                 by the maximum buffer size of the mixer
+ * @param max_frames the maximum number of frames to render, 0 means no limit
+ * @param stats if non-NULL, filled with the rendering statistics
+ * @return >= 0 on success, a negative error code otherwise
+ *
+ * @note This is part of the new sequencer API which is still under construction.
+ *       Thus do not use this yet. It may change at any time, do not expect
+ *       ABI compatibility yet!
+ */
+int avseq_module_render(AVSequencerContext *avctx,
+                        int (*sink)(void *opaque, const int32_t *buf, uint32_t frames),
+                        void *opaque, uint32_t buf_size, uint64_t max_frames,
+                        AVSequencerRenderStats *stats);
+
+/**
+ * Fills a device buffer with exactly the requested number of frames of
+ * the sub-song currently being played back, ignoring the frozen state
+ * of the mixer. This is intended to be called from the period callback
+ * of a low latency audio output device, i.e. avdevice_audio_callback_run,
+ * so that the mixed output is written to the device without any further
+ * buffering. If the song end is reached, the remaining frames are
+ * filled with silence.
+ *
+ * @param avctx the AVSequencerContext which has been initialized for
+ *              playback by avseq_module_play
+ * @param buf the interleaved output buffer, with two channels if the
+ *            mixer has more than one output channel and one otherwise
+ * @param frames the number of frames to fill
+ * @param sample_fmt the sample format of buf, either the native output
+ *                   format of the mixer (SAMPLE_FMT_S32 or SAMPLE_FMT_FLT
+ *                   for floating point mixers) which is mixed into buf
+ *                   directly, or SAMPLE_FMT_S16
+ * @return >= 0 on success, AVERROR_EOF if the song end has already been
+ *         reached, a negative error code otherwise
+ *
+ * @note This is part of the new sequencer API which is still under construction.
+ *       Thus do not use this yet. It may change at any time, do not expect
+ *       ABI compatibility yet!
+ */
+int avseq_module_fill(AVSequencerContext *avctx, uint8_t *buf,
+                      uint32_t frames, enum AVSampleFormat sample_fmt);
+
+/**
+ * Builds a snapshot index of a sub-song by running the player with the
+ * null mixer as fast as possible and storing the complete player state
+ * each time the playing time passed another interval. The current
+ * playback state of the sequencer context, if any, is preserved, but
+ * in that case it must be the playback of the same sub-song.
+ *
+ * @param avctx the AVSequencerContext to use for the pre-scan
+ * @param module the AVSequencerModule the sub-song belongs to
+ * @param song the AVSequencerSong to build the snapshot index for
+ * @param interval the minimum playing time distance between two
+ *                 snapshots in AV_TIME_BASE fractional seconds
+ * @param max_time stop scanning at this playing time if the song end
+ *                 has not been found yet, 0 means no limit
+ * @return pointer to the freshly allocated snapshot index, NULL on failure
+ *
+ * @note This is part of the new sequencer API which is still under construction.
+ *       Thus do not use this yet. It may change at any time, do not expect
+ *       ABI compatibility yet!
+ */
+struct AVSequencerPlayerSnapshotIndex *avseq_snapshot_index_create(AVSequencerContext *avctx,
+                                                                   AVSequencerModule *module,
+                                                                   AVSequencerSong *song,
+                                                                   uint64_t interval,
+                                                                   uint64_t max_time);
+
+/**
+ * Destroys a snapshot index by freeing all snapshots and the index
+ * itself.
+ *
+ * @param index the snapshot index to be destroyed
+ *
+ * @note This is part of the new sequencer API which is still under construction.
+ *       Thus do not use this yet. It may change at any time, do not expect
+ *       ABI compatibility yet!
+ */
+void avseq_snapshot_index_destroy(struct AVSequencerPlayerSnapshotIndex *index);
+
+/**
+ * Seeks the sub-song currently being played back by restoring the
+ * nearest snapshot before the target time and simulating the remaining
+ * ticks with the null mixer. The channel positions are advanced up to
+ * the exact sample frame of the target time and then transferred to
+ * the mixer used for playback.
+ *
+ * @param avctx the AVSequencerContext which has been initialized for
+ *              playback by avseq_module_play
+ * @param index the snapshot index of the sub-song currently played back
+ * @param timestamp the target playing time in AV_TIME_BASE fractional seconds
+ * @return >= 0 on success, a negative error code otherwise
+ *
+ * @note This is part of the new sequencer API which is still under construction.
+ *       Thus do not use this yet. It may change at any time, do not expect
+ *       ABI compatibility yet!
+ */
+int avseq_snapshot_seek(AVSequencerContext *avctx,
+                        struct AVSequencerPlayerSnapshotIndex *index,
+                        uint64_t timestamp);
+
+struct AVSequencerPlayerCommand;
+
+/**
+ * Initializes the player command queue of a sequencer context. This
+ * must be done before starting playback, i.e. before the playback
+ * handler can be executed by another thread.
+ *
+ * @param avctx the AVSequencerContext to initialize the command queue for
+ * @param commands the minimum number of commands the queue can hold
+ *                 without being drained, rounded up to a power of two
+ * @return >= 0 on success, a negative error code otherwise
+ *
+ * @note This is part of the new sequencer API which is still under construction.
+ *       Thus do not use this yet. It may change at any time, do not expect
+ *       ABI compatibility yet!
+ */
+int avseq_command_queue_init(AVSequencerContext *avctx, uint32_t commands);
+
+/**
+ * Sends a command to the playback handler, which will execute it at
+ * the start of its next tick. This function neither locks nor
+ * allocates memory and may be called by one control thread while
+ * another thread is mixing. Calls from several threads at once must
+ * be serialized by the caller.
+ *
+ * @param avctx the AVSequencerContext to send the command to
+ * @param command the AVSequencerPlayerCommand to be sent
+ * @return >= 0 on success, AVERROR(EAGAIN) if the queue is full or
+ *         another negative error code otherwise
+ *
+ * @note This is part of the new sequencer API which is still under construction.
+ *       Thus do not use this yet. It may change at any time, do not expect
+ *       ABI compatibility yet!
+ */
+int avseq_command_send(AVSequencerContext *avctx,
+                       const struct AVSequencerPlayerCommand *command);
+
+/**
+ * Receives the oldest pending command of the command queue. This is
+ * called by the playback handler and must only be called by the thread
+ * executing it.
+ *
+ * @param avctx the AVSequencerContext to receive the command from
+ * @param command the AVSequencerPlayerCommand to store the command into
+ * @return 1 if a command has been received, 0 if the queue is empty
+ *
+ * @note This is part of the new sequencer API which is still under construction.
+ *       Thus do not use this yet. It may change at any time, do not expect
+ *       ABI compatibility yet!
+ */
+int avseq_command_receive(AVSequencerContext *avctx,
+                          struct AVSequencerPlayerCommand *command);
+
 /**
  * Creates a new uninitialized empty sub-song.
  *
@@ -618,6 +1052,41 @@ uint32_t avseq_song_calc_speed(AVSequencerContext *avctx, AVSequencerSong *song)
  */
 int avseq_song_reset(AVSequencerContext *avctx, AVSequencerSong *song);
 
+/**
+ * Scans a sub-song by running the player with the null mixer as fast
+ * as possible, collecting the total duration, all loop-back positions
+ * and a timeline mapping playing time to order list entry and row of
+ * the first channel. The current playback state of the sequencer
+ * context, if any, is preserved, but in that case it must be the
+ * playback of the same sub-song.
+ *
+ * @param avctx the AVSequencerContext to use for the scan
+ * @param module the AVSequencerModule the sub-song belongs to
+ * @param song the AVSequencerSong to be scanned
+ * @param max_time stop scanning at this playing time if the song end
+ *                 has not been found yet, 0 means no limit
+ * @return pointer to the freshly allocated scan result, NULL on failure
+ *
+ * @note This is part of the new sequencer API which is still under construction.
+ *       Thus do not use this yet. It may change at any time, do not expect
+ *       ABI compatibility yet!
+ */
+AVSequencerSongScan *avseq_song_scan(AVSequencerContext *avctx,
+                                     AVSequencerModule *module,
+                                     AVSequencerSong *song,
+                                     uint64_t max_time);
+
+/**
+ * Destroys a sub-song scan result by freeing its occupied memory.
+ *
+ * @param scan the AVSequencerSongScan to be destroyed
+ *
+ * @note This is part of the new sequencer API which is still under construction.
+ *       Thus do not use this yet. It may change at any time, do not expect
+ *       ABI compatibility yet!
+ */
+void avseq_song_scan_destroy(AVSequencerSongScan *scan);
+
 /**
  * Changes sub-song channels to new number of channels specified.
  *
@@ -888,6 +1357,66 @@ AVSequencerTrack *avseq_track_get_address(AVSequencerSong *song, uint32_t track)
  */
 int avseq_track_unpack(AVSequencerTrack *track, const uint8_t *buf, uint32_t len);
 
+/**
+ * Stores a compressed AVSequencerTrack in packed form instead of
+ * unpacking it. The packed track stream is validated and copied and
+ * any previously opened track data is closed. The rows are then
+ * decoded on access by avseq_track_get_row, which saves the memory
+ * and the many small allocations of fully unpacked track data.
+ *
+ * @param track the AVSequencerTrack where the packed track belongs to,
+ *              last_row must already be set
+ * @param buf the byte buffer containing the packed track stream
+ * @param len the size of the byte buffer containing the packed track stream
+ * @return >= 0 on success, a negative error code otherwise
+ *
+ * @note This is part of the new sequencer API which is still under construction.
+ *       Thus do not use this yet. It may change at any time, do not expect
+ *       ABI compatibility yet!
+ */
+int avseq_track_packed_open(AVSequencerTrack *track, const uint8_t *buf, uint32_t len);
+
+/**
+ * Closes and frees the packed track data of a track.
+ *
+ * @param track the AVSequencerTrack of which the packed track data
+ *              should be freed
+ *
+ * @note This is part of the new sequencer API which is still under construction.
+ *       Thus do not use this yet. It may change at any time, do not expect
+ *       ABI compatibility yet!
+ */
+void avseq_track_packed_close(AVSequencerTrack *track);
+
+/**
+ * Gets a row of a track regardless if it is stored unpacked or in
+ * packed form. Rows of packed tracks are decoded into the cache,
+ * which is only done again if a different row is requested.
+ *
+ * @param track the AVSequencerTrack to get the row of
+ * @param row the number of the row to get
+ * @param cache the AVSequencerTrackRowCache to decode packed rows into
+ * @return pointer to the track row, which stays valid until the cache
+ *         is used for another row, NULL on error
+ *
+ * @note This is part of the new sequencer API which is still under construction.
+ *       Thus do not use this yet. It may change at any time, do not expect
+ *       ABI compatibility yet!
+ */
+const AVSequencerTrackRow *avseq_track_get_row(const AVSequencerTrack *track, uint32_t row,
+                                               AVSequencerTrackRowCache *cache);
+
+/**
+ * Frees the effects storage of a track row cache and empties it.
+ *
+ * @param cache the AVSequencerTrackRowCache to be freed
+ *
+ * @note This is part of the new sequencer API which is still under construction.
+ *       Thus do not use this yet. It may change at any time, do not expect
+ *       ABI compatibility yet!
+ */
+void avseq_track_row_cache_free(AVSequencerTrackRowCache *cache);
+
 /**
  * Creates a new uninitialized empty instrument.
  *
@@ -1514,6 +2043,25 @@ int avseq_synth_code_open(AVSequencerSynth *synth, uint32_t lines);
  */
 void avseq_synth_code_close(AVSequencerSynth *synth);
 
+/**
+ * Pre-decodes a synth sound code for execution by the playback handler
+ * of a sequencer context and stores it in that context. This is done by
+ * avseq_module_play for all synth sounds of the module, so that contexts
+ * sharing a module never modify it while playing. Applications changing
+ * the synth sound code in place while playing must call this again to
+ * make the playback handler execute the changed code.
+ *
+ * @param avctx the AVSequencerContext which stores the pre-decoded code
+ * @param synth the AVSequencerSynth of which the synth sound code is to be pre-decoded
+ * @return >= 0 on success, a negative error code otherwise
+ *
+ * @note This is part of the new sequencer API which is still under construction.
+ *       Thus do not use this yet. It may change at any time, do not expect
+ *       ABI compatibility yet!
+ */
+int avseq_synth_code_compile(AVSequencerContext *avctx,
+                             const AVSequencerSynth *synth);
+
 /**
  * Executes one tick of the playback handler, calculating everything
  * needed for the next step of the mixer. This function usually is
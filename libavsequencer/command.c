@@ -0,0 +1,119 @@
+/*
+ * Implement AVSequencer player command queue
+ * Copyright (c) 2010 Sebastian Vater <cdgs.basty@googlemail.com>
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Implement AVSequencer lock-free single-producer single-consumer
+ * player command queue.
+ */
+
+#include "libavutil/attributes.h"
+#include "libavutil/log.h"
+#include "libavsequencer/avsequencer.h"
+#include "libavsequencer/player.h"
+
+/**
+ * Orders the memory accesses of the command data against the update
+ * of the read and write positions. Without compiler support, only the
+ * volatile positions keep the order, which is sufficient for strongly
+ * ordered CPUs like x86 only.
+ */
+#if AV_GCC_VERSION_AT_LEAST(4,1)
+#define MEMORY_BARRIER() __sync_synchronize()
+#else
+#define MEMORY_BARRIER()
+#endif
+
+int avseq_command_queue_init(AVSequencerContext *avctx, uint32_t commands)
+{
+    AVSequencerPlayerCommandQueue *player_commands;
+    uint32_t size = 1;
+
+    if (!avctx)
+        return AVERROR_INVALIDDATA;
+
+    if (!commands || commands > 0x10000)
+        return AVERROR(EINVAL);
+
+    while (size < commands)
+        size <<= 1;
+
+    if (!(player_commands = av_mallocz(sizeof(AVSequencerPlayerCommandQueue) + (size * sizeof(AVSequencerPlayerCommand)) + FF_INPUT_BUFFER_PADDING_SIZE))) {
+        av_log(avctx, AV_LOG_ERROR, "Cannot allocate player command queue.\n");
+        return AVERROR(ENOMEM);
+    }
+
+    player_commands->command_list = (AVSequencerPlayerCommand *) (player_commands + 1);
+    player_commands->commands     = size;
+
+    av_free(avctx->player_commands);
+    avctx->player_commands = player_commands;
+
+    return 0;
+}
+
+int avseq_command_send(AVSequencerContext *avctx,
+                       const AVSequencerPlayerCommand *command)
+{
+    AVSequencerPlayerCommandQueue *player_commands;
+    uint32_t write_pos;
+
+    if (!(avctx && command && (player_commands = avctx->player_commands)))
+        return AVERROR_INVALIDDATA;
+
+    write_pos = player_commands->write_pos;
+
+    if ((write_pos - player_commands->read_pos) >= player_commands->commands)
+        return AVERROR(EAGAIN);
+
+    player_commands->command_list[write_pos & (player_commands->commands - 1)] = *command;
+
+    MEMORY_BARRIER();
+
+    player_commands->write_pos = write_pos + 1;
+
+    return 0;
+}
+
+int avseq_command_receive(AVSequencerContext *avctx,
+                          AVSequencerPlayerCommand *command)
+{
+    AVSequencerPlayerCommandQueue *player_commands;
+    uint32_t read_pos;
+
+    if (!(avctx && (player_commands = avctx->player_commands)))
+        return 0;
+
+    read_pos = player_commands->read_pos;
+
+    if (read_pos == player_commands->write_pos)
+        return 0;
+
+    MEMORY_BARRIER();
+
+    *command = player_commands->command_list[read_pos & (player_commands->commands - 1)];
+
+    MEMORY_BARRIER();
+
+    player_commands->read_pos = read_pos + 1;
+
+    return 1;
+}
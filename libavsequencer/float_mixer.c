@@ -0,0 +1,1538 @@
+/*
+ * Sequencer floating point mixer
+ * Copyright (c) 2010 Sebastian Vater <cdgs.basty@googlemail.com>
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Sequencer floating point mixer.
+ *
+ * Outputs SAMPLE_FMT_FLT with the same level as the integer mixers,
+ * i.e. a full scale SAMPLE_FMT_S32 value corresponds to 1.0. The
+ * channels are resampled block-wise with cubic interpolation into a
+ * contiguous float buffer, on which the resonance filter and the
+ * panning gains are applied in plain loops the compiler can
+ * vectorize.
+ */
+
+#include "libavcodec/avcodec.h"
+#include "libavutil/avstring.h"
+#include "libavutil/mathematics.h"
+#include "libavsequencer/mixer.h"
+
+/** Number of output frames resampled at once before the filter
+   and the panning gains are applied.  */
+#define FLOAT_BLOCK_SIZE 256
+
+typedef struct AV_FloatMixerData {
+    AVMixerData mixer_data;
+    struct AV_FloatMixerChannelInfo *channel_info;
+    uint16_t *active_list;
+    uint32_t active_channels;
+    uint32_t amplify;
+    uint32_t mix_rate;
+    uint32_t mix_rate_frac;
+    uint32_t current_left;
+    uint32_t current_left_frac;
+    uint32_t pass_len;
+    uint32_t pass_len_frac;
+    uint16_t channels_in;
+    uint16_t channels_out;
+} AV_FloatMixerData;
+
+typedef struct AV_FloatMixerChannelInfo {
+    struct ChannelBlock {
+        const int16_t *data;
+        uint32_t len;
+        uint32_t offset;
+        uint32_t fraction;
+        uint32_t offset_one_shoot;
+        uint32_t advance;
+        uint32_t advance_frac;
+        uint32_t end_offset;
+        uint32_t restart_offset;
+        uint32_t repeat;
+        uint32_t repeat_len;
+        uint32_t count_restart;
+        uint32_t counted;
+        uint32_t rate;
+        float volume_left;
+        float volume_right;
+        float filter_c1;
+        float filter_c2;
+        float filter_c3;
+        uint8_t bits_per_sample;
+        uint8_t flags;
+        uint8_t volume;
+        uint8_t panning;
+        uint16_t filter_cutoff;
+        uint16_t filter_damping;
+    } current;
+    struct ChannelBlock next;
+    float filter_tmp1;
+    float filter_tmp2;
+    uint8_t active;
+} AV_FloatMixerChannelInfo;
+
+#if CONFIG_FLOAT_MIXER
+static const char *float_mixer_name(void *p)
+{
+    AVMixerContext *mixctx = p;
+
+    return mixctx->name;
+}
+
+static const AVClass avseq_float_mixer_class = {
+    "AVSequencer Floating Point Mixer",
+    float_mixer_name,
+    NULL,
+    LIBAVUTIL_VERSION_INT,
+};
+
+/** Cubic (Catmull-Rom) interpolation between x0 and x1.  */
+static av_always_inline float interpolate(const float xm1, const float x0,
+                                          const float x1, const float x2,
+                                          const float t)
+{
+    const float c1 = 0.5f * (x1 - xm1);
+    const float c2 = xm1 - 2.5f * x0 + 2.0f * x1 - 0.5f * x2;
+    const float c3 = 0.5f * (x2 - xm1) + 1.5f * (x0 - x1);
+
+    return ((c3 * t + c2) * t + c1) * t + x0;
+}
+
+static av_always_inline int32_t get_sample_x(const struct ChannelBlock *const channel_block,
+                                             const uint32_t offset)
+{
+    const int32_t *const sample    = (const int32_t *const) channel_block->data;
+    const uint32_t bits_per_sample = channel_block->bits_per_sample;
+    uint32_t bit                   = offset * bits_per_sample;
+    const uint32_t smp_offset      = bit >> 5;
+    uint32_t smp_data;
+
+    if (((bit &= 31) + bits_per_sample) < 32) {
+        smp_data = ((uint32_t) sample[smp_offset] << bit) & ~((1 << (32 - bits_per_sample)) - 1);
+    } else {
+        smp_data  = (uint32_t) sample[smp_offset] << bit;
+        smp_data |= ((uint32_t) sample[smp_offset+1] & ~((1 << (64 - (bit + bits_per_sample))) - 1)) >> (32 - bit);
+    }
+
+    return smp_data;
+}
+
+/** Map a neighbouring sample position which lies outside of the
+   current loop back into it, or clamp it to the sample data.  */
+static av_always_inline uint32_t wrap_offset(const struct ChannelBlock *const channel_block,
+                                             int64_t offset)
+{
+    if ((channel_block->flags & AVSEQ_MIXER_CHANNEL_FLAG_LOOP) && channel_block->repeat_len) {
+        const int64_t loop_start = channel_block->repeat;
+        const int64_t loop_end   = loop_start + channel_block->repeat_len;
+
+        if (offset >= loop_end)
+            offset = (channel_block->flags & AVSEQ_MIXER_CHANNEL_FLAG_PINGPONG) ? ((loop_end << 1) - 1) - offset : offset - channel_block->repeat_len;
+        else if ((offset < loop_start) && (channel_block->flags & AVSEQ_MIXER_CHANNEL_FLAG_BACKWARDS))
+            offset = (channel_block->flags & AVSEQ_MIXER_CHANNEL_FLAG_PINGPONG) ? ((loop_start << 1) - 1) - offset : offset + channel_block->repeat_len;
+    }
+
+    if (offset < 0)
+        offset = 0;
+    else if (offset >= channel_block->len)
+        offset = channel_block->len - 1;
+
+    return offset;
+}
+
+/** Resample len output frames of a channel block into dst. The
+   neighbours of the current sample are read directly unless they
+   cross the loop or sample boundaries.  */
+#define RESAMPLE(name, read)                                                                            \
+static void resample_##name(const struct ChannelBlock *const channel_block, float *const dst,            \
+                            uint32_t *const offset, uint32_t *const fraction,                           \
+                            const uint32_t advance, const uint32_t adv_frac, const uint32_t len)        \
+{                                                                                                       \
+    const int32_t inc    = (channel_block->flags & AVSEQ_MIXER_CHANNEL_FLAG_BACKWARDS) ? -1 : 1;         \
+    const int64_t len64  = channel_block->len;                                                          \
+    uint32_t curr_offset = *offset;                                                                     \
+    uint32_t curr_frac   = *fraction;                                                                   \
+    int64_t first, last;                                                                                \
+    uint32_t i;                                                                                         \
+                                                                                                        \
+    if (channel_block->flags & AVSEQ_MIXER_CHANNEL_FLAG_LOOP) {                                         \
+        first = channel_block->repeat;                                                                  \
+        last  = first + channel_block->repeat_len;                                                      \
+                                                                                                        \
+        if (inc > 0)                                                                                    \
+            first = 0;                                                                                  \
+    } else {                                                                                            \
+        first = 0;                                                                                      \
+        last  = len64;                                                                                  \
+    }                                                                                                   \
+                                                                                                        \
+    if (last > len64)                                                                                   \
+        last = len64;                                                                                   \
+                                                                                                        \
+    first += (inc > 0) ? 1 : 2;                                                                         \
+    last  -= (inc > 0) ? 2 : 1;                                                                         \
+                                                                                                        \
+    for (i = 0; i < len; i++) {                                                                         \
+        const float t = (float) curr_frac * (1.0f / 4294967296.0f);                                     \
+        float xm1, x0, x1, x2;                                                                          \
+        uint32_t step;                                                                                  \
+                                                                                                        \
+        if (((int64_t) curr_offset >= first) && ((int64_t) curr_offset < last)) {                      \
+            xm1 = read(curr_offset - inc);                                                              \
+            x0  = read(curr_offset);                                                                    \
+            x1  = read(curr_offset + inc);                                                              \
+            x2  = read(curr_offset + (inc << 1));                                                       \
+        } else {                                                                                        \
+            xm1 = read(wrap_offset(channel_block, (int64_t) curr_offset - inc));                        \
+            x0  = read(wrap_offset(channel_block, (int64_t) curr_offset));                              \
+            x1  = read(wrap_offset(channel_block, (int64_t) curr_offset + inc));                        \
+            x2  = read(wrap_offset(channel_block, (int64_t) curr_offset + (inc << 1)));                 \
+        }                                                                                               \
+                                                                                                        \
+        dst[i]       = interpolate(xm1, x0, x1, x2, t);                                                 \
+        curr_frac   += adv_frac;                                                                        \
+        step         = advance + (curr_frac < adv_frac);                                                \
+        curr_offset += step * inc;                                                                      \
+    }                                                                                                   \
+                                                                                                        \
+    *offset   = curr_offset;                                                                            \
+    *fraction = curr_frac;                                                                              \
+}
+
+#define READ_8(idx)  (((const int8_t *) channel_block->data)[idx] * (1.0f / 128.0f))
+#define READ_16(idx) (channel_block->data[idx] * (1.0f / 32768.0f))
+#define READ_32(idx) (((const int32_t *) channel_block->data)[idx] * (1.0f / 2147483648.0f))
+#define READ_X(idx)  (get_sample_x(channel_block, idx) * (1.0f / 2147483648.0f))
+
+RESAMPLE(8, READ_8)
+RESAMPLE(16, READ_16)
+RESAMPLE(32, READ_32)
+RESAMPLE(x, READ_X)
+
+static void filter_block(AV_FloatMixerChannelInfo *const channel_info,
+                         const struct ChannelBlock *const channel_block,
+                         float *const buf, const uint32_t len)
+{
+    const float c1 = channel_block->filter_c1;
+    const float c2 = channel_block->filter_c2;
+    const float c3 = channel_block->filter_c3;
+    float o1       = channel_info->filter_tmp2;
+    float o2       = channel_info->filter_tmp1;
+    uint32_t i;
+
+    if ((channel_block->filter_cutoff == 4095) && (channel_block->filter_damping == 0))
+        return;
+
+    for (i = 0; i < len; i++) {
+        const float o3 = c1 * buf[i] + c2 * o2 + c3 * o1;
+
+        buf[i] = o3;
+        o1     = o2;
+        o2     = o3;
+    }
+
+    channel_info->filter_tmp1 = o2;
+    channel_info->filter_tmp2 = o1;
+}
+
+static void mix_channel(const AV_FloatMixerData *const mixer_data,
+                        AV_FloatMixerChannelInfo *const channel_info,
+                        float **const buf, uint32_t *const offset, uint32_t *const fraction,
+                        const uint32_t advance, const uint32_t adv_frac, const uint32_t len)
+{
+    const struct ChannelBlock *const channel_block = &channel_info->current;
+    const float volume_left                        = channel_block->volume_left;
+    const float volume_right                       = channel_block->volume_right;
+    float *mix_buf                                 = *buf;
+    uint32_t i                                     = len;
+    float smp_buf[FLOAT_BLOCK_SIZE];
+
+    if ((volume_left == 0.0f) && (volume_right == 0.0f)) {
+        uint32_t curr_offset    = *offset, curr_frac = *fraction, skip_frac;
+        const uint64_t skip_len = (((uint64_t) advance << 32) + adv_frac) * len;
+
+        skip_frac  = skip_len;
+        curr_frac += skip_frac;
+
+        if (channel_block->flags & AVSEQ_MIXER_CHANNEL_FLAG_BACKWARDS)
+            curr_offset -= (skip_len >> 32) + (curr_frac < skip_frac);
+        else
+            curr_offset += (skip_len >> 32) + (curr_frac < skip_frac);
+
+        *offset   = curr_offset;
+        *fraction = curr_frac;
+        *buf     += (mixer_data->channels_out >= 2) ? len << 1 : len;
+
+        return;
+    }
+
+    do {
+        const uint32_t block_len = (i > FLOAT_BLOCK_SIZE) ? FLOAT_BLOCK_SIZE : i;
+        uint32_t j;
+
+        switch (channel_block->bits_per_sample) {
+        case 8 :
+            resample_8(channel_block, smp_buf, offset, fraction, advance, adv_frac, block_len);
+
+            break;
+        case 16 :
+            resample_16(channel_block, smp_buf, offset, fraction, advance, adv_frac, block_len);
+
+            break;
+        case 32 :
+            resample_32(channel_block, smp_buf, offset, fraction, advance, adv_frac, block_len);
+
+            break;
+        default :
+            resample_x(channel_block, smp_buf, offset, fraction, advance, adv_frac, block_len);
+
+            break;
+        }
+
+        filter_block(channel_info, channel_block, smp_buf, block_len);
+
+        if (mixer_data->channels_out >= 2) {
+            for (j = 0; j < block_len; j++) {
+                mix_buf[(j << 1)]     += smp_buf[j] * volume_left;
+                mix_buf[(j << 1) + 1] += smp_buf[j] * volume_right;
+            }
+
+            mix_buf += block_len << 1;
+        } else {
+            for (j = 0; j < block_len; j++)
+                mix_buf[j] += smp_buf[j] * volume_left;
+
+            mix_buf += block_len;
+        }
+
+        i -= block_len;
+    } while (i);
+
+    *buf = mix_buf;
+}
+
+static void mix_sample_channel(AV_FloatMixerData *const mixer_data,
+                               AV_FloatMixerChannelInfo *const channel_info,
+                               float *const buf,
+                               const uint32_t len)
+{
+    float *mix_buf      = buf;
+    uint32_t offset     = channel_info->current.offset;
+    uint32_t fraction   = channel_info->current.fraction;
+    uint32_t advance    = channel_info->current.advance;
+    uint32_t adv_frac   = channel_info->current.advance_frac;
+    uint32_t remain_len = len, remain_mix;
+    uint32_t counted;
+    uint32_t count_restart;
+    uint64_t calc_mix;
+
+    if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_BACKWARDS) {
+mix_sample_backwards:
+        for (;;) {
+            calc_mix = (((((uint64_t) advance << 32) + adv_frac) * remain_len) + fraction) >> 32;
+
+            if ((int32_t) (remain_mix = offset - channel_info->current.end_offset) > 0) {
+                if ((uint32_t) calc_mix < remain_mix) {
+                    mix_channel(mixer_data, channel_info, &mix_buf, &offset, &fraction, advance, adv_frac, remain_len);
+
+                    if ((int32_t) offset <= (int32_t) channel_info->current.end_offset)
+                        remain_len = 0;
+                    else
+                        break;
+                } else {
+                    calc_mix    = (((((uint64_t) remain_mix << 32) - fraction) - 1) / (((uint64_t) advance << 32) + adv_frac) + 1);
+                    remain_len -= (uint32_t) calc_mix;
+
+                    mix_channel(mixer_data, channel_info, &mix_buf, &offset, &fraction, advance, adv_frac, (uint32_t) calc_mix);
+
+                    if (((int32_t) offset > (int32_t) channel_info->current.end_offset) && !remain_len)
+                        break;
+                }
+            }
+
+            if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_LOOP) {
+                counted = channel_info->current.counted++;
+
+                if ((count_restart = channel_info->current.count_restart) && (count_restart == counted)) {
+                    channel_info->current.flags     &= ~AVSEQ_MIXER_CHANNEL_FLAG_LOOP;
+                    channel_info->current.end_offset = -1;
+
+                    goto mix_sample_synth;
+                } else {
+                    if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_PINGPONG) {
+                        if (channel_info->next.data) {
+                            memcpy(&channel_info->current, &channel_info->next, sizeof(struct ChannelBlock));
+
+                            channel_info->next.data = NULL;
+                        }
+
+                        channel_info->current.flags             ^= AVSEQ_MIXER_CHANNEL_FLAG_BACKWARDS;
+                        remain_mix                               = channel_info->current.end_offset;
+                        offset                                  -= remain_mix;
+                        offset                                   = -offset + remain_mix;
+                        remain_mix                              += channel_info->current.restart_offset;
+                        channel_info->current.end_offset         = remain_mix;
+
+                        if ((int32_t) remain_len > 0)
+                            goto mix_sample_forwards;
+
+                        break;
+                    } else {
+                        offset += channel_info->current.restart_offset;
+
+                        if (channel_info->next.data)
+                            goto mix_sample_synth;
+
+                        if ((int32_t) remain_len > 0)
+                            continue;
+
+                        break;
+                    }
+                }
+            } else {
+                if (channel_info->next.data)
+                    goto mix_sample_synth;
+                else
+                    channel_info->current.flags &= ~AVSEQ_MIXER_CHANNEL_FLAG_PLAY;
+
+                break;
+            }
+        }
+    } else {
+mix_sample_forwards:
+        for (;;) {
+            calc_mix = (((((uint64_t) advance << 32) + adv_frac) * remain_len) + fraction) >> 32;
+
+            if ((int32_t) (remain_mix = channel_info->current.end_offset - offset) > 0) {
+                if ((uint32_t) calc_mix < remain_mix) {
+                    mix_channel(mixer_data, channel_info, &mix_buf, &offset, &fraction, advance, adv_frac, remain_len);
+
+                    if (offset >= channel_info->current.end_offset)
+                        remain_len = 0;
+                    else
+                        break;
+                } else {
+                    calc_mix    = (((((uint64_t) remain_mix << 32) - fraction) - 1) / (((uint64_t) advance << 32) + adv_frac) + 1);
+                    remain_len -= (uint32_t) calc_mix;
+
+                    mix_channel(mixer_data, channel_info, &mix_buf, &offset, &fraction, advance, adv_frac, (uint32_t) calc_mix);
+
+                    if ((offset < channel_info->current.end_offset) && !remain_len)
+                        break;
+                }
+            }
+
+            if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_LOOP) {
+                counted = channel_info->current.counted++;
+
+                if ((count_restart = channel_info->current.count_restart) && (count_restart == counted)) {
+                    channel_info->current.flags     &= ~AVSEQ_MIXER_CHANNEL_FLAG_LOOP;
+                    channel_info->current.end_offset = channel_info->current.len;
+
+                    goto mix_sample_synth;
+                } else {
+                    if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_PINGPONG) {
+                        if (channel_info->next.data) {
+                            memcpy(&channel_info->current, &channel_info->next, sizeof(struct ChannelBlock));
+
+                            channel_info->next.data = NULL;
+                        }
+
+                        channel_info->current.flags             ^= AVSEQ_MIXER_CHANNEL_FLAG_BACKWARDS;
+                        remain_mix                               = channel_info->current.end_offset;
+                        offset                                  -= remain_mix;
+                        offset                                   = -offset + remain_mix;
+                        remain_mix                              -= channel_info->current.restart_offset;
+                        channel_info->current.end_offset         = remain_mix;
+
+                        if (remain_len)
+                            goto mix_sample_backwards;
+
+                        break;
+                    } else {
+                        offset -= channel_info->current.restart_offset;
+
+                        if (channel_info->next.data) {
+                            memcpy(&channel_info->current, &channel_info->next, sizeof(struct ChannelBlock));
+
+                            channel_info->next.data = NULL;
+                        }
+
+                        if ((int32_t) remain_len > 0)
+                            continue;
+
+                        break;
+                    }
+                }
+            } else {
+                if (channel_info->next.data) {
+mix_sample_synth:
+                    memcpy(&channel_info->current, &channel_info->next, sizeof(struct ChannelBlock));
+
+                    channel_info->next.data = NULL;
+
+                    if ((int32_t) remain_len > 0)
+                        continue;
+                } else {
+                    channel_info->current.flags &= ~AVSEQ_MIXER_CHANNEL_FLAG_PLAY;
+                }
+
+                break;
+            }
+        }
+    }
+
+    channel_info->current.offset_one_shoot += (offset > channel_info->current.offset) ? (offset - channel_info->current.offset) : (channel_info->current.offset - offset);
+
+    if (channel_info->current.offset_one_shoot >= channel_info->current.len) {
+        channel_info->current.offset_one_shoot = channel_info->current.len;
+
+        if (!(channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_LOOP))
+            channel_info->current.flags &= ~AVSEQ_MIXER_CHANNEL_FLAG_PLAY;
+    }
+
+    channel_info->current.offset   = offset;
+    channel_info->current.fraction = fraction;
+}
+
+static void mix_sample_parallel(AV_FloatMixerData *const mixer_data,
+                                float *const buf, const uint32_t len,
+                                const uint32_t first_channel,
+                                const uint32_t last_channel)
+{
+    AV_FloatMixerChannelInfo *channel_info = mixer_data->channel_info + first_channel;
+    uint16_t i                             = (last_channel - first_channel) + 1;
+
+    do {
+        if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_PLAY)
+            mix_sample_channel(mixer_data, channel_info, buf, len);
+
+        channel_info++;
+    } while (--i);
+}
+
+/** Mixes the channels of the active channel list entries from first
+   up to (but not including) last, so channels which are not playing
+   are never touched.  */
+static void mix_sample_active(AV_FloatMixerData *const mixer_data,
+                              float *const buf,
+                              const uint32_t len,
+                              const uint32_t first,
+                              const uint32_t last)
+{
+    AV_FloatMixerChannelInfo *const channel_info = mixer_data->channel_info;
+    const uint16_t *const active_list            = mixer_data->active_list;
+    uint32_t i;
+
+    for (i = first; i < last; i++) {
+        if (channel_info[active_list[i]].current.flags & AVSEQ_MIXER_CHANNEL_FLAG_PLAY)
+            mix_sample_channel(mixer_data, channel_info + active_list[i], buf, len);
+    }
+}
+
+/** Removes channels which have stopped playing from the active
+   channel list, preserving the order of the remaining ones.  */
+static void update_active_list(AV_FloatMixerData *const mixer_data)
+{
+    AV_FloatMixerChannelInfo *const channel_info = mixer_data->channel_info;
+    uint16_t *const active_list                  = mixer_data->active_list;
+    uint32_t i, j = 0;
+
+    for (i = 0; i < mixer_data->active_channels; i++) {
+        const uint16_t channel = active_list[i];
+
+        if (channel_info[channel].current.flags & AVSEQ_MIXER_CHANNEL_FLAG_PLAY)
+            active_list[j++] = channel;
+        else
+            channel_info[channel].active = 0;
+    }
+
+    mixer_data->active_channels = j;
+}
+
+/** Appends a channel to the active channel list when it has been
+   started, it is removed again by update_active_list after it has
+   stopped playing.  */
+static void activate_channel(AV_FloatMixerData *const mixer_data,
+                             AV_FloatMixerChannelInfo *const channel_info)
+{
+    if ((channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_PLAY) && !channel_info->active) {
+        channel_info->active                                   = 1;
+        mixer_data->active_list[mixer_data->active_channels++] = channel_info - mixer_data->channel_info;
+    }
+}
+
+/** Rebuilds the active channel list from scratch, this is required
+   whenever the channel data has been reallocated.  */
+static void init_active_list(AV_FloatMixerData *const mixer_data)
+{
+    AV_FloatMixerChannelInfo *channel_info = mixer_data->channel_info;
+    uint16_t i;
+
+    mixer_data->active_channels = 0;
+
+    for (i = mixer_data->channels_in; i > 0; i--) {
+        channel_info->active = 0;
+
+        activate_channel(mixer_data, channel_info++);
+    }
+}
+
+static void mix_sample(AV_FloatMixerData *const mixer_data,
+                       float *const buf, const uint32_t len)
+{
+    mix_sample_active(mixer_data, buf, len, 0, mixer_data->active_channels);
+    update_active_list(mixer_data);
+}
+
+/** Calculates the left and right output gains of a channel block,
+   scaled so that the output level matches the integer mixers. Mono
+   output, surround and centre panning use half of the full volume,
+   hard left and right panning the full volume, like the channel
+   preparation of the high quality mixer.  */
+static void set_sample_volume(const AV_FloatMixerData *const mixer_data,
+                              struct ChannelBlock *const channel_block)
+{
+    const float mult      = ((float) mixer_data->amplify * (1.0f / 65536.0f)) / (65536.0f * 65536.0f * mixer_data->channels_in);
+    const float left      = (float) mixer_data->mixer_data.volume_left * mult;
+    const float right     = (float) mixer_data->mixer_data.volume_right * mult;
+    const uint32_t volume = channel_block->volume;
+    const uint8_t panning = channel_block->panning;
+
+    if ((channel_block->flags & AVSEQ_MIXER_CHANNEL_FLAG_MUTED) || !volume || !channel_block->data || !channel_block->len) {
+        channel_block->volume_left  = 0.0f;
+        channel_block->volume_right = 0.0f;
+    } else if (mixer_data->channels_out < 2) {
+        channel_block->volume_left  = (float) (volume << 7) * left;
+        channel_block->volume_right = 0.0f;
+    } else if (channel_block->flags & AVSEQ_MIXER_CHANNEL_FLAG_SURROUND) {
+        channel_block->volume_left  = (float) (volume << 7) * left;
+        channel_block->volume_right = (float) (volume << 7) * -right;
+    } else if (panning == 0x00) {
+        channel_block->volume_left  = (float) (volume << 8) * left;
+        channel_block->volume_right = 0.0f;
+    } else if (panning == 0xFF) {
+        channel_block->volume_left  = 0.0f;
+        channel_block->volume_right = (float) (volume << 8) * right;
+    } else if ((panning == 0x80) && (mixer_data->mixer_data.volume_left == mixer_data->mixer_data.volume_right)) {
+        channel_block->volume_left  = (float) (volume << 7) * left;
+        channel_block->volume_right = (float) (volume << 7) * right;
+    } else {
+        channel_block->volume_left  = (float) (volume * (255 - panning)) * left;
+        channel_block->volume_right = (float) (volume * panning) * right;
+    }
+}
+
+static void set_sample_mix_rate(const AV_FloatMixerData *const mixer_data,
+                                struct ChannelBlock *const channel_block,
+                                const uint32_t rate)
+{
+    const uint32_t mix_rate = mixer_data->mix_rate;
+
+    channel_block->rate         = rate;
+    channel_block->advance      = rate / mix_rate;
+    channel_block->advance_frac = (((uint64_t) rate % mix_rate) << 32) / mix_rate;
+
+    set_sample_volume(mixer_data, channel_block);
+}
+
+static void update_sample_filter(const AV_FloatMixerData *const mixer_data,
+                                 AV_FloatMixerChannelInfo *const channel_info,
+                                 struct ChannelBlock *const channel_block)
+{
+    const float mix_rate = mixer_data->mix_rate;
+    float nat_freq, damp_factor, d, e, tmp;
+
+    if ((channel_block->filter_cutoff == 4095) && (channel_block->filter_damping == 0)) {
+        channel_block->filter_c1  = 1.0f;
+        channel_block->filter_c2  = 0.0f;
+        channel_block->filter_c3  = 0.0f;
+        channel_info->filter_tmp1 = 0.0f;
+        channel_info->filter_tmp2 = 0.0f;
+
+        return;
+    }
+
+    nat_freq    = 2.0f * M_PI * 110.0f * powf(2.0f, 0.25f + channel_block->filter_cutoff * (1.0f / 768.0f));
+    damp_factor = 2.0f * powf(10.0f, -((24.0f / 128.0f) * channel_block->filter_damping) * (1.0f / 640.0f));
+    d           = (nat_freq * (1.0f - damp_factor)) / mix_rate;
+
+    if (d > 2.0f)
+        d = 2.0f;
+
+    d   = ((damp_factor - d) * mix_rate) / nat_freq;
+    e   = (mix_rate / nat_freq) * (mix_rate / nat_freq);
+    tmp = 1.0f + d + e;
+
+    channel_block->filter_c1 = 1.0f / tmp;
+    channel_block->filter_c2 = (d + e + e) / tmp;
+    channel_block->filter_c3 = -e / tmp;
+}
+
+static void set_sample_filter(const AV_FloatMixerData *const mixer_data,
+                              AV_FloatMixerChannelInfo *const channel_info,
+                              struct ChannelBlock *const channel_block,
+                              uint16_t cutoff,
+                              uint16_t damping)
+{
+    if (cutoff > 4095)
+        cutoff = 4095;
+
+    if (damping > 4095)
+        damping = 4095;
+
+    if ((channel_block->filter_cutoff == cutoff) && (channel_block->filter_damping == damping))
+        return;
+
+    channel_block->filter_cutoff  = cutoff;
+    channel_block->filter_damping = damping;
+
+    update_sample_filter(mixer_data, channel_info, channel_block);
+}
+
+static av_cold AVMixerData *init(AVMixerContext *const mixctx,
+                                 const char *args, void *opaque)
+{
+    AV_FloatMixerData *float_mixer_data = NULL;
+    AV_FloatMixerChannelInfo *channel_info;
+    const char *cfg_buf;
+    uint16_t i;
+    int32_t *buf;
+    unsigned buf_size;
+    uint32_t mix_buf_mem_size, channel_rate;
+    uint16_t channels_in = 1, channels_out = 1;
+
+    if (!(float_mixer_data = av_mallocz(sizeof(AV_FloatMixerData) + FF_INPUT_BUFFER_PADDING_SIZE))) {
+        av_log(mixctx, AV_LOG_ERROR, "Cannot allocate mixer data factory.\n");
+
+        return NULL;
+    }
+
+    float_mixer_data->mixer_data.mixctx = mixctx;
+    buf_size                           = float_mixer_data->mixer_data.mixctx->buf_size;
+
+    if ((cfg_buf = av_stristr(args, "buffer=")))
+        sscanf(cfg_buf, "buffer=%d;", &buf_size);
+
+    if (!(channel_info = av_mallocz((channels_in * sizeof(AV_FloatMixerChannelInfo)) + FF_INPUT_BUFFER_PADDING_SIZE))) {
+        av_log(mixctx, AV_LOG_ERROR, "Cannot allocate mixer channel data.\n");
+        av_free(float_mixer_data);
+
+        return NULL;
+    }
+
+    if (!(float_mixer_data->active_list = av_malloc((channels_in * sizeof(uint16_t)) + FF_INPUT_BUFFER_PADDING_SIZE))) {
+        av_log(mixctx, AV_LOG_ERROR, "Cannot allocate mixer active channel list.\n");
+        av_free(channel_info);
+        av_free(float_mixer_data);
+
+        return NULL;
+    }
+
+    float_mixer_data->channel_info           = channel_info;
+    float_mixer_data->mixer_data.channels_in = channels_in;
+    float_mixer_data->channels_in            = channels_in;
+    float_mixer_data->channels_out           = channels_out;
+    mix_buf_mem_size                       = (buf_size << 2) * channels_out;
+
+    if (!(buf = av_mallocz(mix_buf_mem_size + FF_INPUT_BUFFER_PADDING_SIZE))) {
+        av_log(mixctx, AV_LOG_ERROR, "Cannot allocate mixer output buffer.\n");
+        av_freep(&float_mixer_data->active_list);
+        av_freep(&float_mixer_data->channel_info);
+        av_free(float_mixer_data);
+
+        return NULL;
+    }
+
+    float_mixer_data->mixer_data.mix_buf_size = buf_size;
+    float_mixer_data->mixer_data.mix_buf      = buf;
+    channel_rate                             = float_mixer_data->mixer_data.mixctx->frequency;
+    float_mixer_data->mixer_data.rate         = channel_rate;
+    float_mixer_data->mix_rate                = channel_rate;
+    float_mixer_data->channels_in             = channels_in;
+    float_mixer_data->channels_out            = channels_out;
+
+    for (i = float_mixer_data->channels_in; i > 0; i--) {
+        channel_info->current.filter_cutoff = 4095;
+        channel_info->current.filter_c1     = 1.0f;
+        channel_info->next.filter_cutoff    = 4095;
+        channel_info->next.filter_c1        = 1.0f;
+
+        channel_info++;
+    }
+
+    return (AVMixerData *) float_mixer_data;
+}
+
+static av_cold int uninit(AVMixerData *const mixer_data)
+{
+    AV_FloatMixerData *float_mixer_data = (AV_FloatMixerData *) mixer_data;
+
+    if (!float_mixer_data)
+        return AVERROR_INVALIDDATA;
+
+    av_freep(&float_mixer_data->active_list);
+    av_freep(&float_mixer_data->channel_info);
+    av_freep(&float_mixer_data->mixer_data.mix_buf);
+    av_free(float_mixer_data);
+
+    return 0;
+}
+
+static av_cold uint32_t set_tempo(AVMixerData *const mixer_data,
+                                  const uint32_t tempo)
+{
+    AV_FloatMixerData *const float_mixer_data = (AV_FloatMixerData *const) mixer_data;
+    const uint32_t channel_rate             = float_mixer_data->mix_rate * 10;
+    uint64_t pass_value;
+
+    float_mixer_data->mixer_data.tempo = tempo;
+    pass_value                        = ((uint64_t) channel_rate << 16) + ((uint64_t) float_mixer_data->mix_rate_frac >> 16);
+    float_mixer_data->pass_len         = (uint64_t) pass_value / float_mixer_data->mixer_data.tempo;
+    float_mixer_data->pass_len_frac    = (((uint64_t) pass_value % float_mixer_data->mixer_data.tempo) << 32) / float_mixer_data->mixer_data.tempo;
+
+    return tempo;
+}
+
+static av_cold uint32_t set_rate(AVMixerData *const mixer_data,
+                                 const uint32_t mix_rate,
+                                 const uint32_t channels)
+{
+    AV_FloatMixerData *const float_mixer_data = (AV_FloatMixerData *const) mixer_data;
+    uint32_t buf_size, old_mix_rate, mix_rate_frac;
+
+    buf_size                                 = float_mixer_data->mixer_data.mix_buf_size;
+    float_mixer_data->mixer_data.rate         = mix_rate;
+    float_mixer_data->mixer_data.channels_out = channels;
+
+    if ((float_mixer_data->mixer_data.mix_buf_size * float_mixer_data->channels_out) != (buf_size * channels)) {
+        int32_t *buf                    = float_mixer_data->mixer_data.mix_buf;
+        const uint32_t mix_buf_mem_size = (buf_size * channels) << 2;
+
+        if (!(buf = av_realloc(buf, mix_buf_mem_size + FF_INPUT_BUFFER_PADDING_SIZE))) {
+            av_log(float_mixer_data->mixer_data.mixctx, AV_LOG_ERROR, "Cannot allocate mixer output channel data.\n");
+
+            return float_mixer_data->mixer_data.rate;
+        }
+
+        memset(buf, 0, mix_buf_mem_size);
+
+        float_mixer_data->mixer_data.mix_buf      = buf;
+        float_mixer_data->mixer_data.mix_buf_size = buf_size;
+    }
+
+    if (float_mixer_data->channels_out != channels) {
+        AV_FloatMixerChannelInfo *channel_info = float_mixer_data->channel_info;
+        uint16_t i;
+
+        float_mixer_data->channels_out = channels;
+
+        for (i = float_mixer_data->channels_in; i > 0; i--) {
+            set_sample_volume(float_mixer_data, &channel_info->current);
+            set_sample_volume(float_mixer_data, &channel_info->next);
+
+            channel_info++;
+        }
+    }
+
+    if (float_mixer_data->mixer_data.flags & AVSEQ_MIXER_DATA_FLAG_MIXING) {
+        old_mix_rate  = mix_rate; // TODO: Add check here if this mix rate is supported by target device
+        mix_rate_frac = 0;
+
+        if (float_mixer_data->mix_rate != old_mix_rate) {
+            AV_FloatMixerChannelInfo *channel_info = float_mixer_data->channel_info;
+            uint16_t i;
+
+            float_mixer_data->mix_rate      = old_mix_rate;
+            float_mixer_data->mix_rate_frac = mix_rate_frac;
+
+            if (float_mixer_data->mixer_data.tempo)
+                set_tempo((AVMixerData *) mixer_data, float_mixer_data->mixer_data.tempo);
+
+            for (i = float_mixer_data->channels_in; i > 0; i--) {
+                channel_info->current.advance      = channel_info->current.rate / old_mix_rate;
+                channel_info->current.advance_frac = (((uint64_t) channel_info->current.rate % old_mix_rate) << 32) / old_mix_rate;
+                channel_info->next.advance         = channel_info->next.rate / old_mix_rate;
+                channel_info->next.advance_frac    = (((uint64_t) channel_info->next.rate % old_mix_rate) << 32) / old_mix_rate;
+
+                update_sample_filter(float_mixer_data, channel_info, &channel_info->current);
+                update_sample_filter(float_mixer_data, channel_info, &channel_info->next);
+
+                channel_info++;
+            }
+        }
+    }
+
+    // TODO: Inform libavfilter that the target mixing rate has been changed.
+
+    return mix_rate;
+}
+
+static av_cold uint32_t set_volume(AVMixerData *const mixer_data,
+                                   const uint32_t amplify,
+                                   const uint32_t left_volume,
+                                   const uint32_t right_volume,
+                                   const uint32_t channels)
+{
+    AV_FloatMixerData *const float_mixer_data         = (AV_FloatMixerData *const) mixer_data;
+    AV_FloatMixerChannelInfo *channel_info           = NULL;
+    AV_FloatMixerChannelInfo *const old_channel_info = float_mixer_data->channel_info;
+    uint32_t old_channels, i;
+
+    if (((old_channels = float_mixer_data->channels_in) != channels) && !(channel_info = av_mallocz((channels * sizeof(AV_FloatMixerChannelInfo)) + FF_INPUT_BUFFER_PADDING_SIZE))) {
+        av_log(float_mixer_data->mixer_data.mixctx, AV_LOG_ERROR, "Cannot allocate mixer channel data.\n");
+
+        return old_channels;
+    }
+
+    if (channel_info) {
+        uint16_t *const active_list = av_realloc(float_mixer_data->active_list, (channels * sizeof(uint16_t)) + FF_INPUT_BUFFER_PADDING_SIZE);
+
+        if (!active_list) {
+            av_log(float_mixer_data->mixer_data.mixctx, AV_LOG_ERROR, "Cannot allocate mixer active channel list.\n");
+            av_free(channel_info);
+
+            return old_channels;
+        }
+
+        float_mixer_data->active_list = active_list;
+    }
+
+    float_mixer_data->amplify                 = amplify;
+    float_mixer_data->mixer_data.volume_boost = amplify;
+    float_mixer_data->mixer_data.volume_left  = left_volume;
+    float_mixer_data->mixer_data.volume_right = right_volume;
+    float_mixer_data->mixer_data.channels_in  = channels;
+
+    if (old_channels && channel_info && (old_channels != channels)) {
+        uint32_t copy_channels = old_channels;
+        uint16_t i;
+
+        if (copy_channels > channels)
+            copy_channels = channels;
+
+        memcpy(channel_info, old_channel_info, copy_channels * sizeof(AV_FloatMixerChannelInfo));
+
+        float_mixer_data->channel_info = channel_info;
+        float_mixer_data->channels_in  = channels;
+
+        channel_info += copy_channels;
+
+        for (i = copy_channels; i < channels; ++i) {
+            channel_info->current.filter_cutoff = 4095;
+            channel_info->current.filter_c1     = 1.0f;
+            channel_info->next.filter_cutoff    = 4095;
+            channel_info->next.filter_c1        = 1.0f;
+
+            channel_info++;
+        }
+
+        av_free(old_channel_info);
+        init_active_list(float_mixer_data);
+    }
+
+    channel_info = float_mixer_data->channel_info;
+
+    for (i = channels; i > 0; i--) {
+        set_sample_volume(float_mixer_data, &channel_info->current);
+        set_sample_volume(float_mixer_data, &channel_info->next);
+
+        channel_info++;
+    }
+
+    return channels;
+}
+
+static av_cold void get_channel(const AVMixerData *const mixer_data,
+                                AVMixerChannel *const mixer_channel,
+                                const uint32_t channel)
+{
+    const AV_FloatMixerData *const float_mixer_data     = (const AV_FloatMixerData *const) mixer_data;
+    const AV_FloatMixerChannelInfo *const channel_info = float_mixer_data->channel_info + channel;
+
+    mixer_channel->pos             = channel_info->current.offset;
+    mixer_channel->pos_one_shoot   = channel_info->current.offset_one_shoot;
+    mixer_channel->bits_per_sample = channel_info->current.bits_per_sample;
+    mixer_channel->flags           = channel_info->current.flags;
+    mixer_channel->volume          = channel_info->current.volume;
+    mixer_channel->panning         = channel_info->current.panning;
+    mixer_channel->data            = channel_info->current.data;
+    mixer_channel->len             = channel_info->current.len;
+    mixer_channel->repeat_start    = channel_info->current.repeat;
+    mixer_channel->repeat_length   = channel_info->current.repeat_len;
+    mixer_channel->repeat_count    = channel_info->current.count_restart;
+    mixer_channel->repeat_counted  = channel_info->current.counted;
+    mixer_channel->rate            = channel_info->current.rate;
+    mixer_channel->filter_cutoff   = channel_info->current.filter_cutoff;
+    mixer_channel->filter_damping  = channel_info->current.filter_damping;
+}
+
+static av_cold void set_channel(AVMixerData *const mixer_data,
+                                const AVMixerChannel *const mixer_channel,
+                                const uint32_t channel)
+{
+    AV_FloatMixerData *const float_mixer_data       = (AV_FloatMixerData *const) mixer_data;
+    AV_FloatMixerChannelInfo *const channel_info   = float_mixer_data->channel_info + channel;
+    struct ChannelBlock *channel_block;
+    uint32_t repeat, repeat_len;
+
+    channel_info->next.data = NULL;
+
+    if (mixer_channel->flags & AVSEQ_MIXER_CHANNEL_FLAG_SYNTH)
+        channel_block = &channel_info->next;
+    else
+        channel_block = &channel_info->current;
+
+    channel_block->offset           = mixer_channel->pos;
+    channel_block->fraction         = 0;
+    channel_block->offset_one_shoot = mixer_channel->pos_one_shoot;
+    channel_block->bits_per_sample  = mixer_channel->bits_per_sample;
+    channel_block->flags            = mixer_channel->flags;
+    channel_block->volume           = mixer_channel->volume;
+    channel_block->panning          = mixer_channel->panning;
+    channel_block->data             = mixer_channel->data;
+    channel_block->len              = mixer_channel->len;
+    repeat                          = mixer_channel->repeat_start;
+    repeat_len                      = mixer_channel->repeat_length;
+    channel_block->repeat           = repeat;
+    channel_block->repeat_len       = repeat_len;
+
+    if (!(channel_block->flags & AVSEQ_MIXER_CHANNEL_FLAG_LOOP)) {
+        repeat     = mixer_channel->len;
+        repeat_len = 0;
+    }
+
+    repeat += repeat_len;
+
+    if (channel_block->flags & AVSEQ_MIXER_CHANNEL_FLAG_BACKWARDS) {
+        repeat -= repeat_len;
+
+        if (!(channel_block->flags & AVSEQ_MIXER_CHANNEL_FLAG_LOOP))
+            repeat = -1;
+    }
+
+    channel_block->end_offset     = repeat;
+    channel_block->restart_offset = repeat_len;
+    channel_block->count_restart  = mixer_channel->repeat_count;
+    channel_block->counted        = mixer_channel->repeat_counted;
+
+    set_sample_filter(float_mixer_data, channel_info, channel_block, mixer_channel->filter_cutoff, mixer_channel->filter_damping);
+    set_sample_mix_rate(float_mixer_data, channel_block, mixer_channel->rate);
+
+    activate_channel(float_mixer_data, channel_info);
+}
+
+static av_cold void reset_channel(AVMixerData *const mixer_data,
+                                  const uint32_t channel)
+{
+    const AV_FloatMixerData *const float_mixer_data = (const AV_FloatMixerData *const) mixer_data;
+    AV_FloatMixerChannelInfo *const channel_info = float_mixer_data->channel_info + channel;
+    struct ChannelBlock *channel_block        = &channel_info->current;
+
+    channel_block->offset             = 0;
+    channel_block->fraction           = 0;
+    channel_block->offset_one_shoot   = 0;
+    channel_block->bits_per_sample    = 0;
+    channel_block->flags              = 0;
+    channel_block->volume             = 0;
+    channel_block->panning            = 0;
+    channel_block->data               = NULL;
+    channel_block->len                = 0;
+    channel_block->repeat             = 0;
+    channel_block->repeat_len         = 0;
+    channel_block->end_offset         = 0;
+    channel_block->restart_offset     = 0;
+    channel_block->count_restart      = 0;
+    channel_block->counted            = 0;
+    channel_block->filter_cutoff      = 4095;
+    channel_block->filter_damping     = 0;
+    channel_block->filter_c1          = 1.0f;
+    channel_block->filter_c2          = 0.0f;
+    channel_block->filter_c3          = 0.0f;
+    channel_block->volume_left        = 0.0f;
+    channel_block->volume_right       = 0.0f;
+
+    channel_block                     = &channel_info->next;
+    channel_block->offset             = 0;
+    channel_block->fraction           = 0;
+    channel_block->offset_one_shoot   = 0;
+    channel_block->bits_per_sample    = 0;
+    channel_block->flags              = 0;
+    channel_block->volume             = 0;
+    channel_block->panning            = 0;
+    channel_block->data               = NULL;
+    channel_block->len                = 0;
+    channel_block->repeat             = 0;
+    channel_block->repeat_len         = 0;
+    channel_block->end_offset         = 0;
+    channel_block->restart_offset     = 0;
+    channel_block->count_restart      = 0;
+    channel_block->counted            = 0;
+    channel_block->filter_cutoff      = 4095;
+    channel_block->filter_damping     = 0;
+    channel_block->filter_c1          = 1.0f;
+    channel_block->filter_c2          = 0.0f;
+    channel_block->filter_c3          = 0.0f;
+    channel_block->volume_left        = 0.0f;
+    channel_block->volume_right       = 0.0f;
+    channel_info->filter_tmp1         = 0.0f;
+    channel_info->filter_tmp2         = 0.0f;
+}
+
+static av_cold void get_both_channels(const AVMixerData *const mixer_data,
+                                      AVMixerChannel *const mixer_channel_current,
+                                      AVMixerChannel *const mixer_channel_next,
+                                      const uint32_t channel)
+{
+    const AV_FloatMixerData *const float_mixer_data     = (const AV_FloatMixerData *const) mixer_data;
+    const AV_FloatMixerChannelInfo *const channel_info = float_mixer_data->channel_info + channel;
+
+    mixer_channel_current->pos             = channel_info->current.offset;
+    mixer_channel_current->pos_one_shoot   = channel_info->current.offset_one_shoot;
+    mixer_channel_current->bits_per_sample = channel_info->current.bits_per_sample;
+    mixer_channel_current->flags           = channel_info->current.flags;
+    mixer_channel_current->volume          = channel_info->current.volume;
+    mixer_channel_current->panning         = channel_info->current.panning;
+    mixer_channel_current->data            = channel_info->current.data;
+    mixer_channel_current->len             = channel_info->current.len;
+    mixer_channel_current->repeat_start    = channel_info->current.repeat;
+    mixer_channel_current->repeat_length   = channel_info->current.repeat_len;
+    mixer_channel_current->repeat_count    = channel_info->current.count_restart;
+    mixer_channel_current->repeat_counted  = channel_info->current.counted;
+    mixer_channel_current->rate            = channel_info->current.rate;
+    mixer_channel_current->filter_cutoff   = channel_info->current.filter_cutoff;
+    mixer_channel_current->filter_damping  = channel_info->current.filter_damping;
+
+    mixer_channel_next->pos             = channel_info->next.offset;
+    mixer_channel_next->pos_one_shoot   = channel_info->next.offset_one_shoot;
+    mixer_channel_next->bits_per_sample = channel_info->next.bits_per_sample;
+    mixer_channel_next->flags           = channel_info->next.flags;
+    mixer_channel_next->volume          = channel_info->next.volume;
+    mixer_channel_next->panning         = channel_info->next.panning;
+    mixer_channel_next->data            = channel_info->next.data;
+    mixer_channel_next->len             = channel_info->next.len;
+    mixer_channel_next->repeat_start    = channel_info->next.repeat;
+    mixer_channel_next->repeat_length   = channel_info->next.repeat_len;
+    mixer_channel_next->repeat_count    = channel_info->next.count_restart;
+    mixer_channel_next->repeat_counted  = channel_info->next.counted;
+    mixer_channel_next->rate            = channel_info->next.rate;
+    mixer_channel_next->filter_cutoff   = channel_info->next.filter_cutoff;
+    mixer_channel_next->filter_damping  = channel_info->next.filter_damping;
+}
+
+static av_cold void set_both_channels(AVMixerData *const mixer_data,
+                                      const AVMixerChannel *const mixer_channel_current,
+                                      const AVMixerChannel *const mixer_channel_next,
+                                      const uint32_t channel)
+{
+    AV_FloatMixerData *const float_mixer_data       = (AV_FloatMixerData *const) mixer_data;
+    AV_FloatMixerChannelInfo *const channel_info   = float_mixer_data->channel_info + channel;
+    struct ChannelBlock *channel_block            = &channel_info->current;
+    uint32_t repeat, repeat_len;
+
+    channel_block->offset           = mixer_channel_current->pos;
+    channel_block->fraction         = 0;
+    channel_block->offset_one_shoot = mixer_channel_current->pos_one_shoot;
+    channel_block->bits_per_sample  = mixer_channel_current->bits_per_sample;
+    channel_block->flags            = mixer_channel_current->flags;
+    channel_block->volume           = mixer_channel_current->volume;
+    channel_block->panning          = mixer_channel_current->panning;
+    channel_block->data             = mixer_channel_current->data;
+    channel_block->len              = mixer_channel_current->len;
+    repeat                          = mixer_channel_current->repeat_start;
+    repeat_len                      = mixer_channel_current->repeat_length;
+    channel_block->repeat           = repeat;
+    channel_block->repeat_len       = repeat_len;
+
+    if (!(channel_block->flags & AVSEQ_MIXER_CHANNEL_FLAG_LOOP)) {
+        repeat     = mixer_channel_current->len;
+        repeat_len = 0;
+    }
+
+    repeat += repeat_len;
+
+    if (channel_block->flags & AVSEQ_MIXER_CHANNEL_FLAG_BACKWARDS) {
+        repeat -= repeat_len;
+
+        if (!(channel_block->flags & AVSEQ_MIXER_CHANNEL_FLAG_LOOP))
+            repeat = -1;
+    }
+
+    channel_block->end_offset     = repeat;
+    channel_block->restart_offset = repeat_len;
+    channel_block->count_restart  = mixer_channel_current->repeat_count;
+    channel_block->counted        = mixer_channel_current->repeat_counted;
+
+    set_sample_filter(float_mixer_data, channel_info, channel_block, mixer_channel_current->filter_cutoff, mixer_channel_current->filter_damping);
+    set_sample_mix_rate(float_mixer_data, channel_block, mixer_channel_current->rate);
+
+    channel_block                   = &channel_info->next;
+    channel_block->offset           = mixer_channel_next->pos;
+    channel_block->fraction         = 0;
+    channel_block->offset_one_shoot = mixer_channel_next->pos_one_shoot;
+    channel_block->bits_per_sample  = mixer_channel_next->bits_per_sample;
+    channel_block->flags            = mixer_channel_next->flags;
+    channel_block->volume           = mixer_channel_next->volume;
+    channel_block->panning          = mixer_channel_next->panning;
+    channel_block->data             = mixer_channel_next->data;
+    channel_block->len              = mixer_channel_next->len;
+    repeat                          = mixer_channel_next->repeat_start;
+    repeat_len                      = mixer_channel_next->repeat_length;
+    channel_block->repeat           = repeat;
+    channel_block->repeat_len       = repeat_len;
+
+    if (!(channel_block->flags & AVSEQ_MIXER_CHANNEL_FLAG_LOOP)) {
+        repeat     = mixer_channel_next->len;
+        repeat_len = 0;
+    }
+
+    repeat += repeat_len;
+
+    if (channel_block->flags & AVSEQ_MIXER_CHANNEL_FLAG_BACKWARDS) {
+        repeat -= repeat_len;
+
+        if (!(channel_block->flags & AVSEQ_MIXER_CHANNEL_FLAG_LOOP))
+            repeat = -1;
+    }
+
+    channel_block->end_offset     = repeat;
+    channel_block->restart_offset = repeat_len;
+    channel_block->count_restart  = mixer_channel_next->repeat_count;
+    channel_block->counted        = mixer_channel_next->repeat_counted;
+
+    set_sample_filter(float_mixer_data, channel_info, channel_block, mixer_channel_next->filter_cutoff, mixer_channel_next->filter_damping);
+    set_sample_mix_rate(float_mixer_data, channel_block, mixer_channel_next->rate);
+
+    activate_channel(float_mixer_data, channel_info);
+}
+
+static av_cold void set_channel_volume_panning_pitch(AVMixerData *const mixer_data,
+                                                     const AVMixerChannel *const mixer_channel,
+                                                     const uint32_t channel)
+{
+    const AV_FloatMixerData *const float_mixer_data = (const AV_FloatMixerData *const) mixer_data;
+    AV_FloatMixerChannelInfo *const channel_info   = float_mixer_data->channel_info + channel;
+
+    if ((channel_info->current.volume == mixer_channel->volume) && (channel_info->current.panning == mixer_channel->panning)) {
+        const uint32_t rate = mixer_channel->rate, mix_rate = float_mixer_data->mix_rate;
+        uint32_t rate_frac;
+
+        channel_info->current.rate         = rate;
+        channel_info->next.rate            = rate;
+        rate_frac                          = rate / mix_rate;
+        channel_info->current.advance      = rate_frac;
+        channel_info->next.advance         = rate_frac;
+        rate_frac                          = (((uint64_t) rate % mix_rate) << 32) / mix_rate;
+        channel_info->current.advance_frac = rate_frac;
+        channel_info->next.advance_frac    = rate_frac;
+    } else {
+        const uint32_t rate  = mixer_channel->rate, mix_rate = float_mixer_data->mix_rate;
+        const uint8_t volume = mixer_channel->volume;
+        const int8_t panning = mixer_channel->panning;
+        uint32_t rate_frac;
+
+        channel_info->current.volume       = volume;
+        channel_info->next.volume          = volume;
+        channel_info->current.panning      = panning;
+        channel_info->next.panning         = panning;
+        channel_info->current.rate         = rate;
+        channel_info->next.rate            = rate;
+        rate_frac                          = rate / mix_rate;
+        channel_info->current.advance      = rate_frac;
+        channel_info->next.advance         = rate_frac;
+        rate_frac                          = (((uint64_t) rate % mix_rate) << 32) / mix_rate;
+        channel_info->current.advance_frac = rate_frac;
+        channel_info->next.advance_frac    = rate_frac;
+
+        set_sample_volume(float_mixer_data, &channel_info->current);
+        set_sample_volume(float_mixer_data, &channel_info->next);
+    }
+}
+
+static av_cold void set_channel_position_repeat_flags(AVMixerData *const mixer_data,
+                                                      const AVMixerChannel *const mixer_channel,
+                                                      const uint32_t channel)
+{
+    AV_FloatMixerData *const float_mixer_data       = (AV_FloatMixerData *const) mixer_data;
+    AV_FloatMixerChannelInfo *const channel_info   = float_mixer_data->channel_info + channel;
+
+    if (channel_info->current.flags == mixer_channel->flags) {
+        uint32_t repeat = mixer_channel->pos, repeat_len;
+
+        if (repeat != channel_info->current.offset) {
+            channel_info->current.offset   = repeat;
+            channel_info->current.fraction = 0;
+        }
+
+        channel_info->current.offset_one_shoot = mixer_channel->pos_one_shoot;
+        repeat                                 = mixer_channel->repeat_start;
+        repeat_len                             = mixer_channel->repeat_length;
+        channel_info->current.repeat           = repeat;
+        channel_info->current.repeat_len       = repeat_len;
+
+        if (!(channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_LOOP)) {
+            repeat     = mixer_channel->len;
+            repeat_len = 0;
+        }
+
+        repeat += repeat_len;
+
+        if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_BACKWARDS) {
+            repeat -= repeat_len;
+
+            if (!(channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_LOOP))
+                repeat = -1;
+        }
+
+        channel_info->current.end_offset     = repeat;
+        channel_info->current.restart_offset = repeat_len;
+        channel_info->current.count_restart  = mixer_channel->repeat_count;
+        channel_info->current.counted        = mixer_channel->repeat_counted;
+    } else {
+        uint32_t repeat, repeat_len;
+
+        channel_info->current.flags = mixer_channel->flags;
+        repeat                      = mixer_channel->pos;
+
+        if (repeat != channel_info->current.offset) {
+            channel_info->current.offset   = repeat;
+            channel_info->current.fraction = 0;
+        }
+
+        channel_info->current.offset_one_shoot = mixer_channel->pos_one_shoot;
+        repeat                                 = mixer_channel->repeat_start;
+        repeat_len                             = mixer_channel->repeat_length;
+        channel_info->current.repeat           = repeat;
+        channel_info->current.repeat_len       = repeat_len;
+
+        if (!(channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_LOOP)) {
+            repeat     = mixer_channel->len;
+            repeat_len = 0;
+        }
+
+        repeat += repeat_len;
+
+        if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_BACKWARDS) {
+            repeat -= repeat_len;
+
+            if (!(channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_LOOP))
+                repeat = -1;
+        }
+
+        channel_info->current.end_offset     = repeat;
+        channel_info->current.restart_offset = repeat_len;
+        channel_info->current.count_restart  = mixer_channel->repeat_count;
+        channel_info->current.counted        = mixer_channel->repeat_counted;
+
+        set_sample_volume(float_mixer_data, &channel_info->current);
+    }
+
+    activate_channel(float_mixer_data, channel_info);
+}
+
+static av_cold void set_channel_filter(AVMixerData *const mixer_data,
+                                       const AVMixerChannel *const mixer_channel,
+                                       const uint32_t channel)
+{
+    const AV_FloatMixerData *const float_mixer_data = (const AV_FloatMixerData *const) mixer_data;
+    AV_FloatMixerChannelInfo *const channel_info   = float_mixer_data->channel_info + channel;
+
+    set_sample_filter(float_mixer_data, channel_info, &channel_info->current, mixer_channel->filter_cutoff, mixer_channel->filter_damping);
+}
+
+static av_cold void mix(AVMixerData *const mixer_data, int32_t *buf)
+{
+    AV_FloatMixerData *const float_mixer_data = (AV_FloatMixerData *const) mixer_data;
+
+    if (!(float_mixer_data->mixer_data.flags & AVSEQ_MIXER_DATA_FLAG_FROZEN)) {
+        uint32_t current_left      = float_mixer_data->current_left;
+        uint32_t current_left_frac = float_mixer_data->current_left_frac;
+        uint32_t buf_size          = float_mixer_data->mixer_data.mix_buf_size;
+        float *mix_buf             = (float *) buf;
+
+        memset(mix_buf, 0, buf_size << ((float_mixer_data->channels_out >= 2) ? 3 : 2));
+
+        while (buf_size) {
+            if (current_left) {
+                const uint32_t mix_len = (buf_size > current_left) ? current_left : buf_size;
+
+                current_left -= mix_len;
+                buf_size     -= mix_len;
+
+                mix_sample(float_mixer_data, mix_buf, mix_len);
+
+                mix_buf += (float_mixer_data->channels_out >= 2) ? mix_len << 1 : mix_len;
+            }
+
+            if (current_left)
+                continue;
+
+            if (mixer_data->handler)
+                mixer_data->handler(mixer_data);
+
+            current_left_frac += float_mixer_data->pass_len_frac;
+            current_left       = float_mixer_data->pass_len + (current_left_frac < float_mixer_data->pass_len_frac);
+        }
+
+        float_mixer_data->current_left      = current_left;
+        float_mixer_data->current_left_frac = current_left_frac;
+    }
+}
+
+static av_cold void mix_parallel(AVMixerData *const mixer_data,
+                                 int32_t *buf,
+                                 const uint32_t first_channel,
+                                 const uint32_t last_channel)
+{
+    AV_FloatMixerData *const float_mixer_data = (AV_FloatMixerData *const) mixer_data;
+
+    if (!(float_mixer_data->mixer_data.flags & AVSEQ_MIXER_DATA_FLAG_FROZEN)) {
+        uint32_t current_left      = float_mixer_data->current_left;
+        uint32_t current_left_frac = float_mixer_data->current_left_frac;
+        uint32_t buf_size          = float_mixer_data->mixer_data.mix_buf_size;
+        float *mix_buf             = (float *) buf;
+
+        memset(mix_buf, 0, buf_size << ((float_mixer_data->channels_out >= 2) ? 3 : 2));
+
+        while (buf_size) {
+            if (current_left) {
+                const uint32_t mix_len = (buf_size > current_left) ? current_left : buf_size;
+
+                current_left -= mix_len;
+                buf_size     -= mix_len;
+
+                mix_sample_parallel(float_mixer_data, mix_buf, mix_len, first_channel, last_channel);
+
+                mix_buf += (float_mixer_data->channels_out >= 2) ? mix_len << 1 : mix_len;
+            }
+
+            if (current_left)
+                continue;
+
+            if (mixer_data->handler)
+                mixer_data->handler(mixer_data);
+
+            current_left_frac += float_mixer_data->pass_len_frac;
+            current_left       = float_mixer_data->pass_len + (current_left_frac < float_mixer_data->pass_len_frac);
+        }
+
+        float_mixer_data->current_left      = current_left;
+        float_mixer_data->current_left_frac = current_left_frac;
+    }
+}
+
+static av_cold uint32_t mix_tick(AVMixerData *const mixer_data,
+                                 int32_t *buf,
+                                 const uint32_t len)
+{
+    AV_FloatMixerData *const float_mixer_data = (AV_FloatMixerData *const) mixer_data;
+    uint32_t current_left                     = float_mixer_data->current_left;
+    uint32_t current_left_frac                = float_mixer_data->current_left_frac;
+    uint32_t mix_len;
+
+    if (!current_left) {
+        if (mixer_data->handler)
+            mixer_data->handler(mixer_data);
+
+        current_left_frac += float_mixer_data->pass_len_frac;
+        current_left       = float_mixer_data->pass_len + (current_left_frac < float_mixer_data->pass_len_frac);
+    }
+
+    mix_len       = (len > current_left) ? current_left : len;
+    current_left -= mix_len;
+
+    if (mix_len) {
+        memset(buf, 0, mix_len << ((float_mixer_data->channels_out >= 2) ? 3 : 2));
+        mix_sample(float_mixer_data, (float *) buf, mix_len);
+    }
+
+    if (!current_left) {
+        if (mixer_data->handler)
+            mixer_data->handler(mixer_data);
+
+        current_left_frac += float_mixer_data->pass_len_frac;
+        current_left       = float_mixer_data->pass_len + (current_left_frac < float_mixer_data->pass_len_frac);
+    }
+
+    float_mixer_data->current_left      = current_left;
+    float_mixer_data->current_left_frac = current_left_frac;
+
+    return mix_len;
+}
+
+static av_cold void get_tick_phase(const AVMixerData *const mixer_data,
+                                   uint32_t *const left,
+                                   uint32_t *const left_frac)
+{
+    const AV_FloatMixerData *const float_mixer_data = (const AV_FloatMixerData *const) mixer_data;
+
+    *left      = float_mixer_data->current_left;
+    *left_frac = float_mixer_data->current_left_frac;
+}
+
+static av_cold void set_tick_phase(AVMixerData *const mixer_data,
+                                   const uint32_t left,
+                                   const uint32_t left_frac)
+{
+    AV_FloatMixerData *const float_mixer_data = (AV_FloatMixerData *const) mixer_data;
+
+    float_mixer_data->current_left      = left;
+    float_mixer_data->current_left_frac = left_frac;
+}
+
+AVMixerContext float_mixer = {
+    .av_class                          = &avseq_float_mixer_class,
+    .name                              = "Floating point mixer",
+    .description                       = NULL_IF_CONFIG_SMALL("Mixes with cubic interpolation into SAMPLE_FMT_FLT output"),
+
+    .flags                             = AVSEQ_MIXER_CONTEXT_FLAG_SURROUND|AVSEQ_MIXER_CONTEXT_FLAG_FLOAT,
+    .frequency                         = 44100,
+    .frequency_min                     = 1000,
+    .frequency_max                     = 768000,
+    .buf_size                          = 512,
+    .buf_size_min                      = 64,
+    .buf_size_max                      = 32768,
+    .volume_boost                      = 0x10000,
+    .channels_in                       = 65535,
+    .channels_out                      = 2,
+
+    .init                              = init,
+    .uninit                            = uninit,
+    .set_rate                          = set_rate,
+    .set_tempo                         = set_tempo,
+    .set_volume                        = set_volume,
+    .get_channel                       = get_channel,
+    .set_channel                       = set_channel,
+    .reset_channel                     = reset_channel,
+    .get_both_channels                 = get_both_channels,
+    .set_both_channels                 = set_both_channels,
+    .set_channel_volume_panning_pitch  = set_channel_volume_panning_pitch,
+    .set_channel_position_repeat_flags = set_channel_position_repeat_flags,
+    .set_channel_filter                = set_channel_filter,
+    .mix                               = mix,
+    .mix_parallel                      = mix_parallel,
+    .mix_tick                          = mix_tick,
+    .get_tick_phase                    = get_tick_phase,
+    .set_tick_phase                    = set_tick_phase,
+};
+
+#endif /* CONFIG_FLOAT_MIXER */
@@ -26,16 +26,44 @@
 
 #include "libavcodec/avcodec.h"
 #include "libavutil/avstring.h"
+#include "libavutil/mathematics.h"
 #include "libavsequencer/mixer.h"
+#include "libavsequencer/mixerdsp.h"
+
+/** Interpolation mode selecting the polyphase windowed sinc
+   resampler, lower values use the cubic interpolation.  */
+#define HQ_INTERPOLATION_SINC 3
+
+/** Number of fractional position bits used to select the kernel
+   phase of the sinc resampler.  */
+#define SINC_PHASE_BITS 9
+#define SINC_PHASES     (1 << SINC_PHASE_BITS)
+
+/** Number of sinc kernel sets, each one is band limited for a
+   maximum advance ratio of a half octave more than the previous.  */
+#define SINC_RATIOS     5
+#define SINC_MAX_TAPS   64
+#define SINC_MAX_HALF   (SINC_MAX_TAPS >> 1)
+
+/** Window size of the sinc resampler, must be larger than
+   SINC_MAX_TAPS plus the maximum advance.  */
+#define SINC_WINDOW_SIZE (SINC_MAX_TAPS << 2)
+
+/** Higher advances are mixed by averaging the samples.  */
+#define SINC_MAX_ADVANCE 4
+
+/** Maximum number of stems supported for stem output.  */
+#define HQ_MAX_STEMS 256
 
 typedef struct AV_HQMixerData {
     AVMixerData mixer_data;
     int32_t *buf;
-    int32_t *filter_buf;
     uint32_t buf_size;
     uint32_t mix_buf_size;
     int32_t *volume_lut;
     struct AV_HQMixerChannelInfo *channel_info;
+    uint16_t *active_list;
+    uint32_t active_channels;
     uint32_t amplify;
     uint32_t mix_rate;
     uint32_t mix_rate_frac;
@@ -47,6 +75,13 @@ typedef struct AV_HQMixerData {
     uint16_t channels_out;
     uint8_t interpolation;
     uint8_t real_16_bit_mode;
+    int32_t *thread_buf;
+    uint32_t thread_buf_size;
+    int32_t *stem_pos;
+    uint32_t stem_buf_size;
+    MixerDSPContext dsp;
+    int16_t *sinc_lut;
+    const int16_t *sinc_kernel[SINC_RATIOS];
 } AV_HQMixerData;
 
 typedef struct AV_HQMixerChannelInfo {
@@ -101,6 +136,8 @@ typedef struct AV_HQMixerChannelInfo {
     struct ChannelBlock next;
     int32_t filter_tmp1;
     int32_t filter_tmp2;
+    int32_t filter_tmp1_r;
+    int32_t filter_tmp2_r;
     int32_t prev_sample;
     int32_t curr_sample;
     int32_t next_sample;
@@ -108,6 +145,10 @@ typedef struct AV_HQMixerChannelInfo {
     int32_t curr_sample_r;
     int32_t next_sample_r;
     int mix_right;
+    int32_t sinc_hist[SINC_MAX_HALF];
+    int32_t sinc_hist_r[SINC_MAX_HALF];
+    uint8_t active;
+    uint16_t stem;
 } AV_HQMixerChannelInfo;
 
 #if CONFIG_HIGH_QUALITY_MIXER
@@ -125,317 +166,240 @@ static const AVClass avseq_high_quality_mixer_class = {
     LIBAVUTIL_VERSION_INT,
 };
 
-static void apply_filter(AV_HQMixerChannelInfo *channel_info,
-                         struct ChannelBlock *const channel_block,
-                         int32_t **const dest_buf,
-                         const int32_t *src_buf,
-                         const uint32_t len)
+static av_always_inline void filter_block(const AV_HQMixerData *const mixer_data,
+                                          AV_HQMixerChannelInfo *const channel_info,
+                                          const struct ChannelBlock *const channel_block,
+                                          int32_t *const smp_buf,
+                                          const uint32_t len)
 {
-    int32_t *mix_buf = *dest_buf;
-    uint32_t i       = len >> 2;
-    const int64_t c1 = channel_block->filter_c1;
-    const int64_t c2 = channel_block->filter_c2;
-    const int64_t c3 = channel_block->filter_c3;
-    int32_t o1       = channel_info->filter_tmp2;
-    int32_t o2       = channel_info->filter_tmp1;
-    int32_t o3, o4;
+    if ((channel_block->filter_cutoff == 4095) && (channel_block->filter_damping == 0))
+        return;
 
-    while (i--) {
-        mix_buf[0] += o3 = ((c1 * src_buf[0]) + (c2 * o2) + (c3 * o1)) >> 24;
-        mix_buf[1] += o4 = ((c1 * src_buf[1]) + (c2 * o3) + (c3 * o2)) >> 24;
-        mix_buf[2] += o1 = ((c1 * src_buf[2]) + (c2 * o4) + (c3 * o3)) >> 24;
-        mix_buf[3] += o2 = ((c1 * src_buf[3]) + (c2 * o1) + (c3 * o4)) >> 24;
-        src_buf    += 4;
-        mix_buf    += 4;
-    }
+    if (channel_info->mix_right)
+        mixer_data->dsp.filter(smp_buf, channel_block->filter_c1, channel_block->filter_c2, channel_block->filter_c3, &channel_info->filter_tmp1_r, &channel_info->filter_tmp2_r, len);
+    else
+        mixer_data->dsp.filter(smp_buf, channel_block->filter_c1, channel_block->filter_c2, channel_block->filter_c3, &channel_info->filter_tmp1, &channel_info->filter_tmp2, len);
+}
 
-    i = len & 3;
+static void mix_sample_channel(AV_HQMixerData *const mixer_data,
+                               AV_HQMixerChannelInfo *const channel_info,
+                               int32_t *const buf,
+                               const uint32_t len)
+{
+    void (*mix_func)(const AV_HQMixerData *const mixer_data,
+                     struct AV_HQMixerChannelInfo *const channel_info,
+                     struct ChannelBlock *const channel_block,
+                     int32_t **const buf,
+                     uint32_t *const offset,
+                     uint32_t *const fraction,
+                     const uint32_t advance,
+                     const uint32_t adv_frac,
+                     const uint32_t len) = channel_info->current.mix_func;
+    int32_t *mix_buf        = buf;
+    uint32_t offset         = channel_info->current.offset;
+    uint32_t fraction       = channel_info->current.fraction;
+    const uint32_t advance  = channel_info->current.advance;
+    const uint32_t adv_frac = channel_info->current.advance_frac;
+    uint32_t remain_len     = len, remain_mix;
+    uint64_t calc_mix;
+
+    if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_BACKWARDS) {
+mix_sample_backwards:
+        for (;;) {
+            calc_mix = (((((uint64_t) advance << 32) + adv_frac) * remain_len) + fraction) >> 32;
 
-    while (i--) {
-        *mix_buf++ += o3 = ((c1 * *src_buf++) + (c2 * o2) + (c3 * o1)) >> 24;
-        o1          = o2;
-        o2          = o3;
-    }
+            if ((int32_t) (remain_mix = offset - channel_info->current.end_offset) > 0) {
+                if ((uint32_t) calc_mix < remain_mix) {
+                    mix_func(mixer_data, channel_info, &channel_info->current, &mix_buf, &offset, &fraction, advance, adv_frac, remain_len);
 
-    *dest_buf                 = mix_buf;
-    channel_info->filter_tmp1 = o2;
-    channel_info->filter_tmp2 = o1;
-}
+                    if ((int32_t) offset <= (int32_t) channel_info->current.end_offset)
+                        remain_len = 0;
+                    else
+                        break;
+                } else {
+                    calc_mix    = (((((uint64_t) remain_mix << 32) - fraction) - 1) / (((uint64_t) advance << 32) + adv_frac) + 1);
+                    remain_len -= (uint32_t) calc_mix;
 
-static void mix_sample(AV_HQMixerData *const mixer_data,
-                       int32_t *const buf, const uint32_t len)
-{
-    AV_HQMixerChannelInfo *channel_info = mixer_data->channel_info;
-    uint16_t i                          = mixer_data->channels_in;
+                    mix_func(mixer_data, channel_info, &channel_info->current, &mix_buf, &offset, &fraction, advance, adv_frac, (uint32_t) calc_mix);
 
-    do {
-        if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_PLAY) {
-            void (*mix_func)(const AV_HQMixerData *const mixer_data,
-                             struct AV_HQMixerChannelInfo *const channel_info,
-                             struct ChannelBlock *const channel_block,
-                             int32_t **const buf,
-                             uint32_t *const offset,
-                             uint32_t *const fraction,
-                             const uint32_t advance,
-                             const uint32_t adv_frac,
-                             const uint32_t len) = channel_info->current.mix_func;
-            int32_t *mix_buf        = buf;
-            uint32_t offset         = channel_info->current.offset;
-            uint32_t fraction       = channel_info->current.fraction;
-            const uint32_t advance  = channel_info->current.advance;
-            const uint32_t adv_frac = channel_info->current.advance_frac;
-            uint32_t remain_len     = len, remain_mix;
-            uint64_t calc_mix;
-
-            if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_BACKWARDS) {
-mix_sample_backwards:
-                for (;;) {
-                    calc_mix = (((((uint64_t) advance << 32) + adv_frac) * remain_len) + fraction) >> 32;
-
-                    if ((int32_t) (remain_mix = offset - channel_info->current.end_offset) > 0) {
-                        if ((uint32_t) calc_mix < remain_mix) {
-                            if ((channel_info->current.filter_cutoff == 4095) && (channel_info->current.filter_damping == 0)) {
-                                mix_func(mixer_data, channel_info, &channel_info->current, &mix_buf, &offset, &fraction, advance, adv_frac, remain_len);
-                            } else {
-                                int32_t *filter_buf = mixer_data->filter_buf;
-                                uint32_t filter_len = remain_len;
-
-                                if (mixer_data->channels_out >= 2)
-                                    filter_len <<= 1;
-
-                                memset(filter_buf, 0, filter_len * sizeof(int32_t));
-                                mix_func(mixer_data, channel_info, &channel_info->current, &filter_buf, &offset, &fraction, advance, adv_frac, remain_len);
-                                apply_filter(channel_info, &channel_info->current, &mix_buf, mixer_data->filter_buf, filter_len);
-                            }
-
-                            if ((int32_t) offset <= (int32_t) channel_info->current.end_offset)
-                                remain_len = 0;
-                            else
-                                break;
-                        } else {
-                            calc_mix    = (((((uint64_t) remain_mix << 32) - fraction) - 1) / (((uint64_t) advance << 32) + adv_frac) + 1);
-                            remain_len -= (uint32_t) calc_mix;
+                    if (((int32_t) offset > (int32_t) channel_info->current.end_offset) && !remain_len)
+                        break;
+                }
+            }
+
+            if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_LOOP) {
+                const uint32_t count_restart = channel_info->current.count_restart;
+                const uint32_t counted       = channel_info->current.counted++;
 
-                            if ((channel_info->current.filter_cutoff == 4095) && (channel_info->current.filter_damping == 0)) {
-                                mix_func(mixer_data, channel_info, &channel_info->current, &mix_buf, &offset, &fraction, advance, adv_frac, (uint32_t) calc_mix);
-                            } else {
-                                int32_t *filter_buf = mixer_data->filter_buf;
-                                uint32_t filter_len = (uint32_t) calc_mix;
+                if (count_restart && (count_restart == counted)) {
+                    channel_info->current.flags     &= ~AVSEQ_MIXER_CHANNEL_FLAG_LOOP;
+                    channel_info->current.end_offset = -1;
 
-                                if (mixer_data->channels_out >= 2)
-                                    filter_len <<= 1;
+                    goto mix_sample_synth;
+                } else {
+                    if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_PINGPONG) {
+                        void (*mixer_change_func)(const AV_HQMixerData *const mixer_data,
+                                                  struct AV_HQMixerChannelInfo *const channel_info,
+                                                  struct ChannelBlock *const channel_block,
+                                                  int32_t **const buf,
+                                                  uint32_t *const offset,
+                                                  uint32_t *const fraction,
+                                                  const uint32_t advance,
+                                                  const uint32_t adv_frac,
+                                                  const uint32_t len);
 
-                                memset(filter_buf, 0, filter_len * sizeof(int32_t));
-                                mix_func(mixer_data, channel_info, &channel_info->current, &filter_buf, &offset, &fraction, advance, adv_frac, (uint32_t) calc_mix);
-                                apply_filter(channel_info, &channel_info->current, &mix_buf, mixer_data->filter_buf, filter_len);
-                            }
+                        if (channel_info->next.data) {
+                            memcpy(&channel_info->current, &channel_info->next, sizeof(struct ChannelBlock));
 
-                            if (((int32_t) offset > (int32_t) channel_info->current.end_offset) && !remain_len)
-                                break;
+                            channel_info->next.data = NULL;
                         }
-                    }
 
-                    if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_LOOP) {
-                        const uint32_t count_restart = channel_info->current.count_restart;
-                        const uint32_t counted       = channel_info->current.counted++;
+                        mixer_change_func                        = channel_info->current.mix_backwards_func;
+                        channel_info->current.mix_backwards_func = mix_func;
+                        mix_func                                 = mixer_change_func;
+                        channel_info->current.mix_func           = mix_func;
+                        channel_info->current.flags             ^= AVSEQ_MIXER_CHANNEL_FLAG_BACKWARDS;
+                        remain_mix                               = channel_info->current.end_offset;
+                        offset                                  -= remain_mix;
+                        offset                                   = -offset + remain_mix;
+                        remain_mix                              += channel_info->current.restart_offset;
+                        channel_info->current.end_offset         = remain_mix;
 
-                        if (count_restart && (count_restart == counted)) {
-                            channel_info->current.flags     &= ~AVSEQ_MIXER_CHANNEL_FLAG_LOOP;
-                            channel_info->current.end_offset = -1;
+                        if ((int32_t) remain_len > 0)
+                            goto mix_sample_forwards;
 
-                            goto mix_sample_synth;
-                        } else {
-                            if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_PINGPONG) {
-                                void (*mixer_change_func)(const AV_HQMixerData *const mixer_data,
-                                                          struct AV_HQMixerChannelInfo *const channel_info,
-                                                          struct ChannelBlock *const channel_block,
-                                                          int32_t **const buf,
-                                                          uint32_t *const offset,
-                                                          uint32_t *const fraction,
-                                                          const uint32_t advance,
-                                                          const uint32_t adv_frac,
-                                                          const uint32_t len);
-
-                                if (channel_info->next.data) {
-                                    memcpy(&channel_info->current, &channel_info->next, sizeof(struct ChannelBlock));
-
-                                    channel_info->next.data = NULL;
-                                }
-
-                                mixer_change_func                        = channel_info->current.mix_backwards_func;
-                                channel_info->current.mix_backwards_func = mix_func;
-                                mix_func                                 = mixer_change_func;
-                                channel_info->current.mix_func           = mix_func;
-                                channel_info->current.flags             ^= AVSEQ_MIXER_CHANNEL_FLAG_BACKWARDS;
-                                remain_mix                               = channel_info->current.end_offset;
-                                offset                                  -= remain_mix;
-                                offset                                   = -offset + remain_mix;
-                                remain_mix                              += channel_info->current.restart_offset;
-                                channel_info->current.end_offset         = remain_mix;
-
-                                if ((int32_t) remain_len > 0)
-                                    goto mix_sample_forwards;
-
-                                break;
-                            } else {
-                                offset += channel_info->current.restart_offset;
-
-                                if (channel_info->next.data)
-                                    goto mix_sample_synth;
-
-                                if ((int32_t) remain_len > 0)
-                                    continue;
-
-                                break;
-                            }
-                        }
+                        break;
                     } else {
+                        offset += channel_info->current.restart_offset;
+
                         if (channel_info->next.data)
                             goto mix_sample_synth;
-                        else
-                            channel_info->current.flags &= ~AVSEQ_MIXER_CHANNEL_FLAG_PLAY;
+
+                        if ((int32_t) remain_len > 0)
+                            continue;
 
                         break;
                     }
                 }
             } else {
+                if (channel_info->next.data)
+                    goto mix_sample_synth;
+                else
+                    channel_info->current.flags &= ~AVSEQ_MIXER_CHANNEL_FLAG_PLAY;
+
+                break;
+            }
+        }
+    } else {
 mix_sample_forwards:
-                for (;;) {
-                    calc_mix = (((((uint64_t) advance << 32) + adv_frac) * remain_len) + fraction) >> 32;
-
-                    if ((int32_t) (remain_mix = channel_info->current.end_offset - offset) > 0) {
-                        if ((uint32_t) calc_mix < remain_mix) {
-                            if ((channel_info->current.filter_cutoff == 4095) && (channel_info->current.filter_damping == 0)) {
-                                mix_func(mixer_data, channel_info, &channel_info->current, &mix_buf, &offset, &fraction, advance, adv_frac, remain_len);
-                            } else {
-                                int32_t *filter_buf = mixer_data->filter_buf;
-                                uint32_t filter_len = remain_len;
-
-                                if (mixer_data->channels_out >= 2)
-                                    filter_len <<= 1;
-
-                                memset(filter_buf, 0, filter_len * sizeof(int32_t));
-                                mix_func(mixer_data, channel_info, &channel_info->current, &filter_buf, &offset, &fraction, advance, adv_frac, remain_len);
-                                apply_filter(channel_info, &channel_info->current, &mix_buf, mixer_data->filter_buf, filter_len);
-                            }
-
-                            if (offset >= channel_info->current.end_offset)
-                                remain_len = 0;
-                            else
-                                break;
-                        } else {
-                            calc_mix    = (((((uint64_t) remain_mix << 32) - fraction) - 1) / (((uint64_t) advance << 32) + adv_frac) + 1);
-                            remain_len -= (uint32_t) calc_mix;
+        for (;;) {
+            calc_mix = (((((uint64_t) advance << 32) + adv_frac) * remain_len) + fraction) >> 32;
+
+            if ((int32_t) (remain_mix = channel_info->current.end_offset - offset) > 0) {
+                if ((uint32_t) calc_mix < remain_mix) {
+                    mix_func(mixer_data, channel_info, &channel_info->current, &mix_buf, &offset, &fraction, advance, adv_frac, remain_len);
+
+                    if (offset >= channel_info->current.end_offset)
+                        remain_len = 0;
+                    else
+                        break;
+                } else {
+                    calc_mix    = (((((uint64_t) remain_mix << 32) - fraction) - 1) / (((uint64_t) advance << 32) + adv_frac) + 1);
+                    remain_len -= (uint32_t) calc_mix;
 
-                            if ((channel_info->current.filter_cutoff == 4095) && (channel_info->current.filter_damping == 0)) {
-                                mix_func(mixer_data, channel_info, &channel_info->current, &mix_buf, &offset, &fraction, advance, adv_frac, (uint32_t) calc_mix);
-                            } else {
-                                int32_t *filter_buf = mixer_data->filter_buf;
-                                uint32_t filter_len = (uint32_t) calc_mix;
+                    mix_func(mixer_data, channel_info, &channel_info->current, &mix_buf, &offset, &fraction, advance, adv_frac, (uint32_t) calc_mix);
 
-                                if (mixer_data->channels_out >= 2)
-                                    filter_len <<= 1;
+                    if ((offset < channel_info->current.end_offset) && !remain_len)
+                        break;
+                }
+            }
 
-                                memset(filter_buf, 0, filter_len * sizeof(int32_t));
-                                mix_func(mixer_data, channel_info, &channel_info->current, &filter_buf, &offset, &fraction, advance, adv_frac, (uint32_t) calc_mix);
-                                apply_filter(channel_info, &channel_info->current, &mix_buf, mixer_data->filter_buf, filter_len);
-                            }
+            if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_LOOP) {
+                const uint32_t count_restart = channel_info->current.count_restart;
+                const uint32_t counted       = channel_info->current.counted++;
 
-                            if ((offset < channel_info->current.end_offset) && !remain_len)
-                                break;
-                        }
-                    }
+                if (count_restart && (count_restart == counted)) {
+                    channel_info->current.flags     &= ~AVSEQ_MIXER_CHANNEL_FLAG_LOOP;
+                    channel_info->current.end_offset = channel_info->current.len;
 
-                    if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_LOOP) {
-                        const uint32_t count_restart = channel_info->current.count_restart;
-                        const uint32_t counted       = channel_info->current.counted++;
+                    goto mix_sample_synth;
+                } else {
+                    if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_PINGPONG) {
+                        void (*mixer_change_func)(const AV_HQMixerData *const mixer_data,
+                                                  struct AV_HQMixerChannelInfo *const channel_info,
+                                                  struct ChannelBlock *const channel_block,
+                                                  int32_t **const buf,
+                                                  uint32_t *const offset,
+                                                  uint32_t *const fraction,
+                                                  const uint32_t advance,
+                                                  const uint32_t adv_frac,
+                                                  const uint32_t len);
 
-                        if (count_restart && (count_restart == counted)) {
-                            channel_info->current.flags     &= ~AVSEQ_MIXER_CHANNEL_FLAG_LOOP;
-                            channel_info->current.end_offset = channel_info->current.len;
+                        if (channel_info->next.data) {
+                            memcpy(&channel_info->current, &channel_info->next, sizeof(struct ChannelBlock));
 
-                            goto mix_sample_synth;
-                        } else {
-                            if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_PINGPONG) {
-                                void (*mixer_change_func)(const AV_HQMixerData *const mixer_data,
-                                                          struct AV_HQMixerChannelInfo *const channel_info,
-                                                          struct ChannelBlock *const channel_block,
-                                                          int32_t **const buf,
-                                                          uint32_t *const offset,
-                                                          uint32_t *const fraction,
-                                                          const uint32_t advance,
-                                                          const uint32_t adv_frac,
-                                                          const uint32_t len);
-
-                                if (channel_info->next.data) {
-                                    memcpy(&channel_info->current, &channel_info->next, sizeof(struct ChannelBlock));
-
-                                    channel_info->next.data = NULL;
-                                }
-
-                                mixer_change_func                        = channel_info->current.mix_backwards_func;
-                                channel_info->current.mix_backwards_func = mix_func;
-                                mix_func                                 = mixer_change_func;
-                                channel_info->current.mix_func           = mix_func;
-                                channel_info->current.flags             ^= AVSEQ_MIXER_CHANNEL_FLAG_BACKWARDS;
-                                remain_mix                               = channel_info->current.end_offset;
-                                offset                                  -= remain_mix;
-                                offset                                   = -offset + remain_mix;
-                                remain_mix                              -= channel_info->current.restart_offset;
-                                channel_info->current.end_offset         = remain_mix;
-
-                                if (remain_len)
-                                    goto mix_sample_backwards;
-
-                                break;
-                            } else {
-                                offset -= channel_info->current.restart_offset;
-
-                                if (channel_info->next.data) {
-                                    memcpy(&channel_info->current, &channel_info->next, sizeof(struct ChannelBlock));
-
-                                    channel_info->next.data = NULL;
-                                }
-
-                                if ((int32_t) remain_len > 0)
-                                    continue;
-
-                                break;
-                            }
+                            channel_info->next.data = NULL;
                         }
+
+                        mixer_change_func                        = channel_info->current.mix_backwards_func;
+                        channel_info->current.mix_backwards_func = mix_func;
+                        mix_func                                 = mixer_change_func;
+                        channel_info->current.mix_func           = mix_func;
+                        channel_info->current.flags             ^= AVSEQ_MIXER_CHANNEL_FLAG_BACKWARDS;
+                        remain_mix                               = channel_info->current.end_offset;
+                        offset                                  -= remain_mix;
+                        offset                                   = -offset + remain_mix;
+                        remain_mix                              -= channel_info->current.restart_offset;
+                        channel_info->current.end_offset         = remain_mix;
+
+                        if (remain_len)
+                            goto mix_sample_backwards;
+
+                        break;
                     } else {
+                        offset -= channel_info->current.restart_offset;
+
                         if (channel_info->next.data) {
-mix_sample_synth:
                             memcpy(&channel_info->current, &channel_info->next, sizeof(struct ChannelBlock));
 
                             channel_info->next.data = NULL;
-
-                            if ((int32_t) remain_len > 0)
-                                continue;
-                        } else {
-                            channel_info->current.flags &= ~AVSEQ_MIXER_CHANNEL_FLAG_PLAY;
                         }
 
+                        if ((int32_t) remain_len > 0)
+                            continue;
+
                         break;
                     }
                 }
-            }
-
-            channel_info->current.offset_one_shoot += (offset > channel_info->current.offset) ? (offset - channel_info->current.offset) : (channel_info->current.offset - offset);
+            } else {
+                if (channel_info->next.data) {
+mix_sample_synth:
+                    memcpy(&channel_info->current, &channel_info->next, sizeof(struct ChannelBlock));
 
-            if (channel_info->current.offset_one_shoot >= channel_info->current.len) {
-                channel_info->current.offset_one_shoot = channel_info->current.len;
+                    channel_info->next.data = NULL;
 
-                if (!(channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_LOOP))
+                    if ((int32_t) remain_len > 0)
+                        continue;
+                } else {
                     channel_info->current.flags &= ~AVSEQ_MIXER_CHANNEL_FLAG_PLAY;
-            }
+                }
 
-            channel_info->current.offset   = offset;
-            channel_info->current.fraction = fraction;
+                break;
+            }
         }
+    }
 
-        channel_info++;
-    } while (--i);
+    channel_info->current.offset_one_shoot += (offset > channel_info->current.offset) ? (offset - channel_info->current.offset) : (channel_info->current.offset - offset);
+
+    if (channel_info->current.offset_one_shoot >= channel_info->current.len) {
+        channel_info->current.offset_one_shoot = channel_info->current.len;
+
+        if (!(channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_LOOP))
+            channel_info->current.flags &= ~AVSEQ_MIXER_CHANNEL_FLAG_PLAY;
+    }
+
+    channel_info->current.offset   = offset;
+    channel_info->current.fraction = fraction;
 }
 
 static void mix_sample_parallel(AV_HQMixerData *const mixer_data,
@@ -447,273 +411,219 @@ static void mix_sample_parallel(AV_HQMixerData *const mixer_data,
     uint16_t i                          = (last_channel - first_channel) + 1;
 
     do {
-        if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_PLAY) {
-            void (*mix_func)(const AV_HQMixerData *const mixer_data,
-                             struct AV_HQMixerChannelInfo *const channel_info,
-                             struct ChannelBlock *const channel_block,
-                             int32_t **const buf,
-                             uint32_t *const offset,
-                             uint32_t *const fraction,
-                             const uint32_t advance,
-                             const uint32_t adv_frac,
-                             const uint32_t len) = channel_info->current.mix_func;
-            int32_t *mix_buf        = buf;
-            uint32_t offset         = channel_info->current.offset;
-            uint32_t fraction       = channel_info->current.fraction;
-            const uint32_t advance  = channel_info->current.advance;
-            const uint32_t adv_frac = channel_info->current.advance_frac;
-            uint32_t remain_len     = len, remain_mix;
-            uint64_t calc_mix;
-
-            if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_BACKWARDS) {
-mix_sample_backwards:
-                for (;;) {
-                    calc_mix = (((((uint64_t) advance << 32) + adv_frac) * remain_len) + fraction) >> 32;
-
-                    if ((int32_t) (remain_mix = offset - channel_info->current.end_offset) > 0) {
-                        if ((uint32_t) calc_mix < remain_mix) {
-                            if ((channel_info->current.filter_cutoff == 4095) && (channel_info->current.filter_damping == 0)) {
-                                mix_func(mixer_data, channel_info, &channel_info->current, &mix_buf, &offset, &fraction, advance, adv_frac, remain_len);
-                            } else {
-                                int32_t *filter_buf = mixer_data->filter_buf;
-                                uint32_t filter_len = remain_len;
-
-                                if (mixer_data->channels_out >= 2)
-                                    filter_len <<= 1;
-
-                                memset(filter_buf, 0, filter_len * sizeof(int32_t));
-                                mix_func(mixer_data, channel_info, &channel_info->current, &filter_buf, &offset, &fraction, advance, adv_frac, remain_len);
-                                apply_filter(channel_info, &channel_info->current, &mix_buf, mixer_data->filter_buf, filter_len);
-                            }
-
-                            if ((int32_t) offset <= (int32_t) channel_info->current.end_offset)
-                                remain_len = 0;
-                            else
-                                break;
-                        } else {
-                            calc_mix    = (((((uint64_t) remain_mix << 32) - fraction) - 1) / (((uint64_t) advance << 32) + adv_frac) + 1);
-                            remain_len -= (uint32_t) calc_mix;
+        if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_PLAY)
+            mix_sample_channel(mixer_data, channel_info, buf, len);
 
-                            if ((channel_info->current.filter_cutoff == 4095) && (channel_info->current.filter_damping == 0)) {
-                                mix_func(mixer_data, channel_info, &channel_info->current, &mix_buf, &offset, &fraction, advance, adv_frac, (uint32_t) calc_mix);
-                            } else {
-                                int32_t *filter_buf = mixer_data->filter_buf;
-                                uint32_t filter_len = (uint32_t) calc_mix;
+        channel_info++;
+    } while (--i);
+}
 
-                                if (mixer_data->channels_out >= 2)
-                                    filter_len <<= 1;
+/** Mixes the channels of the active channel list entries from first
+   up to (but not including) last, so channels which are not playing
+   are never touched.  */
+static void mix_sample_active(AV_HQMixerData *const mixer_data,
+                              int32_t *const buf,
+                              const uint32_t len,
+                              const uint32_t first,
+                              const uint32_t last)
+{
+    AV_HQMixerChannelInfo *const channel_info = mixer_data->channel_info;
+    const uint16_t *const active_list         = mixer_data->active_list;
+    uint32_t i;
 
-                                memset(filter_buf, 0, filter_len * sizeof(int32_t));
-                                mix_func(mixer_data, channel_info, &channel_info->current, &filter_buf, &offset, &fraction, advance, adv_frac, (uint32_t) calc_mix);
-                                apply_filter(channel_info, &channel_info->current, &mix_buf, mixer_data->filter_buf, filter_len);
-                            }
+    for (i = first; i < last; i++) {
+        if (channel_info[active_list[i]].current.flags & AVSEQ_MIXER_CHANNEL_FLAG_PLAY)
+            mix_sample_channel(mixer_data, channel_info + active_list[i], buf, len);
+    }
+}
 
-                            if (((int32_t) offset > (int32_t) channel_info->current.end_offset) && !remain_len)
-                                break;
-                        }
-                    }
+/** Removes channels which have stopped playing from the active
+   channel list, preserving the order of the remaining ones.  */
+static void update_active_list(AV_HQMixerData *const mixer_data)
+{
+    AV_HQMixerChannelInfo *const channel_info = mixer_data->channel_info;
+    uint16_t *const active_list               = mixer_data->active_list;
+    uint32_t i, j = 0;
 
-                    if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_LOOP) {
-                        const uint32_t count_restart = channel_info->current.count_restart;
-                        const uint32_t counted       = channel_info->current.counted++;
+    for (i = 0; i < mixer_data->active_channels; i++) {
+        const uint16_t channel = active_list[i];
 
-                        if (count_restart && (count_restart == counted)) {
-                            channel_info->current.flags     &= ~AVSEQ_MIXER_CHANNEL_FLAG_LOOP;
-                            channel_info->current.end_offset = -1;
+        if (channel_info[channel].current.flags & AVSEQ_MIXER_CHANNEL_FLAG_PLAY)
+            active_list[j++] = channel;
+        else
+            channel_info[channel].active = 0;
+    }
 
-                            goto mix_sample_synth;
-                        } else {
-                            if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_PINGPONG) {
-                                void (*mixer_change_func)(const AV_HQMixerData *const mixer_data,
-                                                          struct AV_HQMixerChannelInfo *const channel_info,
-                                                          struct ChannelBlock *const channel_block,
-                                                          int32_t **const buf,
-                                                          uint32_t *const offset,
-                                                          uint32_t *const fraction,
-                                                          const uint32_t advance,
-                                                          const uint32_t adv_frac,
-                                                          const uint32_t len);
-
-                                if (channel_info->next.data) {
-                                    memcpy(&channel_info->current, &channel_info->next, sizeof(struct ChannelBlock));
-
-                                    channel_info->next.data = NULL;
-                                }
-
-                                mixer_change_func                        = channel_info->current.mix_backwards_func;
-                                channel_info->current.mix_backwards_func = mix_func;
-                                mix_func                                 = mixer_change_func;
-                                channel_info->current.mix_func           = mix_func;
-                                channel_info->current.flags             ^= AVSEQ_MIXER_CHANNEL_FLAG_BACKWARDS;
-                                remain_mix                               = channel_info->current.end_offset;
-                                offset                                  -= remain_mix;
-                                offset                                   = -offset + remain_mix;
-                                remain_mix                              += channel_info->current.restart_offset;
-                                channel_info->current.end_offset         = remain_mix;
-
-                                if ((int32_t) remain_len > 0)
-                                    goto mix_sample_forwards;
-
-                                break;
-                            } else {
-                                offset += channel_info->current.restart_offset;
-
-                                if (channel_info->next.data)
-                                    goto mix_sample_synth;
-
-                                if ((int32_t) remain_len > 0)
-                                    continue;
-
-                                break;
-                            }
-                        }
-                    } else {
-                        if (channel_info->next.data)
-                            goto mix_sample_synth;
-                        else
-                            channel_info->current.flags &= ~AVSEQ_MIXER_CHANNEL_FLAG_PLAY;
+    mixer_data->active_channels = j;
+}
 
-                        break;
-                    }
-                }
-            } else {
-mix_sample_forwards:
-                for (;;) {
-                    calc_mix = (((((uint64_t) advance << 32) + adv_frac) * remain_len) + fraction) >> 32;
-
-                    if ((int32_t) (remain_mix = channel_info->current.end_offset - offset) > 0) {
-                        if ((uint32_t) calc_mix < remain_mix) {
-                            if ((channel_info->current.filter_cutoff == 4095) && (channel_info->current.filter_damping == 0)) {
-                                mix_func(mixer_data, channel_info, &channel_info->current, &mix_buf, &offset, &fraction, advance, adv_frac, remain_len);
-                            } else {
-                                int32_t *filter_buf = mixer_data->filter_buf;
-                                uint32_t filter_len = remain_len;
-
-                                if (mixer_data->channels_out >= 2)
-                                    filter_len <<= 1;
-
-                                memset(filter_buf, 0, filter_len * sizeof(int32_t));
-                                mix_func(mixer_data, channel_info, &channel_info->current, &filter_buf, &offset, &fraction, advance, adv_frac, remain_len);
-                                apply_filter(channel_info, &channel_info->current, &mix_buf, mixer_data->filter_buf, filter_len);
-                            }
-
-                            if (offset >= channel_info->current.end_offset)
-                                remain_len = 0;
-                            else
-                                break;
-                        } else {
-                            calc_mix    = (((((uint64_t) remain_mix << 32) - fraction) - 1) / (((uint64_t) advance << 32) + adv_frac) + 1);
-                            remain_len -= (uint32_t) calc_mix;
+/** Appends a channel to the active channel list when it has been
+   started, it is removed again by update_active_list after it has
+   stopped playing.  */
+static void activate_channel(AV_HQMixerData *const mixer_data,
+                             AV_HQMixerChannelInfo *const channel_info)
+{
+    if ((channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_PLAY) && !channel_info->active) {
+        channel_info->active                                   = 1;
+        mixer_data->active_list[mixer_data->active_channels++] = channel_info - mixer_data->channel_info;
+    }
+}
 
-                            if ((channel_info->current.filter_cutoff == 4095) && (channel_info->current.filter_damping == 0)) {
-                                mix_func(mixer_data, channel_info, &channel_info->current, &mix_buf, &offset, &fraction, advance, adv_frac, (uint32_t) calc_mix);
-                            } else {
-                                int32_t *filter_buf = mixer_data->filter_buf;
-                                uint32_t filter_len = (uint32_t) calc_mix;
+/** Rebuilds the active channel list from scratch, this is required
+   whenever the channel data has been reallocated.  */
+static void init_active_list(AV_HQMixerData *const mixer_data)
+{
+    AV_HQMixerChannelInfo *channel_info = mixer_data->channel_info;
+    uint16_t i;
 
-                                if (mixer_data->channels_out >= 2)
-                                    filter_len <<= 1;
+    mixer_data->active_channels = 0;
 
-                                memset(filter_buf, 0, filter_len * sizeof(int32_t));
-                                mix_func(mixer_data, channel_info, &channel_info->current, &filter_buf, &offset, &fraction, advance, adv_frac, (uint32_t) calc_mix);
-                                apply_filter(channel_info, &channel_info->current, &mix_buf, mixer_data->filter_buf, filter_len);
-                            }
+    for (i = mixer_data->channels_in; i > 0; i--) {
+        channel_info->active = 0;
 
-                            if ((offset < channel_info->current.end_offset) && !remain_len)
-                                break;
-                        }
-                    }
+        activate_channel(mixer_data, channel_info++);
+    }
+}
 
-                    if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_LOOP) {
-                        const uint32_t count_restart = channel_info->current.count_restart;
-                        const uint32_t counted       = channel_info->current.counted++;
+/** Prepares the stem buffer for mixing len frames into each stem.
+   Returns 0 if stem output is disabled or the buffer cannot be
+   allocated, in which case only the normal output is mixed.  */
+static int init_stem_buf(AV_HQMixerData *const mixer_data,
+                         const uint32_t len)
+{
+    const uint32_t stems  = mixer_data->mixer_data.stems;
+    const uint32_t stride = (mixer_data->channels_out >= 2) ? len << 1 : len;
+    const uint32_t size   = stems * stride;
 
-                        if (count_restart && (count_restart == counted)) {
-                            channel_info->current.flags     &= ~AVSEQ_MIXER_CHANNEL_FLAG_LOOP;
-                            channel_info->current.end_offset = channel_info->current.len;
+    mixer_data->mixer_data.stem_stride = 0;
 
-                            goto mix_sample_synth;
-                        } else {
-                            if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_PINGPONG) {
-                                void (*mixer_change_func)(const AV_HQMixerData *const mixer_data,
-                                                          struct AV_HQMixerChannelInfo *const channel_info,
-                                                          struct ChannelBlock *const channel_block,
-                                                          int32_t **const buf,
-                                                          uint32_t *const offset,
-                                                          uint32_t *const fraction,
-                                                          const uint32_t advance,
-                                                          const uint32_t adv_frac,
-                                                          const uint32_t len);
-
-                                if (channel_info->next.data) {
-                                    memcpy(&channel_info->current, &channel_info->next, sizeof(struct ChannelBlock));
-
-                                    channel_info->next.data = NULL;
-                                }
-
-                                mixer_change_func                        = channel_info->current.mix_backwards_func;
-                                channel_info->current.mix_backwards_func = mix_func;
-                                mix_func                                 = mixer_change_func;
-                                channel_info->current.mix_func           = mix_func;
-                                channel_info->current.flags             ^= AVSEQ_MIXER_CHANNEL_FLAG_BACKWARDS;
-                                remain_mix                               = channel_info->current.end_offset;
-                                offset                                  -= remain_mix;
-                                offset                                   = -offset + remain_mix;
-                                remain_mix                              -= channel_info->current.restart_offset;
-                                channel_info->current.end_offset         = remain_mix;
-
-                                if (remain_len)
-                                    goto mix_sample_backwards;
-
-                                break;
-                            } else {
-                                offset -= channel_info->current.restart_offset;
-
-                                if (channel_info->next.data) {
-                                    memcpy(&channel_info->current, &channel_info->next, sizeof(struct ChannelBlock));
-
-                                    channel_info->next.data = NULL;
-                                }
-
-                                if ((int32_t) remain_len > 0)
-                                    continue;
-
-                                break;
-                            }
-                        }
-                    } else {
-                        if (channel_info->next.data) {
-mix_sample_synth:
-                            memcpy(&channel_info->current, &channel_info->next, sizeof(struct ChannelBlock));
+    if (!(stems && len))
+        return 0;
 
-                            channel_info->next.data = NULL;
+    if (mixer_data->stem_buf_size < size) {
+        int32_t *stem_buf;
 
-                            if ((int32_t) remain_len > 0)
-                                continue;
-                        } else {
-                            channel_info->current.flags &= ~AVSEQ_MIXER_CHANNEL_FLAG_PLAY;
-                        }
+        if (!(stem_buf = av_realloc(mixer_data->mixer_data.stem_buf, (size * sizeof(int32_t)) + FF_INPUT_BUFFER_PADDING_SIZE))) {
+            av_log(mixer_data->mixer_data.mixctx, AV_LOG_ERROR, "Cannot allocate mixer stem buffers, mixing without stems.\n");
 
-                        break;
-                    }
-                }
-            }
+            return 0;
+        }
 
-            channel_info->current.offset_one_shoot += (offset > channel_info->current.offset) ? (offset - channel_info->current.offset) : (channel_info->current.offset - offset);
+        mixer_data->mixer_data.stem_buf = stem_buf;
+        mixer_data->stem_buf_size       = size;
+    }
 
-            if (channel_info->current.offset_one_shoot >= channel_info->current.len) {
-                channel_info->current.offset_one_shoot = channel_info->current.len;
+    memset(mixer_data->mixer_data.stem_buf, 0, size * sizeof(int32_t));
 
-                if (!(channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_LOOP))
-                    channel_info->current.flags &= ~AVSEQ_MIXER_CHANNEL_FLAG_PLAY;
-            }
+    mixer_data->mixer_data.stem_stride = stride;
+    mixer_data->stem_pos               = mixer_data->mixer_data.stem_buf;
+
+    return 1;
+}
+
+/** Mixes each active channel into the block of its stem and adds
+   all stems to the normal output afterwards.  */
+static void mix_sample_stems(AV_HQMixerData *const mixer_data,
+                             int32_t *const buf, const uint32_t len)
+{
+    AV_HQMixerChannelInfo *const channel_info = mixer_data->channel_info;
+    const uint16_t *const active_list         = mixer_data->active_list;
+    const uint32_t last_stem                  = mixer_data->mixer_data.stems - 1;
+    const uint32_t stride                     = mixer_data->mixer_data.stem_stride;
+    const uint32_t mix_len                    = (mixer_data->channels_out >= 2) ? len << 1 : len;
+    int32_t *stem_buf                         = mixer_data->stem_pos;
+    uint32_t i;
+
+    for (i = 0; i < mixer_data->active_channels; i++) {
+        AV_HQMixerChannelInfo *const stem_channel_info = channel_info + active_list[i];
+        const uint32_t stem                            = FFMIN(stem_channel_info->stem, last_stem);
+
+        if (stem_channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_PLAY)
+            mix_sample_channel(mixer_data, stem_channel_info, stem_buf + stem * stride, len);
+    }
+
+    for (i = 0; i <= last_stem; i++) {
+        mixer_data->dsp.add_mono(buf, stem_buf, mix_len);
+        stem_buf += stride;
+    }
+
+    mixer_data->stem_pos += mix_len;
+}
 
-            channel_info->current.offset   = offset;
-            channel_info->current.fraction = fraction;
+static void mix_sample(AV_HQMixerData *const mixer_data,
+                       int32_t *const buf, const uint32_t len)
+{
+    if (mixer_data->mixer_data.stem_stride)
+        mix_sample_stems(mixer_data, buf, len);
+    else
+        mix_sample_active(mixer_data, buf, len, 0, mixer_data->active_channels);
+
+    update_active_list(mixer_data);
+}
+
+typedef struct MixThreadArg {
+    int32_t *buf;
+    uint32_t len;
+    uint32_t stride;
+} MixThreadArg;
+
+static int mix_sample_thread(AVMixerData *const mixer_data,
+                             void *arg, int jobnr)
+{
+    AV_HQMixerData *const hq_mixer_data  = (AV_HQMixerData *const) mixer_data;
+    const MixThreadArg *const thread_arg = arg;
+    const uint32_t active_channels       = hq_mixer_data->active_channels;
+    const uint32_t first_channel         = (active_channels * jobnr) / mixer_data->thread_count;
+    const uint32_t last_channel          = (active_channels * (jobnr + 1)) / mixer_data->thread_count;
+    int32_t *buf                         = thread_arg->buf;
+
+    if (jobnr) {
+        buf = hq_mixer_data->thread_buf + ((jobnr - 1) * thread_arg->stride);
+
+        memset(buf, 0, thread_arg->stride * sizeof(int32_t));
+    }
+
+    if (first_channel < last_channel)
+        mix_sample_active(hq_mixer_data, buf, thread_arg->len, first_channel, last_channel);
+
+    return 0;
+}
+
+static void mix_sample_threaded(AV_HQMixerData *const mixer_data,
+                                int32_t *const buf, const uint32_t len)
+{
+    const int thread_count  = mixer_data->mixer_data.thread_count;
+    const uint32_t mix_len  = (mixer_data->channels_out >= 2) ? len << 1 : len;
+    const uint32_t buf_size = (thread_count - 1) * mix_len;
+    MixThreadArg thread_arg;
+    int32_t *thread_buf;
+    int i;
+
+    if (mixer_data->thread_buf_size < buf_size) {
+        if (!(thread_buf = av_realloc(mixer_data->thread_buf, (buf_size * sizeof(int32_t)) + FF_INPUT_BUFFER_PADDING_SIZE))) {
+            av_log(mixer_data->mixer_data.mixctx, AV_LOG_ERROR, "Cannot allocate mixer thread buffers, mixing single threaded.\n");
+            mix_sample(mixer_data, buf, len);
+
+            return;
         }
 
-        channel_info++;
-    } while (--i);
+        mixer_data->thread_buf      = thread_buf;
+        mixer_data->thread_buf_size = buf_size;
+    }
+
+    thread_arg.buf    = buf;
+    thread_arg.len    = len;
+    thread_arg.stride = mix_len;
+
+    mixer_data->mixer_data.execute((AVMixerData *) mixer_data, mix_sample_thread, &thread_arg, thread_count);
+    update_active_list(mixer_data);
+
+    thread_buf = mixer_data->thread_buf;
+
+    for (i = 1; i < thread_count; i++) {
+        mixer_data->dsp.add_mono(buf, thread_buf, mix_len);
+        thread_buf += mix_len;
+    }
 }
 
 #define MIX(type)                                                                                   \
@@ -3699,6 +3609,106 @@ static int32_t get_backwards_sample_1_x(const AV_HQMixerData *const mixer_data,
     return divs_128(tmp_128, div_volume);
 }
 
+/** Tap counts of the sinc kernel sets.  */
+static const uint8_t sinc_taps_lut[SINC_RATIOS] = {
+    16, 24, 32, 48, 64
+};
+
+/** Maximum advance ratio as 16.16 fixed point value of the sinc
+   kernel sets, they increase by half octaves.  */
+static const uint32_t sinc_ratio_lut[SINC_RATIOS] = {
+    0x10000, 0x16A0A, 0x20000, 0x2D414, 0x40000
+};
+
+static void mix_sinc(const AV_HQMixerData *const mixer_data,
+                     struct AV_HQMixerChannelInfo *const channel_info,
+                     const struct ChannelBlock *const channel_block,
+                     int32_t **const buf,
+                     int32_t (*const get_sample_func)(const AV_HQMixerData *const mixer_data,
+                                                      const struct AV_HQMixerChannelInfo *const channel_info,
+                                                      const struct ChannelBlock *channel_block,
+                                                      uint32_t offset),
+                     void (*const add_func)(int32_t *mix_buf, const int32_t *src, int len),
+                     const uint32_t buf_shift,
+                     const uint32_t offset_inc,
+                     uint32_t *const offset,
+                     uint32_t *const fraction,
+                     const uint32_t advance,
+                     const uint32_t adv_frac,
+                     const uint32_t len)
+{
+    int32_t *const hist    = channel_info->mix_right ? channel_info->sinc_hist_r : channel_info->sinc_hist;
+    const uint32_t ratio   = (advance << 16) + (adv_frac >> 16);
+    int32_t *mix_buf       = *buf;
+    uint32_t curr_offset   = *offset;
+    uint32_t curr_frac     = *fraction;
+    uint32_t fetch_offset  = curr_offset;
+    uint32_t i             = len;
+    uint32_t pos           = SINC_MAX_HALF;
+    uint32_t fill          = SINC_MAX_HALF;
+    uint32_t ratio_index   = 0;
+    const int16_t *kernel;
+    uint32_t taps, half;
+    int32_t win[SINC_WINDOW_SIZE], smp_buf[MIXER_DSP_BLOCK_SIZE];
+
+    while (ratio > sinc_ratio_lut[ratio_index])
+        ratio_index++;
+
+    kernel = mixer_data->sinc_kernel[ratio_index];
+    taps   = sinc_taps_lut[ratio_index];
+    half   = taps >> 1;
+
+    /* The window starts with the samples already passed by and is
+       filled up with the samples ahead which may cross loops.  */
+    memcpy(win, hist, sizeof(channel_info->sinc_hist));
+
+    while (fill <= (pos + half)) {
+        win[fill++]   = get_sample_func(mixer_data, channel_info, channel_block, fetch_offset);
+        fetch_offset += offset_inc;
+    }
+
+    do {
+        const uint32_t block_len = (i > MIXER_DSP_BLOCK_SIZE) ? MIXER_DSP_BLOCK_SIZE : i;
+        uint32_t j;
+
+        for (j = 0; j < block_len; j++) {
+            uint32_t step;
+
+            smp_buf[j]   = mixer_data->dsp.dot_product(win + pos + 1 - half, kernel + (curr_frac >> (32 - SINC_PHASE_BITS)) * taps, taps);
+            curr_frac   += adv_frac;
+            step         = advance + (curr_frac < adv_frac);
+            curr_offset += step * offset_inc;
+            pos         += step;
+
+            if ((pos + half) >= SINC_WINDOW_SIZE) {
+                const uint32_t skip = pos - SINC_MAX_HALF;
+
+                memmove(win, win + skip, (fill - skip) * sizeof(int32_t));
+
+                pos   = SINC_MAX_HALF;
+                fill -= skip;
+            }
+
+            while (fill <= (pos + half)) {
+                win[fill++]   = get_sample_func(mixer_data, channel_info, channel_block, fetch_offset);
+                fetch_offset += offset_inc;
+            }
+        }
+
+        filter_block(mixer_data, channel_info, channel_block, smp_buf, block_len);
+        add_func(mix_buf, smp_buf, block_len);
+
+        mix_buf += block_len << buf_shift;
+        i       -= block_len;
+    } while (i);
+
+    memcpy(hist, win + pos - SINC_MAX_HALF, sizeof(channel_info->sinc_hist));
+
+    *buf      = mix_buf;
+    *offset   = curr_offset;
+    *fraction = curr_frac;
+}
+
 static void mix_mono_loop(const AV_HQMixerData *const mixer_data,
                           struct AV_HQMixerChannelInfo *const channel_info,
                           struct ChannelBlock *const channel_block, int32_t **const buf,
@@ -3717,37 +3727,39 @@ static void mix_mono_loop(const AV_HQMixerData *const mixer_data,
     uint32_t curr_offset = *offset;
     uint32_t curr_frac   = *fraction;
     uint32_t i           = len;
-    int32_t smp;
+    int32_t prev_buf[MIXER_DSP_BLOCK_SIZE], curr_buf[MIXER_DSP_BLOCK_SIZE];
+    int32_t next_buf[MIXER_DSP_BLOCK_SIZE], smp_buf[MIXER_DSP_BLOCK_SIZE];
+    uint32_t frac_buf[MIXER_DSP_BLOCK_SIZE];
 
     get_next_sample_func(mixer_data, channel_info, channel_block, curr_offset);
 
     do {
-        int64_t interpolate_frac = -((int64_t) channel_info->prev_sample - (int64_t) channel_info->curr_sample);
-        int64_t interpolate_div  = ((int64_t) channel_info->next_sample - ((int64_t) channel_info->curr_sample + interpolate_frac)) >> 2;
-        int32_t smp_value;
-
-        smp               = (uint32_t) curr_frac >> 1;
-        interpolate_div   = ((int64_t) smp * interpolate_div) >> 32;
-        interpolate_div   = ((interpolate_div << 2) + interpolate_frac) >> 2;
-        interpolate_div   = ((int64_t) smp * interpolate_div) >> 32;
-        interpolate_div <<= 3;
-        smp_value         = ((int64_t) channel_info->prev_sample + (int64_t) channel_info->curr_sample) >> 1;
-        smp               = (uint32_t) smp_value + (uint32_t) interpolate_div;
-
-        if (((smp_value ^ smp) & (interpolate_div ^ smp)) < 0)
-            smp = channel_info->curr_sample;
-
-        *mix_buf++ += smp;
-        curr_frac  += adv_frac;
-
-        if (curr_frac < adv_frac) {
-            curr_offset              += offset_inc;
-            channel_info->prev_sample = channel_info->curr_sample;
-            channel_info->curr_sample = channel_info->next_sample;
-
-            get_next_sample_func(mixer_data, channel_info, channel_block, curr_offset);
+        const uint32_t block_len = (i > MIXER_DSP_BLOCK_SIZE) ? MIXER_DSP_BLOCK_SIZE : i;
+        uint32_t j;
+
+        for (j = 0; j < block_len; j++) {
+            prev_buf[j] = channel_info->prev_sample;
+            curr_buf[j] = channel_info->curr_sample;
+            next_buf[j] = channel_info->next_sample;
+            frac_buf[j] = curr_frac;
+            curr_frac  += adv_frac;
+
+            if (curr_frac < adv_frac) {
+                curr_offset              += offset_inc;
+                channel_info->prev_sample = channel_info->curr_sample;
+                channel_info->curr_sample = channel_info->next_sample;
+
+                get_next_sample_func(mixer_data, channel_info, channel_block, curr_offset);
+            }
         }
-    } while (--i);
+
+        mixer_data->dsp.interpolate(smp_buf, prev_buf, curr_buf, next_buf, frac_buf, block_len);
+        filter_block(mixer_data, channel_info, channel_block, smp_buf, block_len);
+        mixer_data->dsp.add_mono(mix_buf, smp_buf, block_len);
+
+        mix_buf += block_len;
+        i       -= block_len;
+    } while (i);
 
     *buf      = mix_buf;
     *offset   = curr_offset;
@@ -3776,34 +3788,51 @@ static void mix_average_mono(const AV_HQMixerData *const mixer_data,
     uint32_t curr_offset = *offset;
     uint32_t curr_frac   = *fraction;
     uint32_t i           = len;
+    int32_t smp_buf[MIXER_DSP_BLOCK_SIZE];
+
+    if ((mixer_data->interpolation == HQ_INTERPOLATION_SINC) && (advance < SINC_MAX_ADVANCE)) {
+        mix_sinc(mixer_data, channel_info, channel_block, buf, get_sample_func, mixer_data->dsp.add_mono, 0, offset_inc, offset, fraction, advance, adv_frac, len);
+        return;
+    }
 
     do {
-        int32_t smp                = get_curr_sample_func(channel_info, channel_block, curr_offset);
-        int64_t interpolate_div    = ((int64_t) ((uint32_t) ~curr_frac >> 1) * smp) >> 31;
-        int64_t interpolate_frac   = (uint32_t) ~curr_frac;
-        uint32_t interpolate_count = advance - 1;
+        const uint32_t block_len = (i > MIXER_DSP_BLOCK_SIZE) ? MIXER_DSP_BLOCK_SIZE : i;
+        uint32_t j               = 0;
 
-        curr_offset += offset_inc;
+        do {
+            int32_t smp                = get_curr_sample_func(channel_info, channel_block, curr_offset);
+            int64_t interpolate_div    = ((int64_t) ((uint32_t) ~curr_frac >> 1) * smp) >> 31;
+            int64_t interpolate_frac   = (uint32_t) ~curr_frac;
+            uint32_t interpolate_count = advance - 1;
 
-        while (interpolate_count--) {
-            interpolate_frac += INT64_C(0x100000000);
-            interpolate_div  += get_sample_func(mixer_data, channel_info, channel_block, curr_offset);
-            curr_offset      += offset_inc;
-        }
+            curr_offset += offset_inc;
 
-        curr_frac += adv_frac;
+            while (interpolate_count--) {
+                interpolate_frac += INT64_C(0x100000000);
+                interpolate_div  += get_sample_func(mixer_data, channel_info, channel_block, curr_offset);
+                curr_offset      += offset_inc;
+            }
 
-        if (curr_frac < adv_frac) {
-            interpolate_frac += INT64_C(0x100000000);
-            interpolate_div  += get_sample_func(mixer_data, channel_info, channel_block, curr_offset);
-            curr_offset      += offset_inc;
-        }
+            curr_frac += adv_frac;
 
-        smp               = get_sample_func(mixer_data, channel_info, channel_block, curr_offset);
-        interpolate_frac += curr_frac;
-        interpolate_div  += (((int64_t) ((uint32_t) curr_frac >> 1) * smp) >> 31);
-        *mix_buf++       += (interpolate_div << 24) / (interpolate_frac >> 8);
-    } while (--i);
+            if (curr_frac < adv_frac) {
+                interpolate_frac += INT64_C(0x100000000);
+                interpolate_div  += get_sample_func(mixer_data, channel_info, channel_block, curr_offset);
+                curr_offset      += offset_inc;
+            }
+
+            smp               = get_sample_func(mixer_data, channel_info, channel_block, curr_offset);
+            interpolate_frac += curr_frac;
+            interpolate_div  += (((int64_t) ((uint32_t) curr_frac >> 1) * smp) >> 31);
+            smp_buf[j]        = (interpolate_div << 24) / (interpolate_frac >> 8);
+        } while (++j < block_len);
+
+        filter_block(mixer_data, channel_info, channel_block, smp_buf, block_len);
+        mixer_data->dsp.add_mono(mix_buf, smp_buf, block_len);
+
+        mix_buf += block_len;
+        i       -= block_len;
+    } while (i);
 
     *buf      = mix_buf;
     *offset   = curr_offset;
@@ -3812,7 +3841,7 @@ static void mix_average_mono(const AV_HQMixerData *const mixer_data,
 
 MIX(mono_8)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_mono(mixer_data, channel_info, channel_block, buf, get_curr_sample_8, get_sample_1_8, 1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_8(channel_info, channel_block, *offset);
@@ -3822,7 +3851,7 @@ MIX(mono_8)
 
 MIX(mono_backwards_8)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_mono(mixer_data, channel_info, channel_block, buf, get_curr_sample_8, get_backwards_sample_1_8, -1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_8(channel_info, channel_block, *offset);
@@ -3832,7 +3861,7 @@ MIX(mono_backwards_8)
 
 MIX(mono_16_to_8)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_mono(mixer_data, channel_info, channel_block, buf, get_curr_sample_16_to_8, get_sample_1_16_to_8, 1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_16_to_8(channel_info, channel_block, *offset);
@@ -3842,7 +3871,7 @@ MIX(mono_16_to_8)
 
 MIX(mono_backwards_16_to_8)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_mono(mixer_data, channel_info, channel_block, buf, get_curr_sample_16_to_8, get_backwards_sample_1_16_to_8, -1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_16_to_8(channel_info, channel_block, *offset);
@@ -3852,7 +3881,7 @@ MIX(mono_backwards_16_to_8)
 
 MIX(mono_32_to_8)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_mono(mixer_data, channel_info, channel_block, buf, get_curr_sample_32_to_8, get_sample_1_32_to_8, 1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_32_to_8(channel_info, channel_block, *offset);
@@ -3862,7 +3891,7 @@ MIX(mono_32_to_8)
 
 MIX(mono_backwards_32_to_8)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_mono(mixer_data, channel_info, channel_block, buf, get_curr_sample_32_to_8, get_backwards_sample_1_32_to_8, -1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_32_to_8(channel_info, channel_block, *offset);
@@ -3872,7 +3901,7 @@ MIX(mono_backwards_32_to_8)
 
 MIX(mono_x_to_8)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_mono(mixer_data, channel_info, channel_block, buf, get_curr_sample_x_to_8, get_sample_1_x_to_8, 1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_x_to_8(channel_info, channel_block, *offset);
@@ -3882,7 +3911,7 @@ MIX(mono_x_to_8)
 
 MIX(mono_backwards_x_to_8)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_mono(mixer_data, channel_info, channel_block, buf, get_curr_sample_x_to_8, get_backwards_sample_1_x_to_8, -1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_x_to_8(channel_info, channel_block, *offset);
@@ -3892,7 +3921,7 @@ MIX(mono_backwards_x_to_8)
 
 MIX(mono_16)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_mono(mixer_data, channel_info, channel_block, buf, get_curr_sample_16, get_sample_1_16, 1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_16(channel_info, channel_block, *offset);
@@ -3902,7 +3931,7 @@ MIX(mono_16)
 
 MIX(mono_backwards_16)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_mono(mixer_data, channel_info, channel_block, buf, get_curr_sample_16, get_backwards_sample_1_16, -1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_16(channel_info, channel_block, *offset);
@@ -3912,7 +3941,7 @@ MIX(mono_backwards_16)
 
 MIX(mono_32)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_mono(mixer_data, channel_info, channel_block, buf, get_curr_sample_32, get_sample_1_32, 1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_32(channel_info, channel_block, *offset);
@@ -3922,7 +3951,7 @@ MIX(mono_32)
 
 MIX(mono_backwards_32)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_mono(mixer_data, channel_info, channel_block, buf, get_curr_sample_32, get_backwards_sample_1_32, -1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_32(channel_info, channel_block, *offset);
@@ -3932,7 +3961,7 @@ MIX(mono_backwards_32)
 
 MIX(mono_x)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_mono(mixer_data, channel_info, channel_block, buf, get_curr_sample_x, get_sample_1_x, 1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_x(channel_info, channel_block, *offset);
@@ -3942,7 +3971,7 @@ MIX(mono_x)
 
 MIX(mono_backwards_x)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_mono(mixer_data, channel_info, channel_block, buf, get_curr_sample_x, get_backwards_sample_1_x, -1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_x(channel_info, channel_block, *offset);
@@ -3969,38 +3998,39 @@ static void mix_left_loop(const AV_HQMixerData *const mixer_data,
     uint32_t curr_offset = *offset;
     uint32_t curr_frac   = *fraction;
     uint32_t i           = len;
-    int32_t smp;
+    int32_t prev_buf[MIXER_DSP_BLOCK_SIZE], curr_buf[MIXER_DSP_BLOCK_SIZE];
+    int32_t next_buf[MIXER_DSP_BLOCK_SIZE], smp_buf[MIXER_DSP_BLOCK_SIZE];
+    uint32_t frac_buf[MIXER_DSP_BLOCK_SIZE];
 
     get_next_sample_func(mixer_data, channel_info, channel_block, curr_offset);
 
     do {
-        int64_t interpolate_frac = -((int64_t) channel_info->prev_sample - (int64_t) channel_info->curr_sample);
-        int64_t interpolate_div  = ((int64_t) channel_info->next_sample - ((int64_t) channel_info->curr_sample + interpolate_frac)) >> 2;
-        int32_t smp_value;
-
-        smp               = (uint32_t) curr_frac >> 1;
-        interpolate_div   = ((int64_t) smp * interpolate_div) >> 32;
-        interpolate_div   = ((interpolate_div << 2) + interpolate_frac) >> 2;
-        interpolate_div   = ((int64_t) smp * interpolate_div) >> 32;
-        interpolate_div <<= 3;
-        smp_value         = ((int64_t) channel_info->prev_sample + (int64_t) channel_info->curr_sample) >> 1;
-        smp               = (uint32_t) smp_value + (uint32_t) interpolate_div;
-
-        if (((smp_value ^ smp) & (interpolate_div ^ smp)) < 0)
-            smp = channel_info->curr_sample;
-
-        *mix_buf  += smp;
-        mix_buf   += 2;
-        curr_frac += adv_frac;
-
-        if (curr_frac < adv_frac) {
-            curr_offset              += offset_inc;
-            channel_info->prev_sample = channel_info->curr_sample;
-            channel_info->curr_sample = channel_info->next_sample;
-
-            get_next_sample_func(mixer_data, channel_info, channel_block, curr_offset);
+        const uint32_t block_len = (i > MIXER_DSP_BLOCK_SIZE) ? MIXER_DSP_BLOCK_SIZE : i;
+        uint32_t j;
+
+        for (j = 0; j < block_len; j++) {
+            prev_buf[j] = channel_info->prev_sample;
+            curr_buf[j] = channel_info->curr_sample;
+            next_buf[j] = channel_info->next_sample;
+            frac_buf[j] = curr_frac;
+            curr_frac  += adv_frac;
+
+            if (curr_frac < adv_frac) {
+                curr_offset              += offset_inc;
+                channel_info->prev_sample = channel_info->curr_sample;
+                channel_info->curr_sample = channel_info->next_sample;
+
+                get_next_sample_func(mixer_data, channel_info, channel_block, curr_offset);
+            }
         }
-    } while (--i);
+
+        mixer_data->dsp.interpolate(smp_buf, prev_buf, curr_buf, next_buf, frac_buf, block_len);
+        filter_block(mixer_data, channel_info, channel_block, smp_buf, block_len);
+        mixer_data->dsp.add_left(mix_buf, smp_buf, block_len);
+
+        mix_buf += block_len << 1;
+        i       -= block_len;
+    } while (i);
 
     *buf      = mix_buf;
     *offset   = curr_offset;
@@ -4029,35 +4059,51 @@ static void mix_average_left(const AV_HQMixerData *const mixer_data,
     uint32_t curr_offset = *offset;
     uint32_t curr_frac   = *fraction;
     uint32_t i           = len;
+    int32_t smp_buf[MIXER_DSP_BLOCK_SIZE];
+
+    if ((mixer_data->interpolation == HQ_INTERPOLATION_SINC) && (advance < SINC_MAX_ADVANCE)) {
+        mix_sinc(mixer_data, channel_info, channel_block, buf, get_sample_func, mixer_data->dsp.add_left, 1, offset_inc, offset, fraction, advance, adv_frac, len);
+        return;
+    }
 
     do {
-        int32_t smp                = get_curr_sample_func(channel_info, channel_block, curr_offset);
-        int64_t interpolate_div    = ((int64_t) ((uint32_t) ~curr_frac >> 1) * smp) >> 31;
-        int64_t interpolate_frac   = (uint32_t) ~curr_frac;
-        uint32_t interpolate_count = advance - 1;
+        const uint32_t block_len = (i > MIXER_DSP_BLOCK_SIZE) ? MIXER_DSP_BLOCK_SIZE : i;
+        uint32_t j               = 0;
 
-        curr_offset += offset_inc;
+        do {
+            int32_t smp                = get_curr_sample_func(channel_info, channel_block, curr_offset);
+            int64_t interpolate_div    = ((int64_t) ((uint32_t) ~curr_frac >> 1) * smp) >> 31;
+            int64_t interpolate_frac   = (uint32_t) ~curr_frac;
+            uint32_t interpolate_count = advance - 1;
 
-        while (interpolate_count--) {
-            interpolate_frac += INT64_C(0x100000000);
-            interpolate_div  += get_sample_func(mixer_data, channel_info, channel_block, curr_offset);
-            curr_offset      += offset_inc;
-        }
+            curr_offset += offset_inc;
 
-        curr_frac += adv_frac;
+            while (interpolate_count--) {
+                interpolate_frac += INT64_C(0x100000000);
+                interpolate_div  += get_sample_func(mixer_data, channel_info, channel_block, curr_offset);
+                curr_offset      += offset_inc;
+            }
 
-        if (curr_frac < adv_frac) {
-            interpolate_frac += INT64_C(0x100000000);
-            interpolate_div  += get_sample_func(mixer_data, channel_info, channel_block, curr_offset);
-            curr_offset      += offset_inc;
-        }
+            curr_frac += adv_frac;
 
-        smp               = get_sample_func(mixer_data, channel_info, channel_block, curr_offset);
-        interpolate_frac += curr_frac;
-        interpolate_div  += ((int64_t) ((uint32_t) curr_frac >> 1) * smp) >> 31;
-        *mix_buf         += (interpolate_div << 24) / (interpolate_frac >> 8);
-        mix_buf          += 2;
-    } while (--i);
+            if (curr_frac < adv_frac) {
+                interpolate_frac += INT64_C(0x100000000);
+                interpolate_div  += get_sample_func(mixer_data, channel_info, channel_block, curr_offset);
+                curr_offset      += offset_inc;
+            }
+
+            smp               = get_sample_func(mixer_data, channel_info, channel_block, curr_offset);
+            interpolate_frac += curr_frac;
+            interpolate_div  += ((int64_t) ((uint32_t) curr_frac >> 1) * smp) >> 31;
+            smp_buf[j]        = (interpolate_div << 24) / (interpolate_frac >> 8);
+        } while (++j < block_len);
+
+        filter_block(mixer_data, channel_info, channel_block, smp_buf, block_len);
+        mixer_data->dsp.add_left(mix_buf, smp_buf, block_len);
+
+        mix_buf += block_len << 1;
+        i       -= block_len;
+    } while (i);
 
     *buf      = mix_buf;
     *offset   = curr_offset;
@@ -4066,7 +4112,7 @@ static void mix_average_left(const AV_HQMixerData *const mixer_data,
 
 MIX(stereo_8_left)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_left(mixer_data, channel_info, channel_block, buf, get_curr_sample_8, get_sample_1_8, 1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_8(channel_info, channel_block, *offset);
@@ -4076,7 +4122,7 @@ MIX(stereo_8_left)
 
 MIX(stereo_backwards_8_left)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_left(mixer_data, channel_info, channel_block, buf, get_curr_sample_8, get_backwards_sample_1_8, -1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_8(channel_info, channel_block, *offset);
@@ -4086,7 +4132,7 @@ MIX(stereo_backwards_8_left)
 
 MIX(stereo_16_to_8_left)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_left(mixer_data, channel_info, channel_block, buf, get_curr_sample_16_to_8, get_sample_1_16_to_8, 1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_16_to_8(channel_info, channel_block, *offset);
@@ -4096,7 +4142,7 @@ MIX(stereo_16_to_8_left)
 
 MIX(stereo_backwards_16_to_8_left)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_left(mixer_data, channel_info, channel_block, buf, get_curr_sample_16_to_8, get_backwards_sample_1_16_to_8, -1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_16_to_8(channel_info, channel_block, *offset);
@@ -4106,7 +4152,7 @@ MIX(stereo_backwards_16_to_8_left)
 
 MIX(stereo_32_to_8_left)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_left(mixer_data, channel_info, channel_block, buf, get_curr_sample_32_to_8, get_sample_1_32_to_8, 1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_32_to_8(channel_info, channel_block, *offset);
@@ -4116,7 +4162,7 @@ MIX(stereo_32_to_8_left)
 
 MIX(stereo_backwards_32_to_8_left)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_left(mixer_data, channel_info, channel_block, buf, get_curr_sample_32_to_8, get_backwards_sample_1_32_to_8, -1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_32_to_8(channel_info, channel_block, *offset);
@@ -4126,7 +4172,7 @@ MIX(stereo_backwards_32_to_8_left)
 
 MIX(stereo_x_to_8_left)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_left(mixer_data, channel_info, channel_block, buf, get_curr_sample_x_to_8, get_sample_1_x_to_8, 1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_x_to_8(channel_info, channel_block, *offset);
@@ -4136,7 +4182,7 @@ MIX(stereo_x_to_8_left)
 
 MIX(stereo_backwards_x_to_8_left)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_left(mixer_data, channel_info, channel_block, buf, get_curr_sample_x_to_8, get_backwards_sample_1_x_to_8, -1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_x_to_8(channel_info, channel_block, *offset);
@@ -4146,7 +4192,7 @@ MIX(stereo_backwards_x_to_8_left)
 
 MIX(stereo_16_left)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_left(mixer_data, channel_info, channel_block, buf, get_curr_sample_16, get_sample_1_16, 1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_16(channel_info, channel_block, *offset);
@@ -4156,7 +4202,7 @@ MIX(stereo_16_left)
 
 MIX(stereo_backwards_16_left)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_left(mixer_data, channel_info, channel_block, buf, get_curr_sample_16, get_backwards_sample_1_16, -1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_16(channel_info, channel_block, *offset);
@@ -4166,7 +4212,7 @@ MIX(stereo_backwards_16_left)
 
 MIX(stereo_32_left)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_left(mixer_data, channel_info, channel_block, buf, get_curr_sample_32, get_sample_1_32, 1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_32(channel_info, channel_block, *offset);
@@ -4176,7 +4222,7 @@ MIX(stereo_32_left)
 
 MIX(stereo_backwards_32_left)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_left(mixer_data, channel_info, channel_block, buf, get_curr_sample_32, get_backwards_sample_1_32, -1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_32(channel_info, channel_block, *offset);
@@ -4186,7 +4232,7 @@ MIX(stereo_backwards_32_left)
 
 MIX(stereo_x_left)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_left(mixer_data, channel_info, channel_block, buf, get_curr_sample_x, get_sample_1_x, 1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_x(channel_info, channel_block, *offset);
@@ -4196,7 +4242,7 @@ MIX(stereo_x_left)
 
 MIX(stereo_backwards_x_left)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_left(mixer_data, channel_info, channel_block, buf, get_curr_sample_x, get_backwards_sample_1_x, -1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_x(channel_info, channel_block, *offset);
@@ -4223,38 +4269,39 @@ static void mix_right_loop(const AV_HQMixerData *const mixer_data,
     uint32_t curr_offset = *offset;
     uint32_t curr_frac   = *fraction;
     uint32_t i           = len;
-    int32_t smp;
+    int32_t prev_buf[MIXER_DSP_BLOCK_SIZE], curr_buf[MIXER_DSP_BLOCK_SIZE];
+    int32_t next_buf[MIXER_DSP_BLOCK_SIZE], smp_buf[MIXER_DSP_BLOCK_SIZE];
+    uint32_t frac_buf[MIXER_DSP_BLOCK_SIZE];
 
     get_next_sample_func(mixer_data, channel_info, channel_block, curr_offset);
 
     do {
-        int64_t interpolate_frac = -((int64_t) channel_info->prev_sample - (int64_t) channel_info->curr_sample);
-        int64_t interpolate_div  = ((int64_t) channel_info->next_sample - ((int64_t) channel_info->curr_sample + interpolate_frac)) >> 2;
-        int32_t smp_value;
-
-        smp               = (uint32_t) curr_frac >> 1;
-        interpolate_div   = ((int64_t) smp * interpolate_div) >> 32;
-        interpolate_div   = ((interpolate_div << 2) + interpolate_frac) >> 2;
-        interpolate_div   = ((int64_t) smp * interpolate_div) >> 32;
-        interpolate_div <<= 3;
-        smp_value         = ((int64_t) channel_info->prev_sample_r + (int64_t) channel_info->curr_sample_r) >> 1;
-        smp               = (uint32_t) smp_value + (uint32_t) interpolate_div;
-
-        if (((smp_value ^ smp) & (interpolate_div ^ smp)) < 0)
-            smp = channel_info->curr_sample_r;
-
-        mix_buf++;
-        *mix_buf++ += smp;
-        curr_frac  += adv_frac;
-
-        if (curr_frac < adv_frac) {
-            curr_offset                += offset_inc;
-            channel_info->prev_sample_r = channel_info->curr_sample_r;
-            channel_info->curr_sample_r = channel_info->next_sample_r;
-
-            get_next_sample_func(mixer_data, channel_info, channel_block, curr_offset);
+        const uint32_t block_len = (i > MIXER_DSP_BLOCK_SIZE) ? MIXER_DSP_BLOCK_SIZE : i;
+        uint32_t j;
+
+        for (j = 0; j < block_len; j++) {
+            prev_buf[j] = channel_info->prev_sample_r;
+            curr_buf[j] = channel_info->curr_sample_r;
+            next_buf[j] = channel_info->next_sample_r;
+            frac_buf[j] = curr_frac;
+            curr_frac  += adv_frac;
+
+            if (curr_frac < adv_frac) {
+                curr_offset                += offset_inc;
+                channel_info->prev_sample_r = channel_info->curr_sample_r;
+                channel_info->curr_sample_r = channel_info->next_sample_r;
+
+                get_next_sample_func(mixer_data, channel_info, channel_block, curr_offset);
+            }
         }
-    } while (--i);
+
+        mixer_data->dsp.interpolate(smp_buf, prev_buf, curr_buf, next_buf, frac_buf, block_len);
+        filter_block(mixer_data, channel_info, channel_block, smp_buf, block_len);
+        mixer_data->dsp.add_right(mix_buf, smp_buf, block_len);
+
+        mix_buf += block_len << 1;
+        i       -= block_len;
+    } while (i);
 
     channel_info->mix_right = 0;
     *buf                    = mix_buf;
@@ -4284,37 +4331,55 @@ static void mix_average_right(const AV_HQMixerData *const mixer_data,
     uint32_t curr_offset = *offset;
     uint32_t curr_frac   = *fraction;
     uint32_t i           = len;
+    int32_t smp_buf[MIXER_DSP_BLOCK_SIZE];
 
     channel_info->mix_right = 1;
 
+    if ((mixer_data->interpolation == HQ_INTERPOLATION_SINC) && (advance < SINC_MAX_ADVANCE)) {
+        mix_sinc(mixer_data, channel_info, channel_block, buf, get_sample_func, mixer_data->dsp.add_right, 1, offset_inc, offset, fraction, advance, adv_frac, len);
+
+        channel_info->mix_right = 0;
+        return;
+    }
+
     do {
-        int32_t smp                = get_curr_sample_func(channel_info, channel_block, curr_offset);
-        int64_t interpolate_div    = ((int64_t) ((uint32_t) ~curr_frac >> 1) * smp) >> 31;
-        int64_t interpolate_frac   = (uint32_t) ~curr_frac;
-        uint32_t interpolate_count = advance - 1;
+        const uint32_t block_len = (i > MIXER_DSP_BLOCK_SIZE) ? MIXER_DSP_BLOCK_SIZE : i;
+        uint32_t j               = 0;
 
-        curr_offset += offset_inc;
+        do {
+            int32_t smp                = get_curr_sample_func(channel_info, channel_block, curr_offset);
+            int64_t interpolate_div    = ((int64_t) ((uint32_t) ~curr_frac >> 1) * smp) >> 31;
+            int64_t interpolate_frac   = (uint32_t) ~curr_frac;
+            uint32_t interpolate_count = advance - 1;
 
-        while (interpolate_count--) {
-            interpolate_frac += INT64_C(0x100000000);
-            interpolate_div  += get_sample_func(mixer_data, channel_info, channel_block, curr_offset);
-            curr_offset      += offset_inc;
-        }
+            curr_offset += offset_inc;
+
+            while (interpolate_count--) {
+                interpolate_frac += INT64_C(0x100000000);
+                interpolate_div  += get_sample_func(mixer_data, channel_info, channel_block, curr_offset);
+                curr_offset      += offset_inc;
+            }
 
-        curr_frac += adv_frac;
+            curr_frac += adv_frac;
 
-        if (curr_frac < adv_frac) {
-            interpolate_frac += INT64_C(0x100000000);
-            interpolate_div  += get_sample_func(mixer_data, channel_info, channel_block, curr_offset);
-            curr_offset      += offset_inc;
-        }
+            if (curr_frac < adv_frac) {
+                interpolate_frac += INT64_C(0x100000000);
+                interpolate_div  += get_sample_func(mixer_data, channel_info, channel_block, curr_offset);
+                curr_offset      += offset_inc;
+            }
 
-        smp               = get_sample_func(mixer_data, channel_info, channel_block, curr_offset);
-        interpolate_frac += curr_frac;
-        interpolate_div  += (((int64_t) ((uint32_t) curr_frac >> 1) * smp) >> 31);
-        mix_buf++;
-        *mix_buf++       += (interpolate_div << 24) / (interpolate_frac >> 8);
-    } while (--i);
+            smp               = get_sample_func(mixer_data, channel_info, channel_block, curr_offset);
+            interpolate_frac += curr_frac;
+            interpolate_div  += (((int64_t) ((uint32_t) curr_frac >> 1) * smp) >> 31);
+            smp_buf[j]        = (interpolate_div << 24) / (interpolate_frac >> 8);
+        } while (++j < block_len);
+
+        filter_block(mixer_data, channel_info, channel_block, smp_buf, block_len);
+        mixer_data->dsp.add_right(mix_buf, smp_buf, block_len);
+
+        mix_buf += block_len << 1;
+        i       -= block_len;
+    } while (i);
 
     channel_info->mix_right = 0;
     *buf                    = mix_buf;
@@ -4324,7 +4389,7 @@ static void mix_average_right(const AV_HQMixerData *const mixer_data,
 
 MIX(stereo_8_right)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_right(mixer_data, channel_info, channel_block, buf, get_curr_sample_8, get_sample_1_8, 1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->mix_right   = 1;
@@ -4335,7 +4400,7 @@ MIX(stereo_8_right)
 
 MIX(stereo_backwards_8_right)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_right(mixer_data, channel_info, channel_block, buf, get_curr_sample_8, get_backwards_sample_1_8, -1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->mix_right   = 1;
@@ -4346,7 +4411,7 @@ MIX(stereo_backwards_8_right)
 
 MIX(stereo_16_to_8_right)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_right(mixer_data, channel_info, channel_block, buf, get_curr_sample_16_to_8, get_sample_1_16_to_8, 1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->mix_right   = 1;
@@ -4357,7 +4422,7 @@ MIX(stereo_16_to_8_right)
 
 MIX(stereo_backwards_16_to_8_right)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_right(mixer_data, channel_info, channel_block, buf, get_curr_sample_16_to_8, get_backwards_sample_1_16_to_8, -1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->mix_right   = 1;
@@ -4368,7 +4433,7 @@ MIX(stereo_backwards_16_to_8_right)
 
 MIX(stereo_32_to_8_right)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_right(mixer_data, channel_info, channel_block, buf, get_curr_sample_32_to_8, get_sample_1_32_to_8, 1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->mix_right   = 1;
@@ -4379,7 +4444,7 @@ MIX(stereo_32_to_8_right)
 
 MIX(stereo_backwards_32_to_8_right)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_right(mixer_data, channel_info, channel_block, buf, get_curr_sample_32_to_8, get_backwards_sample_1_32_to_8, -1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->mix_right   = 1;
@@ -4390,7 +4455,7 @@ MIX(stereo_backwards_32_to_8_right)
 
 MIX(stereo_x_to_8_right)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_right(mixer_data, channel_info, channel_block, buf, get_curr_sample_x_to_8, get_sample_1_x_to_8, 1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->mix_right   = 1;
@@ -4401,7 +4466,7 @@ MIX(stereo_x_to_8_right)
 
 MIX(stereo_backwards_x_to_8_right)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_right(mixer_data, channel_info, channel_block, buf, get_curr_sample_x_to_8, get_backwards_sample_1_x_to_8, -1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->mix_right   = 1;
@@ -4412,7 +4477,7 @@ MIX(stereo_backwards_x_to_8_right)
 
 MIX(stereo_16_right)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_right(mixer_data, channel_info, channel_block, buf, get_curr_sample_16, get_sample_1_16, 1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->mix_right   = 1;
@@ -4423,7 +4488,7 @@ MIX(stereo_16_right)
 
 MIX(stereo_backwards_16_right)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_right(mixer_data, channel_info, channel_block, buf, get_curr_sample_16, get_backwards_sample_1_16, -1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->mix_right   = 1;
@@ -4434,7 +4499,7 @@ MIX(stereo_backwards_16_right)
 
 MIX(stereo_32_right)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_right(mixer_data, channel_info, channel_block, buf, get_curr_sample_32, get_sample_1_32, 1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->mix_right   = 1;
@@ -4445,7 +4510,7 @@ MIX(stereo_32_right)
 
 MIX(stereo_backwards_32_right)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_right(mixer_data, channel_info, channel_block, buf, get_curr_sample_32, get_backwards_sample_1_32, -1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->mix_right   = 1;
@@ -4456,7 +4521,7 @@ MIX(stereo_backwards_32_right)
 
 MIX(stereo_x_right)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_right(mixer_data, channel_info, channel_block, buf, get_curr_sample_x, get_sample_1_x, 1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->mix_right   = 1;
@@ -4467,7 +4532,7 @@ MIX(stereo_x_right)
 
 MIX(stereo_backwards_x_right)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_right(mixer_data, channel_info, channel_block, buf, get_curr_sample_x, get_backwards_sample_1_x, -1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->mix_right   = 1;
@@ -4482,7 +4547,7 @@ MIX(stereo_8)
     uint32_t curr_offset = *offset;
     uint32_t curr_frac   = *fraction;
 
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_left(mixer_data, channel_info, channel_block, &mix_buf, get_curr_sample_8, get_sample_1_8, 1, &curr_offset, &curr_frac, advance, adv_frac, len);
         mix_average_right(mixer_data, channel_info, channel_block, buf, get_curr_sample_8, get_sample_1_8, 1, offset, fraction, advance, adv_frac, len);
    } else {
@@ -4501,7 +4566,7 @@ MIX(stereo_backwards_8)
     uint32_t curr_offset = *offset;
     uint32_t curr_frac   = *fraction;
 
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_left(mixer_data, channel_info, channel_block, &mix_buf, get_curr_sample_8, get_backwards_sample_1_8, -1, &curr_offset, &curr_frac, advance, adv_frac, len);
         mix_average_right(mixer_data, channel_info, channel_block, buf, get_curr_sample_8, get_backwards_sample_1_8, -1, offset, fraction, advance, adv_frac, len);
    } else {
@@ -4520,7 +4585,7 @@ MIX(stereo_16_to_8)
     uint32_t curr_offset = *offset;
     uint32_t curr_frac   = *fraction;
 
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_left(mixer_data, channel_info, channel_block, &mix_buf, get_curr_sample_16_to_8, get_sample_1_16_to_8, 1, &curr_offset, &curr_frac, advance, adv_frac, len);
         mix_average_right(mixer_data, channel_info, channel_block, buf, get_curr_sample_16_to_8, get_sample_1_16_to_8, 1, offset, fraction, advance, adv_frac, len);
    } else {
@@ -4539,7 +4604,7 @@ MIX(stereo_backwards_16_to_8)
     uint32_t curr_offset = *offset;
     uint32_t curr_frac   = *fraction;
 
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_left(mixer_data, channel_info, channel_block, &mix_buf, get_curr_sample_16_to_8, get_backwards_sample_1_16_to_8, -1, &curr_offset, &curr_frac, advance, adv_frac, len);
         mix_average_right(mixer_data, channel_info, channel_block, buf, get_curr_sample_16_to_8, get_backwards_sample_1_16_to_8, -1, offset, fraction, advance, adv_frac, len);
    } else {
@@ -4558,7 +4623,7 @@ MIX(stereo_32_to_8)
     uint32_t curr_offset = *offset;
     uint32_t curr_frac   = *fraction;
 
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_left(mixer_data, channel_info, channel_block, &mix_buf, get_curr_sample_32_to_8, get_sample_1_32_to_8, 1, &curr_offset, &curr_frac, advance, adv_frac, len);
         mix_average_right(mixer_data, channel_info, channel_block, buf, get_curr_sample_32_to_8, get_sample_1_32_to_8, 1, offset, fraction, advance, adv_frac, len);
    } else {
@@ -4577,7 +4642,7 @@ MIX(stereo_backwards_32_to_8)
     uint32_t curr_offset = *offset;
     uint32_t curr_frac   = *fraction;
 
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_left(mixer_data, channel_info, channel_block, &mix_buf, get_curr_sample_32_to_8, get_backwards_sample_1_32_to_8, -1, &curr_offset, &curr_frac, advance, adv_frac, len);
         mix_average_right(mixer_data, channel_info, channel_block, buf, get_curr_sample_32_to_8, get_backwards_sample_1_32_to_8, -1, offset, fraction, advance, adv_frac, len);
    } else {
@@ -4596,7 +4661,7 @@ MIX(stereo_x_to_8)
     uint32_t curr_offset = *offset;
     uint32_t curr_frac   = *fraction;
 
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_left(mixer_data, channel_info, channel_block, &mix_buf, get_curr_sample_x_to_8, get_sample_1_x_to_8, 1, &curr_offset, &curr_frac, advance, adv_frac, len);
         mix_average_right(mixer_data, channel_info, channel_block, buf, get_curr_sample_x_to_8, get_sample_1_x_to_8, 1, offset, fraction, advance, adv_frac, len);
    } else {
@@ -4615,7 +4680,7 @@ MIX(stereo_backwards_x_to_8)
     uint32_t curr_offset = *offset;
     uint32_t curr_frac   = *fraction;
 
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_left(mixer_data, channel_info, channel_block, &mix_buf, get_curr_sample_x_to_8, get_backwards_sample_1_x_to_8, -1, &curr_offset, &curr_frac, advance, adv_frac, len);
         mix_average_right(mixer_data, channel_info, channel_block, buf, get_curr_sample_x_to_8, get_backwards_sample_1_x_to_8, -1, offset, fraction, advance, adv_frac, len);
    } else {
@@ -4634,7 +4699,7 @@ MIX(stereo_16)
     uint32_t curr_offset = *offset;
     uint32_t curr_frac   = *fraction;
 
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_left(mixer_data, channel_info, channel_block, &mix_buf, get_curr_sample_16, get_sample_1_16, 1, &curr_offset, &curr_frac, advance, adv_frac, len);
         mix_average_right(mixer_data, channel_info, channel_block, buf, get_curr_sample_16, get_sample_1_16, 1, offset, fraction, advance, adv_frac, len);
    } else {
@@ -4653,7 +4718,7 @@ MIX(stereo_backwards_16)
     uint32_t curr_offset = *offset;
     uint32_t curr_frac   = *fraction;
 
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_left(mixer_data, channel_info, channel_block, &mix_buf, get_curr_sample_16, get_backwards_sample_1_16, -1, &curr_offset, &curr_frac, advance, adv_frac, len);
         mix_average_right(mixer_data, channel_info, channel_block, buf, get_curr_sample_16, get_backwards_sample_1_16, -1, offset, fraction, advance, adv_frac, len);
    } else {
@@ -4672,7 +4737,7 @@ MIX(stereo_32)
     uint32_t curr_offset = *offset;
     uint32_t curr_frac   = *fraction;
 
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_left(mixer_data, channel_info, channel_block, &mix_buf, get_curr_sample_32, get_sample_1_32, 1, &curr_offset, &curr_frac, advance, adv_frac, len);
         mix_average_right(mixer_data, channel_info, channel_block, buf, get_curr_sample_32, get_sample_1_32, 1, offset, fraction, advance, adv_frac, len);
    } else {
@@ -4691,7 +4756,7 @@ MIX(stereo_backwards_32)
     uint32_t curr_offset = *offset;
     uint32_t curr_frac   = *fraction;
 
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_left(mixer_data, channel_info, channel_block, &mix_buf, get_curr_sample_32, get_backwards_sample_1_32, -1, &curr_offset, &curr_frac, advance, adv_frac, len);
         mix_average_right(mixer_data, channel_info, channel_block, buf, get_curr_sample_32, get_backwards_sample_1_32, -1, offset, fraction, advance, adv_frac, len);
    } else {
@@ -4710,7 +4775,7 @@ MIX(stereo_x)
     uint32_t curr_offset = *offset;
     uint32_t curr_frac   = *fraction;
 
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_left(mixer_data, channel_info, channel_block, &mix_buf, get_curr_sample_x, get_sample_1_x, 1, &curr_offset, &curr_frac, advance, adv_frac, len);
         mix_average_right(mixer_data, channel_info, channel_block, &mix_buf, get_curr_sample_x, get_sample_1_x, 1, &curr_offset, &curr_frac, advance, adv_frac, len);
    } else {
@@ -4729,7 +4794,7 @@ MIX(stereo_backwards_x)
     uint32_t curr_offset = *offset;
     uint32_t curr_frac   = *fraction;
 
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_left(mixer_data, channel_info, channel_block, &mix_buf, get_curr_sample_x, get_backwards_sample_1_x, -1, &curr_offset, &curr_frac, advance, adv_frac, len);
         mix_average_right(mixer_data, channel_info, channel_block, buf, get_curr_sample_x, get_backwards_sample_1_x, -1, offset, fraction, advance, adv_frac, len);
    } else {
@@ -4761,38 +4826,39 @@ static void mix_center_loop(const AV_HQMixerData *const mixer_data,
     uint32_t curr_offset = *offset;
     uint32_t curr_frac   = *fraction;
     uint32_t i           = len;
-    int32_t smp;
+    int32_t prev_buf[MIXER_DSP_BLOCK_SIZE], curr_buf[MIXER_DSP_BLOCK_SIZE];
+    int32_t next_buf[MIXER_DSP_BLOCK_SIZE], smp_buf[MIXER_DSP_BLOCK_SIZE];
+    uint32_t frac_buf[MIXER_DSP_BLOCK_SIZE];
 
     get_next_sample_func(mixer_data, channel_info, channel_block, curr_offset);
 
     do {
-        int64_t interpolate_frac = -((int64_t) channel_info->prev_sample - (int64_t) channel_info->curr_sample);
-        int64_t interpolate_div  = ((int64_t) channel_info->next_sample - ((int64_t) channel_info->curr_sample + interpolate_frac)) >> 2;
-        int32_t smp_value;
-
-        smp               = (uint32_t) curr_frac >> 1;
-        interpolate_div   = ((int64_t) smp * interpolate_div) >> 32;
-        interpolate_div   = ((interpolate_div << 2) + interpolate_frac) >> 2;
-        interpolate_div   = ((int64_t) smp * interpolate_div) >> 32;
-        interpolate_div <<= 3;
-        smp_value         = ((int64_t) channel_info->prev_sample + (int64_t) channel_info->curr_sample) >> 1;
-        smp               = (uint32_t) smp_value + (uint32_t) interpolate_div;
-
-        if (((smp_value ^ smp) & (interpolate_div ^ smp)) < 0)
-            smp = channel_info->curr_sample;
-
-        *mix_buf++ += smp;
-        *mix_buf++ += smp;
-        curr_frac  += adv_frac;
-
-        if (curr_frac < adv_frac) {
-            curr_offset              += offset_inc;
-            channel_info->prev_sample = channel_info->curr_sample;
-            channel_info->curr_sample = channel_info->next_sample;
-
-            get_next_sample_func(mixer_data, channel_info, channel_block, curr_offset);
+        const uint32_t block_len = (i > MIXER_DSP_BLOCK_SIZE) ? MIXER_DSP_BLOCK_SIZE : i;
+        uint32_t j;
+
+        for (j = 0; j < block_len; j++) {
+            prev_buf[j] = channel_info->prev_sample;
+            curr_buf[j] = channel_info->curr_sample;
+            next_buf[j] = channel_info->next_sample;
+            frac_buf[j] = curr_frac;
+            curr_frac  += adv_frac;
+
+            if (curr_frac < adv_frac) {
+                curr_offset              += offset_inc;
+                channel_info->prev_sample = channel_info->curr_sample;
+                channel_info->curr_sample = channel_info->next_sample;
+
+                get_next_sample_func(mixer_data, channel_info, channel_block, curr_offset);
+            }
         }
-    } while (--i);
+
+        mixer_data->dsp.interpolate(smp_buf, prev_buf, curr_buf, next_buf, frac_buf, block_len);
+        filter_block(mixer_data, channel_info, channel_block, smp_buf, block_len);
+        mixer_data->dsp.add_center(mix_buf, smp_buf, block_len);
+
+        mix_buf += block_len << 1;
+        i       -= block_len;
+    } while (i);
 
     *buf      = mix_buf;
     *offset   = curr_offset;
@@ -4821,36 +4887,51 @@ static void mix_average_center(const AV_HQMixerData *const mixer_data,
     uint32_t curr_offset = *offset;
     uint32_t curr_frac   = *fraction;
     uint32_t i           = len;
+    int32_t smp_buf[MIXER_DSP_BLOCK_SIZE];
+
+    if ((mixer_data->interpolation == HQ_INTERPOLATION_SINC) && (advance < SINC_MAX_ADVANCE)) {
+        mix_sinc(mixer_data, channel_info, channel_block, buf, get_sample_func, mixer_data->dsp.add_center, 1, offset_inc, offset, fraction, advance, adv_frac, len);
+        return;
+    }
 
     do {
-        int32_t smp                = get_curr_sample_func(channel_info, channel_block, curr_offset);
-        int64_t interpolate_div    = ((int64_t) ((uint32_t) ~curr_frac >> 1) * smp) >> 31;
-        int64_t interpolate_frac   = (uint32_t) ~curr_frac;
-        uint32_t interpolate_count = advance - 1;
+        const uint32_t block_len = (i > MIXER_DSP_BLOCK_SIZE) ? MIXER_DSP_BLOCK_SIZE : i;
+        uint32_t j               = 0;
 
-        curr_offset += offset_inc;
+        do {
+            int32_t smp                = get_curr_sample_func(channel_info, channel_block, curr_offset);
+            int64_t interpolate_div    = ((int64_t) ((uint32_t) ~curr_frac >> 1) * smp) >> 31;
+            int64_t interpolate_frac   = (uint32_t) ~curr_frac;
+            uint32_t interpolate_count = advance - 1;
 
-        while (interpolate_count--) {
-            interpolate_frac += INT64_C(0x100000000);
-            interpolate_div  += get_sample_func(mixer_data, channel_info, channel_block, curr_offset);
-            curr_offset      += offset_inc;
-        }
+            curr_offset += offset_inc;
 
-        curr_frac += adv_frac;
+            while (interpolate_count--) {
+                interpolate_frac += INT64_C(0x100000000);
+                interpolate_div  += get_sample_func(mixer_data, channel_info, channel_block, curr_offset);
+                curr_offset      += offset_inc;
+            }
 
-        if (curr_frac < adv_frac) {
-            interpolate_frac += INT64_C(0x100000000);
-            interpolate_div  += get_sample_func(mixer_data, channel_info, channel_block, curr_offset);
-            curr_offset      += offset_inc;
-        }
+            curr_frac += adv_frac;
 
-        smp               = get_sample_func(mixer_data, channel_info, channel_block, curr_offset);
-        interpolate_frac += curr_frac;
-        interpolate_div  += (((int64_t) ((uint32_t) curr_frac >> 1) * smp) >> 31);
-        smp               = (interpolate_div << 24) / (interpolate_frac >> 8);
-        *mix_buf++       += smp;
-        *mix_buf++       += smp;
-    } while (--i);
+            if (curr_frac < adv_frac) {
+                interpolate_frac += INT64_C(0x100000000);
+                interpolate_div  += get_sample_func(mixer_data, channel_info, channel_block, curr_offset);
+                curr_offset      += offset_inc;
+            }
+
+            smp               = get_sample_func(mixer_data, channel_info, channel_block, curr_offset);
+            interpolate_frac += curr_frac;
+            interpolate_div  += (((int64_t) ((uint32_t) curr_frac >> 1) * smp) >> 31);
+            smp_buf[j]        = (interpolate_div << 24) / (interpolate_frac >> 8);
+        } while (++j < block_len);
+
+        filter_block(mixer_data, channel_info, channel_block, smp_buf, block_len);
+        mixer_data->dsp.add_center(mix_buf, smp_buf, block_len);
+
+        mix_buf += block_len << 1;
+        i       -= block_len;
+    } while (i);
 
     *buf      = mix_buf;
     *offset   = curr_offset;
@@ -4859,7 +4940,7 @@ static void mix_average_center(const AV_HQMixerData *const mixer_data,
 
 MIX(stereo_8_center)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_center(mixer_data, channel_info, channel_block, buf, get_curr_sample_8, get_sample_1_8, 1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_8(channel_info, channel_block, *offset);
@@ -4869,7 +4950,7 @@ MIX(stereo_8_center)
 
 MIX(stereo_backwards_8_center)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_center(mixer_data, channel_info, channel_block, buf, get_curr_sample_8, get_backwards_sample_1_8, -1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_8(channel_info, channel_block, *offset);
@@ -4879,7 +4960,7 @@ MIX(stereo_backwards_8_center)
 
 MIX(stereo_16_to_8_center)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_center(mixer_data, channel_info, channel_block, buf, get_curr_sample_16_to_8, get_sample_1_16_to_8, 1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_16_to_8(channel_info, channel_block, *offset);
@@ -4889,7 +4970,7 @@ MIX(stereo_16_to_8_center)
 
 MIX(stereo_backwards_16_to_8_center)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_center(mixer_data, channel_info, channel_block, buf, get_curr_sample_16_to_8, get_backwards_sample_1_16_to_8, -1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_16_to_8(channel_info, channel_block, *offset);
@@ -4899,7 +4980,7 @@ MIX(stereo_backwards_16_to_8_center)
 
 MIX(stereo_32_to_8_center)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_center(mixer_data, channel_info, channel_block, buf, get_curr_sample_32_to_8, get_sample_1_32_to_8, 1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_32_to_8(channel_info, channel_block, *offset);
@@ -4909,7 +4990,7 @@ MIX(stereo_32_to_8_center)
 
 MIX(stereo_backwards_32_to_8_center)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_center(mixer_data, channel_info, channel_block, buf, get_curr_sample_32_to_8, get_backwards_sample_1_32_to_8, -1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_32_to_8(channel_info, channel_block, *offset);
@@ -4919,7 +5000,7 @@ MIX(stereo_backwards_32_to_8_center)
 
 MIX(stereo_x_to_8_center)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_center(mixer_data, channel_info, channel_block, buf, get_curr_sample_x_to_8, get_sample_1_x_to_8, 1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_x_to_8(channel_info, channel_block, *offset);
@@ -4929,7 +5010,7 @@ MIX(stereo_x_to_8_center)
 
 MIX(stereo_backwards_x_to_8_center)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_center(mixer_data, channel_info, channel_block, buf, get_curr_sample_x_to_8, get_backwards_sample_1_x_to_8, -1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_x_to_8(channel_info, channel_block, *offset);
@@ -4939,7 +5020,7 @@ MIX(stereo_backwards_x_to_8_center)
 
 MIX(stereo_16_center)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_center(mixer_data, channel_info, channel_block, buf, get_curr_sample_16, get_sample_1_16, 1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_16(channel_info, channel_block, *offset);
@@ -4949,7 +5030,7 @@ MIX(stereo_16_center)
 
 MIX(stereo_backwards_16_center)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_center(mixer_data, channel_info, channel_block, buf, get_curr_sample_16, get_backwards_sample_1_16, -1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_16(channel_info, channel_block, *offset);
@@ -4959,7 +5040,7 @@ MIX(stereo_backwards_16_center)
 
 MIX(stereo_32_center)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_center(mixer_data, channel_info, channel_block, buf, get_curr_sample_32, get_sample_1_32, 1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_32(channel_info, channel_block, *offset);
@@ -4969,7 +5050,7 @@ MIX(stereo_32_center)
 
 MIX(stereo_backwards_32_center)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_center(mixer_data, channel_info, channel_block, buf, get_curr_sample_32, get_backwards_sample_1_32, -1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_32(channel_info, channel_block, *offset);
@@ -4979,7 +5060,7 @@ MIX(stereo_backwards_32_center)
 
 MIX(stereo_x_center)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_center(mixer_data, channel_info, channel_block, buf, get_curr_sample_x, get_sample_1_x, 1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_x(channel_info, channel_block, *offset);
@@ -4989,7 +5070,7 @@ MIX(stereo_x_center)
 
 MIX(stereo_backwards_x_center)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_center(mixer_data, channel_info, channel_block, buf, get_curr_sample_x, get_backwards_sample_1_x, -1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_x(channel_info, channel_block, *offset);
@@ -5016,38 +5097,39 @@ static void mix_surround_loop(const AV_HQMixerData *const mixer_data,
     uint32_t curr_offset = *offset;
     uint32_t curr_frac   = *fraction;
     uint32_t i           = len;
-    int32_t smp;
+    int32_t prev_buf[MIXER_DSP_BLOCK_SIZE], curr_buf[MIXER_DSP_BLOCK_SIZE];
+    int32_t next_buf[MIXER_DSP_BLOCK_SIZE], smp_buf[MIXER_DSP_BLOCK_SIZE];
+    uint32_t frac_buf[MIXER_DSP_BLOCK_SIZE];
 
     get_next_sample_func(mixer_data, channel_info, channel_block, curr_offset);
 
     do {
-        int64_t interpolate_frac = -((int64_t) channel_info->prev_sample - (int64_t) channel_info->curr_sample);
-        int64_t interpolate_div  = ((int64_t) channel_info->next_sample - ((int64_t) channel_info->curr_sample + interpolate_frac)) >> 2;
-        int32_t smp_value;
-
-        smp               = (uint32_t) curr_frac >> 1;
-        interpolate_div   = ((int64_t) smp * interpolate_div) >> 32;
-        interpolate_div   = ((interpolate_div << 2) + interpolate_frac) >> 2;
-        interpolate_div   = ((int64_t) smp * interpolate_div) >> 32;
-        interpolate_div <<= 3;
-        smp_value         = ((int64_t) channel_info->prev_sample + (int64_t) channel_info->curr_sample) >> 1;
-        smp               = (uint32_t) smp_value + (uint32_t) interpolate_div;
-
-        if (((smp_value ^ smp) & (interpolate_div ^ smp)) < 0)
-            smp = channel_info->curr_sample;
-
-        *mix_buf++ += smp;
-        *mix_buf++ += ~smp;
-        curr_frac  += adv_frac;
-
-        if (curr_frac < adv_frac) {
-            curr_offset              += offset_inc;
-            channel_info->prev_sample = channel_info->curr_sample;
-            channel_info->curr_sample = channel_info->next_sample;
-
-            get_next_sample_func(mixer_data, channel_info, channel_block, curr_offset);
+        const uint32_t block_len = (i > MIXER_DSP_BLOCK_SIZE) ? MIXER_DSP_BLOCK_SIZE : i;
+        uint32_t j;
+
+        for (j = 0; j < block_len; j++) {
+            prev_buf[j] = channel_info->prev_sample;
+            curr_buf[j] = channel_info->curr_sample;
+            next_buf[j] = channel_info->next_sample;
+            frac_buf[j] = curr_frac;
+            curr_frac  += adv_frac;
+
+            if (curr_frac < adv_frac) {
+                curr_offset              += offset_inc;
+                channel_info->prev_sample = channel_info->curr_sample;
+                channel_info->curr_sample = channel_info->next_sample;
+
+                get_next_sample_func(mixer_data, channel_info, channel_block, curr_offset);
+            }
         }
-    } while (--i);
+
+        mixer_data->dsp.interpolate(smp_buf, prev_buf, curr_buf, next_buf, frac_buf, block_len);
+        filter_block(mixer_data, channel_info, channel_block, smp_buf, block_len);
+        mixer_data->dsp.add_surround(mix_buf, smp_buf, block_len);
+
+        mix_buf += block_len << 1;
+        i       -= block_len;
+    } while (i);
 
     *buf      = mix_buf;
     *offset   = curr_offset;
@@ -5076,36 +5158,51 @@ static void mix_average_surround(const AV_HQMixerData *const mixer_data,
     uint32_t curr_offset = *offset;
     uint32_t curr_frac   = *fraction;
     uint32_t i           = len;
+    int32_t smp_buf[MIXER_DSP_BLOCK_SIZE];
+
+    if ((mixer_data->interpolation == HQ_INTERPOLATION_SINC) && (advance < SINC_MAX_ADVANCE)) {
+        mix_sinc(mixer_data, channel_info, channel_block, buf, get_sample_func, mixer_data->dsp.add_surround, 1, offset_inc, offset, fraction, advance, adv_frac, len);
+        return;
+    }
 
     do {
-        int32_t smp                = get_curr_sample_func(channel_info, channel_block, curr_offset);
-        int64_t interpolate_div    = ((int64_t) ((uint32_t) ~curr_frac >> 1) * smp) >> 31;
-        int64_t interpolate_frac   = (uint32_t) ~curr_frac;
-        uint32_t interpolate_count = advance - 1;
+        const uint32_t block_len = (i > MIXER_DSP_BLOCK_SIZE) ? MIXER_DSP_BLOCK_SIZE : i;
+        uint32_t j               = 0;
 
-        curr_offset += offset_inc;
+        do {
+            int32_t smp                = get_curr_sample_func(channel_info, channel_block, curr_offset);
+            int64_t interpolate_div    = ((int64_t) ((uint32_t) ~curr_frac >> 1) * smp) >> 31;
+            int64_t interpolate_frac   = (uint32_t) ~curr_frac;
+            uint32_t interpolate_count = advance - 1;
 
-        while (interpolate_count--) {
-            interpolate_frac += INT64_C(0x100000000);
-            interpolate_div  += get_sample_func(mixer_data, channel_info, channel_block, curr_offset);
-            curr_offset      += offset_inc;
-        }
+            curr_offset += offset_inc;
 
-        curr_frac += adv_frac;
+            while (interpolate_count--) {
+                interpolate_frac += INT64_C(0x100000000);
+                interpolate_div  += get_sample_func(mixer_data, channel_info, channel_block, curr_offset);
+                curr_offset      += offset_inc;
+            }
 
-        if (curr_frac < adv_frac) {
-            interpolate_frac += INT64_C(0x100000000);
-            interpolate_div  += get_sample_func(mixer_data, channel_info, channel_block, curr_offset);
-            curr_offset      += offset_inc;
-        }
+            curr_frac += adv_frac;
 
-        smp               = get_sample_func(mixer_data, channel_info, channel_block, curr_offset);
-        interpolate_frac += curr_frac;
-        interpolate_div  += (((int64_t) ((uint32_t) curr_frac >> 1) * smp) >> 31);
-        smp               = (interpolate_div << 24) / (interpolate_frac >> 8);
-        *mix_buf++       += smp;
-        *mix_buf++       += ~smp;
-    } while (--i);
+            if (curr_frac < adv_frac) {
+                interpolate_frac += INT64_C(0x100000000);
+                interpolate_div  += get_sample_func(mixer_data, channel_info, channel_block, curr_offset);
+                curr_offset      += offset_inc;
+            }
+
+            smp               = get_sample_func(mixer_data, channel_info, channel_block, curr_offset);
+            interpolate_frac += curr_frac;
+            interpolate_div  += (((int64_t) ((uint32_t) curr_frac >> 1) * smp) >> 31);
+            smp_buf[j]        = (interpolate_div << 24) / (interpolate_frac >> 8);
+        } while (++j < block_len);
+
+        filter_block(mixer_data, channel_info, channel_block, smp_buf, block_len);
+        mixer_data->dsp.add_surround(mix_buf, smp_buf, block_len);
+
+        mix_buf += block_len << 1;
+        i       -= block_len;
+    } while (i);
 
     *buf      = mix_buf;
     *offset   = curr_offset;
@@ -5114,7 +5211,7 @@ static void mix_average_surround(const AV_HQMixerData *const mixer_data,
 
 MIX(stereo_8_surround)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_surround(mixer_data, channel_info, channel_block, buf, get_curr_sample_8, get_sample_1_8, 1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_8(channel_info, channel_block, *offset);
@@ -5124,7 +5221,7 @@ MIX(stereo_8_surround)
 
 MIX(stereo_backwards_8_surround)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_surround(mixer_data, channel_info, channel_block, buf, get_curr_sample_8, get_backwards_sample_1_8, -1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_8(channel_info, channel_block, *offset);
@@ -5134,7 +5231,7 @@ MIX(stereo_backwards_8_surround)
 
 MIX(stereo_16_to_8_surround)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_surround(mixer_data, channel_info, channel_block, buf, get_curr_sample_16_to_8, get_sample_1_16_to_8, 1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_16_to_8(channel_info, channel_block, *offset);
@@ -5144,7 +5241,7 @@ MIX(stereo_16_to_8_surround)
 
 MIX(stereo_backwards_16_to_8_surround)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_surround(mixer_data, channel_info, channel_block, buf, get_curr_sample_16_to_8, get_backwards_sample_1_16_to_8, -1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_16_to_8(channel_info, channel_block, *offset);
@@ -5154,7 +5251,7 @@ MIX(stereo_backwards_16_to_8_surround)
 
 MIX(stereo_32_to_8_surround)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_surround(mixer_data, channel_info, channel_block, buf, get_curr_sample_32_to_8, get_sample_1_32_to_8, 1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_32_to_8(channel_info, channel_block, *offset);
@@ -5164,7 +5261,7 @@ MIX(stereo_32_to_8_surround)
 
 MIX(stereo_backwards_32_to_8_surround)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_surround(mixer_data, channel_info, channel_block, buf, get_curr_sample_32_to_8, get_backwards_sample_1_32_to_8, -1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_32_to_8(channel_info, channel_block, *offset);
@@ -5174,7 +5271,7 @@ MIX(stereo_backwards_32_to_8_surround)
 
 MIX(stereo_x_to_8_surround)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_surround(mixer_data, channel_info, channel_block, buf, get_curr_sample_x_to_8, get_sample_1_x_to_8, 1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_x_to_8(channel_info, channel_block, *offset);
@@ -5184,7 +5281,7 @@ MIX(stereo_x_to_8_surround)
 
 MIX(stereo_backwards_x_to_8_surround)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_surround(mixer_data, channel_info, channel_block, buf, get_curr_sample_x_to_8, get_backwards_sample_1_x_to_8, -1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_x_to_8(channel_info, channel_block, *offset);
@@ -5194,7 +5291,7 @@ MIX(stereo_backwards_x_to_8_surround)
 
 MIX(stereo_16_surround)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_surround(mixer_data, channel_info, channel_block, buf, get_curr_sample_16, get_sample_1_16, 1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_16(channel_info, channel_block, *offset);
@@ -5204,7 +5301,7 @@ MIX(stereo_16_surround)
 
 MIX(stereo_backwards_16_surround)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_surround(mixer_data, channel_info, channel_block, buf, get_curr_sample_16, get_backwards_sample_1_16, -1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_16(channel_info, channel_block, *offset);
@@ -5214,7 +5311,7 @@ MIX(stereo_backwards_16_surround)
 
 MIX(stereo_32_surround)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_surround(mixer_data, channel_info, channel_block, buf, get_curr_sample_32, get_sample_1_32, 1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_32(channel_info, channel_block, *offset);
@@ -5224,7 +5321,7 @@ MIX(stereo_32_surround)
 
 MIX(stereo_backwards_32_surround)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_surround(mixer_data, channel_info, channel_block, buf, get_curr_sample_32, get_backwards_sample_1_32, -1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_32(channel_info, channel_block, *offset);
@@ -5234,7 +5331,7 @@ MIX(stereo_backwards_32_surround)
 
 MIX(stereo_x_surround)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_surround(mixer_data, channel_info, channel_block, buf, get_curr_sample_x, get_sample_1_x, 1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_x(channel_info, channel_block, *offset);
@@ -5244,7 +5341,7 @@ MIX(stereo_x_surround)
 
 MIX(stereo_backwards_x_surround)
 {
-    if (advance) {
+    if (advance || (mixer_data->interpolation == HQ_INTERPOLATION_SINC)) {
         mix_average_surround(mixer_data, channel_info, channel_block, buf, get_curr_sample_x, get_backwards_sample_1_x, -1, offset, fraction, advance, adv_frac, len);
    } else {
         channel_info->curr_sample = get_curr_sample_x(channel_info, channel_block, *offset);
@@ -6469,8 +6566,10 @@ static void update_sample_filter(const AV_HQMixerData *const mixer_data,
         channel_block->filter_c1  = 16777216;
         channel_block->filter_c2  = 0;
         channel_block->filter_c3  = 0;
-        channel_info->filter_tmp1 = 0;
-        channel_info->filter_tmp2 = 0;
+        channel_info->filter_tmp1   = 0;
+        channel_info->filter_tmp2   = 0;
+        channel_info->filter_tmp1_r = 0;
+        channel_info->filter_tmp2_r = 0;
 
         return;
     }
@@ -6519,6 +6618,79 @@ static void set_sample_filter(const AV_HQMixerData *const mixer_data,
     update_sample_filter(mixer_data, channel_info, channel_block);
 }
 
+/** Zeroth order modified Bessel function of the first kind used
+   for the Kaiser window.  */
+static av_cold double bessel_i0(const double x)
+{
+    double v = 1.0, lastv = 0.0, t = 1.0;
+    int i;
+
+    for (i = 1; v != lastv; i++) {
+        lastv = v;
+        t    *= (x / (2 * i)) * (x / (2 * i));
+        v    += t;
+    }
+
+    return v;
+}
+
+/** Build the Kaiser windowed sinc kernels of all advance ratios,
+   each phase is normalized to unity gain in 1.14 fixed point.  */
+static av_cold int init_sinc_kernels(AV_HQMixerData *const mixer_data)
+{
+    static const double beta = 7.0;
+    const double beta_div    = bessel_i0(beta);
+    uint32_t size = 0, ratio_index, phase, tap;
+    int16_t *kernel;
+
+    for (ratio_index = 0; ratio_index < SINC_RATIOS; ratio_index++)
+        size += sinc_taps_lut[ratio_index] * SINC_PHASES;
+
+    if (!(kernel = av_malloc((size * sizeof(int16_t)) + FF_INPUT_BUFFER_PADDING_SIZE)))
+        return AVERROR(ENOMEM);
+
+    mixer_data->sinc_lut = kernel;
+
+    for (ratio_index = 0; ratio_index < SINC_RATIOS; ratio_index++) {
+        const uint32_t taps  = sinc_taps_lut[ratio_index];
+        const int32_t half   = taps >> 1;
+        const double cutoff  = 0.95 * 65536.0 / sinc_ratio_lut[ratio_index];
+
+        mixer_data->sinc_kernel[ratio_index] = kernel;
+
+        for (phase = 0; phase < SINC_PHASES; phase++) {
+            const double frac = (double) phase / SINC_PHASES;
+            double coeff[SINC_MAX_TAPS], sum = 0.0;
+            int32_t total = 0, max_tap = 0;
+
+            for (tap = 0; tap < taps; tap++) {
+                const double x = ((int32_t) tap - half + 1) - frac;
+                const double w = x / half;
+                double c       = cutoff;
+
+                if (x != 0.0)
+                    c = sin(M_PI * cutoff * x) / (M_PI * x);
+
+                coeff[tap] = (w * w < 1.0) ? c * bessel_i0(beta * sqrt(1.0 - w * w)) / beta_div : 0.0;
+                sum       += coeff[tap];
+            }
+
+            for (tap = 0; tap < taps; tap++) {
+                kernel[tap] = lrint(coeff[tap] * 16384.0 / sum);
+                total      += kernel[tap];
+
+                if (kernel[tap] > kernel[max_tap])
+                    max_tap = tap;
+            }
+
+            kernel[max_tap] += 16384 - total;
+            kernel          += taps;
+        }
+    }
+
+    return 0;
+}
+
 static av_cold AVMixerData *init(AVMixerContext *const mixctx,
                                  const char *args, void *opaque)
 {
@@ -6527,7 +6699,7 @@ static av_cold AVMixerData *init(AVMixerContext *const mixctx,
     const char *cfg_buf;
     uint16_t i;
     int32_t *buf;
-    unsigned real16bit = 1, buf_size;
+    unsigned interpolation = 0, real16bit = 1, bitexact = 0, buf_size;
     uint32_t mix_buf_mem_size, channel_rate;
     uint16_t channels_in = 1, channels_out = 1;
 
@@ -6550,11 +6722,21 @@ static av_cold AVMixerData *init(AVMixerContext *const mixctx,
     if ((cfg_buf = av_stristr(args, "buffer=")))
         sscanf(cfg_buf, "buffer=%d;", &buf_size);
 
+    if (av_stristr(args, "interpolation=sinc;"))
+        interpolation = HQ_INTERPOLATION_SINC;
+    else if ((cfg_buf = av_stristr(args, "interpolation=")))
+        sscanf(cfg_buf, "interpolation=%d;", &interpolation);
+
     if (av_stristr(args, "real16bit=false;") || av_stristr(args, "real16bit=disabled;"))
         real16bit = 0;
     else if ((cfg_buf = av_stristr(args, "real16bit=;")))
         sscanf(cfg_buf, "real16bit=%d;", &real16bit);
 
+    if (av_stristr(args, "bitexact=true;") || av_stristr(args, "bitexact=enabled;"))
+        bitexact = 1;
+    else if ((cfg_buf = av_stristr(args, "bitexact=")))
+        sscanf(cfg_buf, "bitexact=%d;", &bitexact);
+
     if (!(channel_info = av_mallocz((channels_in * sizeof(AV_HQMixerChannelInfo)) + FF_INPUT_BUFFER_PADDING_SIZE))) {
         av_log(mixctx, AV_LOG_ERROR, "Cannot allocate mixer channel data.\n");
         av_freep(&hq_mixer_data->volume_lut);
@@ -6563,6 +6745,15 @@ static av_cold AVMixerData *init(AVMixerContext *const mixctx,
         return NULL;
     }
 
+    if (!(hq_mixer_data->active_list = av_malloc((channels_in * sizeof(uint16_t)) + FF_INPUT_BUFFER_PADDING_SIZE))) {
+        av_log(mixctx, AV_LOG_ERROR, "Cannot allocate mixer active channel list.\n");
+        av_free(channel_info);
+        av_freep(&hq_mixer_data->volume_lut);
+        av_free(hq_mixer_data);
+
+        return NULL;
+    }
+
     hq_mixer_data->channel_info            = channel_info;
     hq_mixer_data->mixer_data.channels_in  = channels_in;
     hq_mixer_data->channels_in             = channels_in;
@@ -6571,6 +6762,7 @@ static av_cold AVMixerData *init(AVMixerContext *const mixctx,
 
     if (!(buf = av_mallocz(mix_buf_mem_size + FF_INPUT_BUFFER_PADDING_SIZE))) {
         av_log(mixctx, AV_LOG_ERROR, "Cannot allocate mixer output buffer.\n");
+        av_freep(&hq_mixer_data->active_list);
         av_freep(&hq_mixer_data->channel_info);
         av_freep(&hq_mixer_data->volume_lut);
         av_free(hq_mixer_data);
@@ -6587,10 +6779,12 @@ static av_cold AVMixerData *init(AVMixerContext *const mixctx,
     hq_mixer_data->mixer_data.rate         = channel_rate;
     hq_mixer_data->mix_rate                = channel_rate;
     hq_mixer_data->real_16_bit_mode        = real16bit ? 1 : 0;
+    hq_mixer_data->interpolation           = interpolation >= HQ_INTERPOLATION_SINC ? HQ_INTERPOLATION_SINC : interpolation;
 
-    if (!(buf = av_mallocz(mix_buf_mem_size + FF_INPUT_BUFFER_PADDING_SIZE))) {
-        av_log(mixctx, AV_LOG_ERROR, "Cannot allocate mixer (resonance) filter output buffer.\n");
+    if ((hq_mixer_data->interpolation == HQ_INTERPOLATION_SINC) && init_sinc_kernels(hq_mixer_data) < 0) {
+        av_log(mixctx, AV_LOG_ERROR, "Cannot allocate mixer sinc kernel lookup table.\n");
         av_freep(&hq_mixer_data->buf);
+        av_freep(&hq_mixer_data->active_list);
         av_freep(&hq_mixer_data->channel_info);
         av_freep(&hq_mixer_data->volume_lut);
         av_free(hq_mixer_data);
@@ -6598,7 +6792,7 @@ static av_cold AVMixerData *init(AVMixerContext *const mixctx,
         return NULL;
     }
 
-    hq_mixer_data->filter_buf = buf;
+    ff_mixer_dsp_init(&hq_mixer_data->dsp, bitexact);
 
     for (i = hq_mixer_data->channels_in; i > 0; i--) {
         set_sample_filter(hq_mixer_data, channel_info, &channel_info->current, 4095, 0);
@@ -6617,10 +6811,13 @@ static av_cold int uninit(AVMixerData *const mixer_data)
     if (!hq_mixer_data)
         return AVERROR_INVALIDDATA;
 
+    av_freep(&hq_mixer_data->active_list);
     av_freep(&hq_mixer_data->channel_info);
     av_freep(&hq_mixer_data->volume_lut);
     av_freep(&hq_mixer_data->buf);
-    av_freep(&hq_mixer_data->filter_buf);
+    av_freep(&hq_mixer_data->thread_buf);
+    av_freep(&hq_mixer_data->mixer_data.stem_buf);
+    av_freep(&hq_mixer_data->sinc_lut);
     av_free(hq_mixer_data);
 
     return 0;
@@ -6654,16 +6851,11 @@ static av_cold uint32_t set_rate(AVMixerData *const mixer_data,
 
     if ((hq_mixer_data->buf_size * hq_mixer_data->channels_out) != (buf_size * channels)) {
         int32_t *buf                    = hq_mixer_data->mixer_data.mix_buf;
-        int32_t *filter_buf             = hq_mixer_data->filter_buf;
         const uint32_t mix_buf_mem_size = (buf_size * channels) << 2;
 
         if (!(buf = av_realloc(buf, mix_buf_mem_size + FF_INPUT_BUFFER_PADDING_SIZE))) {
             av_log(hq_mixer_data->mixer_data.mixctx, AV_LOG_ERROR, "Cannot allocate mixer output buffer.\n");
 
-            return hq_mixer_data->mixer_data.rate;
-        } else if (!(filter_buf = av_realloc(filter_buf, mix_buf_mem_size + FF_INPUT_BUFFER_PADDING_SIZE))) {
-            av_log(hq_mixer_data->mixer_data.mixctx, AV_LOG_ERROR, "Cannot allocate mixer (resonance) filter output buffer.\n");
-
             return hq_mixer_data->mixer_data.rate;
         }
 
@@ -6671,7 +6863,6 @@ static av_cold uint32_t set_rate(AVMixerData *const mixer_data,
 
         hq_mixer_data->mixer_data.mix_buf      = buf;
         hq_mixer_data->mixer_data.mix_buf_size = buf_size;
-        hq_mixer_data->filter_buf              = filter_buf;
     }
 
     hq_mixer_data->channels_out = channels;
@@ -6728,6 +6919,19 @@ static av_cold uint32_t set_volume(AVMixerData *const mixer_data,
         return old_channels;
     }
 
+    if (channel_info) {
+        uint16_t *const active_list = av_realloc(hq_mixer_data->active_list, (channels * sizeof(uint16_t)) + FF_INPUT_BUFFER_PADDING_SIZE);
+
+        if (!active_list) {
+            av_log(hq_mixer_data->mixer_data.mixctx, AV_LOG_ERROR, "Cannot allocate mixer active channel list.\n");
+            av_free(channel_info);
+
+            return old_channels;
+        }
+
+        hq_mixer_data->active_list = active_list;
+    }
+
     hq_mixer_data->mixer_data.volume_boost = amplify;
     hq_mixer_data->mixer_data.volume_left  = left_volume;
     hq_mixer_data->mixer_data.volume_right = right_volume;
@@ -6774,6 +6978,7 @@ static av_cold uint32_t set_volume(AVMixerData *const mixer_data,
         }
 
         av_free(old_channel_info);
+        init_active_list(hq_mixer_data);
     }
 
     channel_info = hq_mixer_data->channel_info;
@@ -6787,6 +6992,14 @@ static av_cold uint32_t set_volume(AVMixerData *const mixer_data,
     return channels;
 }
 
+static av_cold uint32_t set_stems(AVMixerData *const mixer_data,
+                                  const uint32_t stems)
+{
+    mixer_data->stems = FFMIN(stems, HQ_MAX_STEMS);
+
+    return mixer_data->stems;
+}
+
 static av_cold void get_channel(const AVMixerData *const mixer_data,
                                 AVMixerChannel *const mixer_channel,
                                 const uint32_t channel)
@@ -6809,18 +7022,20 @@ static av_cold void get_channel(const AVMixerData *const mixer_data,
     mixer_channel->rate            = channel_info->current.rate;
     mixer_channel->filter_cutoff   = channel_info->current.filter_cutoff;
     mixer_channel->filter_damping  = channel_info->current.filter_damping;
+    mixer_channel->stem            = channel_info->stem;
 }
 
 static av_cold void set_channel(AVMixerData *const mixer_data,
                                 const AVMixerChannel *const mixer_channel,
                                 const uint32_t channel)
 {
-    const AV_HQMixerData *const hq_mixer_data = (const AV_HQMixerData *const) mixer_data;
+    AV_HQMixerData *const hq_mixer_data       = (AV_HQMixerData *const) mixer_data;
     AV_HQMixerChannelInfo *const channel_info = hq_mixer_data->channel_info + channel;
     struct ChannelBlock *channel_block;
     uint32_t repeat, repeat_len;
 
     channel_info->next.data = NULL;
+    channel_info->stem      = mixer_channel->stem;
 
     if (mixer_channel->flags & AVSEQ_MIXER_CHANNEL_FLAG_SYNTH)
         channel_block = &channel_info->next;
@@ -6862,6 +7077,8 @@ static av_cold void set_channel(AVMixerData *const mixer_data,
 
     set_sample_mix_rate(hq_mixer_data, channel_block, channel_block->rate);
     set_sample_filter(hq_mixer_data, channel_info, channel_block, mixer_channel->filter_cutoff, mixer_channel->filter_damping);
+
+    activate_channel(hq_mixer_data, channel_info);
 }
 
 static av_cold void reset_channel(AVMixerData *const mixer_data,
@@ -6912,6 +7129,8 @@ static av_cold void reset_channel(AVMixerData *const mixer_data,
     channel_info->prev_sample_r     = 0;
     channel_info->curr_sample_r     = 0;
     channel_info->next_sample_r     = 0;
+    memset(channel_info->sinc_hist, 0, sizeof(channel_info->sinc_hist));
+    memset(channel_info->sinc_hist_r, 0, sizeof(channel_info->sinc_hist_r));
 
     set_sample_mix_rate(hq_mixer_data, channel_block, channel_block->rate);
     set_sample_filter(hq_mixer_data, channel_info, channel_block, 4095, 0);
@@ -6940,6 +7159,7 @@ static av_cold void get_both_channels(const AVMixerData *const mixer_data,
     mixer_channel_current->rate            = channel_info->current.rate;
     mixer_channel_current->filter_cutoff   = channel_info->current.filter_cutoff;
     mixer_channel_current->filter_damping  = channel_info->current.filter_damping;
+    mixer_channel_current->stem            = channel_info->stem;
 
     mixer_channel_next->pos             = channel_info->next.offset;
     mixer_channel_next->pos_one_shoot   = channel_info->next.offset_one_shoot;
@@ -6956,6 +7176,7 @@ static av_cold void get_both_channels(const AVMixerData *const mixer_data,
     mixer_channel_next->rate            = channel_info->next.rate;
     mixer_channel_next->filter_cutoff   = channel_info->next.filter_cutoff;
     mixer_channel_next->filter_damping  = channel_info->next.filter_damping;
+    mixer_channel_next->stem            = channel_info->stem;
 }
 
 static av_cold void set_both_channels(AVMixerData *const mixer_data,
@@ -6963,7 +7184,7 @@ static av_cold void set_both_channels(AVMixerData *const mixer_data,
                                       const AVMixerChannel *const mixer_channel_next,
                                       const uint32_t channel)
 {
-    const AV_HQMixerData *const hq_mixer_data = (const AV_HQMixerData *const) mixer_data;
+    AV_HQMixerData *const hq_mixer_data       = (AV_HQMixerData *const) mixer_data;
     AV_HQMixerChannelInfo *const channel_info = hq_mixer_data->channel_info + channel;
     struct ChannelBlock *channel_block        = &channel_info->current;
     uint32_t repeat, repeat_len;
@@ -6977,6 +7198,7 @@ static av_cold void set_both_channels(AVMixerData *const mixer_data,
     channel_block->panning          = mixer_channel_current->panning;
     channel_block->data             = mixer_channel_current->data;
     channel_block->len              = mixer_channel_current->len;
+    channel_info->stem              = mixer_channel_current->stem;
     repeat                          = mixer_channel_current->repeat_start;
     repeat_len                      = mixer_channel_current->repeat_length;
     channel_block->repeat           = repeat;
@@ -7039,15 +7261,21 @@ static av_cold void set_both_channels(AVMixerData *const mixer_data,
     channel_block->counted        = mixer_channel_next->repeat_counted;
     channel_info->filter_tmp1     = 0;
     channel_info->filter_tmp2     = 0;
+    channel_info->filter_tmp1_r   = 0;
+    channel_info->filter_tmp2_r   = 0;
     channel_info->prev_sample     = 0;
     channel_info->curr_sample     = 0;
     channel_info->next_sample     = 0;
     channel_info->prev_sample_r   = 0;
     channel_info->curr_sample_r   = 0;
     channel_info->next_sample_r   = 0;
+    memset(channel_info->sinc_hist, 0, sizeof(channel_info->sinc_hist));
+    memset(channel_info->sinc_hist_r, 0, sizeof(channel_info->sinc_hist_r));
 
     set_sample_mix_rate(hq_mixer_data, channel_block, channel_block->rate);
     set_sample_filter(hq_mixer_data, channel_info, channel_block, mixer_channel_next->filter_cutoff, mixer_channel_next->filter_damping);
+
+    activate_channel(hq_mixer_data, channel_info);
 }
 
 static av_cold void set_channel_volume_panning_pitch(AVMixerData *const mixer_data,
@@ -7097,7 +7325,7 @@ static av_cold void set_channel_position_repeat_flags(AVMixerData *const mixer_d
                                                       const AVMixerChannel *const mixer_channel,
                                                       const uint32_t channel)
 {
-    const AV_HQMixerData *const hq_mixer_data = (const AV_HQMixerData *const) mixer_data;
+    AV_HQMixerData *const hq_mixer_data       = (AV_HQMixerData *const) mixer_data;
     AV_HQMixerChannelInfo *const channel_info = hq_mixer_data->channel_info + channel;
 
     if (channel_info->current.flags == mixer_channel->flags) {
@@ -7170,6 +7398,8 @@ static av_cold void set_channel_position_repeat_flags(AVMixerData *const mixer_d
 
         set_mix_functions(hq_mixer_data, &channel_info->current);
     }
+
+    activate_channel(hq_mixer_data, channel_info);
 }
 
 static av_cold void set_channel_filter(AVMixerData *const mixer_data,
@@ -7189,6 +7419,7 @@ static av_cold void mix(AVMixerData *const mixer_data, int32_t *buf) {
         uint32_t current_left      = hq_mixer_data->current_left;
         uint32_t current_left_frac = hq_mixer_data->current_left_frac;
         uint32_t buf_size          = hq_mixer_data->buf_size;
+        const int stems            = init_stem_buf(hq_mixer_data, buf_size);
 
         memset(buf, 0, buf_size << ((hq_mixer_data->channels_out >= 2) ? 3 : 2));
 
@@ -7199,7 +7430,10 @@ static av_cold void mix(AVMixerData *const mixer_data, int32_t *buf) {
                 current_left -= mix_len;
                 buf_size     -= mix_len;
 
-                mix_sample(hq_mixer_data, buf, mix_len);
+                if (!stems && (hq_mixer_data->mixer_data.thread_count > 1) && hq_mixer_data->mixer_data.execute)
+                    mix_sample_threaded(hq_mixer_data, buf, mix_len);
+                else
+                    mix_sample(hq_mixer_data, buf, mix_len);
 
                 buf += (hq_mixer_data->channels_out >= 2) ? mix_len << 1 : mix_len;
             }
@@ -7217,8 +7451,6 @@ static av_cold void mix(AVMixerData *const mixer_data, int32_t *buf) {
         hq_mixer_data->current_left      = current_left;
         hq_mixer_data->current_left_frac = current_left_frac;
     }
-
-    // TODO: Execute post-processing step in libavfilter and pass the PCM data.
 }
 
 static av_cold void mix_parallel(AVMixerData *const mixer_data,
@@ -7232,6 +7464,8 @@ static av_cold void mix_parallel(AVMixerData *const mixer_data,
         uint32_t current_left_frac = hq_mixer_data->current_left_frac;
         uint32_t buf_size          = hq_mixer_data->buf_size;
 
+        hq_mixer_data->mixer_data.stem_stride = 0;
+
         memset(buf, 0, buf_size << ((hq_mixer_data->channels_out >= 2) ? 3 : 2));
 
         while (buf_size) {
@@ -7259,8 +7493,73 @@ static av_cold void mix_parallel(AVMixerData *const mixer_data,
         hq_mixer_data->current_left      = current_left;
         hq_mixer_data->current_left_frac = current_left_frac;
     }
+}
+
+static av_cold uint32_t mix_tick(AVMixerData *const mixer_data,
+                                 int32_t *buf,
+                                 const uint32_t len)
+{
+    AV_HQMixerData *const hq_mixer_data = (AV_HQMixerData *const) mixer_data;
+    uint32_t current_left               = hq_mixer_data->current_left;
+    uint32_t current_left_frac          = hq_mixer_data->current_left_frac;
+    uint32_t mix_len;
+
+    if (!current_left) {
+        if (mixer_data->handler)
+            mixer_data->handler(mixer_data);
+
+        current_left_frac += hq_mixer_data->pass_len_frac;
+        current_left       = hq_mixer_data->pass_len + (current_left_frac < hq_mixer_data->pass_len_frac);
+    }
+
+    mix_len       = (len > current_left) ? current_left : len;
+    current_left -= mix_len;
+
+    if (mix_len) {
+        const int stems = init_stem_buf(hq_mixer_data, mix_len);
+
+        memset(buf, 0, mix_len << ((hq_mixer_data->channels_out >= 2) ? 3 : 2));
+
+        if (!stems && (hq_mixer_data->mixer_data.thread_count > 1) && hq_mixer_data->mixer_data.execute)
+            mix_sample_threaded(hq_mixer_data, buf, mix_len);
+        else
+            mix_sample(hq_mixer_data, buf, mix_len);
+    } else {
+        hq_mixer_data->mixer_data.stem_stride = 0;
+    }
+
+    if (!current_left) {
+        if (mixer_data->handler)
+            mixer_data->handler(mixer_data);
+
+        current_left_frac += hq_mixer_data->pass_len_frac;
+        current_left       = hq_mixer_data->pass_len + (current_left_frac < hq_mixer_data->pass_len_frac);
+    }
+
+    hq_mixer_data->current_left      = current_left;
+    hq_mixer_data->current_left_frac = current_left_frac;
+
+    return mix_len;
+}
+
+static av_cold void get_tick_phase(const AVMixerData *const mixer_data,
+                                   uint32_t *const left,
+                                   uint32_t *const left_frac)
+{
+    const AV_HQMixerData *const hq_mixer_data = (const AV_HQMixerData *const) mixer_data;
+
+    *left      = hq_mixer_data->current_left;
+    *left_frac = hq_mixer_data->current_left_frac;
+}
+
+static av_cold void set_tick_phase(AVMixerData *const mixer_data,
+                                   const uint32_t left,
+                                   const uint32_t left_frac)
+{
+    AV_HQMixerData *const hq_mixer_data = (AV_HQMixerData *const) mixer_data;
 
-    // TODO: Execute post-processing step in libavfilter and pass the PCM data.
+    hq_mixer_data->current_left      = left;
+    hq_mixer_data->current_left_frac = left_frac;
 }
 
 AVMixerContext high_quality_mixer = {
@@ -7294,6 +7593,10 @@ AVMixerContext high_quality_mixer = {
     .set_channel_filter                = set_channel_filter,
     .mix                               = mix,
     .mix_parallel                      = mix_parallel,
+    .mix_tick                          = mix_tick,
+    .set_stems                         = set_stems,
+    .get_tick_phase                    = get_tick_phase,
+    .set_tick_phase                    = set_tick_phase,
 };
 
 #endif /* CONFIG_HIGH_QUALITY_MIXER */
@@ -36,6 +36,8 @@ typedef struct AV_LQMixerData {
     uint32_t mix_buf_size;
     int32_t *volume_lut;
     struct AV_LQMixerChannelInfo *channel_info;
+    uint16_t *active_list;
+    uint32_t active_channels;
     uint32_t amplify;
     uint32_t mix_rate;
     uint32_t mix_rate_frac;
@@ -47,6 +49,8 @@ typedef struct AV_LQMixerData {
     uint16_t channels_out;
     uint8_t interpolation;
     uint8_t real_16_bit_mode;
+    int32_t *thread_buf;
+    uint32_t thread_buf_size;
 } AV_LQMixerData;
 
 typedef struct AV_LQMixerChannelInfo {
@@ -98,6 +102,7 @@ typedef struct AV_LQMixerChannelInfo {
     struct ChannelBlock next;
     int32_t filter_tmp1;
     int32_t filter_tmp2;
+    uint8_t active;
 } AV_LQMixerChannelInfo;
 
 #if CONFIG_LOW_QUALITY_MIXER
@@ -152,281 +157,276 @@ static void apply_filter(AV_LQMixerChannelInfo *const channel_info,
     channel_info->filter_tmp2 = o1;
 }
 
-static void mix_sample(AV_LQMixerData *const mixer_data,
-                       int32_t *const buf, const uint32_t len)
+static void mix_sample_channel(AV_LQMixerData *const mixer_data,
+                               AV_LQMixerChannelInfo *const channel_info,
+                               int32_t *const buf,
+                               int32_t *const thread_filter_buf,
+                               const uint32_t len)
 {
-    AV_LQMixerChannelInfo *channel_info = mixer_data->channel_info;
-    uint16_t i                          = mixer_data->channels_in;
-
-    do {
-        if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_PLAY) {
-            void (*mix_func)(const AV_LQMixerData *const mixer_data,
-                             const struct ChannelBlock *const channel_block,
-                             int32_t **const buf,
-                             uint32_t *const offset,
-                             uint32_t *const fraction,
-                             const uint32_t advance,
-                             const uint32_t adv_frac,
-                             const uint32_t len) = channel_info->current.mix_func;
-            int32_t *mix_buf        = buf;
-            uint32_t offset         = channel_info->current.offset;
-            uint32_t fraction       = channel_info->current.fraction;
-            const uint32_t advance  = channel_info->current.advance;
-            const uint32_t adv_frac = channel_info->current.advance_frac;
-            uint32_t remain_len     = len, remain_mix;
-            uint64_t calc_mix;
-
-            if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_BACKWARDS) {
+    void (*mix_func)(const AV_LQMixerData *const mixer_data,
+                     const struct ChannelBlock *const channel_block,
+                     int32_t **const buf,
+                     uint32_t *const offset,
+                     uint32_t *const fraction,
+                     const uint32_t advance,
+                     const uint32_t adv_frac,
+                     const uint32_t len) = channel_info->current.mix_func;
+    int32_t *mix_buf        = buf;
+    uint32_t offset         = channel_info->current.offset;
+    uint32_t fraction       = channel_info->current.fraction;
+    const uint32_t advance  = channel_info->current.advance;
+    const uint32_t adv_frac = channel_info->current.advance_frac;
+    uint32_t remain_len     = len, remain_mix;
+    uint64_t calc_mix;
+
+    if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_BACKWARDS) {
 mix_sample_backwards:
-                for (;;) {
-                    calc_mix = (((((uint64_t) advance << 32) + adv_frac) * remain_len) + fraction) >> 32;
-
-                    if ((int32_t) (remain_mix = offset - channel_info->current.end_offset) > 0) {
-                        if ((uint32_t) calc_mix < remain_mix) {
-                            if ((channel_info->current.filter_cutoff == 4095) && (channel_info->current.filter_damping == 0)) {
-                                mix_func(mixer_data, &channel_info->current, &mix_buf, &offset, &fraction, advance, adv_frac, remain_len);
-                            } else {
-                                int32_t *filter_buf = mixer_data->filter_buf;
-                                uint32_t filter_len = remain_len;
-
-                                if (mixer_data->channels_out >= 2)
-                                    filter_len <<= 1;
-
-                                memset(filter_buf, 0, filter_len * sizeof(int32_t));
-                                mix_func(mixer_data, &channel_info->current, &filter_buf, &offset, &fraction, advance, adv_frac, remain_len);
-                                apply_filter(channel_info, &channel_info->current, &mix_buf, mixer_data->filter_buf, filter_len);
-                            }
-
-                            if ((int32_t) offset <= (int32_t) channel_info->current.end_offset)
-                                remain_len = 0;
-                            else
-                                break;
-                        } else {
-                            calc_mix    = (((((uint64_t) remain_mix << 32) - fraction) - 1) / (((uint64_t) advance << 32) + adv_frac) + 1);
-                            remain_len -= (uint32_t) calc_mix;
+        for (;;) {
+            calc_mix = (((((uint64_t) advance << 32) + adv_frac) * remain_len) + fraction) >> 32;
 
-                            if ((channel_info->current.filter_cutoff == 4095) && (channel_info->current.filter_damping == 0)) {
-                                mix_func(mixer_data, &channel_info->current, &mix_buf, &offset, &fraction, advance, adv_frac, (uint32_t) calc_mix);
-                            } else {
-                                int32_t *filter_buf = mixer_data->filter_buf;
-                                uint32_t filter_len = (uint32_t) calc_mix;
+            if ((int32_t) (remain_mix = offset - channel_info->current.end_offset) > 0) {
+                if ((uint32_t) calc_mix < remain_mix) {
+                    if ((channel_info->current.filter_cutoff == 4095) && (channel_info->current.filter_damping == 0)) {
+                        mix_func(mixer_data, &channel_info->current, &mix_buf, &offset, &fraction, advance, adv_frac, remain_len);
+                    } else {
+                        int32_t *filter_buf = thread_filter_buf;
+                        uint32_t filter_len = remain_len;
 
-                                if (mixer_data->channels_out >= 2)
-                                    filter_len <<= 1;
+                        if (mixer_data->channels_out >= 2)
+                            filter_len <<= 1;
 
-                                memset(filter_buf, 0, filter_len * sizeof(int32_t));
-                                mix_func(mixer_data, &channel_info->current, &filter_buf, &offset, &fraction, advance, adv_frac, (uint32_t) calc_mix);
-                                apply_filter(channel_info, &channel_info->current, &mix_buf, mixer_data->filter_buf, filter_len);
-                            }
+                        memset(filter_buf, 0, filter_len * sizeof(int32_t));
+                        mix_func(mixer_data, &channel_info->current, &filter_buf, &offset, &fraction, advance, adv_frac, remain_len);
+                        apply_filter(channel_info, &channel_info->current, &mix_buf, thread_filter_buf, filter_len);
+                    }
 
-                            if (((int32_t) offset > (int32_t) channel_info->current.end_offset) && !remain_len)
-                                break;
-                        }
+                    if ((int32_t) offset <= (int32_t) channel_info->current.end_offset)
+                        remain_len = 0;
+                    else
+                        break;
+                } else {
+                    calc_mix    = (((((uint64_t) remain_mix << 32) - fraction) - 1) / (((uint64_t) advance << 32) + adv_frac) + 1);
+                    remain_len -= (uint32_t) calc_mix;
+
+                    if ((channel_info->current.filter_cutoff == 4095) && (channel_info->current.filter_damping == 0)) {
+                        mix_func(mixer_data, &channel_info->current, &mix_buf, &offset, &fraction, advance, adv_frac, (uint32_t) calc_mix);
+                    } else {
+                        int32_t *filter_buf = thread_filter_buf;
+                        uint32_t filter_len = (uint32_t) calc_mix;
+
+                        if (mixer_data->channels_out >= 2)
+                            filter_len <<= 1;
+
+                        memset(filter_buf, 0, filter_len * sizeof(int32_t));
+                        mix_func(mixer_data, &channel_info->current, &filter_buf, &offset, &fraction, advance, adv_frac, (uint32_t) calc_mix);
+                        apply_filter(channel_info, &channel_info->current, &mix_buf, thread_filter_buf, filter_len);
                     }
 
-                    if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_LOOP) {
-                        const uint32_t count_restart = channel_info->current.count_restart;
-                        const uint32_t counted       = channel_info->current.counted++;
+                    if (((int32_t) offset > (int32_t) channel_info->current.end_offset) && !remain_len)
+                        break;
+                }
+            }
 
-                        if (count_restart && (count_restart == counted)) {
-                            channel_info->current.flags     &= ~AVSEQ_MIXER_CHANNEL_FLAG_LOOP;
-                            channel_info->current.end_offset = -1;
+            if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_LOOP) {
+                const uint32_t count_restart = channel_info->current.count_restart;
+                const uint32_t counted       = channel_info->current.counted++;
+
+                if (count_restart && (count_restart == counted)) {
+                    channel_info->current.flags     &= ~AVSEQ_MIXER_CHANNEL_FLAG_LOOP;
+                    channel_info->current.end_offset = -1;
+
+                    goto mix_sample_synth;
+                } else {
+                    if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_PINGPONG) {
+                        void (*mixer_change_func)(const AV_LQMixerData *const mixer_data,
+                                                  const struct ChannelBlock *const channel_block,
+                                                  int32_t **const buf,
+                                                  uint32_t *const offset,
+                                                  uint32_t *const fraction,
+                                                  const uint32_t advance,
+                                                  const uint32_t adv_frac,
+                                                  const uint32_t len);
 
-                            goto mix_sample_synth;
-                        } else {
-                            if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_PINGPONG) {
-                                void (*mixer_change_func)(const AV_LQMixerData *const mixer_data,
-                                                          const struct ChannelBlock *const channel_block,
-                                                          int32_t **const buf,
-                                                          uint32_t *const offset,
-                                                          uint32_t *const fraction,
-                                                          const uint32_t advance,
-                                                          const uint32_t adv_frac,
-                                                          const uint32_t len);
-
-                                if (channel_info->next.data) {
-                                    memcpy(&channel_info->current, &channel_info->next, sizeof(struct ChannelBlock));
-
-                                    channel_info->next.data = NULL;
-                                }
-
-                                mixer_change_func                        = channel_info->current.mix_backwards_func;
-                                channel_info->current.mix_backwards_func = mix_func;
-                                mix_func                                 = mixer_change_func;
-                                channel_info->current.mix_func           = mix_func;
-                                channel_info->current.flags             ^= AVSEQ_MIXER_CHANNEL_FLAG_BACKWARDS;
-                                remain_mix                               = channel_info->current.end_offset;
-                                offset                                  -= remain_mix;
-                                offset                                   = -offset + remain_mix;
-                                remain_mix                              += channel_info->current.restart_offset;
-                                channel_info->current.end_offset         = remain_mix;
-
-                                if ((int32_t) remain_len > 0)
-                                    goto mix_sample_forwards;
-
-                                break;
-                            } else {
-                                offset += channel_info->current.restart_offset;
-
-                                if (channel_info->next.data)
-                                    goto mix_sample_synth;
-
-                                if ((int32_t) remain_len > 0)
-                                    continue;
-
-                                break;
-                            }
+                        if (channel_info->next.data) {
+                            memcpy(&channel_info->current, &channel_info->next, sizeof(struct ChannelBlock));
+
+                            channel_info->next.data = NULL;
                         }
+
+                        mixer_change_func                        = channel_info->current.mix_backwards_func;
+                        channel_info->current.mix_backwards_func = mix_func;
+                        mix_func                                 = mixer_change_func;
+                        channel_info->current.mix_func           = mix_func;
+                        channel_info->current.flags             ^= AVSEQ_MIXER_CHANNEL_FLAG_BACKWARDS;
+                        remain_mix                               = channel_info->current.end_offset;
+                        offset                                  -= remain_mix;
+                        offset                                   = -offset + remain_mix;
+                        remain_mix                              += channel_info->current.restart_offset;
+                        channel_info->current.end_offset         = remain_mix;
+
+                        if ((int32_t) remain_len > 0)
+                            goto mix_sample_forwards;
+
+                        break;
                     } else {
+                        offset += channel_info->current.restart_offset;
+
                         if (channel_info->next.data)
                             goto mix_sample_synth;
-                        else
-                            channel_info->current.flags &= ~AVSEQ_MIXER_CHANNEL_FLAG_PLAY;
+
+                        if ((int32_t) remain_len > 0)
+                            continue;
 
                         break;
                     }
                 }
             } else {
+                if (channel_info->next.data)
+                    goto mix_sample_synth;
+                else
+                    channel_info->current.flags &= ~AVSEQ_MIXER_CHANNEL_FLAG_PLAY;
+
+                break;
+            }
+        }
+    } else {
 mix_sample_forwards:
-                for (;;) {
-                    calc_mix = (((((uint64_t) advance << 32) + adv_frac) * remain_len) + fraction) >> 32;
-
-                    if ((int32_t) (remain_mix = channel_info->current.end_offset - offset) > 0) {
-                        if ((uint32_t) calc_mix < remain_mix) {
-                            if ((channel_info->current.filter_cutoff == 4095) && (channel_info->current.filter_damping == 0)) {
-                                mix_func(mixer_data, &channel_info->current, &mix_buf, &offset, &fraction, advance, adv_frac, remain_len);
-                            } else {
-                                int32_t *filter_buf = mixer_data->filter_buf;
-                                uint32_t filter_len = remain_len;
-
-                                if (mixer_data->channels_out >= 2)
-                                    filter_len <<= 1;
-
-                                memset(filter_buf, 0, filter_len * sizeof(int32_t));
-                                mix_func(mixer_data, &channel_info->current, &filter_buf, &offset, &fraction, advance, adv_frac, remain_len);
-                                apply_filter(channel_info, &channel_info->current, &mix_buf, mixer_data->filter_buf, filter_len);
-                            }
-
-                            if (offset >= channel_info->current.end_offset)
-                                remain_len = 0;
-                            else
-                                break;
-                        } else {
-                            calc_mix    = (((((uint64_t) remain_mix << 32) - fraction) - 1) / (((uint64_t) advance << 32) + adv_frac) + 1);
-                            remain_len -= (uint32_t) calc_mix;
+        for (;;) {
+            calc_mix = (((((uint64_t) advance << 32) + adv_frac) * remain_len) + fraction) >> 32;
 
-                            if ((channel_info->current.filter_cutoff == 4095) && (channel_info->current.filter_damping == 0)) {
-                                mix_func(mixer_data, &channel_info->current, &mix_buf, &offset, &fraction, advance, adv_frac, (uint32_t) calc_mix);
-                            } else {
-                                int32_t *filter_buf = mixer_data->filter_buf;
-                                uint32_t filter_len = (uint32_t) calc_mix;
+            if ((int32_t) (remain_mix = channel_info->current.end_offset - offset) > 0) {
+                if ((uint32_t) calc_mix < remain_mix) {
+                    if ((channel_info->current.filter_cutoff == 4095) && (channel_info->current.filter_damping == 0)) {
+                        mix_func(mixer_data, &channel_info->current, &mix_buf, &offset, &fraction, advance, adv_frac, remain_len);
+                    } else {
+                        int32_t *filter_buf = thread_filter_buf;
+                        uint32_t filter_len = remain_len;
 
-                                if (mixer_data->channels_out >= 2)
-                                    filter_len <<= 1;
+                        if (mixer_data->channels_out >= 2)
+                            filter_len <<= 1;
 
-                                memset(filter_buf, 0, filter_len * sizeof(int32_t));
-                                mix_func(mixer_data, &channel_info->current, &filter_buf, &offset, &fraction, advance, adv_frac, (uint32_t) calc_mix);
-                                apply_filter(channel_info, &channel_info->current, &mix_buf, mixer_data->filter_buf, filter_len);
-                            }
+                        memset(filter_buf, 0, filter_len * sizeof(int32_t));
+                        mix_func(mixer_data, &channel_info->current, &filter_buf, &offset, &fraction, advance, adv_frac, remain_len);
+                        apply_filter(channel_info, &channel_info->current, &mix_buf, thread_filter_buf, filter_len);
+                    }
 
-                            if ((offset < channel_info->current.end_offset) && !remain_len)
-                                break;
-                        }
+                    if (offset >= channel_info->current.end_offset)
+                        remain_len = 0;
+                    else
+                        break;
+                } else {
+                    calc_mix    = (((((uint64_t) remain_mix << 32) - fraction) - 1) / (((uint64_t) advance << 32) + adv_frac) + 1);
+                    remain_len -= (uint32_t) calc_mix;
+
+                    if ((channel_info->current.filter_cutoff == 4095) && (channel_info->current.filter_damping == 0)) {
+                        mix_func(mixer_data, &channel_info->current, &mix_buf, &offset, &fraction, advance, adv_frac, (uint32_t) calc_mix);
+                    } else {
+                        int32_t *filter_buf = thread_filter_buf;
+                        uint32_t filter_len = (uint32_t) calc_mix;
+
+                        if (mixer_data->channels_out >= 2)
+                            filter_len <<= 1;
+
+                        memset(filter_buf, 0, filter_len * sizeof(int32_t));
+                        mix_func(mixer_data, &channel_info->current, &filter_buf, &offset, &fraction, advance, adv_frac, (uint32_t) calc_mix);
+                        apply_filter(channel_info, &channel_info->current, &mix_buf, thread_filter_buf, filter_len);
                     }
 
-                    if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_LOOP) {
-                        const uint32_t count_restart = channel_info->current.count_restart;
-                        const uint32_t counted       = channel_info->current.counted++;
+                    if ((offset < channel_info->current.end_offset) && !remain_len)
+                        break;
+                }
+            }
 
-                        if (count_restart && (count_restart == counted)) {
-                            channel_info->current.flags     &= ~AVSEQ_MIXER_CHANNEL_FLAG_LOOP;
-                            channel_info->current.end_offset = channel_info->current.len;
+            if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_LOOP) {
+                const uint32_t count_restart = channel_info->current.count_restart;
+                const uint32_t counted       = channel_info->current.counted++;
+
+                if (count_restart && (count_restart == counted)) {
+                    channel_info->current.flags     &= ~AVSEQ_MIXER_CHANNEL_FLAG_LOOP;
+                    channel_info->current.end_offset = channel_info->current.len;
+
+                    goto mix_sample_synth;
+                } else {
+                    if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_PINGPONG) {
+                        void (*mixer_change_func)(const AV_LQMixerData *const mixer_data,
+                                                  const struct ChannelBlock *const channel_block,
+                                                  int32_t **const buf,
+                                                  uint32_t *const offset,
+                                                  uint32_t *const fraction,
+                                                  const uint32_t advance,
+                                                  const uint32_t adv_frac,
+                                                  const uint32_t len);
 
-                            goto mix_sample_synth;
-                        } else {
-                            if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_PINGPONG) {
-                                void (*mixer_change_func)(const AV_LQMixerData *const mixer_data,
-                                                          const struct ChannelBlock *const channel_block,
-                                                          int32_t **const buf,
-                                                          uint32_t *const offset,
-                                                          uint32_t *const fraction,
-                                                          const uint32_t advance,
-                                                          const uint32_t adv_frac,
-                                                          const uint32_t len);
-
-                                if (channel_info->next.data) {
-                                    memcpy(&channel_info->current, &channel_info->next, sizeof(struct ChannelBlock));
-
-                                    channel_info->next.data = NULL;
-                                }
-
-                                mixer_change_func                        = channel_info->current.mix_backwards_func;
-                                channel_info->current.mix_backwards_func = mix_func;
-                                mix_func                                 = mixer_change_func;
-                                channel_info->current.mix_func           = mix_func;
-                                channel_info->current.flags             ^= AVSEQ_MIXER_CHANNEL_FLAG_BACKWARDS;
-                                remain_mix                               = channel_info->current.end_offset;
-                                offset                                  -= remain_mix;
-                                offset                                   = -offset + remain_mix;
-                                remain_mix                              -= channel_info->current.restart_offset;
-                                channel_info->current.end_offset         = remain_mix;
-
-                                if (remain_len)
-                                    goto mix_sample_backwards;
-
-                                break;
-                            } else {
-                                offset -= channel_info->current.restart_offset;
-
-                                if (channel_info->next.data) {
-                                    memcpy(&channel_info->current, &channel_info->next, sizeof(struct ChannelBlock));
-
-                                    channel_info->next.data = NULL;
-                                }
-
-                                if ((int32_t) remain_len > 0)
-                                    continue;
-
-                                break;
-                            }
+                        if (channel_info->next.data) {
+                            memcpy(&channel_info->current, &channel_info->next, sizeof(struct ChannelBlock));
+
+                            channel_info->next.data = NULL;
                         }
+
+                        mixer_change_func                        = channel_info->current.mix_backwards_func;
+                        channel_info->current.mix_backwards_func = mix_func;
+                        mix_func                                 = mixer_change_func;
+                        channel_info->current.mix_func           = mix_func;
+                        channel_info->current.flags             ^= AVSEQ_MIXER_CHANNEL_FLAG_BACKWARDS;
+                        remain_mix                               = channel_info->current.end_offset;
+                        offset                                  -= remain_mix;
+                        offset                                   = -offset + remain_mix;
+                        remain_mix                              -= channel_info->current.restart_offset;
+                        channel_info->current.end_offset         = remain_mix;
+
+                        if (remain_len)
+                            goto mix_sample_backwards;
+
+                        break;
                     } else {
+                        offset -= channel_info->current.restart_offset;
+
                         if (channel_info->next.data) {
-mix_sample_synth:
                             memcpy(&channel_info->current, &channel_info->next, sizeof(struct ChannelBlock));
 
                             channel_info->next.data = NULL;
-
-                            if ((int32_t) remain_len > 0)
-                                continue;
-                        } else {
-                            channel_info->current.flags &= ~AVSEQ_MIXER_CHANNEL_FLAG_PLAY;
                         }
 
+                        if ((int32_t) remain_len > 0)
+                            continue;
+
                         break;
                     }
                 }
-            }
-
-            channel_info->current.offset_one_shoot += (offset > channel_info->current.offset) ? (offset - channel_info->current.offset) : (channel_info->current.offset - offset);
+            } else {
+                if (channel_info->next.data) {
+mix_sample_synth:
+                    memcpy(&channel_info->current, &channel_info->next, sizeof(struct ChannelBlock));
 
-            if (channel_info->current.offset_one_shoot >= channel_info->current.len) {
-                channel_info->current.offset_one_shoot = channel_info->current.len;
+                    channel_info->next.data = NULL;
 
-                if (!(channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_LOOP))
+                    if ((int32_t) remain_len > 0)
+                        continue;
+                } else {
                     channel_info->current.flags &= ~AVSEQ_MIXER_CHANNEL_FLAG_PLAY;
-            }
+                }
 
-            channel_info->current.offset   = offset;
-            channel_info->current.fraction = fraction;
+                break;
+            }
         }
+    }
 
-        channel_info++;
-    } while (--i);
+    channel_info->current.offset_one_shoot += (offset > channel_info->current.offset) ? (offset - channel_info->current.offset) : (channel_info->current.offset - offset);
+
+    if (channel_info->current.offset_one_shoot >= channel_info->current.len) {
+        channel_info->current.offset_one_shoot = channel_info->current.len;
+
+        if (!(channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_LOOP))
+            channel_info->current.flags &= ~AVSEQ_MIXER_CHANNEL_FLAG_PLAY;
+    }
+
+    channel_info->current.offset   = offset;
+    channel_info->current.fraction = fraction;
 }
 
 static void mix_sample_parallel(AV_LQMixerData *const mixer_data,
                                 int32_t *const buf,
+                                int32_t *const thread_filter_buf,
                                 const uint32_t len,
                                 const uint32_t first_channel,
                                 const uint32_t last_channel)
@@ -435,270 +435,156 @@ static void mix_sample_parallel(AV_LQMixerData *const mixer_data,
     uint16_t i                          = (last_channel - first_channel) + 1;
 
     do {
-        if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_PLAY) {
-            void (*mix_func)(const AV_LQMixerData *const mixer_data,
-                             const struct ChannelBlock *const channel_block,
-                             int32_t **const buf,
-                             uint32_t *const offset,
-                             uint32_t *const fraction,
-                             const uint32_t advance,
-                             const uint32_t adv_frac,
-                             const uint32_t len) = channel_info->current.mix_func;
-            int32_t *mix_buf        = buf;
-            uint32_t offset         = channel_info->current.offset;
-            uint32_t fraction       = channel_info->current.fraction;
-            const uint32_t advance  = channel_info->current.advance;
-            const uint32_t adv_frac = channel_info->current.advance_frac;
-            uint32_t remain_len     = len, remain_mix;
-            uint64_t calc_mix;
-
-            if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_BACKWARDS) {
-mix_sample_backwards:
-                for (;;) {
-                    calc_mix = (((((uint64_t) advance << 32) + adv_frac) * remain_len) + fraction) >> 32;
-
-                    if ((int32_t) (remain_mix = offset - channel_info->current.end_offset) > 0) {
-                        if ((uint32_t) calc_mix < remain_mix) {
-                            if ((channel_info->current.filter_cutoff == 4095) && (channel_info->current.filter_damping == 0)) {
-                                mix_func(mixer_data, &channel_info->current, &mix_buf, &offset, &fraction, advance, adv_frac, remain_len);
-                            } else {
-                                int32_t *filter_buf = mixer_data->filter_buf;
-                                uint32_t filter_len = remain_len;
-
-                                if (mixer_data->channels_out >= 2)
-                                    filter_len <<= 1;
-
-                                memset(filter_buf, 0, filter_len * sizeof(int32_t));
-                                mix_func(mixer_data, &channel_info->current, &filter_buf, &offset, &fraction, advance, adv_frac, remain_len);
-                                apply_filter(channel_info, &channel_info->current, &mix_buf, mixer_data->filter_buf, filter_len);
-                            }
-
-                            if ((int32_t) offset <= (int32_t) channel_info->current.end_offset)
-                                remain_len = 0;
-                            else
-                                break;
-                        } else {
-                            calc_mix    = (((((uint64_t) remain_mix << 32) - fraction) - 1) / (((uint64_t) advance << 32) + adv_frac) + 1);
-                            remain_len -= (uint32_t) calc_mix;
+        if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_PLAY)
+            mix_sample_channel(mixer_data, channel_info, buf, thread_filter_buf, len);
 
-                            if ((channel_info->current.filter_cutoff == 4095) && (channel_info->current.filter_damping == 0)) {
-                                mix_func(mixer_data, &channel_info->current, &mix_buf, &offset, &fraction, advance, adv_frac, (uint32_t) calc_mix);
-                            } else {
-                                int32_t *filter_buf = mixer_data->filter_buf;
-                                uint32_t filter_len = (uint32_t) calc_mix;
+        channel_info++;
+    } while (--i);
+}
 
-                                if (mixer_data->channels_out >= 2)
-                                    filter_len <<= 1;
+/** Mixes the channels of the active channel list entries from first
+   up to (but not including) last, so channels which are not playing
+   are never touched.  */
+static void mix_sample_active(AV_LQMixerData *const mixer_data,
+                              int32_t *const buf,
+                              int32_t *const thread_filter_buf,
+                              const uint32_t len,
+                              const uint32_t first,
+                              const uint32_t last)
+{
+    AV_LQMixerChannelInfo *const channel_info = mixer_data->channel_info;
+    const uint16_t *const active_list         = mixer_data->active_list;
+    uint32_t i;
 
-                                memset(filter_buf, 0, filter_len * sizeof(int32_t));
-                                mix_func(mixer_data, &channel_info->current, &filter_buf, &offset, &fraction, advance, adv_frac, (uint32_t) calc_mix);
-                                apply_filter(channel_info, &channel_info->current, &mix_buf, mixer_data->filter_buf, filter_len);
-                            }
+    for (i = first; i < last; i++) {
+        if (channel_info[active_list[i]].current.flags & AVSEQ_MIXER_CHANNEL_FLAG_PLAY)
+            mix_sample_channel(mixer_data, channel_info + active_list[i], buf, thread_filter_buf, len);
+    }
+}
 
-                            if (((int32_t) offset > (int32_t) channel_info->current.end_offset) && !remain_len)
-                                break;
-                        }
-                    }
+/** Removes channels which have stopped playing from the active
+   channel list, preserving the order of the remaining ones.  */
+static void update_active_list(AV_LQMixerData *const mixer_data)
+{
+    AV_LQMixerChannelInfo *const channel_info = mixer_data->channel_info;
+    uint16_t *const active_list               = mixer_data->active_list;
+    uint32_t i, j = 0;
 
-                    if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_LOOP) {
-                        const uint32_t count_restart = channel_info->current.count_restart;
-                        const uint32_t counted       = channel_info->current.counted++;
+    for (i = 0; i < mixer_data->active_channels; i++) {
+        const uint16_t channel = active_list[i];
 
-                        if (count_restart && (count_restart == counted)) {
-                            channel_info->current.flags     &= ~AVSEQ_MIXER_CHANNEL_FLAG_LOOP;
-                            channel_info->current.end_offset = -1;
+        if (channel_info[channel].current.flags & AVSEQ_MIXER_CHANNEL_FLAG_PLAY)
+            active_list[j++] = channel;
+        else
+            channel_info[channel].active = 0;
+    }
 
-                            goto mix_sample_synth;
-                        } else {
-                            if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_PINGPONG) {
-                                void (*mixer_change_func)(const AV_LQMixerData *const mixer_data,
-                                                          const struct ChannelBlock *const channel_block,
-                                                          int32_t **const buf,
-                                                          uint32_t *const offset,
-                                                          uint32_t *const fraction,
-                                                          const uint32_t advance,
-                                                          const uint32_t adv_frac,
-                                                          const uint32_t len);
-
-                                if (channel_info->next.data) {
-                                    memcpy(&channel_info->current, &channel_info->next, sizeof(struct ChannelBlock));
-
-                                    channel_info->next.data = NULL;
-                                }
-
-                                mixer_change_func                        = channel_info->current.mix_backwards_func;
-                                channel_info->current.mix_backwards_func = mix_func;
-                                mix_func                                 = mixer_change_func;
-                                channel_info->current.mix_func           = mix_func;
-                                channel_info->current.flags             ^= AVSEQ_MIXER_CHANNEL_FLAG_BACKWARDS;
-                                remain_mix                               = channel_info->current.end_offset;
-                                offset                                  -= remain_mix;
-                                offset                                   = -offset + remain_mix;
-                                remain_mix                              += channel_info->current.restart_offset;
-                                channel_info->current.end_offset         = remain_mix;
-
-                                if ((int32_t) remain_len > 0)
-                                    goto mix_sample_forwards;
-
-                                break;
-                            } else {
-                                offset += channel_info->current.restart_offset;
-
-                                if (channel_info->next.data)
-                                    goto mix_sample_synth;
-
-                                if ((int32_t) remain_len > 0)
-                                    continue;
-
-                                break;
-                            }
-                        }
-                    } else {
-                        if (channel_info->next.data)
-                            goto mix_sample_synth;
-                        else
-                            channel_info->current.flags &= ~AVSEQ_MIXER_CHANNEL_FLAG_PLAY;
+    mixer_data->active_channels = j;
+}
 
-                        break;
-                    }
-                }
-            } else {
-mix_sample_forwards:
-                for (;;) {
-                    calc_mix = (((((uint64_t) advance << 32) + adv_frac) * remain_len) + fraction) >> 32;
-
-                    if ((int32_t) (remain_mix = channel_info->current.end_offset - offset) > 0) {
-                        if ((uint32_t) calc_mix < remain_mix) {
-                            if ((channel_info->current.filter_cutoff == 4095) && (channel_info->current.filter_damping == 0)) {
-                                mix_func(mixer_data, &channel_info->current, &mix_buf, &offset, &fraction, advance, adv_frac, remain_len);
-                            } else {
-                                int32_t *filter_buf = mixer_data->filter_buf;
-                                uint32_t filter_len = remain_len;
-
-                                if (mixer_data->channels_out >= 2)
-                                    filter_len <<= 1;
-
-                                memset(filter_buf, 0, filter_len * sizeof(int32_t));
-                                mix_func(mixer_data, &channel_info->current, &filter_buf, &offset, &fraction, advance, adv_frac, remain_len);
-                                apply_filter(channel_info, &channel_info->current, &mix_buf, mixer_data->filter_buf, filter_len);
-                            }
-
-                            if (offset >= channel_info->current.end_offset)
-                                remain_len = 0;
-                            else
-                                break;
-                        } else {
-                            calc_mix    = (((((uint64_t) remain_mix << 32) - fraction) - 1) / (((uint64_t) advance << 32) + adv_frac) + 1);
-                            remain_len -= (uint32_t) calc_mix;
+/** Appends a channel to the active channel list when it has been
+   started, it is removed again by update_active_list after it has
+   stopped playing.  */
+static void activate_channel(AV_LQMixerData *const mixer_data,
+                             AV_LQMixerChannelInfo *const channel_info)
+{
+    if ((channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_PLAY) && !channel_info->active) {
+        channel_info->active                                   = 1;
+        mixer_data->active_list[mixer_data->active_channels++] = channel_info - mixer_data->channel_info;
+    }
+}
 
-                            if ((channel_info->current.filter_cutoff == 4095) && (channel_info->current.filter_damping == 0)) {
-                                mix_func(mixer_data, &channel_info->current, &mix_buf, &offset, &fraction, advance, adv_frac, (uint32_t) calc_mix);
-                            } else {
-                                int32_t *filter_buf = mixer_data->filter_buf;
-                                uint32_t filter_len = (uint32_t) calc_mix;
+/** Rebuilds the active channel list from scratch, this is required
+   whenever the channel data has been reallocated.  */
+static void init_active_list(AV_LQMixerData *const mixer_data)
+{
+    AV_LQMixerChannelInfo *channel_info = mixer_data->channel_info;
+    uint16_t i;
 
-                                if (mixer_data->channels_out >= 2)
-                                    filter_len <<= 1;
+    mixer_data->active_channels = 0;
 
-                                memset(filter_buf, 0, filter_len * sizeof(int32_t));
-                                mix_func(mixer_data, &channel_info->current, &filter_buf, &offset, &fraction, advance, adv_frac, (uint32_t) calc_mix);
-                                apply_filter(channel_info, &channel_info->current, &mix_buf, mixer_data->filter_buf, filter_len);
-                            }
+    for (i = mixer_data->channels_in; i > 0; i--) {
+        channel_info->active = 0;
 
-                            if ((offset < channel_info->current.end_offset) && !remain_len)
-                                break;
-                        }
-                    }
+        activate_channel(mixer_data, channel_info++);
+    }
+}
 
-                    if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_LOOP) {
-                        const uint32_t count_restart = channel_info->current.count_restart;
-                        const uint32_t counted       = channel_info->current.counted++;
+static void mix_sample(AV_LQMixerData *const mixer_data,
+                       int32_t *const buf, const uint32_t len)
+{
+    mix_sample_active(mixer_data, buf, mixer_data->filter_buf, len, 0, mixer_data->active_channels);
+    update_active_list(mixer_data);
+}
 
-                        if (count_restart && (count_restart == counted)) {
-                            channel_info->current.flags     &= ~AVSEQ_MIXER_CHANNEL_FLAG_LOOP;
-                            channel_info->current.end_offset = channel_info->current.len;
+typedef struct MixThreadArg {
+    int32_t *buf;
+    uint32_t len;
+    uint32_t stride;
+} MixThreadArg;
 
-                            goto mix_sample_synth;
-                        } else {
-                            if (channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_PINGPONG) {
-                                void (*mixer_change_func)(const AV_LQMixerData *const mixer_data,
-                                                          const struct ChannelBlock *const channel_block,
-                                                          int32_t **const buf,
-                                                          uint32_t *const offset,
-                                                          uint32_t *const fraction,
-                                                          const uint32_t advance,
-                                                          const uint32_t adv_frac,
-                                                          const uint32_t len);
-
-                                if (channel_info->next.data) {
-                                    memcpy(&channel_info->current, &channel_info->next, sizeof(struct ChannelBlock));
-
-                                    channel_info->next.data = NULL;
-                                }
-
-                                mixer_change_func                        = channel_info->current.mix_backwards_func;
-                                channel_info->current.mix_backwards_func = mix_func;
-                                mix_func                                 = mixer_change_func;
-                                channel_info->current.mix_func           = mix_func;
-                                channel_info->current.flags             ^= AVSEQ_MIXER_CHANNEL_FLAG_BACKWARDS;
-                                remain_mix                               = channel_info->current.end_offset;
-                                offset                                  -= remain_mix;
-                                offset                                   = -offset + remain_mix;
-                                remain_mix                              -= channel_info->current.restart_offset;
-                                channel_info->current.end_offset         = remain_mix;
-
-                                if (remain_len)
-                                    goto mix_sample_backwards;
-
-                                break;
-                            } else {
-                                offset -= channel_info->current.restart_offset;
-
-                                if (channel_info->next.data) {
-                                    memcpy(&channel_info->current, &channel_info->next, sizeof(struct ChannelBlock));
-
-                                    channel_info->next.data = NULL;
-                                }
-
-                                if ((int32_t) remain_len > 0)
-                                    continue;
-
-                                break;
-                            }
-                        }
-                    } else {
-                        if (channel_info->next.data) {
-mix_sample_synth:
-                            memcpy(&channel_info->current, &channel_info->next, sizeof(struct ChannelBlock));
+static int mix_sample_thread(AVMixerData *const mixer_data,
+                             void *arg, int jobnr)
+{
+    AV_LQMixerData *const lq_mixer_data  = (AV_LQMixerData *const) mixer_data;
+    const MixThreadArg *const thread_arg = arg;
+    const uint32_t active_channels       = lq_mixer_data->active_channels;
+    const uint32_t first_channel         = (active_channels * jobnr) / mixer_data->thread_count;
+    const uint32_t last_channel          = (active_channels * (jobnr + 1)) / mixer_data->thread_count;
+    int32_t *buf                         = thread_arg->buf;
+    int32_t *filter_buf                  = lq_mixer_data->filter_buf;
+
+    if (jobnr) {
+        buf        = lq_mixer_data->thread_buf + ((jobnr - 1) * (thread_arg->stride << 1));
+        filter_buf = buf + thread_arg->stride;
+
+        memset(buf, 0, thread_arg->stride * sizeof(int32_t));
+    }
 
-                            channel_info->next.data = NULL;
+    if (first_channel < last_channel)
+        mix_sample_active(lq_mixer_data, buf, filter_buf, thread_arg->len, first_channel, last_channel);
 
-                            if ((int32_t) remain_len > 0)
-                                continue;
-                        } else {
-                            channel_info->current.flags &= ~AVSEQ_MIXER_CHANNEL_FLAG_PLAY;
-                        }
+    return 0;
+}
 
-                        break;
-                    }
-                }
-            }
+static void mix_sample_threaded(AV_LQMixerData *const mixer_data,
+                                int32_t *const buf, const uint32_t len)
+{
+    const int thread_count  = mixer_data->mixer_data.thread_count;
+    const uint32_t mix_len  = (mixer_data->channels_out >= 2) ? len << 1 : len;
+    const uint32_t buf_size = (thread_count - 1) * (mix_len << 1);
+    MixThreadArg thread_arg;
+    int32_t *thread_buf;
+    int i;
+    uint32_t j;
+
+    if (mixer_data->thread_buf_size < buf_size) {
+        if (!(thread_buf = av_realloc(mixer_data->thread_buf, (buf_size * sizeof(int32_t)) + FF_INPUT_BUFFER_PADDING_SIZE))) {
+            av_log(mixer_data->mixer_data.mixctx, AV_LOG_ERROR, "Cannot allocate mixer thread buffers, mixing single threaded.\n");
+            mix_sample(mixer_data, buf, len);
+
+            return;
+        }
 
-            channel_info->current.offset_one_shoot += (offset > channel_info->current.offset) ? (offset - channel_info->current.offset) : (channel_info->current.offset - offset);
+        mixer_data->thread_buf      = thread_buf;
+        mixer_data->thread_buf_size = buf_size;
+    }
 
-            if (channel_info->current.offset_one_shoot >= channel_info->current.len) {
-                channel_info->current.offset_one_shoot = channel_info->current.len;
+    thread_arg.buf    = buf;
+    thread_arg.len    = len;
+    thread_arg.stride = mix_len;
 
-                if (!(channel_info->current.flags & AVSEQ_MIXER_CHANNEL_FLAG_LOOP))
-                    channel_info->current.flags &= ~AVSEQ_MIXER_CHANNEL_FLAG_PLAY;
-            }
+    mixer_data->mixer_data.execute((AVMixerData *) mixer_data, mix_sample_thread, &thread_arg, thread_count);
+    update_active_list(mixer_data);
 
-            channel_info->current.offset   = offset;
-            channel_info->current.fraction = fraction;
-        }
+    thread_buf = mixer_data->thread_buf;
 
-        channel_info++;
-    } while (--i);
+    for (i = 1; i < thread_count; i++) {
+        for (j = 0; j < mix_len; j++)
+            buf[j] += thread_buf[j];
+
+        thread_buf += mix_len << 1;
+    }
 }
 
 #define MIX_FUNCTION(INIT, TYPE, OP, OFFSET_START, OFFSET_END, SKIP,      \
@@ -5072,6 +4958,15 @@ static av_cold AVMixerData *init(AVMixerContext *const mixctx,
         return NULL;
     }
 
+    if (!(lq_mixer_data->active_list = av_malloc((channels_in * sizeof(uint16_t)) + FF_INPUT_BUFFER_PADDING_SIZE))) {
+        av_log(mixctx, AV_LOG_ERROR, "Cannot allocate mixer active channel list.\n");
+        av_free(channel_info);
+        av_freep(&lq_mixer_data->volume_lut);
+        av_free(lq_mixer_data);
+
+        return NULL;
+    }
+
     lq_mixer_data->channel_info            = channel_info;
     lq_mixer_data->mixer_data.channels_in  = channels_in;
     lq_mixer_data->channels_in             = channels_in;
@@ -5080,6 +4975,7 @@ static av_cold AVMixerData *init(AVMixerContext *const mixctx,
 
     if (!(buf = av_mallocz(mix_buf_mem_size + FF_INPUT_BUFFER_PADDING_SIZE))) {
         av_log(mixctx, AV_LOG_ERROR, "Cannot allocate mixer output buffer.\n");
+        av_freep(&lq_mixer_data->active_list);
         av_freep(&lq_mixer_data->channel_info);
         av_freep(&lq_mixer_data->volume_lut);
         av_free(lq_mixer_data);
@@ -5101,6 +4997,7 @@ static av_cold AVMixerData *init(AVMixerContext *const mixctx,
     if (!(buf = av_mallocz(mix_buf_mem_size + FF_INPUT_BUFFER_PADDING_SIZE))) {
         av_log(mixctx, AV_LOG_ERROR, "Cannot allocate mixer (resonance) filter output buffer.\n");
         av_freep(&lq_mixer_data->buf);
+        av_freep(&lq_mixer_data->active_list);
         av_freep(&lq_mixer_data->channel_info);
         av_freep(&lq_mixer_data->volume_lut);
         av_free(lq_mixer_data);
@@ -5127,10 +5024,12 @@ static av_cold int uninit(AVMixerData *const mixer_data)
     if (!lq_mixer_data)
         return AVERROR_INVALIDDATA;
 
+    av_freep(&lq_mixer_data->active_list);
     av_freep(&lq_mixer_data->channel_info);
     av_freep(&lq_mixer_data->volume_lut);
     av_freep(&lq_mixer_data->buf);
     av_freep(&lq_mixer_data->filter_buf);
+    av_freep(&lq_mixer_data->thread_buf);
     av_free(lq_mixer_data);
 
     return 0;
@@ -5238,6 +5137,19 @@ static av_cold uint32_t set_volume(AVMixerData *const mixer_data,
         return old_channels;
     }
 
+    if (channel_info) {
+        uint16_t *const active_list = av_realloc(lq_mixer_data->active_list, (channels * sizeof(uint16_t)) + FF_INPUT_BUFFER_PADDING_SIZE);
+
+        if (!active_list) {
+            av_log(lq_mixer_data->mixer_data.mixctx, AV_LOG_ERROR, "Cannot allocate mixer active channel list.\n");
+            av_free(channel_info);
+
+            return old_channels;
+        }
+
+        lq_mixer_data->active_list = active_list;
+    }
+
     lq_mixer_data->mixer_data.volume_boost = amplify;
     lq_mixer_data->mixer_data.volume_left  = left_volume;
     lq_mixer_data->mixer_data.volume_right = right_volume;
@@ -5284,6 +5196,7 @@ static av_cold uint32_t set_volume(AVMixerData *const mixer_data,
         }
 
         av_free(old_channel_info);
+        init_active_list(lq_mixer_data);
     }
 
     channel_info = lq_mixer_data->channel_info;
@@ -5325,7 +5238,7 @@ static av_cold void set_channel(AVMixerData *const mixer_data,
                                 const AVMixerChannel *const mixer_channel,
                                 const uint32_t channel)
 {
-    const AV_LQMixerData *const lq_mixer_data = (const AV_LQMixerData *const) mixer_data;
+    AV_LQMixerData *const lq_mixer_data       = (AV_LQMixerData *const) mixer_data;
     AV_LQMixerChannelInfo *const channel_info = lq_mixer_data->channel_info + channel;
     struct ChannelBlock *channel_block;
     uint32_t repeat, repeat_len;
@@ -5372,6 +5285,8 @@ static av_cold void set_channel(AVMixerData *const mixer_data,
 
     set_sample_mix_rate(lq_mixer_data, channel_block, channel_block->rate);
     set_sample_filter(lq_mixer_data, channel_info, channel_block, mixer_channel->filter_cutoff, mixer_channel->filter_damping);
+
+    activate_channel(lq_mixer_data, channel_info);
 }
 
 static av_cold void reset_channel(AVMixerData *const mixer_data,
@@ -5467,7 +5382,7 @@ static av_cold void set_both_channels(AVMixerData *const mixer_data,
                                       const AVMixerChannel *const mixer_channel_next,
                                       const uint32_t channel)
 {
-    const AV_LQMixerData *const lq_mixer_data = (const AV_LQMixerData *const) mixer_data;
+    AV_LQMixerData *const lq_mixer_data       = (AV_LQMixerData *const) mixer_data;
     AV_LQMixerChannelInfo *const channel_info = lq_mixer_data->channel_info + channel;
     struct ChannelBlock *channel_block        = &channel_info->current;
     uint32_t repeat, repeat_len;
@@ -5546,6 +5461,8 @@ static av_cold void set_both_channels(AVMixerData *const mixer_data,
 
     set_sample_mix_rate(lq_mixer_data, channel_block, channel_block->rate);
     set_sample_filter(lq_mixer_data, channel_info, channel_block, mixer_channel_next->filter_cutoff, mixer_channel_next->filter_damping);
+
+    activate_channel(lq_mixer_data, channel_info);
 }
 
 static av_cold void set_channel_volume_panning_pitch(AVMixerData *const mixer_data,
@@ -5595,7 +5512,7 @@ static av_cold void set_channel_position_repeat_flags(AVMixerData *const mixer_d
                                                       const AVMixerChannel *const mixer_channel,
                                                       const uint32_t channel)
 {
-    const AV_LQMixerData *const lq_mixer_data = (const AV_LQMixerData *const) mixer_data;
+    AV_LQMixerData *const lq_mixer_data       = (AV_LQMixerData *const) mixer_data;
     AV_LQMixerChannelInfo *const channel_info = lq_mixer_data->channel_info + channel;
 
     if (channel_info->current.flags == mixer_channel->flags) {
@@ -5668,6 +5585,8 @@ static av_cold void set_channel_position_repeat_flags(AVMixerData *const mixer_d
 
         set_mix_functions(lq_mixer_data, &channel_info->current);
     }
+
+    activate_channel(lq_mixer_data, channel_info);
 }
 
 static av_cold void set_channel_filter(AVMixerData *const mixer_data,
@@ -5697,7 +5616,10 @@ static av_cold void mix(AVMixerData *const mixer_data, int32_t *buf) {
                 current_left -= mix_len;
                 buf_size     -= mix_len;
 
-                mix_sample(lq_mixer_data, buf, mix_len);
+                if ((lq_mixer_data->mixer_data.thread_count > 1) && lq_mixer_data->mixer_data.execute)
+                    mix_sample_threaded(lq_mixer_data, buf, mix_len);
+                else
+                    mix_sample(lq_mixer_data, buf, mix_len);
 
                 buf += (lq_mixer_data->channels_out >= 2) ? mix_len << 1 : mix_len;
             }
@@ -5715,8 +5637,6 @@ static av_cold void mix(AVMixerData *const mixer_data, int32_t *buf) {
         lq_mixer_data->current_left      = current_left;
         lq_mixer_data->current_left_frac = current_left_frac;
     }
-
-    // TODO: Execute post-processing step in libavfilter and pass the PCM data.
 }
 
 static av_cold void mix_parallel(AVMixerData *const mixer_data,
@@ -5739,7 +5659,7 @@ static av_cold void mix_parallel(AVMixerData *const mixer_data,
                 current_left -= mix_len;
                 buf_size     -= mix_len;
 
-                mix_sample_parallel(lq_mixer_data, buf, mix_len, first_channel, last_channel);
+                mix_sample_parallel(lq_mixer_data, buf, lq_mixer_data->filter_buf, mix_len, first_channel, last_channel);
 
                 buf += (lq_mixer_data->channels_out >= 2) ? mix_len << 1 : mix_len;
             }
@@ -5757,8 +5677,69 @@ static av_cold void mix_parallel(AVMixerData *const mixer_data,
         lq_mixer_data->current_left      = current_left;
         lq_mixer_data->current_left_frac = current_left_frac;
     }
+}
+
+static av_cold uint32_t mix_tick(AVMixerData *const mixer_data,
+                                 int32_t *buf,
+                                 const uint32_t len)
+{
+    AV_LQMixerData *const lq_mixer_data = (AV_LQMixerData *const) mixer_data;
+    uint32_t current_left               = lq_mixer_data->current_left;
+    uint32_t current_left_frac          = lq_mixer_data->current_left_frac;
+    uint32_t mix_len;
+
+    if (!current_left) {
+        if (mixer_data->handler)
+            mixer_data->handler(mixer_data);
+
+        current_left_frac += lq_mixer_data->pass_len_frac;
+        current_left       = lq_mixer_data->pass_len + (current_left_frac < lq_mixer_data->pass_len_frac);
+    }
+
+    mix_len       = (len > current_left) ? current_left : len;
+    current_left -= mix_len;
+
+    if (mix_len) {
+        memset(buf, 0, mix_len << ((lq_mixer_data->channels_out >= 2) ? 3 : 2));
+
+        if ((lq_mixer_data->mixer_data.thread_count > 1) && lq_mixer_data->mixer_data.execute)
+            mix_sample_threaded(lq_mixer_data, buf, mix_len);
+        else
+            mix_sample(lq_mixer_data, buf, mix_len);
+    }
+
+    if (!current_left) {
+        if (mixer_data->handler)
+            mixer_data->handler(mixer_data);
+
+        current_left_frac += lq_mixer_data->pass_len_frac;
+        current_left       = lq_mixer_data->pass_len + (current_left_frac < lq_mixer_data->pass_len_frac);
+    }
+
+    lq_mixer_data->current_left      = current_left;
+    lq_mixer_data->current_left_frac = current_left_frac;
+
+    return mix_len;
+}
+
+static av_cold void get_tick_phase(const AVMixerData *const mixer_data,
+                                   uint32_t *const left,
+                                   uint32_t *const left_frac)
+{
+    const AV_LQMixerData *const lq_mixer_data = (const AV_LQMixerData *const) mixer_data;
+
+    *left      = lq_mixer_data->current_left;
+    *left_frac = lq_mixer_data->current_left_frac;
+}
+
+static av_cold void set_tick_phase(AVMixerData *const mixer_data,
+                                   const uint32_t left,
+                                   const uint32_t left_frac)
+{
+    AV_LQMixerData *const lq_mixer_data = (AV_LQMixerData *const) mixer_data;
 
-    // TODO: Execute post-processing step in libavfilter and pass the PCM data.
+    lq_mixer_data->current_left      = left;
+    lq_mixer_data->current_left_frac = left_frac;
 }
 
 AVMixerContext low_quality_mixer = {
@@ -5792,6 +5773,9 @@ AVMixerContext low_quality_mixer = {
     .set_channel_filter                = set_channel_filter,
     .mix                               = mix,
     .mix_parallel                      = mix_parallel,
+    .mix_tick                          = mix_tick,
+    .get_tick_phase                    = get_tick_phase,
+    .set_tick_phase                    = set_tick_phase,
 };
 
 #endif /* CONFIG_LOW_QUALITY_MIXER */
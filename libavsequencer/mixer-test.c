@@ -0,0 +1,174 @@
+/*
+ * AVSequencer mixer level test
+ * Copyright (c) 2010 Sebastian Vater <cdgs.basty@googlemail.com>
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Compares the output levels of all registered mixers against the high
+ * quality mixer in mono, stereo panning and surround setups.
+ */
+
+#include "libavutil/log.h"
+#include "libavutil/mem.h"
+#include "avsequencer.h"
+#include <math.h>
+#include <string.h>
+
+#define SAMPLE_LEN 65536
+
+static const struct {
+    const char *name;
+    unsigned channels;
+    uint8_t panning;
+    uint8_t flags;
+} level_list[] = {
+    { "mono",     1, 0x80, 0 },
+    { "left",     2, 0x00, 0 },
+    { "centre",   2, 0x80, 0 },
+    { "right",    2, 0xFF, 0 },
+    { "pan 0x40", 2, 0x40, 0 },
+    { "surround", 2, 0x80, AVSEQ_MIXER_CHANNEL_FLAG_SURROUND },
+};
+
+/** mix one full volume voice at the output rate, so that no interpolation
+   takes place, and return the sum of the absolute output values, with
+   floating point output scaled to the S32 range */
+static double mix_level(AVSequencerContext *avctx, AVMixerContext *mixctx,
+                        const char *args, const int16_t *data, unsigned level)
+{
+    AVMixerData *mixer_data;
+    AVMixerChannel channel;
+    double sum = 0.0;
+    unsigned i, run;
+
+    if (!(mixer_data = avseq_mixer_init(avctx, mixctx, args, NULL)))
+        return -1.0;
+
+    mixer_data->handler = NULL;
+
+    avseq_mixer_set_rate(mixer_data, 44100, level_list[level].channels);
+    avseq_mixer_set_tempo(mixer_data, 125 * 4);
+
+    if (avseq_mixer_set_volume(mixer_data, 65536, 65536, 65536, 1) < 1) {
+        avseq_mixer_uninit(avctx, mixer_data);
+        return -1.0;
+    }
+
+    memset(&channel, 0, sizeof(channel));
+
+    channel.data            = data;
+    channel.len             = SAMPLE_LEN;
+    channel.repeat_length   = SAMPLE_LEN;
+    channel.rate            = 44100;
+    channel.bits_per_sample = 16;
+    channel.flags           = level_list[level].flags|AVSEQ_MIXER_CHANNEL_FLAG_LOOP|AVSEQ_MIXER_CHANNEL_FLAG_PLAY;
+    channel.volume          = 255;
+    channel.panning         = level_list[level].panning;
+    channel.filter_cutoff   = 4095;
+
+    avseq_mixer_set_channel(mixer_data, &channel, 0);
+
+    if (mixctx->set_channel_volume_panning_pitch)
+        mixctx->set_channel_volume_panning_pitch(mixer_data, &channel, 0);
+
+    for (run = 0; run < 4; run++) {
+        const unsigned len = mixer_data->mix_buf_size * mixer_data->channels_out;
+
+        avseq_mixer_do_mix(mixer_data, NULL);
+
+        if (mixctx->flags & AVSEQ_MIXER_CONTEXT_FLAG_FLOAT) {
+            const float *buf = (const float *) mixer_data->mix_buf;
+
+            for (i = 0; i < len; i++)
+                sum += fabs(buf[i]) * 2147483648.0;
+        } else {
+            const int32_t *buf = mixer_data->mix_buf;
+
+            for (i = 0; i < len; i++)
+                sum += fabs((double) buf[i]);
+        }
+    }
+
+    avseq_mixer_uninit(avctx, mixer_data);
+
+    return sum;
+}
+
+/** compare the output level of all mixers against the high quality mixer,
+   returns the number of mismatches */
+static int check_levels(AVSequencerContext *avctx, const char *args)
+{
+    AVMixerContext **mixctx = NULL, *hq_mixctx;
+    int16_t *data;
+    unsigned level, i;
+    int errors = 0;
+
+    if (!(hq_mixctx = avseq_mixer_get_by_name("High quality mixer")))
+        return 0;
+
+    if (!(data = av_malloc(SAMPLE_LEN * sizeof(*data))))
+        return 1;
+
+    /* square wave at half of full scale */
+    for (i = 0; i < SAMPLE_LEN; i++)
+        data[i] = (i & 64) ? 16384 : -16384;
+
+    for (level = 0; level < FF_ARRAY_ELEMS(level_list); level++) {
+        const double ref = mix_level(avctx, hq_mixctx, args, data, level);
+
+        mixctx = NULL;
+
+        while ((mixctx = avseq_mixer_next(mixctx)) && *mixctx) {
+            double sum, ratio;
+
+            if ((*mixctx == hq_mixctx) || !(*mixctx)->mix || !strcmp((*mixctx)->name, "Null mixer"))
+                continue;
+
+            sum   = mix_level(avctx, *mixctx, args, data, level);
+            ratio = (ref > 0.0) ? sum / ref : 0.0;
+
+            if (fabs(ratio - 1.0) >= 0.01) {
+                av_log(NULL, AV_LOG_ERROR, "%s %s: level %6.4f of high quality mixer\n",
+                       (*mixctx)->name, level_list[level].name, ratio);
+                errors++;
+            }
+        }
+    }
+
+    av_free(data);
+
+    return errors;
+}
+
+int main(int argc, char **argv)
+{
+    AVSequencerContext *avctx;
+    int errors;
+
+    if (!(avctx = avsequencer_open(NULL, NULL, NULL))) {
+        av_log(NULL, AV_LOG_ERROR, "Cannot allocate sequencer context.\n");
+        return 1;
+    }
+
+    errors = check_levels(avctx, argc > 1 ? argv[1] : "");
+    avsequencer_destroy(avctx);
+
+    return !!errors;
+}
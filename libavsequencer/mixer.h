@@ -38,6 +38,9 @@ enum AVMixerID {
     /* Integer based mixers */
     MIXER_ID_LQ, ///< Low quality mixer optimized for fastest playback
     MIXER_ID_HQ, ///< High quality mixer optimized for quality playback and disk writers
+
+    /* Floating point based mixers */
+    MIXER_ID_FLOAT, ///< Floating point mixer outputting SAMPLE_FMT_FLT
 };
 
 /** AVMixerChannel->flags bitfield.  */
@@ -133,6 +136,11 @@ typedef struct AVMixerChannel {
        ranges from 0 to 4095. Damping factor is calculated by
        damp_factor = 10^(-((24/128)*filter_damping)/640).  */
     uint16_t filter_damping;
+
+    /** Output bus (stem) this channel is mixed into if the mixer has
+       stem output enabled, ranging from 0 to stems - 1. Mixers clip
+       larger values to the last stem.  */
+    uint16_t stem;
 } AVMixerChannel;
 
 /** AVMixerData->flags bitfield.  */
@@ -166,8 +174,9 @@ typedef struct AVMixerData {
     uint32_t rate;
 
     /** Pointer to the mixing output buffer for the calculated sample
-       data from the channels. This is always SAMPLE_FMT_S32 in native
-       endianess.  */
+       data from the channels. This is SAMPLE_FMT_S32 in native
+       endianess or SAMPLE_FMT_FLT if the mixer context has the
+       AVSEQ_MIXER_CONTEXT_FLAG_FLOAT flag set.  */
     int32_t *mix_buf;
 
     /** The current actual size of the output buffer for the
@@ -207,12 +216,60 @@ typedef struct AVMixerData {
     /** Executes one tick of the playback handler when enough mixing
        data has been processed.  */
     int (*handler)(struct AVMixerData *mixer_data);
+
+    /** Number of threads used for mixing the input channels in
+       parallel. Values below 2 disable threaded mixing. This is set
+       by avseq_mixer_thread_init.  */
+    int thread_count;
+
+    /** Private data of the mixer thread pool.  */
+    void *thread_opaque;
+
+    /** Executes func job_count times distributed over the threads of
+       the mixer thread pool and returns after all jobs have finished.
+       The mixing engines call this once per mixing pass between two
+       playback handler calls, i.e. the handler is never called while
+       channels are being mixed in parallel.  */
+    int (*execute)(struct AVMixerData *mixer_data,
+                   int (*func)(struct AVMixerData *mixer_data, void *arg, int jobnr),
+                   void *arg, int job_count);
+
+    /** Number of output buses (stems) the channels are mixed into in
+       addition to the normal output, 0 disables stem output. This is
+       set by avseq_mixer_set_stems.  */
+    uint16_t stems;
+
+    /** Stem output of the last buffer or tick based mixing call,
+       which is organized as one block of interleaved samples for each
+       stem. Each stem block has the same format as the normal output
+       and the normal output equals to the sum of all stems.  */
+    int32_t *stem_buf;
+
+    /** Number of samples from the start of one stem block in stem_buf
+       to the next one, i.e. the number of frames produced by the last
+       mixing call multiplied by the number of output channels. This is
+       zero if the last mixing call did not produce stem output.  */
+    uint32_t stem_stride;
+
+    /** Output link of a libavfilter source filter which receives
+       the mixed PCM data if avseq_mixer_do_mix is called without an
+       explicit target buffer. The mixer then renders directly into
+       audio buffers requested from this link, which are passed on
+       to the filter graph without copying. This is set by
+       avseq_mixer_set_filter_link.  */
+    struct AVFilterLink *filter_link;
+
+    /** Number of frames passed to the filter link so far in units
+       of the current mixing rate, this is used for calculating the
+       presentation timestamps of the audio buffers.  */
+    int64_t filter_pts;
 } AVMixerData;
 
 /** AVMixerContext->flags bitfield.  */
 enum AVMixerContextFlags {
     AVSEQ_MIXER_CONTEXT_FLAG_SURROUND   = 0x10, ///< This mixer supports surround panning in addition to stereo panning
     AVSEQ_MIXER_CONTEXT_FLAG_AVFILTER   = 0x20, ///< This mixer supports additional audio filters if FFmpeg is compiled with AVFilter enabled
+    AVSEQ_MIXER_CONTEXT_FLAG_FLOAT      = 0x40, ///< This mixer outputs SAMPLE_FMT_FLT instead of SAMPLE_FMT_S32, where 1.0 equals to full scale of SAMPLE_FMT_S32
 };
 
 /**
@@ -355,7 +412,8 @@ typedef struct AVMixerContext {
                                const uint32_t channel);
 
     /** Run the actual mixing engine by filling the buffer, i.e. the
-       player data is converted to SAMPLE_FMT_S32.  */
+       player data is converted to SAMPLE_FMT_S32 (SAMPLE_FMT_FLT for
+       mixers with AVSEQ_MIXER_CONTEXT_FLAG_FLOAT set).  */
     void (*mix)(AVMixerData *const mixer_data, int32_t *buf);
 
     /** Run the actual mixing engine by filling the buffer by
@@ -365,6 +423,40 @@ typedef struct AVMixerContext {
                          int32_t *buf,
                          const uint32_t first_channel,
                          const uint32_t last_channel);
+
+    /** Run the actual mixing engine up to the end of the current
+       tick by filling the buffer with at most len frames, i.e. the
+       playback handler is called after the last frame of a tick has
+       been mixed. The buffer size is not limited by buf_size_max and
+       the frozen flag is ignored. Returns the number of frames mixed,
+       which is less than len if a tick boundary has been reached.
+       A len of zero only runs a pending playback handler call. Mixers
+       which do not output audio accept a NULL buffer.  */
+    uint32_t (*mix_tick)(AVMixerData *const mixer_data,
+                         int32_t *buf,
+                         const uint32_t len);
+
+    /** Sets the number of output buses (stems) the channels are
+       mixed into by the buffer and tick based mixing functions.
+       Returns the number of stems actually set. Mixers not supporting
+       stem output leave this NULL.  */
+    uint32_t (*set_stems)(AVMixerData *const mixer_data,
+                          const uint32_t stems);
+
+    /** Transfers the position within the current tick, i.e. the
+       number of frames and the fraction of a frame left until the
+       playback handler is called next, from the internal mixer data
+       to the AVSequencer.  */
+    void (*get_tick_phase)(const AVMixerData *const mixer_data,
+                           uint32_t *const left,
+                           uint32_t *const left_frac);
+
+    /** Transfers the position within the current tick from the
+       AVSequencer to the internal mixer data, e.g. to continue at the
+       position reached by another mixer.  */
+    void (*set_tick_phase)(AVMixerData *const mixer_data,
+                           const uint32_t left,
+                           const uint32_t left_frac);
 } AVMixerContext;
 
 #endif /* AVSEQUENCER_MIXER_H */
@@ -0,0 +1,158 @@
+/*
+ * AVSequencer mixer DSP functions
+ * Copyright (c) 2010 Sebastian Vater <cdgs.basty@googlemail.com>
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * AVSequencer mixer DSP functions.
+ */
+
+#include "config.h"
+#include "libavutil/common.h"
+#include "libavsequencer/mixerdsp.h"
+
+void ff_mixer_interpolate_c(int32_t *dst, const int32_t *prev,
+                            const int32_t *curr, const int32_t *next,
+                            const uint32_t *frac, int len)
+{
+    int i;
+
+    for (i = 0; i < len; i++) {
+        int64_t interpolate_frac = -((int64_t) prev[i] - (int64_t) curr[i]);
+        int64_t interpolate_div  = ((int64_t) next[i] - ((int64_t) curr[i] + interpolate_frac)) >> 2;
+        int32_t smp_value, smp;
+
+        smp               = frac[i] >> 1;
+        interpolate_div   = ((int64_t) smp * interpolate_div) >> 32;
+        interpolate_div   = ((interpolate_div << 2) + interpolate_frac) >> 2;
+        interpolate_div   = ((int64_t) smp * interpolate_div) >> 32;
+        interpolate_div <<= 3;
+        smp_value         = ((int64_t) prev[i] + (int64_t) curr[i]) >> 1;
+        smp               = (uint32_t) smp_value + (uint32_t) interpolate_div;
+
+        if (((smp_value ^ smp) & (interpolate_div ^ smp)) < 0)
+            smp = curr[i];
+
+        dst[i] = smp;
+    }
+}
+
+void ff_mixer_filter_c(int32_t *buf, const int32_t c1, const int32_t c2,
+                       const int32_t c3, int32_t *const tmp1,
+                       int32_t *const tmp2, int len)
+{
+    int32_t o1 = *tmp2;
+    int32_t o2 = *tmp1;
+    int32_t o3, o4;
+
+    while (len >= 4) {
+        buf[0] = o3 = (((int64_t) c1 * buf[0]) + ((int64_t) c2 * o2) + ((int64_t) c3 * o1)) >> 24;
+        buf[1] = o4 = (((int64_t) c1 * buf[1]) + ((int64_t) c2 * o3) + ((int64_t) c3 * o2)) >> 24;
+        buf[2] = o1 = (((int64_t) c1 * buf[2]) + ((int64_t) c2 * o4) + ((int64_t) c3 * o3)) >> 24;
+        buf[3] = o2 = (((int64_t) c1 * buf[3]) + ((int64_t) c2 * o1) + ((int64_t) c3 * o4)) >> 24;
+        buf   += 4;
+        len   -= 4;
+    }
+
+    while (len--) {
+        *buf = o3 = (((int64_t) c1 * *buf) + ((int64_t) c2 * o2) + ((int64_t) c3 * o1)) >> 24;
+        buf++;
+        o1   = o2;
+        o2   = o3;
+    }
+
+    *tmp1 = o2;
+    *tmp2 = o1;
+}
+
+void ff_mixer_add_mono_c(int32_t *mix_buf, const int32_t *src, int len)
+{
+    int i;
+
+    for (i = 0; i < len; i++)
+        mix_buf[i] += src[i];
+}
+
+void ff_mixer_add_left_c(int32_t *mix_buf, const int32_t *src, int len)
+{
+    int i;
+
+    for (i = 0; i < len; i++)
+        mix_buf[i << 1] += src[i];
+}
+
+void ff_mixer_add_right_c(int32_t *mix_buf, const int32_t *src, int len)
+{
+    int i;
+
+    for (i = 0; i < len; i++)
+        mix_buf[(i << 1) + 1] += src[i];
+}
+
+void ff_mixer_add_center_c(int32_t *mix_buf, const int32_t *src, int len)
+{
+    int i;
+
+    for (i = 0; i < len; i++) {
+        *mix_buf++ += src[i];
+        *mix_buf++ += src[i];
+    }
+}
+
+void ff_mixer_add_surround_c(int32_t *mix_buf, const int32_t *src, int len)
+{
+    int i;
+
+    for (i = 0; i < len; i++) {
+        *mix_buf++ += src[i];
+        *mix_buf++ += ~src[i];
+    }
+}
+
+int32_t ff_mixer_dot_product_c(const int32_t *src, const int16_t *coeff, int taps)
+{
+    int32_t sum_hi = 0, sum_lo = 0;
+    int i;
+
+    for (i = 0; i < taps; i++) {
+        sum_hi += av_clip_int16(src[i] >> 15) * coeff[i];
+        sum_lo += (src[i] & 0x7FFF) * coeff[i];
+    }
+
+    return av_clipl_int32((((int64_t) sum_hi << 15) + sum_lo + (1 << 13)) >> 14);
+}
+
+void ff_mixer_dsp_init(MixerDSPContext *c, int bitexact)
+{
+    c->interpolate  = ff_mixer_interpolate_c;
+    c->filter       = ff_mixer_filter_c;
+    c->add_mono     = ff_mixer_add_mono_c;
+    c->add_left     = ff_mixer_add_left_c;
+    c->add_right    = ff_mixer_add_right_c;
+    c->add_center   = ff_mixer_add_center_c;
+    c->add_surround = ff_mixer_add_surround_c;
+    c->dot_product  = ff_mixer_dot_product_c;
+
+    if (bitexact)
+        return;
+
+    if (HAVE_MMX)
+        ff_mixer_dsp_init_x86(c);
+}
@@ -0,0 +1,112 @@
+/*
+ * AVSequencer mixer DSP functions
+ * Copyright (c) 2010 Sebastian Vater <cdgs.basty@googlemail.com>
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * AVSequencer mixer DSP functions.
+ */
+
+#ifndef AVSEQUENCER_MIXERDSP_H
+#define AVSEQUENCER_MIXERDSP_H
+
+#include <stdint.h>
+
+/** Number of output frames gathered by the mixing loops before
+   calling the block based DSP functions.  */
+#define MIXER_DSP_BLOCK_SIZE 64
+
+/**
+ * Mixer DSP context which contains the block based inner loops of
+ * the integer mixers. All optimized versions are required to be
+ * bit-exact to the C versions.
+ */
+typedef struct MixerDSPContext {
+    /**
+     * Interpolate len output samples. Each output sample is
+     * calculated from the previous, current and next sample and the
+     * 32-bit fractional position between current and next sample.
+     */
+    void (*interpolate)(int32_t *dst, const int32_t *prev,
+                        const int32_t *curr, const int32_t *next,
+                        const uint32_t *frac, int len);
+
+    /**
+     * Apply the 2-pole resonance filter in place on len samples.
+     * c1, c2 and c3 are the 8.24 fixed point filter coefficients,
+     * tmp1 and tmp2 hold the last and the second last output sample
+     * and are updated on return.
+     */
+    void (*filter)(int32_t *buf, const int32_t c1, const int32_t c2,
+                   const int32_t c3, int32_t *const tmp1,
+                   int32_t *const tmp2, int len);
+
+    /** Accumulate len samples into a mono output buffer.  */
+    void (*add_mono)(int32_t *mix_buf, const int32_t *src, int len);
+
+    /** Accumulate len samples into the left channel of an
+       interleaved stereo output buffer.  */
+    void (*add_left)(int32_t *mix_buf, const int32_t *src, int len);
+
+    /** Accumulate len samples into the right channel of an
+       interleaved stereo output buffer.  */
+    void (*add_right)(int32_t *mix_buf, const int32_t *src, int len);
+
+    /** Accumulate len samples into both channels of an interleaved
+       stereo output buffer.  */
+    void (*add_center)(int32_t *mix_buf, const int32_t *src, int len);
+
+    /** Accumulate len samples into an interleaved stereo output
+       buffer with the right channel being phase inverted.  */
+    void (*add_surround)(int32_t *mix_buf, const int32_t *src, int len);
+
+    /**
+     * Calculate the dot product of taps samples with the 1.14 fixed
+     * point coefficients of a resampling kernel. taps must be a
+     * multiple of 8. Samples are split into their upper bits, which
+     * are saturated to 16 bits, and their lower 15 bits, thus the
+     * samples must not exceed 31 bits including sign.
+     */
+    int32_t (*dot_product)(const int32_t *src, const int16_t *coeff, int taps);
+} MixerDSPContext;
+
+/**
+ * Initialize the mixer DSP context.
+ *
+ * @param c the MixerDSPContext to initialize
+ * @param bitexact if non-zero only the C versions are used
+ */
+void ff_mixer_dsp_init(MixerDSPContext *c, int bitexact);
+void ff_mixer_dsp_init_x86(MixerDSPContext *c);
+
+void ff_mixer_interpolate_c(int32_t *dst, const int32_t *prev,
+                            const int32_t *curr, const int32_t *next,
+                            const uint32_t *frac, int len);
+void ff_mixer_filter_c(int32_t *buf, const int32_t c1, const int32_t c2,
+                       const int32_t c3, int32_t *const tmp1,
+                       int32_t *const tmp2, int len);
+void ff_mixer_add_mono_c(int32_t *mix_buf, const int32_t *src, int len);
+void ff_mixer_add_left_c(int32_t *mix_buf, const int32_t *src, int len);
+void ff_mixer_add_right_c(int32_t *mix_buf, const int32_t *src, int len);
+void ff_mixer_add_center_c(int32_t *mix_buf, const int32_t *src, int len);
+void ff_mixer_add_surround_c(int32_t *mix_buf, const int32_t *src, int len);
+int32_t ff_mixer_dot_product_c(const int32_t *src, const int16_t *coeff, int taps);
+
+#endif /* AVSEQUENCER_MIXERDSP_H */
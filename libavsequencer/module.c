@@ -24,11 +24,24 @@
  * Implement AVSequencer module stuff.
  */
 
+#include "config.h"
 #include "libavutil/log.h"
 #include "libavformat/avformat.h"
 #include "libavsequencer/avsequencer.h"
 #include "libavsequencer/player.h"
 
+#if HAVE_PTHREADS
+#include <pthread.h>
+
+/** Protects the reference counts of all modules, so that contexts
+   sharing a module can open and close it from different threads.  */
+static pthread_mutex_t refs_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/** Minimum playing time distance between two snapshots of the seek
+   index built by avseq_module_seek.  */
+#define SEEK_SNAPSHOT_INTERVAL (5 * AV_TIME_BASE)
+
 static const char *module_name(void *p)
 {
     AVSequencerModule *module = p;
@@ -47,6 +60,28 @@ static const AVClass avseq_module_class = {
     LIBAVUTIL_VERSION_INT,
 };
 
+/** Adds inc to the reference count of a module, which never drops
+   below zero, and returns the new reference count.  */
+static uint32_t update_refs(AVSequencerModule *module, const int inc)
+{
+    uint32_t refs;
+
+#if HAVE_PTHREADS
+    pthread_mutex_lock(&refs_lock);
+#endif
+
+    if ((inc >= 0) || module->refs)
+        module->refs += inc;
+
+    refs = module->refs;
+
+#if HAVE_PTHREADS
+    pthread_mutex_unlock(&refs_lock);
+#endif
+
+    return refs;
+}
+
 AVSequencerModule *avseq_module_create(void)
 {
     return av_mallocz(sizeof(AVSequencerModule) + FF_INPUT_BUFFER_PADDING_SIZE);
@@ -54,8 +89,12 @@ AVSequencerModule *avseq_module_create(void)
 
 void avseq_module_destroy(AVSequencerModule *module)
 {
-    if (module)
+    if (module) {
+        if (update_refs(module, 0))
+            return;
+
         av_metadata_free(&module->metadata);
+    }
 
     av_free(module);
 }
@@ -63,6 +102,7 @@ void avseq_module_destroy(AVSequencerModule *module)
 int avseq_module_open(AVSequencerContext *avctx, AVSequencerModule *module)
 {
     AVSequencerModule **module_list;
+    uint32_t refs;
     uint16_t modules;
 
     if (!avctx)
@@ -71,17 +111,20 @@ int avseq_module_open(AVSequencerContext *avctx, AVSequencerModule *module)
     module_list = avctx->module_list;
     modules     = avctx->modules;
 
-    if (!(module && ++modules)) {
+    if (!(module && ++modules && (refs = update_refs(module, 1)))) {
         return AVERROR_INVALIDDATA;
     } else if (!(module_list = av_realloc(module_list, (modules * sizeof(AVSequencerModule *)) + FF_INPUT_BUFFER_PADDING_SIZE))) {
+        update_refs(module, -1);
         av_log(avctx, AV_LOG_ERROR, "Cannot allocate module storage container.\n");
         return AVERROR(ENOMEM);
     }
 
-    module->av_class = &avseq_module_class;
+    if (refs == 1) {
+        module->av_class = &avseq_module_class;
 
-    if (!module->channels)
-        module->channels = 64;
+        if (!module->channels)
+            module->channels = 64;
+    }
 
     module_list[modules - 1] = module;
     avctx->module_list       = module_list;
@@ -134,6 +177,9 @@ void avseq_module_close(AVSequencerContext *avctx, AVSequencerModule *module)
             avctx->module_list = module_list;
             avctx->modules     = modules;
         }
+
+        if (update_refs(module, -1))
+            return;
     }
 
     i = module->songs;
@@ -182,6 +228,57 @@ void avseq_module_close(AVSequencerContext *avctx, AVSequencerModule *module)
     }
 }
 
+static void free_row_cache(AVSequencerContext *avctx)
+{
+    AVSequencerTrackRowCache *row_cache = avctx->player_row_cache;
+    uint16_t i;
+
+    for (i = 0; i < avctx->player_row_caches; ++i)
+        avseq_track_row_cache_free(row_cache + i);
+
+    av_freep(&avctx->player_row_cache);
+
+    avctx->player_row_caches = 0;
+}
+
+static void free_synth_code(AVSequencerContext *avctx)
+{
+    void **synth_code_list = avctx->player_synth_code;
+    uint16_t i;
+
+    for (i = 0; i < avctx->player_synth_codes; ++i)
+        av_free(synth_code_list[i]);
+
+    av_freep(&avctx->player_synth_code);
+
+    avctx->player_synth_codes = 0;
+}
+
+static int init_row_cache(AVSequencerContext *avctx, uint16_t channels)
+{
+    AVSequencerTrackRowCache *row_cache = avctx->player_row_cache;
+    uint16_t i;
+
+    if (avctx->player_row_caches == channels) {
+        for (i = 0; i < channels; ++i)
+            row_cache[i].track = NULL;
+
+        return 0;
+    }
+
+    free_row_cache(avctx);
+
+    if (!(row_cache = av_mallocz((channels * sizeof(AVSequencerTrackRowCache)) + FF_INPUT_BUFFER_PADDING_SIZE))) {
+        av_log(avctx, AV_LOG_ERROR, "Cannot allocate track row cache.\n");
+        return AVERROR(ENOMEM);
+    }
+
+    avctx->player_row_cache  = row_cache;
+    avctx->player_row_caches = channels;
+
+    return 0;
+}
+
 int avseq_module_play(AVSequencerContext *avctx, AVMixerContext *mixctx,
                       AVSequencerModule *module, AVSequencerSong *song,
                       const char *args, void *opaque, uint32_t mode)
@@ -196,10 +293,29 @@ int avseq_module_play(AVSequencerContext *avctx, AVMixerContext *mixctx,
     uint16_t *new_loop_stack  = NULL;
     uint64_t volume_boost;
     uint32_t tempo;
+    uint16_t i;
+    int res;
 
     if (!(avctx && module && song))
         return AVERROR_INVALIDDATA;
 
+    free_synth_code(avctx);
+
+    for (i = 0; i < module->instruments; ++i) {
+        const AVSequencerInstrument *instrument = module->instrument_list[i];
+        unsigned j;
+
+        for (j = 0; j < instrument->samples; ++j) {
+            const AVSequencerSample *sample = instrument->sample_list[j];
+
+            if (sample->synth && ((res = avseq_synth_code_compile(avctx, sample->synth)) < 0))
+                return res;
+        }
+    }
+
+    if ((res = init_row_cache(avctx, song->channels)) < 0)
+        return res;
+
     player_globals      = avctx->player_globals;
     player_host_channel = avctx->player_host_channel;
     player_channel      = avctx->player_channel;
@@ -222,6 +338,7 @@ int avseq_module_play(AVSequencerContext *avctx, AVMixerContext *mixctx,
         av_free(player_host_channel);
         av_free(player_globals);
         av_log(avctx, AV_LOG_ERROR, "Cannot allocate mixer data.\n");
+        return AVERROR(ENOMEM);
     }
 
     if (avctx->player_globals) {
@@ -394,6 +511,11 @@ void avseq_module_stop(AVSequencerContext *avctx, uint32_t mode)
             av_freep(&avctx->player_hook);
             av_freep(&avctx->player_channel);
             av_freep(&avctx->player_host_channel);
+            free_row_cache(avctx);
+            free_synth_code(avctx);
+
+            avseq_snapshot_index_destroy(avctx->player_snapshots);
+            avctx->player_snapshots = NULL;
 
             if ((player_globals = avctx->player_globals)) {
                 av_free(player_globals->gosub_stack);
@@ -405,6 +527,228 @@ void avseq_module_stop(AVSequencerContext *avctx, uint32_t mode)
     }
 }
 
+int avseq_module_start(AVSequencerContext *avctx, const char *mixer_name,
+                       const char *args, uint32_t *rate, uint32_t *channels)
+{
+    AVSequencerModule *module;
+    AVSequencerSong *song;
+    AVMixerContext *mixctx;
+    int res;
+
+    if (!(avctx && avctx->modules && (module = avctx->module_list[0]) && module->songs))
+        return AVERROR_INVALIDDATA;
+
+    if (!(mixctx = avseq_mixer_get_by_name(mixer_name))) {
+        av_log(avctx, AV_LOG_ERROR, "Mixer '%s' not found.\n", mixer_name);
+        return AVERROR(ENOSYS);
+    }
+
+    if (!mixctx->mix_tick) {
+        av_log(avctx, AV_LOG_ERROR, "Mixer '%s' does not support tick based mixing.\n", mixctx->name);
+        return AVERROR(ENOSYS);
+    }
+
+    if (!*rate)
+        *rate = mixctx->frequency;
+
+    if (!*channels)
+        *channels = mixctx->channels_out;
+
+    *channels = FFMIN(*channels, 2);
+    song      = module->song_list[0];
+
+    if ((res = avseq_module_play(avctx, mixctx, module, song, args, NULL, 1)) < 0)
+        return res;
+
+    if (!avctx->player_mixer_data) {
+        avseq_module_stop(avctx, 1);
+        return AVERROR(ENOMEM);
+    }
+
+    avseq_mixer_set_rate(avctx->player_mixer_data, *rate, *channels);
+
+    if ((res = avseq_song_reset(avctx, song)) < 0) {
+        avseq_module_stop(avctx, 1);
+        return res;
+    }
+
+    return 0;
+}
+
+int avseq_module_render(AVSequencerContext *avctx,
+                        int (*sink)(void *opaque, const int32_t *buf, uint32_t frames),
+                        void *opaque, uint32_t buf_size, uint64_t max_frames,
+                        AVSequencerRenderStats *stats)
+{
+    AVSequencerPlayerGlobals *player_globals;
+    AVMixerData *mixer_data;
+    AVMixerContext *mixctx;
+    int32_t *buf;
+    uint64_t frames = 0;
+    uint32_t chunks = 0;
+    int64_t start_time, render_time;
+    int ret         = 0;
+
+    if (!(avctx && sink && (player_globals = avctx->player_globals) && (mixer_data = avctx->player_mixer_data)))
+        return AVERROR_INVALIDDATA;
+
+    if (!((mixctx = mixer_data->mixctx) && mixctx->mix_tick)) {
+        av_log(avctx, AV_LOG_ERROR, "Mixer does not support offline rendering.\n");
+        return AVERROR(ENOSYS);
+    }
+
+    if (!buf_size)
+        buf_size = mixctx->buf_size_max;
+
+    if ((uint64_t) buf_size * (mixer_data->channels_out << 2) > INT_MAX - FF_INPUT_BUFFER_PADDING_SIZE) {
+        av_log(avctx, AV_LOG_ERROR, "Render buffer size too large.\n");
+        return AVERROR_INVALIDDATA;
+    } else if (!(buf = av_malloc((buf_size * (mixer_data->channels_out << 2)) + FF_INPUT_BUFFER_PADDING_SIZE))) {
+        av_log(avctx, AV_LOG_ERROR, "Cannot allocate render buffer.\n");
+        return AVERROR(ENOMEM);
+    }
+
+    start_time = av_gettime();
+
+    while (!(player_globals->flags & AVSEQ_PLAYER_GLOBALS_FLAG_SONG_END)) {
+        uint32_t len = buf_size;
+
+        if (max_frames) {
+            if (frames >= max_frames)
+                break;
+
+            if ((max_frames - frames) < len)
+                len = max_frames - frames;
+        }
+
+        if (!(len = mixctx->mix_tick(mixer_data, buf, len)))
+            continue;
+
+        if ((ret = sink(opaque, buf, len)) < 0)
+            break;
+
+        frames += len;
+        chunks++;
+    }
+
+    render_time = av_gettime() - start_time;
+
+    av_free(buf);
+
+    if (stats) {
+        stats->frames = frames;
+        stats->chunks = chunks;
+        stats->time   = render_time;
+        stats->fps    = render_time > 0 ? (frames * AV_TIME_BASE) / render_time : 0;
+    }
+
+    av_log(avctx, AV_LOG_VERBOSE, "Rendered %"PRIu64" frames in %"PRId64" us.\n", frames, render_time);
+
+    return (ret < 0) ? ret : 0;
+}
+
+int avseq_module_fill(AVSequencerContext *avctx, uint8_t *buf,
+                      uint32_t frames, enum AVSampleFormat sample_fmt)
+{
+    AVSequencerPlayerGlobals *player_globals;
+    AVMixerData *mixer_data;
+    AVMixerContext *mixctx;
+    enum AVSampleFormat mix_fmt;
+    uint32_t channels;
+
+    if (!(avctx && buf && (player_globals = avctx->player_globals) && (mixer_data = avctx->player_mixer_data)))
+        return AVERROR_INVALIDDATA;
+
+    if (!((mixctx = mixer_data->mixctx) && mixctx->mix_tick)) {
+        av_log(avctx, AV_LOG_ERROR, "Mixer does not support direct device output.\n");
+        return AVERROR(ENOSYS);
+    }
+
+    if (player_globals->flags & AVSEQ_PLAYER_GLOBALS_FLAG_SONG_END)
+        return AVERROR_EOF;
+
+    channels = (mixer_data->channels_out >= 2) ? 2 : 1;
+    mix_fmt  = (mixctx->flags & AVSEQ_MIXER_CONTEXT_FLAG_FLOAT) ? AV_SAMPLE_FMT_FLT : AV_SAMPLE_FMT_S32;
+
+    if (sample_fmt == mix_fmt) {
+        int32_t *out = (int32_t *) buf;
+
+        while (frames && !(player_globals->flags & AVSEQ_PLAYER_GLOBALS_FLAG_SONG_END)) {
+            const uint32_t len = mixctx->mix_tick(mixer_data, out, frames);
+
+            out    += len * channels;
+            frames -= len;
+        }
+
+        memset(out, 0, frames * (channels << 2));
+    } else if (sample_fmt == AV_SAMPLE_FMT_S16) {
+        int16_t *out = (int16_t *) buf;
+
+        if (!(mixer_data->mix_buf && mixer_data->mix_buf_size)) {
+            av_log(avctx, AV_LOG_ERROR, "Mixer has no output buffer for sample format conversion.\n");
+            return AVERROR_INVALIDDATA;
+        }
+
+        while (frames && !(player_globals->flags & AVSEQ_PLAYER_GLOBALS_FLAG_SONG_END)) {
+            const uint32_t len = mixctx->mix_tick(mixer_data, mixer_data->mix_buf, FFMIN(frames, mixer_data->mix_buf_size));
+            uint32_t i;
+
+            if (mix_fmt == AV_SAMPLE_FMT_FLT) {
+                const float *src = (const float *) mixer_data->mix_buf;
+
+                for (i = len * channels; i > 0; i--)
+                    *out++ = av_clip_int16(lrintf(*src++ * 32768.0f));
+            } else {
+                const int32_t *src = mixer_data->mix_buf;
+
+                for (i = len * channels; i > 0; i--)
+                    *out++ = av_clip_int16(*src++ >> 16);
+            }
+
+            frames -= len;
+        }
+
+        memset(out, 0, frames * (channels << 1));
+    } else {
+        av_log(avctx, AV_LOG_ERROR, "Unsupported sample format for direct device output.\n");
+        return AVERROR(ENOSYS);
+    }
+
+    return 0;
+}
+
+int avseq_module_seek(AVSequencerContext *avctx, uint64_t timestamp)
+{
+    AVSequencerPlayerSnapshotIndex *index;
+    uint64_t max_time;
+
+    if (!(avctx && avctx->player_globals && avctx->player_mixer_data))
+        return AVERROR_INVALIDDATA;
+
+    max_time = timestamp + SEEK_SNAPSHOT_INTERVAL;
+
+    if ((index = avctx->player_snapshots)) {
+        if (index->song == avctx->player_song) {
+            if (index->song_end || (index->duration > timestamp))
+                return avseq_snapshot_seek(avctx, index, timestamp);
+
+            /* The pre-scan stopped before the target time, so scan at
+               least twice as far this time.  */
+            max_time = FFMAX(max_time, index->duration << 1);
+        }
+
+        avseq_snapshot_index_destroy(index);
+        avctx->player_snapshots = NULL;
+    }
+
+    if (!(index = avseq_snapshot_index_create(avctx, avctx->player_module, avctx->player_song, SEEK_SNAPSHOT_INTERVAL, max_time)))
+        return AVERROR(ENOMEM);
+
+    avctx->player_snapshots = index;
+
+    return avseq_snapshot_seek(avctx, index, timestamp);
+}
+
 int avseq_module_set_channels(AVSequencerContext *avctx, AVSequencerModule *module,
                               uint32_t channels)
 {
@@ -417,6 +761,11 @@ int avseq_module_set_channels(AVSequencerContext *avctx, AVSequencerModule *modu
     if (channels > 65535)
         channels = 65535;
 
+    if ((module->refs > 1) && (channels != module->channels)) {
+        av_log(avctx, AV_LOG_ERROR, "Cannot change virtual channels of a module shared by %u contexts.\n", module->refs);
+        return AVERROR(EBUSY);
+    }
+
     if ((module == avctx->player_module) && (channels != module->channels)) {
         AVSequencerPlayerGlobals *player_globals;
         AVSequencerPlayerChannel *player_channel;
@@ -101,6 +101,17 @@ typedef struct AVSequencerModule {
        Some programs write editor settings for module in those chunks,
        which then won't get lost in that case.  */
     uint8_t **unknown_data;
+
+    /** Number of sequencer contexts this module is currently opened
+       to. A module can be opened to any number of contexts, each
+       keeping its own playback state in its AVSequencerPlayerGlobals
+       and channel arrays, while songs, instruments, samples, synth
+       sounds and envelopes are loaded only once and only read by the
+       playback handler. The module data is freed when it has been
+       closed from the last context it was opened to. This is only
+       changed by avseq_module_open and avseq_module_close while
+       holding a lock, so it must not be modified directly.  */
+    uint32_t refs;
 } AVSequencerModule;
 
 #endif /* AVSEQUENCER_MODULE_H */
@@ -1180,6 +1180,66 @@ static av_cold void mix_parallel(AVMixerData *const mixer_data,
     }
 }
 
+static av_cold uint32_t mix_tick(AVMixerData *const mixer_data,
+                                 int32_t *buf,
+                                 const uint32_t len)
+{
+    AV_NULLMixerData *const null_mixer_data = (AV_NULLMixerData *const) mixer_data;
+    uint32_t current_left                   = null_mixer_data->current_left;
+    uint32_t current_left_frac              = null_mixer_data->current_left_frac;
+    uint32_t mix_len;
+
+    if (!current_left) {
+        if (mixer_data->handler)
+            mixer_data->handler(mixer_data);
+
+        current_left_frac += null_mixer_data->pass_len_frac;
+        current_left       = null_mixer_data->pass_len + (current_left_frac < null_mixer_data->pass_len_frac);
+    }
+
+    mix_len       = (len > current_left) ? current_left : len;
+    current_left -= mix_len;
+
+    if (buf)
+        memset(buf, 0, mix_len << ((null_mixer_data->channels_out >= 2) ? 3 : 2));
+
+    if (mix_len)
+        mix_sample(null_mixer_data, mix_len);
+
+    if (!current_left) {
+        if (mixer_data->handler)
+            mixer_data->handler(mixer_data);
+
+        current_left_frac += null_mixer_data->pass_len_frac;
+        current_left       = null_mixer_data->pass_len + (current_left_frac < null_mixer_data->pass_len_frac);
+    }
+
+    null_mixer_data->current_left      = current_left;
+    null_mixer_data->current_left_frac = current_left_frac;
+
+    return mix_len;
+}
+
+static av_cold void get_tick_phase(const AVMixerData *const mixer_data,
+                                   uint32_t *const left,
+                                   uint32_t *const left_frac)
+{
+    const AV_NULLMixerData *const null_mixer_data = (const AV_NULLMixerData *const) mixer_data;
+
+    *left      = null_mixer_data->current_left;
+    *left_frac = null_mixer_data->current_left_frac;
+}
+
+static av_cold void set_tick_phase(AVMixerData *const mixer_data,
+                                   const uint32_t left,
+                                   const uint32_t left_frac)
+{
+    AV_NULLMixerData *const null_mixer_data = (AV_NULLMixerData *const) mixer_data;
+
+    null_mixer_data->current_left      = left;
+    null_mixer_data->current_left_frac = left_frac;
+}
+
 AVMixerContext null_mixer = {
     .av_class                          = &avseq_null_mixer_class,
     .name                              = "Null mixer",
@@ -1211,6 +1271,9 @@ AVMixerContext null_mixer = {
     .set_channel_filter                = set_channel_filter,
     .mix                               = mix,
     .mix_parallel                      = mix_parallel,
+    .mix_tick                          = mix_tick,
+    .get_tick_phase                    = get_tick_phase,
+    .set_tick_phase                    = set_tick_phase,
 };
 
 #endif /* CONFIG_NULL_MIXER */
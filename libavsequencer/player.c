@@ -782,6 +782,19 @@ static int16_t step_envelope(AVSequencerContext *const avctx,
 
     value += value_adjustment;
 
+    /* Forward running envelope not reaching its loop or end point on
+       this tick, which is the case for almost every tick, so skip the
+       loop and ping pong handling below.  */
+    if (!(player_envelope->flags & (AVSEQ_PLAYER_ENVELOPE_FLAG_BACKWARDS|AVSEQ_PLAYER_ENVELOPE_FLAG_RANDOM|AVSEQ_PLAYER_ENVELOPE_FLAG_PINGPONG)) &&
+        ((uint32_t) envelope_pos + tempo_multiplier <= player_envelope->end)) {
+        player_envelope->pos = envelope_pos += tempo_multiplier;
+
+        if (player_envelope->flags & AVSEQ_PLAYER_ENVELOPE_FLAG_FIRST_ADD)
+            value = envelope_data[envelope_pos] + value_adjustment;
+
+        return value;
+    }
+
     if (player_envelope->flags & AVSEQ_PLAYER_ENVELOPE_FLAG_BACKWARDS) {
         if (player_envelope->flags & AVSEQ_PLAYER_ENVELOPE_FLAG_LOOPING) {
             envelope_pos += tempo_multiplier;
@@ -8537,6 +8550,23 @@ EXECUTE_SYNTH_CODE_INSTRUCTION(nop)
     return synth_code_line;
 }
 
+static const AVSequencerTrackRow *get_track_row(const AVSequencerContext *const avctx,
+                                                const AVSequencerTrack *const track,
+                                                const uint16_t row,
+                                                const uint16_t channel)
+{
+    static const AVSequencerTrackRow empty_track_row;
+    const AVSequencerTrackRow *track_data;
+
+    if (track->data)
+        return track->data + row;
+
+    if (!(track_data = avseq_track_get_row(track, row, (channel < avctx->player_row_caches) ? avctx->player_row_cache + channel : NULL)))
+        track_data = &empty_track_row;
+
+    return track_data;
+}
+
 static void process_row(const AVSequencerContext *const avctx,
                         AVSequencerPlayerHostChannel *const player_host_channel,
                         AVSequencerPlayerChannel *const player_channel,
@@ -8713,7 +8743,7 @@ loop_to_row:
 
         player_host_channel->row = row;
 
-        if ((int) ((player_host_channel->track->data) + row)->note == AVSEQ_TRACK_DATA_NOTE_END) {
+        if ((int) get_track_row(avctx, player_host_channel->track, row, channel)->note == AVSEQ_TRACK_DATA_NOTE_END) {
             if (++counted)
                 goto get_new_pattern;
 
@@ -8860,6 +8890,200 @@ static const AVSequencerPlayerEffects fx_lut[128] = {
     {user_sync,                         NULL,                   NULL,                       AVSEQ_PLAYER_EFFECTS_FLAG_EXEC_WHOLE_ROW,   0x00, 0x0000}
 };
 
+static const void *se_lut[128] = {
+    se_stop,    se_kill,    se_wait,    se_waitvol, se_waitpan, se_waitsld, se_waitspc, se_jump,
+    se_jumpeq,  se_jumpne,  se_jumppl,  se_jumpmi,  se_jumplt,  se_jumple,  se_jumpgt,  se_jumpge,
+    se_jumpvs,  se_jumpvc,  se_jumpcs,  se_jumpcc,  se_jumpls,  se_jumphi,  se_jumpvol, se_jumppan,
+    se_jumpsld, se_jumpspc, se_call,    se_ret,     se_posvar,  se_load,    se_add,     se_addx,
+    se_sub,     se_subx,    se_cmp,     se_mulu,    se_muls,    se_dmulu,   se_dmuls,   se_divu,
+    se_divs,    se_modu,    se_mods,    se_ddivu,   se_ddivs,   se_ashl,    se_ashr,    se_lshl,
+    se_lshr,    se_rol,     se_ror,     se_rolx,    se_rorx,    se_or,      se_and,     se_xor,
+    se_not,     se_neg,     se_negx,    se_extb,    se_ext,     se_xchg,    se_swap,    se_getwave,
+    se_getwlen, se_getwpos, se_getchan, se_getnote, se_getrans, se_getptch, se_getper,  se_getfx,
+    se_getarpw, se_getarpv, se_getarpl, se_getarpp, se_getvibw, se_getvibv, se_getvibl, se_getvibp,
+    se_gettrmw, se_gettrmv, se_gettrml, se_gettrmp, se_getpanw, se_getpanv, se_getpanl, se_getpanp,
+    se_getrnd,  se_getsine, se_portaup, se_portadn, se_vibspd,  se_vibdpth, se_vibwave, se_vibwavp,
+    se_vibrato, se_vibval,  se_arpspd,  se_arpwave, se_arpwavp, se_arpegio, se_arpval,  se_setwave,
+    se_isetwav, se_setwavp, se_setrans, se_setnote, se_setptch, se_setper,  se_reset,   se_volslup,
+    se_volsldn, se_trmspd,  se_trmdpth, se_trmwave, se_trmwavp, se_tremolo, se_trmval,  se_panleft,
+    se_panrght, se_panspd,  se_pandpth, se_panwave, se_panwavp, se_pannolo, se_panval,  se_nop
+};
+
+/** Pre-decoded synth sound code instruction. Either exec_func or
+   effect is set, if both are NULL the line terminates execution.  */
+typedef struct SynthCodeOp {
+    uint16_t (*exec_func)(AVSequencerContext *const avctx,
+                          AVSequencerPlayerChannel *const player_channel,
+                          const uint16_t virtual_channel,
+                          uint16_t synth_code_line,
+                          const int src_var,
+                          int dst_var,
+                          uint16_t instruction_data,
+                          const int synth_type);
+    const AVSequencerPlayerEffects *effect;
+    uint16_t data;
+    uint16_t next_line;
+    uint8_t src_var;
+    uint8_t dst_var;
+    uint8_t fx_byte;
+} SynthCodeOp;
+
+/** Header of the pre-decoded synth sound code stored in the sequencer
+   context, followed by size SynthCodeOp entries.  */
+typedef struct SynthCompiledCode {
+    const AVSequencerSynth *synth;
+    const AVSequencerSynthCode *code;
+    const void *exec_lut;
+    const void *effects_lut;
+    uint16_t size;
+} SynthCompiledCode;
+
+/** Pre-decodes the synth sound code into the slot of the context's
+   synth code list. Instruction and effect handlers are resolved, the
+   variable nibbles are split and runs of NOP instructions are skipped
+   by continuing at the next line doing actual work, except after
+   instructions which expose the line number (CALL, RET and POSVAR).  */
+static const SynthCompiledCode *compile_synth_code(AVSequencerContext *const avctx,
+                                                   const uint16_t slot,
+                                                   const AVSequencerSynth *const synth)
+{
+    const void *exec_lut    = avctx->synth_code_exec_lut ? avctx->synth_code_exec_lut : se_lut;
+    const void *effects_lut = avctx->effects_lut ? avctx->effects_lut : fx_lut;
+    const AVSequencerSynthCode *synth_code;
+    SynthCompiledCode *compiled;
+    SynthCodeOp *op;
+    uint16_t i, next_line;
+
+    av_freep(&avctx->player_synth_code[slot]);
+
+    if (!(compiled = av_malloc(sizeof(SynthCompiledCode) + (synth->size * sizeof(SynthCodeOp)) + FF_INPUT_BUFFER_PADDING_SIZE))) {
+        av_log(avctx, AV_LOG_ERROR, "Cannot allocate pre-decoded synth sound code.\n");
+
+        return NULL;
+    }
+
+    compiled->synth       = synth;
+    compiled->code        = synth->code;
+    compiled->exec_lut    = exec_lut;
+    compiled->effects_lut = effects_lut;
+    compiled->size        = synth->size;
+    synth_code            = synth->code;
+    op                    = (SynthCodeOp *) (compiled + 1);
+
+    for (i = 0; i < synth->size; i++) {
+        const int8_t instruction = synth_code[i].instruction;
+
+        op[i].exec_func = NULL;
+        op[i].effect    = NULL;
+        op[i].data      = synth_code[i].data;
+        op[i].src_var   = synth_code[i].src_dst_var >> 4;
+        op[i].dst_var   = synth_code[i].src_dst_var & 0x0F;
+        op[i].fx_byte   = ~instruction;
+
+        if (!instruction && !synth_code[i].src_dst_var && !synth_code[i].data)
+            continue;
+
+        if (instruction < 0)
+            op[i].effect    = (const AVSequencerPlayerEffects *) effects_lut + (uint8_t) ~instruction;
+        else
+            op[i].exec_func = ((void *const *) exec_lut)[(uint8_t) instruction];
+    }
+
+    next_line = synth->size;
+    i         = synth->size;
+
+    while (i--) {
+        if ((exec_lut != se_lut) || (op[i].exec_func == se_call) || (op[i].exec_func == se_ret) || (op[i].exec_func == se_posvar))
+            op[i].next_line = i + 1;
+        else
+            op[i].next_line = next_line;
+
+        if (op[i].exec_func != se_nop)
+            next_line = i;
+    }
+
+    avctx->player_synth_code[slot] = compiled;
+
+    return compiled;
+}
+
+/** Returns the slot of the synth sound in the context's synth code
+   list, appending a new empty slot if the synth sound has not been
+   pre-decoded yet, or a negative error code.  */
+static int get_synth_code_slot(AVSequencerContext *const avctx,
+                               const AVSequencerSynth *const synth)
+{
+    void **synth_code_list = avctx->player_synth_code;
+    uint16_t synth_codes   = avctx->player_synth_codes, i;
+
+    for (i = 0; i < synth_codes; ++i) {
+        const SynthCompiledCode *compiled = synth_code_list[i];
+
+        if (compiled && (compiled->synth == synth))
+            return i;
+    }
+
+    if (!++synth_codes) {
+        av_log(avctx, AV_LOG_ERROR, "Exceeded maximum number of pre-decoded synth sound codes.\n");
+        return AVERROR_INVALIDDATA;
+    } else if (!(synth_code_list = av_realloc(synth_code_list, (synth_codes * sizeof(void *)) + FF_INPUT_BUFFER_PADDING_SIZE))) {
+        av_log(avctx, AV_LOG_ERROR, "Cannot allocate pre-decoded synth sound code list.\n");
+        return AVERROR(ENOMEM);
+    }
+
+    synth_code_list[i]        = NULL;
+    avctx->player_synth_code  = synth_code_list;
+    avctx->player_synth_codes = synth_codes;
+
+    return i;
+}
+
+/** Returns the slot of the pre-decoded synth sound code of the context,
+   (re-)compiling it if the synth sound code has been reallocated or the
+   context uses different lookup tables, or a negative error code.  */
+static int update_synth_code(AVSequencerContext *const avctx,
+                             const AVSequencerSynth *const synth)
+{
+    const void *exec_lut    = avctx->synth_code_exec_lut ? avctx->synth_code_exec_lut : se_lut;
+    const void *effects_lut = avctx->effects_lut ? avctx->effects_lut : fx_lut;
+    const SynthCompiledCode *compiled;
+    int slot;
+
+    if ((slot = get_synth_code_slot(avctx, synth)) < 0)
+        return slot;
+
+    compiled = avctx->player_synth_code[slot];
+
+    if (!(compiled && (compiled->code == synth->code) && (compiled->size == synth->size) && (compiled->exec_lut == exec_lut) && (compiled->effects_lut == effects_lut)))
+        compile_synth_code(avctx, slot, synth);
+
+    return slot;
+}
+
+/** Returns the pre-decoded synth sound code resolved for the virtual
+   channel by init_new_sample or NULL if it could not be decoded.  */
+static inline const SynthCompiledCode *get_synth_code(const AVSequencerContext *const avctx,
+                                                      const AVSequencerPlayerChannel *const player_channel)
+{
+    const uint16_t slot = player_channel->synth_code_slot;
+
+    return (slot < avctx->player_synth_codes) ? avctx->player_synth_code[slot] : NULL;
+}
+
+int avseq_synth_code_compile(AVSequencerContext *avctx,
+                             const AVSequencerSynth *synth)
+{
+    int slot;
+
+    if (!(avctx && synth))
+        return AVERROR_INVALIDDATA;
+
+    if ((slot = get_synth_code_slot(avctx, synth)) < 0)
+        return slot;
+
+    return compile_synth_code(avctx, slot, synth) ? 0 : AVERROR(ENOMEM);
+}
+
 static void get_effects(const AVSequencerContext *const avctx,
                         AVSequencerPlayerHostChannel *const player_host_channel,
                         AVSequencerPlayerChannel *const player_channel,
@@ -8873,7 +9097,7 @@ static void get_effects(const AVSequencerContext *const avctx,
     if (!(track = player_host_channel->track))
         return;
 
-    track_data = track->data + player_host_channel->row;
+    track_data = get_track_row(avctx, track, player_host_channel->row, channel);
 
     if ((track_fx = player_host_channel->effect)) {
         while (++fx < track_data->effects) {
@@ -8939,7 +9163,7 @@ static void run_effects(AVSequencerContext *const avctx,
 
     if ((track = player_host_channel->track) && player_host_channel->effect) {
         const AVSequencerTrackEffect *track_fx;
-        const AVSequencerTrackRow *const track_data = track->data + player_host_channel->row;
+        const AVSequencerTrackRow *const track_data = get_track_row(avctx, track, player_host_channel->row, channel);
         uint32_t fx                                 = -1;
 
         while ((++fx < track_data->effects) && ((track_fx = track_data->effects_data[fx]))) {
@@ -9456,6 +9680,28 @@ nna_found:
     return new_player_channel;
 }
 
+/** Returns the stem a newly played note is routed to.  */
+static uint16_t get_stem(const AVSequencerContext *const avctx,
+                         const AVSequencerPlayerChannel *const player_channel)
+{
+    const AVMixerData *const mixer_data = avctx->player_mixer_data;
+    uint32_t stems, stem = player_channel->host_channel;
+
+    if (!(mixer_data && (stems = mixer_data->stems)))
+        return 0;
+
+    if (avctx->stem_mode == AVSEQ_STEM_MODE_INSTRUMENT) {
+        const AVSequencerModule *const module = avctx->player_module;
+
+        for (stem = 0; stem < module->instruments; stem++) {
+            if (module->instrument_list[stem] == player_channel->instrument)
+                break;
+        }
+    }
+
+    return stem % stems;
+}
+
 static AVSequencerPlayerChannel *play_note_got(AVSequencerContext *const avctx,
                                                AVSequencerPlayerHostChannel *const player_host_channel,
                                                AVSequencerPlayerChannel *player_channel,
@@ -9499,6 +9745,7 @@ static AVSequencerPlayerChannel *play_note_got(AVSequencerContext *const avctx,
     player_channel->sample               = player_host_channel->sample;
     player_channel->instr_note           = player_host_channel->instr_note;
     player_channel->sample_note          = player_host_channel->sample_note;
+    player_channel->mixer.stem           = get_stem(avctx, player_channel);
 
     if (player_channel->instr_note || player_channel->sample_note) {
         const int16_t final_note = player_host_channel->final_note;
@@ -9863,7 +10110,7 @@ static void init_new_instrument(AVSequencerContext *const avctx,
     }
 }
 
-static void init_new_sample(const AVSequencerContext *const avctx,
+static void init_new_sample(AVSequencerContext *const avctx,
                             AVSequencerPlayerHostChannel *const player_host_channel,
                             AVSequencerPlayerChannel *const player_channel)
 {
@@ -9873,10 +10120,14 @@ static void init_new_sample(const AVSequencerContext *const avctx,
     uint32_t samples;
 
     if ((samples = sample->samples)) {
+        const int16_t *data = sample->data;
         uint8_t flags, repeat_mode, playback_flags;
 
+        if (!data && avctx->load_sample)
+            data = avctx->load_sample(avctx, sample);
+
         player_channel->mixer.len  = samples;
-        player_channel->mixer.data = sample->data;
+        player_channel->mixer.data = data;
         player_channel->mixer.rate = player_channel->frequency;
         flags                      = sample->flags;
 
@@ -9920,9 +10171,15 @@ static void init_new_sample(const AVSequencerContext *const avctx,
         const uint16_t *src_var;
         uint16_t *dst_var;
         uint16_t keep_flags, i;
+        int slot;
 
         player_channel->mixer.flags |= AVSEQ_MIXER_CHANNEL_FLAG_PLAY;
 
+        if ((slot = update_synth_code(avctx, player_channel->synth)) < 0)
+            slot = 0xFFFF;
+
+        player_channel->synth_code_slot = slot;
+
         if (!player_host_channel->waveform_list || !(synth->pos_keep_mask & AVSEQ_SYNTH_POS_KEEP_MASK_WAVEFORMS)) {
             AVSequencerSynthWave *const *waveform_list = synth->waveform_list;
             const AVSequencerSynthWave *waveform       = NULL;
@@ -10116,7 +10373,7 @@ static uint32_t get_note(AVSequencerContext *const avctx,
     if (player_host_channel->pattern_delay_count || (player_host_channel->tempo_counter != player_host_channel->note_delay) || !(track = player_host_channel->track))
         return 0;
 
-    track_data = track->data + player_host_channel->row;
+    track_data = get_track_row(avctx, track, player_host_channel->row, channel);
 
     if (!(track_data->octave || track_data->note || track_data->instrument))
         return 0;
@@ -10317,41 +10574,22 @@ static uint32_t get_note(AVSequencerContext *const avctx,
     return 0;
 }
 
-static const void *se_lut[128] = {
-    se_stop,    se_kill,    se_wait,    se_waitvol, se_waitpan, se_waitsld, se_waitspc, se_jump,
-    se_jumpeq,  se_jumpne,  se_jumppl,  se_jumpmi,  se_jumplt,  se_jumple,  se_jumpgt,  se_jumpge,
-    se_jumpvs,  se_jumpvc,  se_jumpcs,  se_jumpcc,  se_jumpls,  se_jumphi,  se_jumpvol, se_jumppan,
-    se_jumpsld, se_jumpspc, se_call,    se_ret,     se_posvar,  se_load,    se_add,     se_addx,
-    se_sub,     se_subx,    se_cmp,     se_mulu,    se_muls,    se_dmulu,   se_dmuls,   se_divu,
-    se_divs,    se_modu,    se_mods,    se_ddivu,   se_ddivs,   se_ashl,    se_ashr,    se_lshl,
-    se_lshr,    se_rol,     se_ror,     se_rolx,    se_rorx,    se_or,      se_and,     se_xor,
-    se_not,     se_neg,     se_negx,    se_extb,    se_ext,     se_xchg,    se_swap,    se_getwave,
-    se_getwlen, se_getwpos, se_getchan, se_getnote, se_getrans, se_getptch, se_getper,  se_getfx,
-    se_getarpw, se_getarpv, se_getarpl, se_getarpp, se_getvibw, se_getvibv, se_getvibl, se_getvibp,
-    se_gettrmw, se_gettrmv, se_gettrml, se_gettrmp, se_getpanw, se_getpanv, se_getpanl, se_getpanp,
-    se_getrnd,  se_getsine, se_portaup, se_portadn, se_vibspd,  se_vibdpth, se_vibwave, se_vibwavp,
-    se_vibrato, se_vibval,  se_arpspd,  se_arpwave, se_arpwavp, se_arpegio, se_arpval,  se_setwave,
-    se_isetwav, se_setwavp, se_setrans, se_setnote, se_setptch, se_setper,  se_reset,   se_volslup,
-    se_volsldn, se_trmspd,  se_trmdpth, se_trmwave, se_trmwavp, se_tremolo, se_trmval,  se_panleft,
-    se_panrght, se_panspd,  se_pandpth, se_panwave, se_panwavp, se_pannolo, se_panval,  se_nop
-};
-
 static int execute_synth(AVSequencerContext *const avctx,
                          AVSequencerPlayerHostChannel *const player_host_channel,
                          AVSequencerPlayerChannel *const player_channel,
                          const uint16_t channel,
                          const int synth_type)
 {
+    const AVSequencerSynth *synth      = player_channel->synth;
+    const SynthCompiledCode *compiled  = get_synth_code(avctx, player_channel);
     uint16_t synth_count = 0, bit_mask = 1 << synth_type;
 
-    do {
-        const AVSequencerSynth *synth          = player_channel->synth;
-        const AVSequencerSynthCode *synth_code = synth->code;
-        uint16_t synth_code_line               = player_channel->entry_pos[synth_type], instruction_data, i;
-        int8_t instruction;
-        int src_var, dst_var;
+    if (!compiled)
+        return 0;
 
-        synth_code += synth_code_line;
+    do {
+        const SynthCodeOp *op;
+        uint16_t synth_code_line = player_channel->entry_pos[synth_type];
 
         if (player_channel->wait_count[synth_type]--) {
 exec_synth_done:
@@ -10364,33 +10602,13 @@ exec_synth_done:
 
         player_channel->wait_count[synth_type] = 0;
 
-        if ((synth_code_line >= synth->size) || ((int8_t) player_channel->wait_type[synth_type] < 0))
+        if ((synth_code_line >= compiled->size) || ((int8_t) player_channel->wait_type[synth_type] < 0))
             goto exec_synth_done;
 
-        i = 4 - 1;
+        op = (const SynthCodeOp *) (compiled + 1) + synth_code_line;
 
-        do {
-            int8_t wait_volume_type;
-
-            if (((wait_volume_type = ~player_channel->wait_type[synth_type]) >= 0) && (wait_volume_type == i) && (player_channel->wait_line[synth_type] == synth_code_line))
-                player_channel->wait_type[synth_type] = 0;
-
-        } while (i--);
-
-        instruction      = synth_code->instruction;
-        dst_var          = synth_code->src_dst_var;
-        instruction_data = synth_code->data;
-
-        if (!instruction && !dst_var && !instruction_data)
-            goto exec_synth_done;
-
-        src_var  = dst_var >> 4;
-        dst_var &= 0x0F;
-
-        synth_code_line++;
-
-        if (instruction < 0) {
-            const AVSequencerPlayerEffects *effects_lut;
+        if (op->effect) {
+            const AVSequencerPlayerEffects *effects_lut = op->effect;
             void (*check_func)(const AVSequencerContext *const avctx,
                                AVSequencerPlayerHostChannel *const player_host_channel,
                                AVSequencerPlayerChannel *const player_channel,
@@ -10398,40 +10616,39 @@ exec_synth_done:
                                uint16_t *const fx_byte,
                                uint16_t *const data_word,
                                uint16_t *const flags);
-            uint16_t fx_byte, data_word, flags;
+            uint16_t fx_byte, data_word, flags, virtual_channel;
 
-            fx_byte     = ~instruction;
-            effects_lut = (const AVSequencerPlayerEffects *) (avctx->effects_lut ? avctx->effects_lut : fx_lut) + fx_byte;
-            data_word   = instruction_data + player_channel->variable[src_var];
-            flags       = effects_lut->flags;
+            fx_byte   = op->fx_byte;
+            data_word = op->data + player_channel->variable[op->src_var];
+            flags     = effects_lut->flags;
 
             if ((check_func = effects_lut->check_fx_func)) {
                 check_func(avctx, player_host_channel, player_channel, player_channel->host_channel, &fx_byte, &data_word, &flags);
 
-                effects_lut = (const AVSequencerPlayerEffects *) (avctx->effects_lut ? avctx->effects_lut : fx_lut) + fx_byte;
+                effects_lut = (const AVSequencerPlayerEffects *) compiled->effects_lut + fx_byte;
             }
 
             if (!effects_lut->pre_pattern_func) {
-                instruction_data                     = player_host_channel->virtual_channel;
+                virtual_channel                      = player_host_channel->virtual_channel;
                 player_host_channel->virtual_channel = channel;
 
                 effects_lut->effect_func(avctx, player_host_channel, player_channel, player_channel->host_channel, fx_byte, data_word);
 
-                player_host_channel->virtual_channel = instruction_data;
+                player_host_channel->virtual_channel = virtual_channel;
             }
 
-            player_channel->entry_pos[synth_type] = synth_code_line;
-        } else {
-            uint16_t (**const fx_exec_func)(const AVSequencerContext *const avctx,
-                                            AVSequencerPlayerChannel *const player_channel,
-                                            const uint16_t virtual_channel,
-                                            uint16_t synth_code_line,
-                                            const int src_var,
-                                            int dst_var,
-                                            uint16_t instruction_data,
-                                            const int synth_type) = (avctx->synth_code_exec_lut ? avctx->synth_code_exec_lut : se_lut);
+            player_channel->entry_pos[synth_type] = synth_code_line + 1;
+
+            if (player_channel->synth != synth) {
+                synth = player_channel->synth;
 
-            player_channel->entry_pos[synth_type] = fx_exec_func[(uint8_t) instruction](avctx, player_channel, channel, synth_code_line, src_var, dst_var, instruction_data, synth_type);
+                if (!(compiled = get_synth_code(avctx, player_channel)))
+                    return 0;
+            }
+        } else if (op->exec_func) {
+            player_channel->entry_pos[synth_type] = op->exec_func(avctx, player_channel, channel, op->next_line, op->src_var, op->dst_var, op->data, synth_type);
+        } else {
+            goto exec_synth_done;
         }
     } while (++synth_count);
 
@@ -10489,6 +10706,75 @@ static inline uint64_t divu_128(const uint64_t *const a,
 }
 #endif
 
+static void execute_commands(AVSequencerContext *const avctx,
+                             AVMixerData *const mixer_data)
+{
+    const AVSequencerSong *const song              = avctx->player_song;
+    AVSequencerPlayerGlobals *const player_globals = avctx->player_globals;
+    AVSequencerPlayerCommand command;
+
+    while (avseq_command_receive(avctx, &command)) {
+        AVSequencerPlayerHostChannel *const player_host_channel = avctx->player_host_channel + command.channel;
+        AVSequencerPlayerChannel *player_channel;
+        const AVSequencerPlayerEffects *effects_lut;
+        uint64_t tempo;
+        uint16_t fx_byte, data_word, flags;
+
+        switch (command.type) {
+        case AVSEQ_PLAYER_COMMAND_EFFECT :
+            if (command.channel >= song->channels)
+                break;
+
+            player_channel = avctx->player_channel + player_host_channel->virtual_channel;
+            fx_byte        = command.effect & 0x7F;
+            data_word      = command.value;
+            effects_lut    = (const AVSequencerPlayerEffects *) (avctx->effects_lut ? avctx->effects_lut : fx_lut) + fx_byte;
+            flags          = effects_lut->flags;
+
+            /* same stages as a track effect: row setup, then the effect mapping */
+            if (effects_lut->pre_pattern_func)
+                effects_lut->pre_pattern_func(avctx, player_host_channel, player_channel, command.channel, data_word);
+
+            if (effects_lut->check_fx_func) {
+                effects_lut->check_fx_func(avctx, player_host_channel, player_channel, command.channel, &fx_byte, &data_word, &flags);
+
+                effects_lut = (const AVSequencerPlayerEffects *) (avctx->effects_lut ? avctx->effects_lut : fx_lut) + fx_byte;
+            }
+
+            if (effects_lut->effect_func)
+                effects_lut->effect_func(avctx, player_host_channel, player_channel, command.channel, fx_byte, data_word);
+
+            break;
+        case AVSEQ_PLAYER_COMMAND_MUTE :
+            if (command.channel < song->channels)
+                player_host_channel->flags |= AVSEQ_PLAYER_HOST_CHANNEL_FLAG_MUTED;
+
+            break;
+        case AVSEQ_PLAYER_COMMAND_UNMUTE :
+            if (command.channel < song->channels)
+                player_host_channel->flags &= ~AVSEQ_PLAYER_HOST_CHANNEL_FLAG_MUTED;
+
+            break;
+        case AVSEQ_PLAYER_COMMAND_RELATIVE_SPEED :
+            if (!command.value)
+                break;
+
+            player_globals->relative_speed = command.value;
+            tempo                          = (player_globals->tempo * command.value) >> 16;
+
+            if (tempo && (tempo <= UINT64_C(0xFFFFFFFF)) && mixer_data->mixctx->set_tempo)
+                mixer_data->mixctx->set_tempo(mixer_data, tempo);
+
+            break;
+        case AVSEQ_PLAYER_COMMAND_RELATIVE_PITCH :
+            if (command.value)
+                player_globals->relative_pitch = command.value;
+
+            break;
+        }
+    }
+}
+
 int avseq_playback_handler(AVMixerData *mixer_data)
 {
     AVSequencerContext *const avctx                   = (AVSequencerContext *) mixer_data->opaque;
@@ -10512,6 +10798,9 @@ int avseq_playback_handler(AVMixerData *mixer_data)
         player_channel++;
     } while (++channel < module->channels);
 
+    if (avctx->player_commands)
+        execute_commands(avctx, mixer_data);
+
     if (player_globals->flags & AVSEQ_PLAYER_GLOBALS_FLAG_TRACE_MODE) {
         if (!player_globals->trace_count--)
             player_globals->trace_count = 0;
@@ -10920,6 +11209,9 @@ turn_note_off:
             if (!(player_channel->flags & AVSEQ_PLAYER_CHANNEL_FLAG_BACKGROUND) && (player_host_channel->virtual_channel == channel) && (player_host_channel->flags & AVSEQ_PLAYER_HOST_CHANNEL_FLAG_TREMOR_EXEC) && (!(player_host_channel->flags & AVSEQ_PLAYER_HOST_CHANNEL_FLAG_TREMOR_ON)))
                 host_volume = 0;
 
+            if (player_host_channel->flags & AVSEQ_PLAYER_HOST_CHANNEL_FLAG_MUTED)
+                host_volume = 0;
+
 #ifdef ACCURATE_VOLUMES
             host_volume                 *= (uint16_t) player_host_channel->track_volume * (uint16_t) player_channel->instr_volume;
             virtual_volume               = (uint32_t) player_channel->fade_out_count * ((((uint16_t) player_channel->vol_env.value >> 8U) * (uint16_t) player_channel->global_volume));
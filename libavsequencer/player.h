@@ -481,6 +481,7 @@ enum AVSequencerPlayerHostChannelFlags {
     AVSEQ_PLAYER_HOST_CHANNEL_FLAG_SET_SAMPLE       = 0x00200000, ///< Only playing sample without instrument, order list and pattern processing
     AVSEQ_PLAYER_HOST_CHANNEL_FLAG_NO_TRANSPOSE     = 0x00400000, ///< Instrument can't be transpoed by the order list
     AVSEQ_PLAYER_HOST_CHANNEL_FLAG_DEFAULT_PANNING  = 0x00800000, ///< Use instrument panning and override sample default panning
+    AVSEQ_PLAYER_HOST_CHANNEL_FLAG_MUTED            = 0x01000000, ///< Host channel and its NNA background channels are muted by a player command
     AVSEQ_PLAYER_HOST_CHANNEL_FLAG_SONG_END         = 0x80000000, ///< Song end triggered for this host channel / track
 };
 
@@ -1977,6 +1978,14 @@ typedef struct AVSequencerPlayerChannel {
     /** Current PANNOLO synth sound instruction rate or 0 if the
        current sample does not use synth sound.  */
     uint16_t pannolo_rate;
+
+    /** Slot of the pre-decoded code of the synth sound in the
+       sequencer context's player_synth_code list. It is resolved
+       when the synth sound is assigned to this virtual channel, so
+       the synth sound code executed each tick does not need to be
+       looked up. The slot stays valid when the code is pre-decoded
+       again, unlike a pointer to it which a snapshot would keep.  */
+    uint16_t synth_code_slot;
 } AVSequencerPlayerChannel;
 
 #include "libavsequencer/avsequencer.h"
@@ -2069,4 +2078,135 @@ typedef struct AVSequencerPlayerHook {
     uint64_t hook_len;
 } AVSequencerPlayerHook;
 
+/** AVSequencerPlayerCommand->type values.  */
+enum AVSequencerPlayerCommandType {
+    AVSEQ_PLAYER_COMMAND_EFFECT         = 0x00, ///< Execute track effect command with data value on host channel once
+    AVSEQ_PLAYER_COMMAND_MUTE           = 0x01, ///< Mute host channel including its NNA background channels
+    AVSEQ_PLAYER_COMMAND_UNMUTE         = 0x02, ///< Unmute host channel including its NNA background channels
+    AVSEQ_PLAYER_COMMAND_RELATIVE_SPEED = 0x03, ///< Set relative speed to value, 65536 (=0x10000) is 100%
+    AVSEQ_PLAYER_COMMAND_RELATIVE_PITCH = 0x04, ///< Set relative pitch to value, 65536 (=0x10000) is 100%
+};
+
+/**
+ * Player command which is sent by a control thread to the playback
+ * handler through the command queue of the sequencer context. The
+ * playback handler executes all pending commands at the start of
+ * the next tick.
+ * New fields can be added to the end with minor version bumps.
+ * Removal, reordering and changes to existing fields require a major
+ * version bump.
+ */
+typedef struct AVSequencerPlayerCommand {
+    /** Type of the command, see enum AVSequencerPlayerCommandType.  */
+    uint8_t type;
+
+    /** Track effect command number to be executed for the effect
+       command type, ignored otherwise.  */
+    uint8_t effect;
+
+    /** Host channel number (counting from 0) the command applies to,
+       ignored by the relative speed and pitch commands.  */
+    uint16_t channel;
+
+    /** Data word of the track effect or the new relative speed or
+       pitch value.  */
+    uint32_t value;
+} AVSequencerPlayerCommand;
+
+/**
+ * Single-producer single-consumer command queue which allows exactly
+ * one control thread to pass commands to the playback handler without
+ * any locking. The write position is only changed by the sending
+ * thread and the read position only by the playback handler.
+ * New fields can be added to the end with minor version bumps.
+ * Removal, reordering and changes to existing fields require a major
+ * version bump.
+ */
+typedef struct AVSequencerPlayerCommandQueue {
+    /** Array (of size commands) containing the ring buffer of
+       commands.  */
+    AVSequencerPlayerCommand *command_list;
+
+    /** Number of commands the ring buffer can hold, always a power
+       of two.  */
+    uint32_t commands;
+
+    /** Number of commands sent so far, wrapping around, i.e. the
+       write position in the ring buffer masked by commands - 1.  */
+    volatile uint32_t write_pos;
+
+    /** Number of commands received so far, wrapping around, i.e. the
+       read position in the ring buffer masked by commands - 1.  */
+    volatile uint32_t read_pos;
+} AVSequencerPlayerCommandQueue;
+
+/**
+ * Player state snapshot which contains everything required to resume
+ * playback of a sub-song at the tick it was taken, i.e. the player
+ * globals, the host and virtual channel data, the stack contents and
+ * the current and next mixer channel data of every virtual channel.
+ * New fields can be added to the end with minor version bumps.
+ * Removal, reordering and changes to existing fields require a major
+ * version bump.
+ */
+typedef struct AVSequencerPlayerSnapshot {
+    /** Playing time of the module in AV_TIME_BASE fractional seconds
+       at which the snapshot has been taken.  */
+    uint64_t play_time;
+
+    /** Copy of the player globals. The stack pointers point to the
+       stack copies of this snapshot.  */
+    AVSequencerPlayerGlobals player_globals;
+
+    /** Copy of the host channel data, one entry per sub-song
+       channel.  */
+    AVSequencerPlayerHostChannel *player_host_channel;
+
+    /** Copy of the virtual channel data, one entry per module
+       channel.  */
+    AVSequencerPlayerChannel *player_channel;
+
+    /** Current and next mixer channel data of each virtual channel,
+       stored in pairs.  */
+    AVMixerChannel *mixer_channel;
+
+    /** Randomization seed value of the sequencer context.  */
+    uint32_t seed;
+
+    /** Tempo of the mixer in AV_TIME_BASE fractional seconds.  */
+    uint32_t tempo;
+} AVSequencerPlayerSnapshot;
+
+/**
+ * Snapshot index of a sub-song which is built by a pre-scan with the
+ * null mixer and allows seeking by restoring the nearest snapshot and
+ * only simulating the remaining ticks.
+ * New fields can be added to the end with minor version bumps.
+ * Removal, reordering and changes to existing fields require a major
+ * version bump.
+ */
+typedef struct AVSequencerPlayerSnapshotIndex {
+    /** Sub-song the snapshots have been taken from.  */
+    AVSequencerSong *song;
+
+    /** Minimum playing time distance between two snapshots in
+       AV_TIME_BASE fractional seconds.  */
+    uint64_t interval;
+
+    /** Array of pointers containing every snapshot ordered by
+       ascending playing time.  */
+    AVSequencerPlayerSnapshot **snapshot_list;
+
+    /** Number of snapshots stored in the index.  */
+    uint32_t snapshots;
+
+    /** Playing time in AV_TIME_BASE fractional seconds at which the
+       pre-scan stopped, i.e. the song end if it has been found.  */
+    uint64_t duration;
+
+    /** 1 if the pre-scan stopped at the song end, 0 if it stopped
+       at the maximum scanning time.  */
+    uint8_t song_end;
+} AVSequencerPlayerSnapshotIndex;
+
 #endif /* AVSEQUENCER_PLAYER_H */
@@ -0,0 +1,548 @@
+/*
+ * Implement AVSequencer player state snapshots
+ * Copyright (c) 2010 Sebastian Vater <cdgs.basty@googlemail.com>
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Implement AVSequencer sub-song pre-scanning, player state snapshots
+ * and seeking.
+ */
+
+#include "libavutil/log.h"
+#include "libavutil/mathematics.h"
+#include "libavcodec/avcodec.h"
+#include "libavsequencer/avsequencer.h"
+#include "libavsequencer/player.h"
+
+/** Pre-scan state passed to the hook functions.  */
+typedef struct PreScan {
+    AVMixerData *mixer_data;
+    void *opaque;
+    uint64_t next_time;
+    uint64_t last_time;
+    uint64_t duration;
+    unsigned int timeline_size;
+    unsigned int loop_list_size;
+    uint32_t last_order;
+    uint16_t last_row;
+    uint8_t song_end;
+    int error;
+} PreScan;
+
+/** Placeholder for the data of samples left in the file. The null
+   mixer never reads sample data, so pre-scans and seeks do not load
+   them, and the actual data is only requested for the channels which
+   are transferred to the mixer used for playback.  */
+static const int16_t placeholder_data[1];
+
+static const int16_t *placeholder_load_sample(const AVSequencerContext *avctx,
+                                              const AVSequencerSample *sample)
+{
+    return placeholder_data;
+}
+
+/** Returns the actual data of a sample the null mixer has been fed
+   with the placeholder for, NULL if it cannot be loaded.  */
+static const int16_t *resolve_data(const AVSequencerContext *avctx,
+                                   const AVSequencerSample *sample)
+{
+    return (sample && avctx->load_sample) ? avctx->load_sample(avctx, sample) : NULL;
+}
+
+static AVSequencerPlayerSnapshot *snapshot_take(AVSequencerContext *avctx,
+                                                AVMixerData *mixer_data)
+{
+    const AVSequencerPlayerGlobals *const player_globals = avctx->player_globals;
+    const uint16_t host_channels                         = player_globals->stack_channels;
+    const uint16_t channels                              = avctx->player_module->channels;
+    const uint32_t gosub_size                            = host_channels * player_globals->gosub_stack_size << 2;
+    const uint32_t loop_size                             = host_channels * player_globals->loop_stack_size << 2;
+    AVSequencerPlayerSnapshot *snapshot;
+    uint8_t *buf;
+    uint16_t channel;
+
+    if (!(snapshot = av_malloc(sizeof(AVSequencerPlayerSnapshot) +
+                               (host_channels * sizeof(AVSequencerPlayerHostChannel)) +
+                               (channels * sizeof(AVSequencerPlayerChannel)) +
+                               ((channels << 1) * sizeof(AVMixerChannel)) +
+                               gosub_size + loop_size + FF_INPUT_BUFFER_PADDING_SIZE)))
+        return NULL;
+
+    buf                           = (uint8_t *) (snapshot + 1);
+    snapshot->play_time           = player_globals->play_time;
+    snapshot->player_globals      = *player_globals;
+    snapshot->player_host_channel = (AVSequencerPlayerHostChannel *) buf;
+    buf                          += host_channels * sizeof(AVSequencerPlayerHostChannel);
+    snapshot->player_channel      = (AVSequencerPlayerChannel *) buf;
+    buf                          += channels * sizeof(AVSequencerPlayerChannel);
+    snapshot->mixer_channel       = (AVMixerChannel *) buf;
+    buf                          += (channels << 1) * sizeof(AVMixerChannel);
+    snapshot->seed                = avctx->seed;
+    snapshot->tempo               = mixer_data ? mixer_data->tempo : 0;
+
+    snapshot->player_globals.gosub_stack = (uint16_t *) buf;
+    memcpy(buf, player_globals->gosub_stack, gosub_size);
+    buf                                 += gosub_size;
+    snapshot->player_globals.loop_stack  = (uint16_t *) buf;
+    memcpy(buf, player_globals->loop_stack, loop_size);
+
+    memcpy(snapshot->player_host_channel, avctx->player_host_channel, host_channels * sizeof(AVSequencerPlayerHostChannel));
+    memcpy(snapshot->player_channel, avctx->player_channel, channels * sizeof(AVSequencerPlayerChannel));
+
+    if (mixer_data) {
+        for (channel = 0; channel < channels; ++channel)
+            avseq_mixer_get_both_channels(mixer_data, snapshot->mixer_channel + (channel << 1), snapshot->mixer_channel + (channel << 1) + 1, channel);
+    }
+
+    return snapshot;
+}
+
+static void snapshot_restore(AVSequencerContext *avctx,
+                             const AVSequencerPlayerSnapshot *const snapshot,
+                             AVMixerData *mixer_data)
+{
+    AVSequencerPlayerGlobals *const player_globals = avctx->player_globals;
+    const uint16_t host_channels                   = snapshot->player_globals.stack_channels;
+    const uint16_t channels                        = avctx->player_module->channels;
+    uint16_t *gosub_stack                          = player_globals->gosub_stack;
+    uint16_t *loop_stack                           = player_globals->loop_stack;
+    uint16_t channel;
+
+    memcpy(gosub_stack, snapshot->player_globals.gosub_stack, host_channels * snapshot->player_globals.gosub_stack_size << 2);
+    memcpy(loop_stack, snapshot->player_globals.loop_stack, host_channels * snapshot->player_globals.loop_stack_size << 2);
+
+    *player_globals             = snapshot->player_globals;
+    player_globals->gosub_stack = gosub_stack;
+    player_globals->loop_stack  = loop_stack;
+    avctx->seed                 = snapshot->seed;
+
+    memcpy(avctx->player_host_channel, snapshot->player_host_channel, host_channels * sizeof(AVSequencerPlayerHostChannel));
+    memcpy(avctx->player_channel, snapshot->player_channel, channels * sizeof(AVSequencerPlayerChannel));
+
+    if (mixer_data) {
+        for (channel = 0; channel < channels; ++channel) {
+            avseq_mixer_reset_channel(mixer_data, channel);
+            avseq_mixer_set_both_channels(mixer_data, snapshot->mixer_channel + (channel << 1), snapshot->mixer_channel + (channel << 1) + 1, channel);
+        }
+
+        avseq_mixer_set_tempo(mixer_data, snapshot->tempo);
+    }
+}
+
+static void snapshot_hook(AVSequencerContext *avctx, void *hook_data,
+                          uint64_t hook_len)
+{
+    PreScan *const scan                            = hook_data;
+    AVSequencerPlayerSnapshotIndex *const index    = scan->opaque;
+    const AVSequencerPlayerGlobals *player_globals = avctx->player_globals;
+    AVSequencerPlayerSnapshot **snapshot_list      = index->snapshot_list;
+    AVSequencerPlayerSnapshot *snapshot;
+
+    if (scan->error || (player_globals->play_time < scan->next_time))
+        return;
+
+    if (!(snapshot = snapshot_take(avctx, scan->mixer_data))) {
+        av_log(avctx, AV_LOG_ERROR, "Cannot allocate player state snapshot.\n");
+        scan->error = AVERROR(ENOMEM);
+        return;
+    } else if (!(snapshot_list = av_realloc(snapshot_list, ((index->snapshots + 1) * sizeof(AVSequencerPlayerSnapshot *)) + FF_INPUT_BUFFER_PADDING_SIZE))) {
+        av_free(snapshot);
+        av_log(avctx, AV_LOG_ERROR, "Cannot allocate snapshot index storage container.\n");
+        scan->error = AVERROR(ENOMEM);
+        return;
+    }
+
+    snapshot_list[index->snapshots++] = snapshot;
+    index->snapshot_list              = snapshot_list;
+    scan->next_time                   = player_globals->play_time + index->interval;
+}
+
+/**
+ * Runs the player for a sub-song with the null mixer as fast as
+ * possible, calling the hook function each tick before it is
+ * processed. An existing playback of the same sub-song is saved
+ * before and restored after the pre-scan.
+ */
+static int prescan(AVSequencerContext *avctx, AVSequencerModule *module,
+                   AVSequencerSong *song, uint64_t max_time,
+                   void (*hook_func)(AVSequencerContext *avctx, void *hook_data, uint64_t hook_len),
+                   PreScan *scan)
+{
+    AVSequencerPlayerSnapshot *live = NULL;
+    AVSequencerPlayerGlobals *player_globals;
+    AVSequencerPlayerHook *player_hook;
+    AVSequencerPlayerHook scan_hook;
+    AVMixerContext *mixctx;
+    AVMixerData *live_mixer_data, *mixer_data;
+    const int16_t *(*load_sample)(const AVSequencerContext *avctx, const AVSequencerSample *sample);
+    uint32_t mode = 1;
+    int res;
+
+    if (!(avctx && module && song))
+        return AVERROR_INVALIDDATA;
+
+    if (!((mixctx = avseq_mixer_get_by_name("Null mixer")) && mixctx->mix_tick)) {
+        av_log(avctx, AV_LOG_ERROR, "Null mixer required for pre-scan not found.\n");
+        return AVERROR(ENOSYS);
+    }
+
+    live_mixer_data = avctx->player_mixer_data;
+
+    if (avctx->player_globals) {
+        if ((avctx->player_module != module) || (avctx->player_song != song)) {
+            av_log(avctx, AV_LOG_ERROR, "Cannot pre-scan a sub-song while playing back another one.\n");
+            return AVERROR_INVALIDDATA;
+        }
+
+        if (!(live = snapshot_take(avctx, NULL))) {
+            av_log(avctx, AV_LOG_ERROR, "Cannot allocate player state snapshot.\n");
+            return AVERROR(ENOMEM);
+        }
+
+        if (avctx->player_globals->flags & AVSEQ_PLAYER_GLOBALS_FLAG_PLAY_ONCE)
+            mode = 0;
+    }
+
+    avctx->player_mixer_data = NULL;
+
+    if ((res = avseq_module_play(avctx, mixctx, module, song, "", NULL, mode)) < 0) {
+        avctx->player_mixer_data = live_mixer_data;
+        av_free(live);
+        return res;
+    }
+
+    mixer_data = avctx->player_mixer_data;
+
+    if (live_mixer_data)
+        avseq_mixer_set_rate(mixer_data, live_mixer_data->rate, live_mixer_data->channels_out);
+
+    player_hook         = avctx->player_hook;
+    scan->mixer_data    = mixer_data;
+    scan->duration      = 0;
+    scan->song_end      = 0;
+    scan->error         = 0;
+    scan_hook.flags     = AVSEQ_PLAYER_HOOK_FLAG_BEGINNING;
+    scan_hook.hook_func = hook_func;
+    scan_hook.hook_data = scan;
+    scan_hook.hook_len  = sizeof(PreScan);
+
+    if ((load_sample = avctx->load_sample))
+        avctx->load_sample = placeholder_load_sample;
+
+    if ((scan->error = avseq_song_reset(avctx, song)) >= 0) {
+        player_globals     = avctx->player_globals;
+        avctx->player_hook = &scan_hook;
+
+        while (!(scan->error || (player_globals->flags & AVSEQ_PLAYER_GLOBALS_FLAG_SONG_END))) {
+            if (max_time && (player_globals->play_time >= max_time))
+                break;
+
+            mixctx->mix_tick(mixer_data, NULL, UINT32_MAX);
+        }
+
+        scan->duration = player_globals->play_time;
+        scan->song_end = (player_globals->flags & AVSEQ_PLAYER_GLOBALS_FLAG_SONG_END) ? 1 : 0;
+    }
+
+    avctx->player_hook = player_hook;
+    avctx->load_sample = load_sample;
+
+    if (live) {
+        avseq_module_stop(avctx, 0);
+
+        avctx->player_mixer_data = live_mixer_data;
+
+        snapshot_restore(avctx, live, NULL);
+        av_free(live);
+    } else {
+        avseq_module_stop(avctx, 1);
+    }
+
+    return (scan->error < 0) ? scan->error : 0;
+}
+
+AVSequencerPlayerSnapshotIndex *avseq_snapshot_index_create(AVSequencerContext *avctx,
+                                                            AVSequencerModule *module,
+                                                            AVSequencerSong *song,
+                                                            uint64_t interval,
+                                                            uint64_t max_time)
+{
+    AVSequencerPlayerSnapshotIndex *index;
+    PreScan scan;
+
+    if (!(index = av_mallocz(sizeof(AVSequencerPlayerSnapshotIndex) + FF_INPUT_BUFFER_PADDING_SIZE))) {
+        av_log(avctx, AV_LOG_ERROR, "Cannot allocate snapshot index.\n");
+        return NULL;
+    }
+
+    index->song     = song;
+    index->interval = interval;
+    scan.opaque     = index;
+    scan.next_time  = 0;
+
+    if (prescan(avctx, module, song, max_time, snapshot_hook, &scan) < 0) {
+        avseq_snapshot_index_destroy(index);
+        return NULL;
+    }
+
+    index->duration = scan.duration;
+    index->song_end = scan.song_end;
+
+    return index;
+}
+
+void avseq_snapshot_index_destroy(AVSequencerPlayerSnapshotIndex *index)
+{
+    if (index) {
+        uint32_t i;
+
+        for (i = 0; i < index->snapshots; ++i)
+            av_free(index->snapshot_list[i]);
+
+        av_free(index->snapshot_list);
+    }
+
+    av_free(index);
+}
+
+static void song_scan_hook(AVSequencerContext *avctx, void *hook_data,
+                           uint64_t hook_len)
+{
+    PreScan *const scan                                           = hook_data;
+    AVSequencerSongScan *const song_scan                          = scan->opaque;
+    const AVSequencerPlayerHostChannel *const player_host_channel = avctx->player_host_channel;
+    const AVSequencerOrderList *const order_list                  = avctx->player_song->order_list;
+    const uint64_t time                                           = scan->last_time;
+    const uint16_t row                                            = player_host_channel->row;
+    uint32_t order                                                = scan->last_order;
+
+    /* The hook runs before the tick is processed, thus the current
+       row has been entered by the previous tick.  */
+    scan->last_time = avctx->player_globals->play_time;
+
+    if (scan->error || !player_host_channel->order)
+        return;
+
+    if (!((order < order_list->orders) && (order_list->order_data[order] == player_host_channel->order))) {
+        for (order = 0; order < order_list->orders; ++order) {
+            if (order_list->order_data[order] == player_host_channel->order)
+                break;
+        }
+
+        if (order == order_list->orders)
+            return;
+    }
+
+    if ((order == scan->last_order) && (row == scan->last_row))
+        return;
+
+    if ((scan->last_order != UINT32_MAX) && ((order < scan->last_order) || ((order == scan->last_order) && (row < scan->last_row)))) {
+        AVSequencerSongScanLoop *loop_list;
+
+        if (!(loop_list = av_fast_realloc(song_scan->loop_list, &scan->loop_list_size, (song_scan->loops + 1) * sizeof(AVSequencerSongScanLoop)))) {
+            av_log(avctx, AV_LOG_ERROR, "Cannot allocate song scan loop storage container.\n");
+            scan->error = AVERROR(ENOMEM);
+            return;
+        }
+
+        song_scan->loop_list        = loop_list;
+        loop_list                  += song_scan->loops++;
+        loop_list->time             = time;
+        loop_list->from_order       = scan->last_order;
+        loop_list->from_row         = scan->last_row;
+        loop_list->to_order         = order;
+        loop_list->to_row           = row;
+    }
+
+    {
+        AVSequencerSongScanEntry *timeline;
+
+        if (!(timeline = av_fast_realloc(song_scan->timeline, &scan->timeline_size, (song_scan->entries + 1) * sizeof(AVSequencerSongScanEntry)))) {
+            av_log(avctx, AV_LOG_ERROR, "Cannot allocate song scan timeline storage container.\n");
+            scan->error = AVERROR(ENOMEM);
+            return;
+        }
+
+        song_scan->timeline  = timeline;
+        timeline            += song_scan->entries++;
+        timeline->time       = time;
+        timeline->order      = order;
+        timeline->row        = row;
+    }
+
+    scan->last_order = order;
+    scan->last_row   = row;
+}
+
+AVSequencerSongScan *avseq_song_scan(AVSequencerContext *avctx,
+                                     AVSequencerModule *module,
+                                     AVSequencerSong *song,
+                                     uint64_t max_time)
+{
+    AVSequencerSongScan *song_scan;
+    PreScan scan;
+
+    if (!(song_scan = av_mallocz(sizeof(AVSequencerSongScan) + FF_INPUT_BUFFER_PADDING_SIZE))) {
+        av_log(avctx, AV_LOG_ERROR, "Cannot allocate song scan.\n");
+        return NULL;
+    }
+
+    scan.opaque         = song_scan;
+    scan.last_time      = 0;
+    scan.timeline_size  = 0;
+    scan.loop_list_size = 0;
+    scan.last_order     = UINT32_MAX;
+    scan.last_row       = 0;
+
+    if (prescan(avctx, module, song, max_time, song_scan_hook, &scan) < 0) {
+        avseq_song_scan_destroy(song_scan);
+        return NULL;
+    }
+
+    song_scan->duration = scan.duration;
+    song_scan->song_end = scan.song_end;
+
+    return song_scan;
+}
+
+void avseq_song_scan_destroy(AVSequencerSongScan *scan)
+{
+    if (scan) {
+        av_free(scan->timeline);
+        av_free(scan->loop_list);
+    }
+
+    av_free(scan);
+}
+
+int avseq_snapshot_seek(AVSequencerContext *avctx,
+                        AVSequencerPlayerSnapshotIndex *index,
+                        uint64_t timestamp)
+{
+    AVSequencerPlayerGlobals *player_globals;
+    const AVSequencerPlayerSnapshot *snapshot;
+    AVSequencerPlayerHook *player_hook;
+    AVMixerContext *mixctx;
+    AVMixerData *mixer_data, *null_mixer_data;
+    const int16_t *(*load_sample)(const AVSequencerContext *avctx, const AVSequencerSample *sample);
+    uint64_t tick_start;
+    uint32_t lo, hi, frames, left, left_frac;
+    uint16_t channel;
+
+    if (!(avctx && index && index->snapshots && avctx->player_globals && (mixer_data = avctx->player_mixer_data)))
+        return AVERROR_INVALIDDATA;
+
+    if (index->song != avctx->player_song)
+        return AVERROR_INVALIDDATA;
+
+    if (!((mixctx = avseq_mixer_get_by_name("Null mixer")) && mixctx->mix_tick))
+        return AVERROR(ENOSYS);
+
+    lo = 0;
+    hi = index->snapshots - 1;
+
+    while (lo < hi) {
+        const uint32_t mid = (lo + hi + 1) >> 1;
+
+        if (index->snapshot_list[mid]->play_time <= timestamp)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+
+    snapshot = index->snapshot_list[lo];
+
+    if (snapshot->player_globals.stack_channels != avctx->player_globals->stack_channels ||
+        snapshot->player_globals.gosub_stack_size != avctx->player_globals->gosub_stack_size ||
+        snapshot->player_globals.loop_stack_size != avctx->player_globals->loop_stack_size)
+        return AVERROR_INVALIDDATA;
+
+    if (!(null_mixer_data = avseq_mixer_init(avctx, mixctx, "", NULL)))
+        return AVERROR(ENOMEM);
+
+    avseq_mixer_set_rate(null_mixer_data, mixer_data->rate, mixer_data->channels_out);
+
+    null_mixer_data->flags  |= AVSEQ_MIXER_DATA_FLAG_MIXING;
+    avctx->player_mixer_data = null_mixer_data;
+    player_hook              = avctx->player_hook;
+    avctx->player_hook       = NULL;
+
+    if ((load_sample = avctx->load_sample))
+        avctx->load_sample = placeholder_load_sample;
+
+    snapshot_restore(avctx, snapshot, null_mixer_data);
+
+    /* The snapshot has been taken right before the playback handler
+       processed its tick, so run the pending handler call first.  */
+    player_globals = avctx->player_globals;
+    tick_start     = player_globals->play_time;
+    mixctx->mix_tick(null_mixer_data, NULL, 0);
+
+    while (player_globals->play_time <= timestamp) {
+        if ((player_globals->flags & (AVSEQ_PLAYER_GLOBALS_FLAG_SONG_END|AVSEQ_PLAYER_GLOBALS_FLAG_PLAY_ONCE)) == (AVSEQ_PLAYER_GLOBALS_FLAG_SONG_END|AVSEQ_PLAYER_GLOBALS_FLAG_PLAY_ONCE))
+            break;
+
+        tick_start = player_globals->play_time;
+        mixctx->mix_tick(null_mixer_data, NULL, UINT32_MAX);
+    }
+
+    /* Advance the channel positions within the tick containing the
+       target time.  */
+    if (timestamp > tick_start) {
+        frames = av_rescale(timestamp - tick_start, null_mixer_data->rate, AV_TIME_BASE);
+
+        mixctx->mix_tick(null_mixer_data, NULL, frames);
+    }
+
+    avctx->player_mixer_data = mixer_data;
+    avctx->player_hook       = player_hook;
+    avctx->load_sample       = load_sample;
+
+    for (channel = 0; channel < avctx->player_module->channels; ++channel) {
+        AVSequencerPlayerChannel *const player_channel = avctx->player_channel + channel;
+        const AVSequencerSample *const sample          = player_channel->sample;
+        AVMixerChannel mixer_channel_current;
+        AVMixerChannel mixer_channel_next;
+
+        avseq_mixer_get_both_channels(null_mixer_data, &mixer_channel_current, &mixer_channel_next, channel);
+
+        if ((mixer_channel_current.data == placeholder_data) && !(mixer_channel_current.data = resolve_data(avctx, sample)))
+            mixer_channel_current.flags = 0;
+
+        if ((mixer_channel_next.data == placeholder_data) && !(mixer_channel_next.data = resolve_data(avctx, sample)))
+            mixer_channel_next.flags = 0;
+
+        if (player_channel->mixer.data == placeholder_data)
+            player_channel->mixer.data = resolve_data(avctx, sample);
+
+        avseq_mixer_reset_channel(mixer_data, channel);
+        avseq_mixer_set_both_channels(mixer_data, &mixer_channel_current, &mixer_channel_next, channel);
+    }
+
+    /* Continue within the tick where the null mixer stopped, the tempo
+       has to be set first since it recalculates the tick length.  */
+    avseq_mixer_set_tempo(mixer_data, null_mixer_data->tempo);
+    avseq_mixer_get_tick_phase(null_mixer_data, &left, &left_frac);
+    avseq_mixer_set_tick_phase(mixer_data, left, left_frac);
+
+    avseq_mixer_uninit(avctx, null_mixer_data);
+
+    return 0;
+}
@@ -207,4 +207,80 @@ typedef struct AVSequencerSong {
     uint8_t **unknown_data;
 } AVSequencerSong;
 
+/**
+ * Song timeline entry which maps a playing time to the order list
+ * position and row of the first channel.
+ * New fields can be added to the end with minor version bumps.
+ * Removal, reordering and changes to existing fields require a major
+ * version bump.
+ */
+typedef struct AVSequencerSongScanEntry {
+    /** Playing time in AV_TIME_BASE fractional seconds at which the
+       row starts playing.  */
+    uint64_t time;
+
+    /** Order list entry number of the first channel.  */
+    uint16_t order;
+
+    /** Track row of the first channel.  */
+    uint16_t row;
+} AVSequencerSongScanEntry;
+
+/**
+ * Loop-back position detected by the song scan, i.e. a jump of the
+ * first channel to an earlier order list entry or an earlier row
+ * within the same order list entry.
+ * New fields can be added to the end with minor version bumps.
+ * Removal, reordering and changes to existing fields require a major
+ * version bump.
+ */
+typedef struct AVSequencerSongScanLoop {
+    /** Playing time in AV_TIME_BASE fractional seconds at which the
+       jump occurs.  */
+    uint64_t time;
+
+    /** Order list entry number the jump starts from.  */
+    uint16_t from_order;
+
+    /** Track row the jump starts from.  */
+    uint16_t from_row;
+
+    /** Order list entry number the jump leads to.  */
+    uint16_t to_order;
+
+    /** Track row the jump leads to.  */
+    uint16_t to_row;
+} AVSequencerSongScanLoop;
+
+/**
+ * Result of a sub-song pre-scan with the null mixer containing the
+ * total duration, the detected loop-back positions and a timeline
+ * with one entry per row played.
+ * New fields can be added to the end with minor version bumps.
+ * Removal, reordering and changes to existing fields require a major
+ * version bump.
+ */
+typedef struct AVSequencerSongScan {
+    /** Total playing time in AV_TIME_BASE fractional seconds until
+       the song end has been detected or the scan has been stopped.  */
+    uint64_t duration;
+
+    /** Array of timeline entries ordered by ascending playing time.  */
+    AVSequencerSongScanEntry *timeline;
+
+    /** Number of timeline entries.  */
+    uint32_t entries;
+
+    /** Array of loop-back positions ordered by ascending playing
+       time.  */
+    AVSequencerSongScanLoop *loop_list;
+
+    /** Number of loop-back positions.  */
+    uint32_t loops;
+
+    /** Non-zero if the song end has been found before the maximum
+       scan time has been reached.  */
+    uint8_t song_end;
+} AVSequencerSongScan;
+
 #endif /* AVSEQUENCER_SONG_H */
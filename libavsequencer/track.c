@@ -171,6 +171,7 @@ void avseq_track_close(AVSequencerSong *song, AVSequencerTrack *track)
 
     avseq_track_data_close(track);
     av_freep(&track->data);
+    avseq_track_packed_close(track);
 
     track->last_row = 0;
 }
@@ -327,142 +328,193 @@ AVSequencerTrack *avseq_track_get_address(AVSequencerSong *song, uint32_t track)
     return song->track_list[--track];
 }
 
-int avseq_track_unpack(AVSequencerTrack *track, const uint8_t *buf, uint32_t len)
+/** Reads the row position bytes of a packed track row, updating
+   last_pack_row to the number of the row the packed data refers to.
+   Errors are logged to log_ctx.  */
+static int unpack_row_position(void *log_ctx, const AVSequencerTrack *track,
+                               const uint8_t **buf_ptr, uint32_t *len,
+                               const uint8_t pack_type, uint16_t *last_pack_row)
 {
-    AVSequencerTrackRow *data;
-    uint16_t last_pack_row = 0;
-    uint8_t pack_type;
-
-    if (!(track && buf && len))
-        return AVERROR_INVALIDDATA;
+    const uint8_t *buf     = *buf_ptr;
+    uint16_t tmp_pack_word = 0, tmp_pack_row;
 
-    data = track->data;
+    if (pack_type & 1) { // row high byte follows
+        if (!--*len) {
+            av_log(log_ctx, AV_LOG_ERROR, "Cannot unpack track data row high byte, unexpected end of stream.\n");
+            return AVERROR_INVALIDDATA;
+        }
 
-    while ((pack_type = *buf++)) {
-        AVSequencerTrackEffect *fx;
-        uint16_t tmp_pack_word = 0, tmp_pack_row;
-        uint8_t tmp_pack_byte;
+        tmp_pack_word = (uint8_t) (*buf++ << 8);
+    }
 
-        if (last_pack_row > track->last_row) {
-            av_log(track, AV_LOG_ERROR, "Cannot unpack track data, track has too few rows (expected: %d, got: %d).\n", track->last_row + 1, last_pack_row + 1);
+    if (pack_type & 2) { // row low byte follows
+        if (!--*len) {
+            av_log(log_ctx, AV_LOG_ERROR, "Cannot unpack track data row low byte, unexpected end of stream.\n");
             return AVERROR_INVALIDDATA;
         }
 
-        if (pack_type & 1) { // row high byte follows
-            if (!--len) {
-                av_log(track, AV_LOG_ERROR, "Cannot unpack track data row high byte, unexpected end of stream.\n");
-                return AVERROR_INVALIDDATA;
-            }
+        tmp_pack_word |= (uint8_t) *buf++;
+    }
 
-            tmp_pack_word = (uint8_t) (*buf++ << 8);
-        }
+    if ((tmp_pack_row = tmp_pack_word)) {
+        if (!(tmp_pack_row >>= 8))
+            tmp_pack_word = (*last_pack_row & 0xFF00) | (uint8_t) tmp_pack_word;
 
-        if (pack_type & 2) { // row low byte follows
-            if (!--len) {
-                av_log(track, AV_LOG_ERROR, "Cannot unpack track data row low byte, unexpected end of stream.\n");
-                return AVERROR_INVALIDDATA;
-            }
+        *last_pack_row = tmp_pack_word;
+    }
 
-            tmp_pack_word |= (uint8_t) *buf++;
-        }
+    if (*last_pack_row > track->last_row) {
+        av_log(log_ctx, AV_LOG_ERROR, "Cannot unpack track data, track has too few rows (expected: %d, got: %d).\n", track->last_row + 1, *last_pack_row + 1);
+        return AVERROR_INVALIDDATA;
+    }
 
-        if ((tmp_pack_row = tmp_pack_word)) {
-            if (!(tmp_pack_row >>= 8)) {
-                tmp_pack_row  = (uint8_t) tmp_pack_word;
-                tmp_pack_word = (last_pack_row & 0xFF00) | tmp_pack_row;
-            }
+    *buf_ptr = buf;
+
+    return 0;
+}
 
-            tmp_pack_row  = last_pack_row;
-            last_pack_row = tmp_pack_word;
-            data         += tmp_pack_word - tmp_pack_row;
+/** Reads the note, instrument and effects of a packed track row. If
+   data is NULL, the row is only validated and skipped. Otherwise the
+   effects are either stored into fx_buf, which must have enough room
+   for all effects of the row, or allocated and opened separately if
+   fx_buf is NULL, which is the only case track is needed for. The
+   number of effects read is returned in effects. Errors are logged to
+   log_ctx.  */
+static int unpack_row_data(void *log_ctx, AVSequencerTrack *track,
+                           const uint8_t **buf_ptr, uint32_t *len,
+                           uint8_t pack_type, AVSequencerTrackRow *data,
+                           AVSequencerTrackEffect *fx_buf, uint16_t *effects)
+{
+    const uint8_t *buf     = *buf_ptr;
+    uint16_t tmp_pack_word = 0;
+    uint8_t tmp_pack_byte;
+
+    *effects = 0;
+
+    if (pack_type & 4) { // octave (high nibble) and note (low nibble) follows or 0xFx are special notes (keyoff, etc.)
+        if (!--*len) {
+            av_log(log_ctx, AV_LOG_ERROR, "Cannot unpack track data octave and note byte, unexpected end of stream.\n");
+            return AVERROR_INVALIDDATA;
         }
 
-        if (pack_type & 4) { // octave (high nibble) and note (low nibble) follows or 0xFx are special notes (keyoff, etc.)
-            if (!--len) {
-                av_log(track, AV_LOG_ERROR, "Cannot unpack track data octave and note byte, unexpected end of stream.\n");
-                return AVERROR_INVALIDDATA;
-            }
+        tmp_pack_byte = *buf++;
 
-            if ( (tmp_pack_byte = *buf++) >= 0xF0) {
+        if (data) {
+            if (tmp_pack_byte >= 0xF0) {
                 data->note = tmp_pack_byte;
             } else {
                 data->octave = tmp_pack_byte >> 4;
                 data->note   = tmp_pack_byte & 0xF;
             }
         }
+    }
 
-        tmp_pack_word = 0;
-
-        if (pack_type & 8) { // instrument high byte follows
-            if (!--len) {
-                av_log(track, AV_LOG_ERROR, "Cannot unpack track data instrument high byte, unexpected end of stream.\n");
-                return AVERROR_INVALIDDATA;
-            }
-
-            tmp_pack_word = *buf++ << 8;
+    if (pack_type & 8) { // instrument high byte follows
+        if (!--*len) {
+            av_log(log_ctx, AV_LOG_ERROR, "Cannot unpack track data instrument high byte, unexpected end of stream.\n");
+            return AVERROR_INVALIDDATA;
         }
 
-        if (pack_type & 16) { // instrument low byte follows
-            if (!--len) {
-                av_log(track, AV_LOG_ERROR, "Cannot unpack track data instrument low byte, unexpected end of stream.\n");
-                return AVERROR_INVALIDDATA;
-            }
+        tmp_pack_word = *buf++ << 8;
+    }
 
-            tmp_pack_word |= *buf++;
+    if (pack_type & 16) { // instrument low byte follows
+        if (!--*len) {
+            av_log(log_ctx, AV_LOG_ERROR, "Cannot unpack track data instrument low byte, unexpected end of stream.\n");
+            return AVERROR_INVALIDDATA;
         }
 
-        data->instrument = tmp_pack_word;
+        tmp_pack_word |= *buf++;
+    }
 
-        if (pack_type & (32|64|128)) { // either track data effect byte, high or low byte of data word follow
-            do {
-                int res;
+    if (data)
+        data->instrument = tmp_pack_word;
 
-                tmp_pack_byte = 0;
+    if (pack_type & (32|64|128)) { // either track data effect byte, high or low byte of data word follow
+        do {
+            AVSequencerTrackEffect *fx;
+            int res;
 
-                if (pack_type & 32) { // track data effect command follows
-                    if (!--len) {
-                        av_log(track, AV_LOG_ERROR, "Cannot unpack track data effect command, unexpected end of stream.\n");
-                        return AVERROR_INVALIDDATA;
-                    }
+            tmp_pack_byte = 0;
 
-                    tmp_pack_byte = *buf++;
+            if (pack_type & 32) { // track data effect command follows
+                if (!--*len) {
+                    av_log(log_ctx, AV_LOG_ERROR, "Cannot unpack track data effect command, unexpected end of stream.\n");
+                    return AVERROR_INVALIDDATA;
                 }
 
-                tmp_pack_word = 0;
+                tmp_pack_byte = *buf++;
+            }
 
-                if (pack_type & 64) { // track data effect data word high byte follows
-                    if (!--len) {
-                        av_log(track, AV_LOG_ERROR, "Cannot unpack track data effect data word high byte, unexpected end of stream.\n");
-                        return AVERROR_INVALIDDATA;
-                    }
+            tmp_pack_word = 0;
 
-                    tmp_pack_word = *buf++ << 8;
+            if (pack_type & 64) { // track data effect data word high byte follows
+                if (!--*len) {
+                    av_log(log_ctx, AV_LOG_ERROR, "Cannot unpack track data effect data word high byte, unexpected end of stream.\n");
+                    return AVERROR_INVALIDDATA;
                 }
 
-                if (pack_type & 128) { // track data effect data word low byte follows
-                    if (!--len) {
-                        av_log(track, AV_LOG_ERROR, "Cannot unpack track data effect data word low byte, unexpected end of stream.\n");
-                        return AVERROR_INVALIDDATA;
-                    }
+                tmp_pack_word = *buf++ << 8;
+            }
 
-                    tmp_pack_word |= *buf++;
+            if (pack_type & 128) { // track data effect data word low byte follows
+                if (!--*len) {
+                    av_log(log_ctx, AV_LOG_ERROR, "Cannot unpack track data effect data word low byte, unexpected end of stream.\n");
+                    return AVERROR_INVALIDDATA;
                 }
 
-                if (!(fx = avseq_track_effect_create()))
+                tmp_pack_word |= *buf++;
+            }
+
+            if (!++*effects) {
+                av_log(log_ctx, AV_LOG_ERROR, "Cannot unpack track data, too many effects.\n");
+                return AVERROR_INVALIDDATA;
+            }
+
+            if (data) {
+                if (fx_buf) {
+                    fx = fx_buf + *effects - 1;
+                } else if (!(fx = avseq_track_effect_create())) {
                     return AVERROR(ENOMEM);
+                }
 
                 fx->command = tmp_pack_byte & 0x7F;
                 fx->data    = tmp_pack_word;
 
-                if ((res = avseq_track_effect_open(track, data, fx)) < 0) {
+                if (fx_buf) {
+                    data->effects_data[*effects - 1] = fx;
+                    data->effects                    = *effects;
+                } else if ((res = avseq_track_effect_open(track, data, fx)) < 0) {
                     avseq_track_effect_destroy(fx);
 
                     return res;
                 }
+            }
 
-                pack_type = 0xFF;
-            } while ((int8_t) tmp_pack_byte < 0);
-        }
+            pack_type = 0xFF;
+        } while ((int8_t) tmp_pack_byte < 0);
+    }
+
+    *buf_ptr = buf;
+
+    return 0;
+}
+
+int avseq_track_unpack(AVSequencerTrack *track, const uint8_t *buf, uint32_t len)
+{
+    uint16_t last_pack_row = 0, effects;
+    uint8_t pack_type;
+    int res;
+
+    if (!(track && track->data && buf && len))
+        return AVERROR_INVALIDDATA;
+
+    while ((pack_type = *buf++)) {
+        if ((res = unpack_row_position(track, track, &buf, &len, pack_type, &last_pack_row)) < 0)
+            return res;
+
+        if ((res = unpack_row_data(track, track, &buf, &len, pack_type, track->data + last_pack_row, NULL, &effects)) < 0)
+            return res;
 
         if (!len--) {
             av_log(track, AV_LOG_ERROR, "Cannot unpack track, unexpected end of stream.\n");
@@ -470,7 +522,6 @@ int avseq_track_unpack(AVSequencerTrack *track, const uint8_t *buf, uint32_t len
         }
 
         last_pack_row++;
-        data++;
     }
 
     if (len || pack_type) {
@@ -480,3 +531,161 @@ int avseq_track_unpack(AVSequencerTrack *track, const uint8_t *buf, uint32_t len
 
     return 0;
 }
+
+int avseq_track_packed_open(AVSequencerTrack *track, const uint8_t *buf, uint32_t len)
+{
+    const uint8_t *pos = buf;
+    uint8_t *packed_data;
+    uint32_t *packed_index;
+    uint32_t packed_len = len;
+    uint16_t last_pack_row = 0, effects, max_effects = 0;
+    uint8_t pack_type;
+    int res;
+
+    if (!(track && buf && len))
+        return AVERROR_INVALIDDATA;
+
+    if (!(packed_index = av_mallocz(((track->last_row + 1) * sizeof(uint32_t)) + FF_INPUT_BUFFER_PADDING_SIZE))) {
+        av_log(track, AV_LOG_ERROR, "Cannot allocate packed track index.\n");
+        return AVERROR(ENOMEM);
+    }
+
+    while ((pack_type = *pos)) {
+        const uint32_t offset = pos++ - buf;
+
+        if ((res = unpack_row_position(track, track, &pos, &len, pack_type, &last_pack_row)) < 0) {
+            av_free(packed_index);
+            return res;
+        }
+
+        packed_index[last_pack_row] = offset + 1;
+
+        if ((res = unpack_row_data(track, track, &pos, &len, pack_type, NULL, NULL, &effects)) < 0) {
+            av_free(packed_index);
+            return res;
+        }
+
+        if (max_effects < effects)
+            max_effects = effects;
+
+        if (!len--) {
+            av_free(packed_index);
+            av_log(track, AV_LOG_ERROR, "Cannot unpack track, unexpected end of stream.\n");
+            return AVERROR_INVALIDDATA;
+        }
+
+        last_pack_row++;
+    }
+
+    if (len) {
+        av_free(packed_index);
+        av_log(track, AV_LOG_ERROR, "Cannot unpack track, unexpected end of stream.\n");
+        return AVERROR_INVALIDDATA;
+    }
+
+    if (!(packed_data = av_malloc(packed_len + 1 + FF_INPUT_BUFFER_PADDING_SIZE))) {
+        av_free(packed_index);
+        av_log(track, AV_LOG_ERROR, "Cannot allocate packed track data.\n");
+        return AVERROR(ENOMEM);
+    }
+
+    memcpy(packed_data, buf, packed_len + 1);
+
+    avseq_track_packed_close(track);
+    avseq_track_data_close(track);
+    av_freep(&track->data);
+
+    track->packed_data    = packed_data;
+    track->packed_index   = packed_index;
+    track->packed_size    = packed_len;
+    track->packed_effects = max_effects;
+
+    return 0;
+}
+
+void avseq_track_packed_close(AVSequencerTrack *track)
+{
+    if (track) {
+        av_freep(&track->packed_data);
+        av_freep(&track->packed_index);
+
+        track->packed_size    = 0;
+        track->packed_effects = 0;
+    }
+}
+
+static const AVSequencerTrackRow empty_row;
+
+const AVSequencerTrackRow *avseq_track_get_row(const AVSequencerTrack *track, uint32_t row,
+                                               AVSequencerTrackRowCache *cache)
+{
+    const uint8_t *buf;
+    uint32_t offset, len;
+    uint16_t last_pack_row = row, effects;
+    uint8_t pack_type;
+
+    if (!track || (row > track->last_row))
+        return NULL;
+
+    if (track->data)
+        return track->data + row;
+
+    if (!(track->packed_index && (offset = track->packed_index[row])))
+        return &empty_row;
+
+    if (!cache)
+        return NULL;
+
+    if ((cache->track == track) && (cache->row == row))
+        return &cache->data;
+
+    if (cache->effects_size < track->packed_effects) {
+        AVSequencerTrackEffect *effects_buf;
+        AVSequencerTrackEffect **effects_data;
+
+        if (!(effects_buf = av_realloc(cache->effects, (track->packed_effects * sizeof(AVSequencerTrackEffect)) + FF_INPUT_BUFFER_PADDING_SIZE))) {
+            av_log(NULL, AV_LOG_ERROR, "Cannot allocate track row cache effects.\n");
+            return NULL;
+        }
+
+        cache->effects = effects_buf;
+
+        if (!(effects_data = av_realloc(cache->data.effects_data, (track->packed_effects * sizeof(AVSequencerTrackEffect *)) + FF_INPUT_BUFFER_PADDING_SIZE))) {
+            av_log(NULL, AV_LOG_ERROR, "Cannot allocate track row cache effects.\n");
+            return NULL;
+        }
+
+        cache->data.effects_data = effects_data;
+        cache->effects_size      = track->packed_effects;
+    }
+
+    cache->track           = NULL;
+    cache->data.effects    = 0;
+    cache->data.octave     = 0;
+    cache->data.note       = 0;
+    cache->data.instrument = 0;
+
+    buf       = track->packed_data + --offset;
+    len       = track->packed_size - offset;
+    pack_type = *buf++;
+
+    if ((unpack_row_position(NULL, track, &buf, &len, pack_type, &last_pack_row) < 0) ||
+        (unpack_row_data(NULL, NULL, &buf, &len, pack_type, &cache->data, cache->effects, &effects) < 0))
+        return NULL;
+
+    cache->track = track;
+    cache->row   = row;
+
+    return &cache->data;
+}
+
+void avseq_track_row_cache_free(AVSequencerTrackRowCache *cache)
+{
+    if (cache) {
+        av_freep(&cache->effects);
+        av_freep(&cache->data.effects_data);
+
+        cache->track        = NULL;
+        cache->effects_size = 0;
+    }
+}
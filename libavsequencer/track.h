@@ -1635,6 +1635,53 @@ typedef struct AVSequencerTrack {
        Some programs write editor settings for tracks in those chunks,
        which then won't get lost in that case.  */
     uint8_t **unknown_data;
+
+    /** Packed track data stream as passed to avseq_track_packed_open
+       or NULL if the track is not stored in packed form. Packed
+       tracks have no data array, their rows are decoded one at a
+       time by avseq_track_get_row when they are accessed.  */
+    uint8_t *packed_data;
+
+    /** Array (of size last_row + 1) of offsets into packed_data
+       plus one where the packed data of each row starts or 0 if the
+       row is empty.  */
+    uint32_t *packed_index;
+
+    /** Size of packed_data in bytes excluding the end marker.  */
+    uint32_t packed_size;
+
+    /** Maximum number of effects used by one row of the packed track
+       data.  */
+    uint16_t packed_effects;
 } AVSequencerTrack;
 
+/**
+ * Track row cache structure which holds the last row decoded from a
+ * packed track by avseq_track_get_row, including storage for its
+ * effects. It belongs to the reader, i.e. a packed track can be
+ * shared by several readers each using its own cache.
+ * New fields can be added to the end with minor version bumps.
+ * Removal, reordering and changes to existing fields require a major
+ * version bump.
+ */
+typedef struct AVSequencerTrackRowCache {
+    /** The decoded track row, its effects_data array points into
+       effects.  */
+    AVSequencerTrackRow data;
+
+    /** Packed track the cached row belongs to or NULL if the cache
+       is empty.  */
+    const AVSequencerTrack *track;
+
+    /** Array (of size effects_size) of effects storage for the
+       decoded row.  */
+    AVSequencerTrackEffect *effects;
+
+    /** Number of effects which fit into effects.  */
+    uint16_t effects_size;
+
+    /** Number of the cached row.  */
+    uint16_t row;
+} AVSequencerTrackRowCache;
+
 #endif /* AVSEQUENCER_TRACK_H */
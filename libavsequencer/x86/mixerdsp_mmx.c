@@ -0,0 +1,290 @@
+/*
+ * SIMD optimized AVSequencer mixer DSP functions
+ * Copyright (c) 2010 Sebastian Vater <cdgs.basty@googlemail.com>
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/common.h"
+#include "libavutil/cpu.h"
+#include "libavutil/mem.h"
+#include "libavutil/x86_cpu.h"
+#include "libavsequencer/mixerdsp.h"
+
+#if HAVE_SSE
+DECLARE_ALIGNED(16, static const uint32_t, pd_1)[4] = {1, 1, 1, 1};
+DECLARE_ALIGNED(16, static const uint32_t, pd_3)[4] = {3, 3, 3, 3};
+DECLARE_ALIGNED(16, static const uint32_t, pd_7fff)[4] = {0x7FFF, 0x7FFF, 0x7FFF, 0x7FFF};
+
+/* Signed (x * y) >> 32 for x in [0, 2^31) without 64-bit arithmetic
+   shifts: the unsigned high part of x * (uint32_t) y is corrected by
+   subtracting x for negative y. x is expected in xmm3, y in d, the
+   result is stored in r, t0 and t1 are clobbered.  */
+#define MULHS(d, r, t0, t1)                 \
+    "movdqa     %%xmm3, "r"           \n\t" \
+    "pmuludq      "d", "r"            \n\t" \
+    "movdqa     %%xmm3, "t0"          \n\t" \
+    "psrlq         $32, "t0"          \n\t" \
+    "movdqa       "d", "t1"           \n\t" \
+    "psrlq         $32, "t1"          \n\t" \
+    "pmuludq     "t1", "t0"           \n\t" \
+    "pshufd $0x0D, "r", "r"           \n\t" \
+    "pshufd $0x0D, "t0", "t0"         \n\t" \
+    "punpckldq   "t0", "r"            \n\t" \
+    "psrad         $31, "d"           \n\t" \
+    "pand       %%xmm3, "d"           \n\t" \
+    "psubd        "d", "r"            \n\t"
+
+/* All intermediate values of ff_mixer_interpolate_c fit into 32 bits
+   once the 64-bit divisions by 2 and 4 are split into the high and
+   low parts of the operands, which keeps this bit-exact.  */
+static void mixer_interpolate_sse2(int32_t *dst, const int32_t *prev,
+                                   const int32_t *curr, const int32_t *next,
+                                   const uint32_t *frac, int len)
+{
+    const int simd_len = len & ~3;
+    x86_reg i          = -simd_len * (x86_reg) sizeof(int32_t);
+
+    if (simd_len) {
+        __asm__ volatile(
+            "1:                                     \n\t"
+            "movdqu      (%2,%0), %%xmm0            \n\t" // prev
+            "movdqu      (%3,%0), %%xmm1            \n\t" // curr
+            "movdqu      (%4,%0), %%xmm2            \n\t" // next
+            "movdqu      (%5,%0), %%xmm3            \n\t"
+            "psrld            $1, %%xmm3            \n\t" // frac >> 1
+            // d = (next + prev - 2 * curr) >> 2
+            "movdqa       %%xmm2, %%xmm4            \n\t"
+            "psrad            $2, %%xmm4            \n\t"
+            "movdqa       %%xmm0, %%xmm5            \n\t"
+            "psrad            $2, %%xmm5            \n\t"
+            "paddd        %%xmm5, %%xmm4            \n\t"
+            "movdqa       %%xmm1, %%xmm5            \n\t"
+            "psrad            $1, %%xmm5            \n\t"
+            "psubd        %%xmm5, %%xmm4            \n\t"
+            "movdqa       %%xmm2, %%xmm5            \n\t"
+            "pand             %6, %%xmm5            \n\t"
+            "movdqa       %%xmm0, %%xmm6            \n\t"
+            "pand             %6, %%xmm6            \n\t"
+            "paddd        %%xmm6, %%xmm5            \n\t"
+            "movdqa       %%xmm1, %%xmm6            \n\t"
+            "pand             %7, %%xmm6            \n\t"
+            "paddd        %%xmm6, %%xmm6            \n\t"
+            "psubd        %%xmm6, %%xmm5            \n\t"
+            "psrad            $2, %%xmm5            \n\t"
+            "paddd        %%xmm5, %%xmm4            \n\t"
+            // d = ((frac >> 1) * d) >> 32
+            MULHS("%%xmm4", "%%xmm5", "%%xmm6", "%%xmm7")
+            // d += (curr - prev) >> 2
+            "movdqa       %%xmm1, %%xmm6            \n\t"
+            "psrad            $2, %%xmm6            \n\t"
+            "movdqa       %%xmm0, %%xmm7            \n\t"
+            "psrad            $2, %%xmm7            \n\t"
+            "psubd        %%xmm7, %%xmm6            \n\t"
+            "movdqa       %%xmm1, %%xmm7            \n\t"
+            "pand             %6, %%xmm7            \n\t"
+            "movdqa       %%xmm0, %%xmm4            \n\t"
+            "pand             %6, %%xmm4            \n\t"
+            "psubd        %%xmm4, %%xmm7            \n\t"
+            "psrad            $2, %%xmm7            \n\t"
+            "paddd        %%xmm7, %%xmm6            \n\t"
+            "paddd        %%xmm6, %%xmm5            \n\t"
+            // d = ((frac >> 1) * d) >> 32
+            MULHS("%%xmm5", "%%xmm4", "%%xmm6", "%%xmm7")
+            // smp_value = (prev + curr) >> 1
+            "movdqa       %%xmm0, %%xmm5            \n\t"
+            "pand         %%xmm1, %%xmm5            \n\t"
+            "movdqa       %%xmm0, %%xmm6            \n\t"
+            "pxor         %%xmm1, %%xmm6            \n\t"
+            "psrad            $1, %%xmm6            \n\t"
+            "paddd        %%xmm6, %%xmm5            \n\t"
+            // smp = smp_value + (d << 3)
+            "movdqa       %%xmm4, %%xmm6            \n\t"
+            "pslld            $3, %%xmm6            \n\t"
+            "paddd        %%xmm5, %%xmm6            \n\t"
+            // use curr instead on signed overflow
+            "movdqa       %%xmm5, %%xmm7            \n\t"
+            "pxor         %%xmm6, %%xmm7            \n\t"
+            "pxor         %%xmm6, %%xmm4            \n\t"
+            "pand         %%xmm4, %%xmm7            \n\t"
+            "psrad           $31, %%xmm7            \n\t"
+            "pand         %%xmm7, %%xmm1            \n\t"
+            "pandn        %%xmm6, %%xmm7            \n\t"
+            "por          %%xmm1, %%xmm7            \n\t"
+            "movdqu       %%xmm7, (%1,%0)           \n\t"
+            "add             $16, %0                \n\t"
+            "jl 1b                                  \n\t"
+            : "+&r"(i)
+            : "r"(dst + simd_len), "r"(prev + simd_len), "r"(curr + simd_len),
+              "r"(next + simd_len), "r"(frac + simd_len),
+              "m"(*pd_3), "m"(*pd_1)
+            : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",
+                           "%xmm4", "%xmm5", "%xmm6", "%xmm7",) "memory"
+        );
+    }
+
+    if (len & 3)
+        ff_mixer_interpolate_c(dst + simd_len, prev + simd_len, curr + simd_len,
+                               next + simd_len, frac + simd_len, len & 3);
+}
+
+static void mixer_add_mono_sse2(int32_t *mix_buf, const int32_t *src, int len)
+{
+    const int simd_len = len & ~3;
+    x86_reg i          = -simd_len * (x86_reg) sizeof(int32_t);
+
+    if (simd_len) {
+        __asm__ volatile(
+            "1:                                     \n\t"
+            "movdqu      (%2,%0), %%xmm0            \n\t"
+            "movdqu      (%1,%0), %%xmm1            \n\t"
+            "paddd        %%xmm1, %%xmm0            \n\t"
+            "movdqu       %%xmm0, (%1,%0)           \n\t"
+            "add             $16, %0                \n\t"
+            "jl 1b                                  \n\t"
+            : "+&r"(i)
+            : "r"(mix_buf + simd_len), "r"(src + simd_len)
+            : XMM_CLOBBERS("%xmm0", "%xmm1",) "memory"
+        );
+    }
+
+    if (len & 3)
+        ff_mixer_add_mono_c(mix_buf + simd_len, src + simd_len, len & 3);
+}
+
+/* Interleaves four source samples into two stereo frame vectors
+   by using the given unpack setup and adds them to the output.  */
+#define ADD_STEREO(name, setup)                                                     \
+static void mixer_add_##name##_sse2(int32_t *mix_buf, const int32_t *src, int len)  \
+{                                                                                   \
+    const int simd_len = len & ~3;                                                  \
+    x86_reg i          = -simd_len * (x86_reg) sizeof(int32_t);                     \
+                                                                                    \
+    if (simd_len) {                                                                 \
+        __asm__ volatile(                                                           \
+            "pxor         %%xmm7, %%xmm7            \n\t"                           \
+            "pcmpeqd      %%xmm6, %%xmm6            \n\t"                           \
+            "1:                                     \n\t"                           \
+            "movdqu      (%2,%0), %%xmm0            \n\t"                           \
+            setup                                                                   \
+            "movdqu    (%1,%0,2), %%xmm2            \n\t"                           \
+            "movdqu  16(%1,%0,2), %%xmm3            \n\t"                           \
+            "paddd        %%xmm2, %%xmm0            \n\t"                           \
+            "paddd        %%xmm3, %%xmm1            \n\t"                           \
+            "movdqu       %%xmm0, (%1,%0,2)         \n\t"                           \
+            "movdqu       %%xmm1, 16(%1,%0,2)       \n\t"                           \
+            "add             $16, %0                \n\t"                           \
+            "jl 1b                                  \n\t"                           \
+            : "+&r"(i)                                                              \
+            : "r"(mix_buf + (simd_len << 1)), "r"(src + simd_len)                   \
+            : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",                      \
+                           "%xmm6", "%xmm7",) "memory"                              \
+        );                                                                          \
+    }                                                                               \
+                                                                                    \
+    if (len & 3)                                                                    \
+        ff_mixer_add_##name##_c(mix_buf + (simd_len << 1), src + simd_len, len & 3);\
+}
+
+ADD_STEREO(left,
+           "movdqa       %%xmm0, %%xmm1            \n\t"
+           "punpckldq    %%xmm7, %%xmm0            \n\t"
+           "punpckhdq    %%xmm7, %%xmm1            \n\t")
+
+ADD_STEREO(right,
+           "movdqa       %%xmm7, %%xmm1            \n\t"
+           "punpckhdq    %%xmm0, %%xmm1            \n\t"
+           "movdqa       %%xmm7, %%xmm2            \n\t"
+           "punpckldq    %%xmm0, %%xmm2            \n\t"
+           "movdqa       %%xmm2, %%xmm0            \n\t")
+
+ADD_STEREO(center,
+           "movdqa       %%xmm0, %%xmm1            \n\t"
+           "punpckldq    %%xmm0, %%xmm0            \n\t"
+           "punpckhdq    %%xmm1, %%xmm1            \n\t")
+
+ADD_STEREO(surround,
+           "movdqa       %%xmm0, %%xmm2            \n\t"
+           "pxor         %%xmm6, %%xmm2            \n\t"
+           "movdqa       %%xmm0, %%xmm1            \n\t"
+           "punpckldq    %%xmm2, %%xmm0            \n\t"
+           "punpckhdq    %%xmm2, %%xmm1            \n\t")
+
+/* Packs the saturated upper and the lower 15 bits of eight samples
+   into words, so pmaddwd can be used for both halves.  */
+static int32_t mixer_dot_product_sse2(const int32_t *src, const int16_t *coeff, int taps)
+{
+    x86_reg i = -taps * (x86_reg) sizeof(int16_t);
+    int32_t sum_hi, sum_lo;
+
+    __asm__ volatile(
+        "pxor         %%xmm6, %%xmm6            \n\t"
+        "pxor         %%xmm7, %%xmm7            \n\t"
+        "1:                                     \n\t"
+        "movdqu    (%3,%0,2), %%xmm0            \n\t"
+        "movdqu  16(%3,%0,2), %%xmm1            \n\t"
+        "movdqu      (%4,%0), %%xmm4            \n\t"
+        "movdqa       %%xmm0, %%xmm2            \n\t"
+        "movdqa       %%xmm1, %%xmm3            \n\t"
+        "psrad           $15, %%xmm0            \n\t"
+        "psrad           $15, %%xmm1            \n\t"
+        "pand             %5, %%xmm2            \n\t"
+        "pand             %5, %%xmm3            \n\t"
+        "packssdw     %%xmm1, %%xmm0            \n\t"
+        "packssdw     %%xmm3, %%xmm2            \n\t"
+        "pmaddwd      %%xmm4, %%xmm0            \n\t"
+        "pmaddwd      %%xmm4, %%xmm2            \n\t"
+        "paddd        %%xmm0, %%xmm6            \n\t"
+        "paddd        %%xmm2, %%xmm7            \n\t"
+        "add             $16, %0                \n\t"
+        "jl 1b                                  \n\t"
+        "pshufd $0x4E, %%xmm6, %%xmm0           \n\t"
+        "pshufd $0x4E, %%xmm7, %%xmm2           \n\t"
+        "paddd        %%xmm0, %%xmm6            \n\t"
+        "paddd        %%xmm2, %%xmm7            \n\t"
+        "pshufd $0xB1, %%xmm6, %%xmm0           \n\t"
+        "pshufd $0xB1, %%xmm7, %%xmm2           \n\t"
+        "paddd        %%xmm0, %%xmm6            \n\t"
+        "paddd        %%xmm2, %%xmm7            \n\t"
+        "movd         %%xmm6, %1                \n\t"
+        "movd         %%xmm7, %2                \n\t"
+        : "+&r"(i), "=r"(sum_hi), "=r"(sum_lo)
+        : "r"(src + taps), "r"(coeff + taps), "m"(*pd_7fff)
+        : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",
+                       "%xmm4", "%xmm6", "%xmm7",) "memory"
+    );
+
+    return av_clipl_int32((((int64_t) sum_hi << 15) + sum_lo + (1 << 13)) >> 14);
+}
+#endif /* HAVE_SSE */
+
+void ff_mixer_dsp_init_x86(MixerDSPContext *c)
+{
+    av_unused int cpu_flags = av_get_cpu_flags();
+
+#if HAVE_SSE
+    if (cpu_flags & AV_CPU_FLAG_SSE2) {
+        c->interpolate  = mixer_interpolate_sse2;
+        c->add_mono     = mixer_add_mono_sse2;
+        c->add_left     = mixer_add_left_sse2;
+        c->add_right    = mixer_add_right_sse2;
+        c->add_center   = mixer_add_center_sse2;
+        c->add_surround = mixer_add_surround_sse2;
+        c->dot_product  = mixer_dot_product_sse2;
+    }
+#endif
+}
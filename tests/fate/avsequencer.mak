@@ -0,0 +1,7 @@
+FATE_AVSEQUENCER += fate-seqmixer-levels
+fate-seqmixer-levels: libavsequencer/mixer-test$(EXESUF)
+fate-seqmixer-levels: CMD = run libavsequencer/mixer-test
+
+FATE_TESTS += $(FATE_AVSEQUENCER)
+fate-avsequencer: $(FATE_AVSEQUENCER)
+$(FATE_AVSEQUENCER): REF = /dev/null
@@ -0,0 +1,249 @@
+/*
+ * AVSequencer mixer benchmark
+ * Copyright (c) 2010 Sebastian Vater <cdgs.basty@googlemail.com>
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Measures the throughput of every registered mixer by mixing synthetic
+ * voices with different sample sizes, loop types, filter settings and
+ * output modes. Results are printed as time per output frame and voice.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#undef HAVE_AV_CONFIG_H
+#include "libavutil/lfg.h"
+#include "libavutil/mem.h"
+#include "libavutil/timer.h"
+#include "libavformat/avformat.h"
+#include "libavsequencer/avsequencer.h"
+
+#define SAMPLE_LEN 65536
+#define VOICE_POS(i) (((i) * 4099) % SAMPLE_LEN)
+
+static const uint8_t bits_list[] = { 8, 16, 32, 12, 24 };
+
+static const struct {
+    const char *name;
+    uint8_t flags;
+} loop_list[] = {
+    { "forward",  AVSEQ_MIXER_CHANNEL_FLAG_LOOP },
+    { "backward", AVSEQ_MIXER_CHANNEL_FLAG_LOOP|AVSEQ_MIXER_CHANNEL_FLAG_BACK_LOOP },
+    { "pingpong", AVSEQ_MIXER_CHANNEL_FLAG_LOOP|AVSEQ_MIXER_CHANNEL_FLAG_PINGPONG },
+};
+
+static const char *const output_list[] = { "mono", "stereo", "surround" };
+
+static void usage(void)
+{
+    printf("Benchmark the AVSequencer mixers\n");
+    printf("Usage: seqmixbench [voices [runs [mixer arguments]]]\n");
+    printf("\n"
+           "voices            number of voices mixed at once (default 32)\n"
+           "runs              number of mixing buffers per test (default 64)\n"
+           "mixer arguments   string passed to the mixer init, e.g. \"interpolation=1;\"\n");
+}
+
+/** set up all voices, odd voices are set together with their next sample */
+static void set_voices(AVMixerData *mixer_data, const int16_t *data,
+                       unsigned voices, unsigned bits, uint8_t flags,
+                       int filter)
+{
+    AVMixerContext *mixctx = mixer_data->mixctx;
+    AVMixerChannel channel;
+    unsigned i;
+
+    for (i = 0; i < voices; i++) {
+        memset(&channel, 0, sizeof(channel));
+
+        channel.data            = data;
+        channel.len             = SAMPLE_LEN;
+        channel.repeat_start    = SAMPLE_LEN >> 2;
+        channel.repeat_length   = SAMPLE_LEN >> 1;
+        channel.pos             = VOICE_POS(i);
+        channel.rate            = 8363 + i * 1013;
+        channel.bits_per_sample = bits;
+        channel.flags           = flags|AVSEQ_MIXER_CHANNEL_FLAG_PLAY;
+        channel.volume          = 255 - (i & 63);
+        channel.panning         = i * 37;
+        channel.filter_cutoff   = filter ? 1024 + (i & 1023) : 4095;
+        channel.filter_damping  = filter ? 512 : 0;
+
+        if (i & 1)
+            avseq_mixer_set_both_channels(mixer_data, &channel, &channel, i);
+        else
+            avseq_mixer_set_channel(mixer_data, &channel, i);
+
+        /* set_channel does not apply the rate, only the pitch change does */
+        if (mixctx->set_channel_volume_panning_pitch)
+            mixctx->set_channel_volume_panning_pitch(mixer_data, &channel, i);
+    }
+}
+
+/** check that every voice has moved away from its start position */
+static int voices_advance(const AVMixerData *mixer_data, unsigned voices)
+{
+    AVMixerChannel channel;
+    unsigned i;
+
+    for (i = 0; i < voices; i++) {
+        avseq_mixer_get_channel(mixer_data, &channel, i);
+
+        if (channel.pos == VOICE_POS(i))
+            return 0;
+    }
+
+    return 1;
+}
+
+static void bench_mixer(AVSequencerContext *avctx, AVMixerContext *mixctx,
+                        const char *args, const int16_t *data,
+                        unsigned voices, unsigned runs)
+{
+    AVMixerData *mixer_data;
+    unsigned output, bits, loop, filter, i;
+
+    if (!mixctx->mix) {
+        printf("%s: no buffer based mixing, skipped\n", mixctx->name);
+        return;
+    }
+
+    if (!(mixer_data = avseq_mixer_init(avctx, mixctx, args, NULL))) {
+        printf("%s: initialization failed\n", mixctx->name);
+        return;
+    }
+
+    mixer_data->handler = NULL;
+
+    for (output = 0; output < FF_ARRAY_ELEMS(output_list); output++) {
+        if ((output == 2) && !(mixctx->flags & AVSEQ_MIXER_CONTEXT_FLAG_SURROUND))
+            continue;
+
+        avseq_mixer_set_rate(mixer_data, 44100, output ? 2 : 1);
+        avseq_mixer_set_tempo(mixer_data, 125 * 4); // 125 BpM, 4 rows per beat
+
+        if (avseq_mixer_set_volume(mixer_data, 65536, 65536, 65536, voices) < voices) {
+            printf("%s: cannot allocate %u voices\n", mixctx->name, voices);
+            break;
+        }
+
+        for (bits = 0; bits < FF_ARRAY_ELEMS(bits_list); bits++) {
+            for (loop = 0; loop < FF_ARRAY_ELEMS(loop_list); loop++) {
+                for (filter = 0; filter < 2; filter++) {
+                    uint8_t flags = loop_list[loop].flags;
+                    uint64_t cycles = 0;
+                    int64_t time;
+                    double frames;
+
+                    if (output == 2)
+                        flags |= AVSEQ_MIXER_CHANNEL_FLAG_SURROUND;
+
+                    set_voices(mixer_data, data, voices, bits_list[bits], flags, filter);
+
+                    /* warm up caches and lookup tables */
+                    avseq_mixer_do_mix(mixer_data, NULL);
+
+                    if (!voices_advance(mixer_data, voices)) {
+                        printf("%-22s %-8s %2u bit %-8s %-8s voices do not advance, skipped\n",
+                               mixctx->name, output_list[output], bits_list[bits],
+                               loop_list[loop].name, filter ? "filter" : "nofilter");
+                        continue;
+                    }
+
+                    time = av_gettime();
+
+                    for (i = 0; i < runs; i++) {
+#ifdef AV_READ_TIME
+                        START_TIMER
+                        avseq_mixer_do_mix(mixer_data, NULL);
+                        tend    = AV_READ_TIME();
+                        cycles += tend - tstart;
+#else
+                        avseq_mixer_do_mix(mixer_data, NULL);
+#endif
+                    }
+
+                    time   = av_gettime() - time;
+                    frames = (double) mixer_data->mix_buf_size * runs * voices;
+
+                    printf("%-22s %-8s %2u bit %-8s %-8s %8.2f ns %8.1f cycles\n",
+                           mixctx->name, output_list[output], bits_list[bits],
+                           loop_list[loop].name, filter ? "filter" : "nofilter",
+                           time * 1000.0 / frames, cycles / frames);
+                }
+            }
+        }
+    }
+
+    avseq_mixer_uninit(avctx, mixer_data);
+}
+
+int main(int argc, char **argv)
+{
+    AVSequencerContext *avctx;
+    AVMixerContext **mixctx = NULL;
+    const char *args        = "";
+    unsigned voices = 32, runs = 64, i;
+    uint32_t *data;
+    AVLFG lfg;
+
+    if (argc > 1 && !strcmp(argv[1], "-h")) {
+        usage();
+        return 0;
+    }
+
+    if (argc > 1)
+        voices = FFMAX(atoi(argv[1]), 1);
+
+    if (argc > 2)
+        runs = FFMAX(atoi(argv[2]), 1);
+
+    if (argc > 3)
+        args = argv[3];
+
+    if (!(avctx = avsequencer_open(NULL, NULL, NULL))) {
+        fprintf(stderr, "Cannot allocate sequencer context.\n");
+        return 1;
+    }
+
+    /* large enough for SAMPLE_LEN 32-bit samples */
+    if (!(data = av_malloc(SAMPLE_LEN * sizeof(*data)))) {
+        fprintf(stderr, "Cannot allocate sample data.\n");
+        avsequencer_destroy(avctx);
+        return 1;
+    }
+
+    av_lfg_init(&lfg, 0xdeadbeef);
+
+    for (i = 0; i < SAMPLE_LEN; i++)
+        data[i] = av_lfg_get(&lfg);
+
+    printf("%u voices, %u runs, mixer arguments \"%s\"\n", voices, runs, args);
+
+    while ((mixctx = avseq_mixer_next(mixctx)) && *mixctx)
+        bench_mixer(avctx, *mixctx, args, (const int16_t *) data, voices, runs);
+
+    av_free(data);
+    avsequencer_destroy(avctx);
+
+    return 0;
+}